@@ -167,19 +167,27 @@ HEADERS += \
 	src/gl/glproperty.h \
 	src/gl/glscene.h \
 	src/gl/glshape.h \
+	src/gl/glskin.h \
 	src/gl/gltex.h \
 	src/gl/gltexloaders.h \
+	src/gl/gltexqueue.h \
 	src/gl/gltools.h \
 	src/gl/icontrollable.h \
 	src/gl/renderer.h \
 	src/io/material.h \
 	src/io/MeshFile.h \
+	src/io/nifindex.h \
 	src/io/nifstream.h \
+	src/io/resourceindex.h \
 	src/lib/importex/3ds.h \
+	src/lib/importex/gltf.h \
 	src/lib/nvtristripwrapper.h \
 	src/lib/qhull.h \
+	src/lib/skinpartition.h \
+	src/lib/spatialhash.h \
 	src/model/basemodel.h \
 	src/model/kfmmodel.h \
+	src/model/niffields.h \
 	src/model/nifmodel.h \
 	src/model/nifproxymodel.h \
 	src/model/undocommands.h \
@@ -202,6 +210,7 @@ HEADERS += \
 	src/ui/widgets/lightingwidget.h \
 	src/ui/widgets/nifcheckboxlist.h \
 	src/ui/widgets/nifeditors.h \
+	src/ui/widgets/nifindexwidget.h \
 	src/ui/widgets/nifview.h \
 	src/ui/widgets/refrbrowser.h \
 	src/ui/widgets/uvedit.h \
@@ -213,6 +222,7 @@ HEADERS += \
 	src/ui/settingspane.h \
 	src/xml/nifexpr.h \
 	src/xml/xmlconfig.h \
+	src/batchprocessor.h \
 	src/bsamodel.h \
 	src/gamemanager.h \
 	src/glview.h \
@@ -245,13 +255,17 @@ SOURCES += \
 	src/gl/glproperty.cpp \
 	src/gl/glscene.cpp \
 	src/gl/glshape.cpp \
+	src/gl/glskin.cpp \
 	src/gl/gltex.cpp \
 	src/gl/gltexloaders.cpp \
+	src/gl/gltexqueue.cpp \
 	src/gl/gltools.cpp \
 	src/gl/renderer.cpp \
 	src/io/materialfile.cpp \
 	src/io/MeshFile.cpp \
+	src/io/nifindex.cpp \
 	src/io/nifstream.cpp \
+	src/io/resourceindex.cpp \
 	src/lib/importex/3ds.cpp \
 	src/lib/importex/importex.cpp \
 	src/lib/importex/obj.cpp \
@@ -259,6 +273,8 @@ SOURCES += \
 	src/lib/importex/gltf.cpp \
 	src/lib/nvtristripwrapper.cpp \
 	src/lib/qhull.cpp \
+	src/lib/skinpartition.cpp \
+	src/lib/spatialhash.cpp \
 	src/model/basemodel.cpp \
 	src/model/kfmmodel.cpp \
 	src/model/nifdelegate.cpp \
@@ -306,6 +322,7 @@ SOURCES += \
 	src/ui/widgets/lightingwidget.cpp \
 	src/ui/widgets/nifcheckboxlist.cpp \
 	src/ui/widgets/nifeditors.cpp \
+	src/ui/widgets/nifindexwidget.cpp \
 	src/ui/widgets/nifview.cpp \
 	src/ui/widgets/refrbrowser.cpp \
 	src/ui/widgets/uvedit.cpp \
@@ -318,6 +335,7 @@ SOURCES += \
 	src/xml/kfmxml.cpp \
 	src/xml/nifexpr.cpp \
 	src/xml/nifxml.cpp \
+	src/batchprocessor.cpp \
 	src/bsamodel.cpp \
 	src/gamemanager.cpp \
 	src/glview.cpp \
@@ -0,0 +1,46 @@
+###############################
+## BENCHMARKS
+###############################
+
+# Builds the benchmarks as the NifSkopeBenchmark console application,
+# from the same sources as NifSkope without its main.cpp
+#	qmake NifSkopeBenchmark.pro
+# The benchmarks are not linked into NifSkope itself.
+
+include(NifSkope.pro)
+
+TARGET = NifSkopeBenchmark
+
+CONFIG += console
+
+SOURCES -= src/main.cpp
+
+HEADERS += \
+	benchmark/benchmark.h
+
+SOURCES += \
+	benchmark/anim.cpp \
+	benchmark/benchmark.cpp \
+	benchmark/bigmesh.cpp \
+	benchmark/check.cpp \
+	benchmark/expr.cpp \
+	benchmark/glb.cpp \
+	benchmark/links.cpp \
+	benchmark/load.cpp \
+	benchmark/main.cpp \
+	benchmark/mesh.cpp \
+	benchmark/normals.cpp \
+	benchmark/save.cpp \
+	benchmark/schema.cpp \
+	benchmark/skin.cpp \
+	benchmark/skinpart.cpp \
+	benchmark/values.cpp
+
+*msvc* {
+	QMAKE_LFLAGS -= /IMPLIB:$$syspath($${INTERMEDIATE}/NifSkope.lib)
+	QMAKE_LFLAGS += /IMPLIB:$$syspath($${INTERMEDIATE}/NifSkopeBenchmark.lib)
+	QMAKE_LFLAGS_DEBUG -= /PDB:$$syspath($${INTERMEDIATE}/nifskope.pdb)
+	QMAKE_LFLAGS_DEBUG += /PDB:$$syspath($${INTERMEDIATE}/nifskopebenchmark.pdb)
+}
+
+# vim: set filetype=config :
@@ -0,0 +1,177 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "gl/glcontroller.h"
+#include "model/nifmodel.h"
+#include "qtcompat.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+
+//! @file benchmark/anim.cpp Keyframe animation benchmark
+
+namespace Benchmark
+{
+
+//! The largest difference between two transforms
+static float transformDifference( const Transform & a, const Transform & b )
+{
+	float d = std::fabs( a.scale - b.scale );
+	for ( int i = 0; i < 3; i++ ) {
+		d = std::max( d, std::fabs( a.translation[i] - b.translation[i] ) );
+		for ( int j = 0; j < 3; j++ )
+			d = std::max( d, std::fabs( a.rotation( i, j ) - b.rotation( i, j ) ) );
+	}
+
+	return d;
+}
+
+int animBenchmark( const QString & rootFolder, QTextStream & out )
+{
+	QList<SourceFile> files = readFiles( rootFolder, { ".nif", ".kf" } );
+	if ( files.isEmpty() )
+		return noFiles( rootFolder, out );
+
+	constexpr float frameTime = 1.0f / 60.0f;
+	constexpr int loops = 4;
+
+	NifModel nif;
+	BaseModel & model = nif;
+
+	int numSequences = 0, numTracks = 0, numSplines = 0;
+	qint64 numSamples = 0, numSplineSamples = 0;
+	double tReference = 0.0, tDecode = 0.0, tDecoded = 0.0, tSplines = 0.0;
+	float maxError = 0.0f;
+
+	for ( const SourceFile & f : files ) {
+		QBuffer in;
+		in.setData( f.data );
+		in.open( QIODevice::ReadOnly );
+		if ( !model.load( in, f.path.toStdString().c_str() ) )
+			continue;
+
+		for ( int b = 0; b < nif.getBlockCount(); b++ ) {
+			QModelIndex iSeq = nif.getBlockIndex( b, "NiControllerSequence" );
+			if ( !iSeq.isValid() )
+				continue;
+
+			float start = nif.get<float>( iSeq, "Start Time" );
+			float stop = nif.get<float>( iSeq, "Stop Time" );
+			int numFrames = std::max( int( ( stop - start ) / frameTime ), 1 ) * loops;
+			numSequences++;
+
+			QModelIndex iCtrlBlcks = nif.getIndex( iSeq, "Controlled Blocks" );
+			for ( int r = 0; r < nif.rowCount( iCtrlBlcks ); r++ ) {
+				QModelIndex iInterp = nif.getBlockIndex( nif.getLink( QModelIndex_child( iCtrlBlcks, r ), "Interpolator" ), "NiInterpolator" );
+
+				if ( nif.isNiBlock( iInterp, "NiBSplineCompTransformInterpolator" ) ) {
+					BSplineTransformInterpolator interp( nullptr );
+					interp.update( &nif, iInterp );
+
+					Transform tm;
+					QElapsedTimer timer;
+					timer.start();
+					for ( int i = 0; i < numFrames; i++ )
+						interp.updateTransform( tm, start + std::fmod( float( i ) * frameTime, std::max( stop - start, frameTime ) ) );
+					tSplines += secondsSince( timer );
+
+					numSplines++;
+					numSplineSamples += numFrames;
+					continue;
+				}
+
+				if ( !nif.isNiBlock( iInterp, "NiTransformInterpolator" ) )
+					continue;
+				QModelIndex iData = nif.getBlockIndex( nif.getLink( iInterp, "Data" ), "NiKeyframeData" );
+				if ( !iData.isValid() )
+					continue;
+
+				// the per-frame model lookups that the decoded keys replaced
+				QModelIndex iTranslations = nif.getIndex( iData, "Translations" );
+				QModelIndex iScales = nif.getIndex( iData, "Scales" );
+				int lRotate = 0, lTrans = 0, lScale = 0;
+
+				Transform ref, tm;
+				QElapsedTimer timer;
+				timer.start();
+				for ( int i = 0; i < numFrames; i++ ) {
+					float time = start + std::fmod( float( i ) * frameTime, std::max( stop - start, frameTime ) );
+					Controller::interpolate( ref.rotation, iData, time, lRotate );
+					Controller::interpolate( ref.translation, iTranslations, time, lTrans );
+					Controller::interpolate( ref.scale, iScales, time, lScale );
+				}
+				tReference += secondsSince( timer );
+
+				TransformInterpolator interp( nullptr );
+				timer.restart();
+				interp.update( &nif, iInterp );
+				tDecode += secondsSince( timer );
+
+				timer.restart();
+				for ( int i = 0; i < numFrames; i++ )
+					interp.updateTransform( tm, start + std::fmod( float( i ) * frameTime, std::max( stop - start, frameTime ) ) );
+				tDecoded += secondsSince( timer );
+
+				// both ended on the same frame
+				maxError = std::max( maxError, transformDifference( ref, tm ) );
+
+				numTracks++;
+				numSamples += numFrames;
+			}
+		}
+	}
+
+	out << QString( "Keyframe benchmark: %1 files, %2 sequences, %3 keyframe tracks, %4 samples" )
+		.arg( files.size() ).arg( numSequences ).arg( numTracks ).arg( numSamples ) << "\n";
+	out << QString( "  model lookups: %1 s, %2 ns/sample" )
+		.arg( tReference, 0, 'f', 3 ).arg( tReference * 1.0e9 / std::max( numSamples, qint64( 1 ) ), 0, 'f', 1 ) << "\n";
+	out << QString( "  decoded keys:  %1 s, %2 ns/sample (%3x), %4 s decoding" )
+		.arg( tDecoded, 0, 'f', 3 ).arg( tDecoded * 1.0e9 / std::max( numSamples, qint64( 1 ) ), 0, 'f', 1 )
+		.arg( tReference / std::max( tDecoded, 1.0e-9 ), 0, 'f', 1 ).arg( tDecode, 0, 'f', 3 ) << "\n";
+	out << QString( "  B-spline tracks: %1, %2 samples, %3 ns/sample" )
+		.arg( numSplines ).arg( numSplineSamples )
+		.arg( tSplines * 1.0e9 / std::max( numSplineSamples, qint64( 1 ) ), 0, 'f', 1 ) << "\n";
+
+	bool same = ( maxError < 1.0e-4f );
+	out << QString( "  max difference: %1%2" ).arg( maxError ).arg( same ? "" : ", output differs" ) << "\n";
+
+	return same ? 0 : 1;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,139 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+
+//! @file benchmark/benchmark.cpp Shared helpers and the list of benchmarks
+
+namespace Benchmark
+{
+
+QList<SourceFile> readFiles( const QString & rootFolder, const QStringList & suffixes )
+{
+	if ( rootFolder.isEmpty() )
+		return {};
+
+	QStringList paths;
+	QDirIterator it( rootFolder, QDir::Files, QDirIterator::Subdirectories );
+	while ( it.hasNext() ) {
+		QString filePath = it.next();
+		for ( const QString & suffix : suffixes ) {
+			if ( filePath.endsWith( suffix, Qt::CaseInsensitive ) ) {
+				paths.append( filePath );
+				break;
+			}
+		}
+	}
+	paths.sort();
+
+	QList<SourceFile> files;
+	for ( const QString & path : paths ) {
+		QFile f( path );
+		if ( f.open( QIODevice::ReadOnly ) )
+			files.append( { path, f.readAll() } );
+	}
+
+	return files;
+}
+
+int noFiles( const QString & rootFolder, QTextStream & out )
+{
+	out << "No NIF files found in " << rootFolder << "\n";
+	return 1;
+}
+
+double megabytes( const QList<SourceFile> & files )
+{
+	qint64 bytes = 0;
+	for ( const SourceFile & f : files )
+		bytes += f.data.size();
+
+	return double( bytes ) / ( 1024.0 * 1024.0 );
+}
+
+double secondsSince( const QElapsedTimer & timer )
+{
+	return double( timer.nsecsElapsed() ) / 1.0e9;
+}
+
+//! A benchmark that run() can dispatch to
+struct BenchmarkEntry
+{
+	const char * name;
+	int ( * func )( const QString & rootFolder, QTextStream & out );
+};
+
+static const BenchmarkEntry benchmarks[] = {
+	{ "load", loadBenchmark },
+	{ "expr", exprBenchmark },
+	{ "mesh", meshBenchmark },
+	{ "normals", normalsBenchmark },
+	{ "bigmesh", bigMeshBenchmark },
+	{ "skin", skinBenchmark },
+	{ "anim", animBenchmark },
+	{ "skinpart", skinPartitionBenchmark },
+	{ "glb", glbBenchmark },
+	{ "schema", schemaBenchmark },
+	{ "values", valuesBenchmark },
+	{ "save", saveBenchmark },
+	{ "links", linksBenchmark },
+	{ "check", checkBenchmark },
+};
+
+QStringList names()
+{
+	QStringList list;
+	for ( const BenchmarkEntry & b : benchmarks )
+		list.append( b.name );
+
+	return list;
+}
+
+int run( const QString & name, const QString & rootFolder, QTextStream & out )
+{
+	for ( const BenchmarkEntry & b : benchmarks ) {
+		if ( name == b.name )
+			return b.func( rootFolder, out );
+	}
+
+	out << "Unknown benchmark: " << name << "\n" << "Available benchmarks: " << names().join( ", " ) << "\n";
+	return 1;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,151 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+
+//! @file benchmark/benchmark.h Benchmarks of the NifSkopeBenchmark command line tool
+
+class QElapsedTimer;
+class QTextStream;
+
+namespace Benchmark
+{
+
+//! A file read into memory, so that disk access is not measured
+struct SourceFile
+{
+	QString path;
+	QByteArray data;
+};
+
+//! Reads the files under \a rootFolder that end with one of \a suffixes, sorted by path
+QList<SourceFile> readFiles( const QString & rootFolder, const QStringList & suffixes = { ".nif" } );
+//! Prints that no files were found under \a rootFolder and returns the exit code of a failed benchmark
+int noFiles( const QString & rootFolder, QTextStream & out );
+//! Total size of \a files in MB
+double megabytes( const QList<SourceFile> & files );
+//! Seconds elapsed since \a timer was started
+double secondsSince( const QElapsedTimer & timer );
+//! A flat grid of side x side vertices with two triangles per cell, using 32-bit indices
+std::vector<quint32> makeGridTriangles( quint32 side );
+
+//! Loader settings compared by the load benchmark
+struct LoadSettings
+{
+	const char * name;
+	bool bulk;
+	bool bytecode;
+};
+
+//! Loads every file, returns the elapsed seconds and the saved output of each file in \a output
+double loadFiles( const QList<SourceFile> & files, const LoadSettings & settings, QList<QByteArray> & output, int & failed );
+
+/*
+ * Benchmarks: each takes the root folder or archive given on the command line, prints its results to out
+ * and returns the process exit code
+ */
+
+//! NifModel::load with bulk array reading and the expression bytecode disabled and enabled,
+//! the saved output must be identical
+int loadBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Evaluation of the cond and vercond expressions of the loaded files, expression tree vs. bytecode
+int exprBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! MeshFile decoding of every .mesh file in the archive or folder \a rootFolder
+int meshBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Smooth Normals and Remove Duplicate Vertices on generated meshes, checked against the duplicates and seams
+//! of the mesh, \a rootFolder is not used
+int normalsBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Splitting of generated grids of up to 2 million triangles into 16-bit chunks, the grids are also written
+//! to bigmesh.obj in the folder \a rootFolder for import and rendering tests
+int bigMeshBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Skinning of a generated 30k vertex mesh over recorded bone animation frames by SkinEngine, on one thread and
+//! threaded, \a rootFolder is not used
+int skinBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Replays the NiControllerSequences of the .nif and .kf files at 60 frames per second,
+//! keyframe sampling through model lookups vs. the decoded key arrays of TransformInterpolator
+int animBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! "Make Skin Partition" on generated skinned tubes by SkinPartitioner, and all tubes on worker threads as
+//! "Make All Skin Partitions" runs them, \a rootFolder is not used
+int skinPartitionBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Writes generated grids as a .glb file in the folder \a rootFolder (or the system temporary folder),
+//! GltfBinaryStream vs. tinygltf with the whole buffer in memory, the time and peak memory use of each and whether
+//! the output is identical
+int glbBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Loading of nif.xml by the XML parser vs. the binary schema cache, a block of every type is inserted
+//! and the NIF files under \a rootFolder are loaded with both, the saved output must be identical
+int schemaBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Load time, the number of values stored inline and with heap data, and the time of copying,
+//! QVariant conversion and moving of all values of the loaded files
+int valuesBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! NifModel::save to memory and BaseModel::saveToFile to the system temporary folder, with the time of the
+//! block size pass that is no longer needed, the recorded block sizes and the output of saving twice must match
+int saveBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! A full rebuild of the link graph vs. the incremental updates after link edits and after inserting and
+//! removing a block, the resulting links, parents and roots must match
+int linksBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Self-checks of code paths that the other benchmarks do not cover, on generated models, \a rootFolder is not used
+int checkBenchmark( const QString & rootFolder, QTextStream & out );
+
+//! Names of the benchmarks that run() accepts
+QStringList names();
+
+//! Runs the named benchmark on \a rootFolder and prints the results to \a out
+/*!
+ * @return The process exit code
+ */
+int run( const QString & name, const QString & rootFolder, QTextStream & out );
+
+} // namespace Benchmark
+
+#endif
@@ -0,0 +1,143 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "data/niftypes.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+#include <iterator>
+#include <vector>
+
+
+//! @file benchmark/bigmesh.cpp Large mesh splitting benchmark
+
+namespace Benchmark
+{
+
+std::vector<quint32> makeGridTriangles( quint32 side )
+{
+	std::vector<quint32> indices;
+	indices.reserve( size_t( side - 1 ) * size_t( side - 1 ) * 6 );
+	for ( quint32 y = 0; y + 1 < side; y++ ) {
+		for ( quint32 x = 0; x + 1 < side; x++ ) {
+			quint32 v = y * side + x;
+			indices.insert( indices.end(), { v, v + 1, v + side, v + 1, v + side + 1, v + side } );
+		}
+	}
+	return indices;
+}
+
+//! Writes the generated grids as an OBJ scene with one material per grid
+static bool writeGridScene( const QString & fileName, const quint32 * sides, size_t numGrids )
+{
+	QFile f( fileName );
+	if ( !f.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+		return false;
+
+	QTextStream s( &f );
+	quint32 firstVertex = 1;
+	for ( size_t i = 0; i < numGrids; i++ ) {
+		quint32 side = sides[i];
+		s << "o grid" << i << "\nusemtl grid" << i << "\n";
+		for ( quint32 y = 0; y < side; y++ ) {
+			for ( quint32 x = 0; x < side; x++ )
+				s << "v " << float( x ) * 0.1f << " " << float( y ) * 0.1f << " " << float( i ) * 10.0f << "\n";
+		}
+		std::vector<quint32> indices = makeGridTriangles( side );
+		for ( size_t j = 0; j < indices.size(); j = j + 3 )
+			s << "f " << ( indices[j] + firstVertex ) << " " << ( indices[j + 1] + firstVertex ) << " " << ( indices[j + 2] + firstVertex ) << "\n";
+		firstVertex = firstVertex + side * side;
+	}
+	s.flush();
+	return ( f.error() == QFileDevice::NoError );
+}
+
+int bigMeshBenchmark( const QString & outputFolder, QTextStream & out )
+{
+	// the first grid fits in 16-bit indices, the others are split
+	static const quint32 sides[] = { 256, 709, 1002 };
+
+	int mismatches = 0;
+	out << "Large mesh benchmark: 32-bit triangle lists to 16-bit chunks" << "\n";
+
+	for ( quint32 side : sides ) {
+		std::vector<quint32> indices = makeGridTriangles( side );
+		qsizetype numTriangles = qsizetype( indices.size() / 3 );
+
+		QElapsedTimer timer;
+		timer.start();
+		QVector<TriangleChunk> chunks = splitTriangles( indices.data(), numTriangles );
+		double t = secondsSince( timer );
+
+		// verify that the chunks map back to the source triangles
+		size_t bytes16 = 0;
+		size_t k = 0;
+		bool same = true;
+		for ( const TriangleChunk & chunk : chunks ) {
+			bytes16 += size_t( chunk.triangles.size() ) * sizeof( Triangle ) + size_t( chunk.vertices.size() ) * sizeof( quint32 );
+			for ( const Triangle & tri : chunk.triangles ) {
+				for ( int j = 0; j < 3; j++, k++ ) {
+					quint32 v = ( chunk.vertices.isEmpty() ? tri[j] : chunk.vertices.at( tri[j] ) );
+					same = same && ( k < indices.size() && v == indices[k] );
+				}
+			}
+		}
+		same = same && ( k == indices.size() );
+		if ( !same )
+			mismatches++;
+
+		out << QString( "  %1 vertices, %2 triangles: %3 chunks in %4 s, %5 MB -> %6 MB%7" )
+			.arg( side * side ).arg( numTriangles ).arg( chunks.size() ).arg( t, 0, 'f', 3 )
+			.arg( double( indices.size() * sizeof( quint32 ) ) / 1048576.0, 0, 'f', 2 )
+			.arg( double( bytes16 ) / 1048576.0, 0, 'f', 2 ).arg( same ? "" : ", output differs" ) << "\n";
+	}
+
+	if ( !outputFolder.isEmpty() && QDir( outputFolder ).exists() ) {
+		QString fileName = QDir( outputFolder ).filePath( "bigmesh.obj" );
+		QElapsedTimer timer;
+		timer.start();
+		if ( !writeGridScene( fileName, sides, std::size( sides ) ) ) {
+			out << "Failed to write " << fileName << "\n";
+			return 1;
+		}
+		out << QString( "  scene written to %1 in %2 s" ).arg( fileName ).arg( secondsSince( timer ), 0, 'f', 3 ) << "\n";
+	}
+
+	return ( mismatches > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,186 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "gl/glnode.h"
+#include "gl/glscene.h"
+#include "gl/gltex.h"
+#include "model/nifmodel.h"
+#include "qtcompat.h"
+#include "xml/nifexpr.h"
+
+#include <QTextStream>
+
+
+//! @file benchmark/check.cpp Self-checks that need no input files
+
+namespace Benchmark
+{
+
+//! Editing a translation key of a NiKeyframeController must move the node on the next frame
+static int checkKeyframeEdit( QTextStream & out )
+{
+	NifModel nif;
+
+	QModelIndex iNode = nif.insertNiBlock( "NiNode" );
+	QModelIndex iCtrl = nif.insertNiBlock( "NiKeyframeController" );
+	nif.setLink( iNode, "Controller", nif.getBlockNumber( iCtrl ) );
+	nif.setLink( iCtrl, "Target", nif.getBlockNumber( iNode ) );
+	nif.set<int>( iCtrl, "Flags", 0x08 );
+	nif.set<float>( iCtrl, "Frequency", 1.0f );
+	nif.set<float>( iCtrl, "Start Time", 0.0f );
+	nif.set<float>( iCtrl, "Stop Time", 1.0f );
+
+	// the keys are in NiKeyframeData up to 10.1.0.103, in the NiTransformData of an interpolator after that
+	QModelIndex iData;
+	if ( nif.getIndex( iCtrl, "Interpolator" ).isValid() ) {
+		QModelIndex iInterp = nif.insertNiBlock( "NiTransformInterpolator" );
+		iData = nif.insertNiBlock( "NiTransformData" );
+		nif.setLink( iCtrl, "Interpolator", nif.getBlockNumber( iInterp ) );
+		nif.setLink( iInterp, "Data", nif.getBlockNumber( iData ) );
+	} else {
+		iData = nif.insertNiBlock( "NiKeyframeData" );
+		nif.setLink( iCtrl, "Data", nif.getBlockNumber( iData ) );
+	}
+
+	QModelIndex iTrans = nif.getIndex( iData, "Translations" );
+	nif.set<int>( iTrans, "Num Keys", 1 );
+	nif.set<int>( iTrans, "Interpolation", 1 );
+	nif.updateArraySize( iTrans, "Keys" );
+	QModelIndex iKey = QModelIndex_child( nif.getIndex( iTrans, "Keys" ), 0 );
+	nif.set<Vector3>( iKey, "Value", Vector3( 1.0f, 2.0f, 3.0f ) );
+
+	TexCache textures;
+	Scene scene( &textures );
+	scene.make( &nif );
+	Node * node = scene.getNode( &nif, iNode );
+	if ( !node ) {
+		out << "  keyframe edit: the node was not created\n";
+		return 1;
+	}
+
+	int errors = 0;
+	scene.transform( Transform(), 0.5f );
+	if ( node->localTrans().translation != Vector3( 1.0f, 2.0f, 3.0f ) ) {
+		out << "  keyframe edit: the key was not applied\n";
+		errors++;
+	}
+
+	// GLView::dataChanged passes the edited item to Scene::update
+	QModelIndex iValue = nif.getIndex( iKey, "Value" );
+	nif.set<Vector3>( iValue, Vector3( 4.0f, 5.0f, 6.0f ) );
+	scene.update( &nif, iValue );
+	scene.transform( Transform(), 0.5f );
+	if ( node->localTrans().translation != Vector3( 4.0f, 5.0f, 6.0f ) ) {
+		out << "  keyframe edit: the edited key was not picked up\n";
+		errors++;
+	}
+
+	return errors;
+}
+
+//! Evaluates the names of an expression to a single field value, like BaseModelEval does
+struct FlagsEval
+{
+	quint64 flags;
+
+	quint64 symbol( [[maybe_unused]] const NifExpr::Symbol & s ) const { return flags; }
+	quint64 arg() const { return 0; }
+	QVariant operator()( const QVariant & v ) const
+	{
+		if ( v.typeId() != QMetaType::QString )
+			return v;
+		bool numeric;
+		int val = v.toString().toInt( &numeric, 10 );
+		if ( numeric )
+			return QVariant::fromValue( val );
+		return QVariant::fromValue( flags );
+	}
+};
+
+//! Negative literals compare as 32-bit unsigned values, so "Flags != -1" is false for 0xFFFFFFFF
+static int checkNegativeLiteral( QTextStream & out )
+{
+	static const struct
+	{
+		const char * expr;
+		quint64 flags;
+		bool result;
+	} cases[] = {
+		{ "Flags != -1", 0xFFFFFFFF, false },
+		{ "Flags != -1", 5, true },
+		{ "Flags == -1", 0xFFFFFFFF, true },
+		{ "Flags == -1", 5, false },
+	};
+
+	int errors = 0;
+	for ( bool bytecode : { false, true } ) {
+		NifExpr::setBytecodeEnabled( bytecode );
+		for ( const auto & c : cases ) {
+			NifExpr expr( QString( c.expr ) );
+			if ( expr.evaluateBool( FlagsEval{ c.flags } ) != c.result ) {
+				out << "  negative literal: " << c.expr << " with Flags = " << c.flags
+					<< ( bytecode ? " (bytecode)" : " (tree)" ) << " is not " << ( c.result ? "true" : "false" ) << "\n";
+				errors++;
+			}
+		}
+	}
+	NifExpr::setBytecodeEnabled( true );
+
+	return errors;
+}
+
+int checkBenchmark( [[maybe_unused]] const QString & rootFolder, QTextStream & out )
+{
+	static const struct
+	{
+		const char * name;
+		int ( * func )( QTextStream & out );
+	} checks[] = {
+		{ "keyframe edit", checkKeyframeEdit },
+		{ "negative literal", checkNegativeLiteral },
+	};
+
+	int failures = 0;
+	out << "Self-checks" << "\n";
+	for ( const auto & c : checks ) {
+		int errors = c.func( out );
+		out << "  " << c.name << ": " << ( errors ? "failed" : "ok" ) << "\n";
+		if ( errors )
+			failures++;
+	}
+
+	return ( failures > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,140 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "model/nifmodel.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+
+
+//! @file benchmark/expr.cpp Expression evaluation benchmark
+
+namespace Benchmark
+{
+
+//! Collects the items that have a cond or vercond, skipping packed arrays which have neither
+static void collectConditions( const NifItem * item, QVector<const NifItem *> & conds, QVector<const NifItem *> & verconds )
+{
+	for ( auto child : item->childIter() ) {
+		if ( !child->cond().isEmpty() && !child->isConditionless() )
+			conds.append( child );
+		if ( !child->vercond().isEmpty() )
+			verconds.append( child );
+		if ( !child->isPacked() )
+			collectConditions( child, conds, verconds );
+	}
+}
+
+//! Evaluates every cond and vercond of the loaded file \a passes times, returns the elapsed seconds
+static double evalConditions( const NifModel & nif, const QVector<const NifItem *> & conds, const QVector<const NifItem *> & verconds,
+							  int passes, QVector<bool> & results )
+{
+	results.clear();
+	results.reserve( conds.size() + verconds.size() );
+
+	QElapsedTimer timer;
+	timer.start();
+	for ( int i = 0; i < passes; i++ ) {
+		bool record = ( i == 0 );
+		for ( const NifItem * item : conds ) {
+			bool r = item->condexpr().evaluateBool( BaseModelEval( &nif, item ) );
+			if ( record )
+				results.append( r );
+		}
+		for ( const NifItem * item : verconds ) {
+			bool r = item->verexpr().evaluateBool( NifModelEval( &nif, nif.getHeaderItem() ) );
+			if ( record )
+				results.append( r );
+		}
+	}
+
+	return secondsSince( timer );
+}
+
+int exprBenchmark( const QString & rootFolder, QTextStream & out )
+{
+	QList<SourceFile> files = readFiles( rootFolder );
+	if ( files.isEmpty() )
+		return noFiles( rootFolder, out );
+
+	constexpr int passes = 20;
+
+	NifModel nif;
+	BaseModel & model = nif;
+
+	qint64 nEvals = 0;
+	double tTree = 0.0, tBytecode = 0.0;
+	int mismatches = 0;
+
+	for ( const SourceFile & f : files ) {
+		QBuffer in;
+		in.setData( f.data );
+		in.open( QIODevice::ReadOnly );
+		if ( !model.load( in, f.path.toStdString().c_str() ) )
+			continue;
+
+		QVector<const NifItem *> conds, verconds;
+		for ( int r = 0; r < nif.rowCount(); r++ ) {
+			const NifItem * top = nif.getItem( nif.index( r, 0 ) );
+			if ( top )
+				collectConditions( top, conds, verconds );
+		}
+
+		QVector<bool> treeResults, bytecodeResults;
+		NifExpr::setBytecodeEnabled( false );
+		tTree += evalConditions( nif, conds, verconds, passes, treeResults );
+		NifExpr::setBytecodeEnabled( true );
+		tBytecode += evalConditions( nif, conds, verconds, passes, bytecodeResults );
+
+		nEvals += qint64( conds.size() + verconds.size() ) * passes;
+		if ( treeResults != bytecodeResults ) {
+			out << "  results differ: " << f.path << "\n";
+			mismatches++;
+		}
+	}
+
+	out << QString( "Expression benchmark: %1 files, %2 evaluations" ).arg( files.size() ).arg( nEvals ) << "\n";
+	out << QString( "  expression tree: %1 s, %2 M/s" )
+		.arg( tTree, 0, 'f', 3 ).arg( double( nEvals ) / std::max( tTree, 1.0e-9 ) / 1.0e6, 0, 'f', 2 ) << "\n";
+	out << QString( "  bytecode:        %1 s, %2 M/s (%3x)" )
+		.arg( tBytecode, 0, 'f', 3 ).arg( double( nEvals ) / std::max( tBytecode, 1.0e-9 ) / 1.0e6, 0, 'f', 2 )
+		.arg( tTree / std::max( tBytecode, 1.0e-9 ), 0, 'f', 2 ) << "\n";
+
+	return ( mismatches > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
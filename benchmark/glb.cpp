@@ -0,0 +1,238 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "lib/importex/gltf.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QtEndian>
+
+#include <cmath>
+#include <vector>
+
+#define TINYGLTF_NO_STB_IMAGE	1
+#define TINYGLTF_NO_STB_IMAGE_WRITE	1
+#include <tiny_gltf.h>
+
+
+//! @file benchmark/glb.cpp glTF binary export benchmark
+
+namespace Benchmark
+{
+
+//! Peak resident set size of the process in MB since the last resetPeakMemory(), or -1 if it is not available
+static double peakMemory()
+{
+#ifdef Q_OS_LINUX
+	QFile f( "/proc/self/status" );
+	if ( f.open( QIODevice::ReadOnly ) ) {
+		for ( const QByteArray & line : f.readAll().split( '\n' ) ) {
+			if ( line.startsWith( "VmHWM:" ) )
+				return line.mid( 6 ).trimmed().split( ' ' ).value( 0 ).toDouble() / 1024.0;
+		}
+	}
+#endif
+	return -1.0;
+}
+
+//! Resets the peak resident set size to the current one
+static void resetPeakMemory()
+{
+#ifdef Q_OS_LINUX
+	QFile f( "/proc/self/clear_refs" );
+	if ( f.open( QIODevice::WriteOnly ) )
+		f.write( "5" );
+#endif
+}
+
+//! Replaces \a data with the vertices and triangles of a generated grid, and adds its accessors and buffer views
+//! to \a model as if \a data was appended to the buffer at \a offset
+static void makeGltfTestMesh( tinygltf::Model & model, QByteArray & data, size_t offset, quint32 side, int meshNum )
+{
+	std::vector<float> positions;
+	std::vector<float> normals;
+	std::vector<float> coords;
+	for ( quint32 y = 0; y < side; y++ ) {
+		for ( quint32 x = 0; x < side; x++ ) {
+			float u = float( x ) / float( side - 1 );
+			float v = float( y ) / float( side - 1 );
+			positions.insert( positions.end(), { float( x ) * 0.1f, float( y ) * 0.1f, std::sin( u * 6.0f ) + float( meshNum ) } );
+			normals.insert( normals.end(), { 0.0f, 0.0f, 1.0f } );
+			coords.insert( coords.end(), { u, v } );
+		}
+	}
+	std::vector<quint32> indices = makeGridTriangles( side );
+
+	data.clear();
+	auto addAccessor = [&]( const void * p, size_t count, int componentType, int type, int target ) {
+		size_t n = count * size_t( tinygltf::GetComponentSizeInBytes( componentType ) * tinygltf::GetNumComponentsInType( type ) );
+		tinygltf::BufferView & view = model.bufferViews.emplace_back();
+		view.buffer = 0;
+		view.byteOffset = offset + size_t( data.size() );
+		view.byteLength = n;
+		view.target = target;
+		data.append( reinterpret_cast<const char *>( p ), qsizetype( n ) );
+
+		tinygltf::Accessor & acc = model.accessors.emplace_back();
+		acc.bufferView = int( model.bufferViews.size() - 1 );
+		acc.componentType = componentType;
+		acc.type = type;
+		acc.count = count;
+		return int( model.accessors.size() - 1 );
+	};
+
+	tinygltf::Primitive prim;
+	size_t numVerts = size_t( side ) * side;
+	prim.attributes["POSITION"] = addAccessor( positions.data(), numVerts, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, TINYGLTF_TARGET_ARRAY_BUFFER );
+	prim.attributes["NORMAL"] = addAccessor( normals.data(), numVerts, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, TINYGLTF_TARGET_ARRAY_BUFFER );
+	prim.attributes["TEXCOORD_0"] = addAccessor( coords.data(), numVerts, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC2, TINYGLTF_TARGET_ARRAY_BUFFER );
+	prim.indices = addAccessor( indices.data(), indices.size(), TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR,
+								TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER );
+	prim.mode = TINYGLTF_MODE_TRIANGLES;
+
+	tinygltf::Mesh & mesh = model.meshes.emplace_back();
+	mesh.name = QString( "grid%1" ).arg( meshNum ).toStdString();
+	mesh.primitives.push_back( prim );
+	model.nodes.emplace_back().mesh = int( model.meshes.size() - 1 );
+}
+
+//! Reads the JSON and BIN chunks of a .glb file
+static bool readGlbChunks( const QString & fileName, QJsonObject & json, QByteArray & bin )
+{
+	QFile f( fileName );
+	if ( !f.open( QIODevice::ReadOnly ) )
+		return false;
+	QByteArray d = f.readAll();
+	if ( d.size() < 20 || !d.startsWith( "glTF" ) || qFromLittleEndian<quint32>( d.constData() + 8 ) != quint32( d.size() ) )
+		return false;
+
+	for ( qsizetype offset = 12; ( offset + 8 ) <= d.size(); ) {
+		quint32 len = qFromLittleEndian<quint32>( d.constData() + offset );
+		quint32 type = qFromLittleEndian<quint32>( d.constData() + offset + 4 );
+		offset = offset + 8;
+		if ( qsizetype( len ) > ( d.size() - offset ) )
+			return false;
+		if ( type == 0x4E4F534A )
+			json = QJsonDocument::fromJson( d.mid( offset, len ) ).object();
+		else if ( type == 0x004E4942 )
+			bin = d.mid( offset, len );
+		offset = offset + qsizetype( len );
+	}
+	return !json.isEmpty();
+}
+
+int glbBenchmark( const QString & outputFolder, QTextStream & out )
+{
+	static const int numMeshes = 24;
+	static const quint32 side = 400;
+
+	QDir dir( ( !outputFolder.isEmpty() && QDir( outputFolder ).exists() ) ? outputFolder : QDir::tempPath() );
+	QString streamedName = dir.filePath( "glbtest_streamed.glb" );
+	QString referenceName = dir.filePath( "glbtest_tinygltf.glb" );
+	out << "glTF binary export benchmark: " << numMeshes << " grids of " << ( side * side ) << " vertices" << "\n";
+
+	// streamed, as exportGltf writes it
+	double tStreamed;
+	double peakStreamed;
+	bool okStreamed;
+	qint64 bufferSize;
+	{
+		resetPeakMemory();
+		double base = peakMemory();
+		QElapsedTimer timer;
+		timer.start();
+		tinygltf::Model model;
+		model.asset.version = "2.0";
+		GltfBinaryStream bin( dir.path() );
+		QByteArray data;
+		for ( int i = 0; i < numMeshes; i++ ) {
+			makeGltfTestMesh( model, data, size_t( bin.size() ), side, i );
+			bin.append( data.constData(), data.size() );
+		}
+		okStreamed = bin.isValid() && writeGltfStreamed( model, bin, streamedName, true );
+		bufferSize = bin.size();
+		tStreamed = secondsSince( timer );
+		peakStreamed = peakMemory() - base;
+	}
+
+	// the previous exporter: the buffer is built in a QByteArray and copied into the model
+	double tReference;
+	double peakReference;
+	bool okReference;
+	{
+		resetPeakMemory();
+		double base = peakMemory();
+		QElapsedTimer timer;
+		timer.start();
+		tinygltf::Model model;
+		model.asset.version = "2.0";
+		QByteArray buffer;
+		QByteArray data;
+		for ( int i = 0; i < numMeshes; i++ ) {
+			makeGltfTestMesh( model, data, size_t( buffer.size() ), side, i );
+			buffer.append( data );
+		}
+		model.buffers.emplace_back().data = std::vector<unsigned char>( buffer.cbegin(), buffer.cend() );
+		tinygltf::TinyGLTF writer;
+		okReference = writer.WriteGltfSceneToFile( &model, referenceName.toStdString(), false, false, false, true );
+		tReference = secondsSince( timer );
+		peakReference = peakMemory() - base;
+	}
+
+	QJsonObject jsonStreamed, jsonReference;
+	QByteArray binStreamed, binReference;
+	bool same = okStreamed && okReference && readGlbChunks( streamedName, jsonStreamed, binStreamed )
+				&& readGlbChunks( referenceName, jsonReference, binReference )
+				&& jsonStreamed == jsonReference && binStreamed == binReference;
+
+	auto peakString = []( double mb ) {
+		return ( mb < 0.0 ? QString( "n/a" ) : QString( "%1 MB" ).arg( mb, 0, 'f', 1 ) );
+	};
+	out << QString( "  buffer size: %1 MB" ).arg( double( bufferSize ) / 1048576.0, 0, 'f', 1 ) << "\n";
+	out << QString( "  GltfBinaryStream: %1 s, peak memory +%2%3" )
+		.arg( tStreamed, 0, 'f', 3 ).arg( peakString( peakStreamed ) ).arg( okStreamed ? "" : ", write failed" ) << "\n";
+	out << QString( "  tinygltf in memory: %1 s, peak memory +%2%3" )
+		.arg( tReference, 0, 'f', 3 ).arg( peakString( peakReference ) ).arg( okReference ? "" : ", write failed" ) << "\n";
+	out << ( same ? "  output identical" : "  output differs" ) << "\n";
+
+	QFile::remove( streamedName );
+	QFile::remove( referenceName );
+	return same ? 0 : 1;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,156 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "model/nifmodel.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+#include <utility>
+
+
+//! @file benchmark/links.cpp Link graph update benchmark
+
+namespace Benchmark
+{
+
+//! Appends the child link items under \a item to \a links
+static void collectLinks( NifItem * item, QVector<NifItem *> & links )
+{
+	for ( auto child : item->childIter() ) {
+		if ( child->isPacked() )
+			continue;
+		if ( child->childCount() > 0 )
+			collectLinks( child, links );
+		else if ( child->valueType() == NifValue::tLink && child->getLinkValue() >= 0 )
+			links.append( child );
+	}
+}
+
+//! Returns the child links, uplinks and parent of every block and the root links as a list of numbers
+static QVector<int> linkGraph( const NifModel & nif )
+{
+	QVector<int> graph;
+	for ( int b = 0; b < nif.getBlockCount(); b++ ) {
+		graph << nif.getChildLinks( b ) << -2 << nif.getParentLinks( b ) << -3 << nif.getParent( b ) << -4;
+	}
+	graph << nif.getRootLinks();
+	return graph;
+}
+
+int linksBenchmark( const QString & rootFolder, QTextStream & out )
+{
+	QList<SourceFile> files = readFiles( rootFolder );
+	if ( files.isEmpty() )
+		return noFiles( rootFolder, out );
+
+	double mb = megabytes( files );
+	out << QString( "Links benchmark: %1 files, %2 MB" ).arg( files.size() ).arg( mb, 0, 'f', 1 ) << "\n";
+
+	// Number of link edits per file
+	constexpr int maxEdits = 200;
+
+	NifModel nif;
+	BaseModel & model = nif;
+
+	double tFull = 0.0, tEdits = 0.0, tBlocks = 0.0;
+	qint64 numEdits = 0, numBlocks = 0;
+	int failed = 0;
+	int mismatches = 0;
+
+	for ( const SourceFile & f : files ) {
+		QBuffer in;
+		in.setData( f.data );
+		in.open( QIODevice::ReadOnly );
+		if ( !model.load( in, f.path.toStdString().c_str() ) ) {
+			failed++;
+			continue;
+		}
+
+		QVector<NifItem *> links;
+		for ( int b = 0; b < nif.getBlockCount(); b++ ) {
+			if ( auto block = nif.getBlockItem( b ) )
+				collectLinks( block, links );
+		}
+		if ( links.size() > maxEdits )
+			links.resize( maxEdits );
+
+		// A full rebuild for each edit, as every link change did before
+		QElapsedTimer timer;
+		timer.start();
+		for ( qsizetype i = 0; i < std::max<qsizetype>( links.size(), 1 ); i++ )
+			nif.mapLinks( QMap<qint32, qint32>() );
+		tFull += secondsSince( timer );
+		QVector<int> expected = linkGraph( nif );
+
+		// Clearing and restoring each link updates the links of its block only
+		timer.restart();
+		for ( NifItem * item : std::as_const( links ) ) {
+			qint32 l = item->getLinkValue();
+			nif.setLink( item, -1 );
+			nif.setLink( item, l );
+		}
+		tEdits += secondsSince( timer );
+		numEdits += links.size() * 2;
+
+		if ( linkGraph( nif ) != expected ) {
+			out << "  link graph differs after link edits: " << f.path << "\n";
+			mismatches++;
+			continue;
+		}
+
+		// Inserting and removing a block at the start renumbers every block
+		timer.restart();
+		nif.insertNiBlock( "NiNode", 0 );
+		nif.removeNiBlock( 0 );
+		tBlocks += secondsSince( timer );
+		numBlocks += 2;
+
+		if ( linkGraph( nif ) != expected ) {
+			out << "  link graph differs after inserting and removing a block: " << f.path << "\n";
+			mismatches++;
+		}
+	}
+
+	out << QString( "  full rebuild: %1 s" ).arg( tFull, 0, 'f', 3 ) << "\n";
+	out << QString( "  %1 link edits: %2 s" ).arg( numEdits ).arg( tEdits, 0, 'f', 3 ) << "\n";
+	out << QString( "  %1 block inserts and removals: %2 s" ).arg( numBlocks ).arg( tBlocks, 0, 'f', 3 ) << "\n";
+	out << QString( "  %1 failed, %2 link graph mismatches" ).arg( failed ).arg( mismatches ) << "\n";
+
+	return ( mismatches > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,123 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "model/nifmodel.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+
+
+//! @file benchmark/load.cpp NIF loading benchmark
+
+namespace Benchmark
+{
+
+double loadFiles( const QList<SourceFile> & files, const LoadSettings & settings, QList<QByteArray> & output, int & failed )
+{
+	NifModel nif;
+	nif.setBulkLoading( settings.bulk );
+	NifExpr::setBytecodeEnabled( settings.bytecode );
+	BaseModel & model = nif;
+
+	output.clear();
+	failed = 0;
+
+	double seconds = 0.0;
+	for ( const SourceFile & f : files ) {
+		QBuffer in;
+		in.setData( f.data );
+		in.open( QIODevice::ReadOnly );
+
+		QElapsedTimer timer;
+		timer.start();
+		bool ok = model.load( in, f.path.toStdString().c_str() );
+		seconds += secondsSince( timer );
+
+		QBuffer out;
+		out.open( QIODevice::WriteOnly );
+		if ( !ok || !model.save( out ) )
+			failed++;
+		output.append( out.data() );
+	}
+
+	NifExpr::setBytecodeEnabled( true );
+	return seconds;
+}
+
+int loadBenchmark( const QString & rootFolder, QTextStream & out )
+{
+	static const LoadSettings settings[] = {
+		{ "one value at a time", false, false },
+		{ "bulk arrays", true, false },
+		{ "bulk arrays, bytecode", true, true },
+	};
+
+	QList<SourceFile> files = readFiles( rootFolder );
+	if ( files.isEmpty() )
+		return noFiles( rootFolder, out );
+
+	double mb = megabytes( files );
+	out << QString( "Load benchmark: %1 files, %2 MB" ).arg( files.size() ).arg( mb, 0, 'f', 1 ) << "\n";
+
+	QList<QByteArray> reference, output;
+	double tReference = 0.0;
+	int mismatches = 0;
+
+	for ( const LoadSettings & ls : settings ) {
+		int failed = 0;
+		double t = loadFiles( files, ls, ( &ls == settings ) ? reference : output, failed );
+		if ( &ls == settings )
+			tReference = t;
+
+		out << QString( "  %1: %2 s, %3 MB/s, %4 failed (%5x)" )
+			.arg( QString( ls.name ), -22 ).arg( t, 0, 'f', 3 ).arg( mb / std::max( t, 1.0e-9 ), 0, 'f', 1 ).arg( failed )
+			.arg( tReference / std::max( t, 1.0e-9 ), 0, 'f', 2 ) << "\n";
+
+		if ( &ls == settings )
+			continue;
+		for ( qsizetype i = 0; i < files.size(); i++ ) {
+			if ( output.at( i ) != reference.at( i ) ) {
+				out << "  output differs (" << ls.name << "): " << files.at( i ).path << "\n";
+				mismatches++;
+			}
+		}
+	}
+
+	return ( mismatches > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,81 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+#include "gamemanager.h"
+#include "version.h"
+#include "model/nifmodel.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QTextStream>
+
+
+//! @file benchmark/main.cpp Entry point of the NifSkopeBenchmark command line tool
+
+//! Runs a benchmark: NifSkopeBenchmark <name> [root]
+int main( int argc, char * argv[] )
+{
+	QCoreApplication a( argc, argv );
+
+	// Same names as NifSkope so that the game paths and NIF settings are shared
+	a.setOrganizationName( "NifTools" );
+	a.setOrganizationDomain( "niftools.org" );
+	a.setApplicationName( "NifSkope " + NifSkopeVersion::rawToMajMin( NIFSKOPE_VERSION ) );
+	a.setApplicationVersion( NIFSKOPE_VERSION );
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription( "Runs a benchmark of the NifSkope core on the files under a folder." );
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addPositionalArgument( "name", "Benchmark to run (" + Benchmark::names().join( ", " ) + ")" );
+	parser.addPositionalArgument( "root", "Folder to process, including subfolders, or an archive for the mesh benchmark", "[root]" );
+
+	parser.process( a );
+
+	// the benchmarks on generated data and the self-checks need no root
+	const QStringList args = parser.positionalArguments();
+	if ( args.size() < 1 || args.size() > 2 )
+		parser.showHelp( 1 );
+
+	if ( !NifModel::loadXML() )
+		return 1;
+
+	// Init game manager
+	(void) Game::GameManager::get();
+
+	QTextStream out( stdout );
+	QString rootFolder = ( args.size() > 1 ) ? QDir::current().absoluteFilePath( args.at( 1 ) ) : QString();
+
+	return Benchmark::run( args.at( 0 ), rootFolder, out );
+}
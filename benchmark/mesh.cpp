@@ -0,0 +1,124 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "io/MeshFile.h"
+#include "ba2file.hpp"
+
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+//! @file benchmark/mesh.cpp Starfield .mesh decoding benchmark
+
+namespace Benchmark
+{
+
+static bool meshArchiveFilter( [[maybe_unused]] void * p, const std::string_view & s )
+{
+	return s.ends_with( ".mesh" );
+}
+
+static bool meshFileListScan( void * p, const BA2File::FileInfo & fd )
+{
+	reinterpret_cast< std::vector< std::string > * >( p )->emplace_back( fd.fileName );
+	return false;
+}
+
+int meshBenchmark( const QString & archivePath, QTextStream & out )
+{
+	BA2File	ba2;
+	try {
+		ba2.loadArchivePath( archivePath.toStdString().c_str(), &meshArchiveFilter );
+	} catch ( std::exception & e ) {
+		out << "Could not open " << archivePath << ": " << e.what() << "\n";
+		return 1;
+	}
+
+	std::vector< std::string >	names;
+	ba2.scanFileList( &meshFileListScan, &names );
+	if ( names.empty() ) {
+		out << "No .mesh files found in " << archivePath << "\n";
+		return 1;
+	}
+	std::sort( names.begin(), names.end() );
+
+	qint64 bytes = 0, nVerts = 0, nTris = 0;
+	double tExtract = 0.0, tDecode = 0.0;
+	int failed = 0;
+
+	BA2File::UCharArray	buf;
+	for ( const std::string & name : names ) {
+		QElapsedTimer timer;
+		timer.start();
+		const unsigned char *	dataPtr = nullptr;
+		size_t	dataSize = 0;
+		try {
+			dataSize = ba2.extractFile( dataPtr, buf, name );
+		} catch ( std::exception & ) {
+			failed++;
+			continue;
+		}
+		tExtract += secondsSince( timer );
+
+		timer.restart();
+		MeshFile	mesh( dataPtr, dataSize );
+		tDecode += secondsSince( timer );
+
+		bytes += qint64( dataSize );
+		if ( !mesh.isValid() ) {
+			failed++;
+			continue;
+		}
+		nVerts += mesh.positions.size();
+		nTris += mesh.triangles.size();
+		for ( const auto & lod : mesh.lods )
+			nTris += lod.size();
+	}
+
+	double mb = double( bytes ) / ( 1024.0 * 1024.0 );
+	out << QString( "Mesh benchmark: %1 files, %2 MB, %3 vertices, %4 triangles" )
+		.arg( names.size() ).arg( mb, 0, 'f', 1 ).arg( nVerts ).arg( nTris ) << "\n";
+	out << QString( "  extract: %1 s" ).arg( tExtract, 0, 'f', 3 ) << "\n";
+	out << QString( "  decode:  %1 s, %2 MB/s, %3 M vertices/s, %4 failed" )
+		.arg( tDecode, 0, 'f', 3 ).arg( mb / std::max( tDecode, 1.0e-9 ), 0, 'f', 1 )
+		.arg( double( nVerts ) / std::max( tDecode, 1.0e-9 ) / 1.0e6, 0, 'f', 2 ).arg( failed ) << "\n";
+
+	return ( failed > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,156 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "data/niftypes.h"
+#include "lib/spatialhash.h"
+
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+//! @file benchmark/normals.cpp Smooth Normals and Remove Duplicate Vertices benchmark
+
+namespace Benchmark
+{
+
+/*! A wavy grid with a seam: every fourth vertex has a duplicate with the same position
+ *
+ * The first vertex of each pair is appended to \a duplicates if the duplicate has the same normal,
+ * or to \a seams if its normal differs by 90 degrees.
+ */
+static void makeTestMesh( int numVerts, QVector<Vector3> & verts, QVector<Vector3> & norms, QVector<int> & duplicates, QVector<int> & seams )
+{
+	std::mt19937 rng( 12345 );
+	std::uniform_real_distribution<float> noise( -0.1f, 0.1f );
+	int side = std::max( int( std::sqrt( double( numVerts ) * 0.8 ) ), 1 );
+	verts.clear();
+	norms.clear();
+	duplicates.clear();
+	seams.clear();
+	for ( int i = 0; verts.size() < numVerts; i++ ) {
+		float x = float( i % side ) * 0.01f;
+		float y = float( i / side ) * 0.01f;
+		Vector3 v( x, y, 0.05f * std::sin( x * 3.0f ) * std::cos( y * 2.0f ) );
+		Vector3 n( noise( rng ), noise( rng ), 1.0f );
+		verts.append( v );
+		norms.append( n );
+		if ( ( i & 3 ) == 0 && verts.size() < numVerts ) {
+			( ( i & 4 ) ? duplicates : seams ).append( int( verts.size() - 1 ) );
+			verts.append( v );
+			norms.append( ( i & 4 ) ? n : Vector3( 1.0f, noise( rng ), noise( rng ) ) );
+		}
+	}
+}
+
+//! Counts the smoothed normals that are not unit length, the duplicates that were not smoothed alike
+//! and the seams that were
+static int checkSmoothNormals( const QVector<Vector3> & snorms, int numVerts, const QVector<int> & duplicates, const QVector<int> & seams )
+{
+	int errors = 0;
+	for ( int i = 0; i < numVerts; i++ ) {
+		if ( std::fabs( snorms[i].length() - 1.0f ) > 1.0e-4f )
+			errors++;
+	}
+	for ( int i : duplicates ) {
+		if ( ( snorms[i] - snorms[i + 1] ).length() > 1.0e-5f )
+			errors++;
+	}
+	for ( int i : seams ) {
+		if ( Vector3::dotproduct( snorms[i], snorms[i + 1] ) > 0.5f )
+			errors++;
+	}
+
+	return errors;
+}
+
+int normalsBenchmark( [[maybe_unused]] const QString & rootFolder, QTextStream & out )
+{
+	static const int sizes[] = { 10000, 100000, 1000000 };
+	const float maxa = float( std::cos( deg2radd( 60.0 ) ) );
+	const float maxd = 0.015f * 0.015f;
+	int mismatches = 0;
+
+	out << "Normals benchmark: smoothVertexNormals and findDuplicateVertices" << "\n";
+
+	for ( int numVerts : sizes ) {
+		QVector<Vector3> verts, norms;
+		QVector<int> duplicates, seams;
+		makeTestMesh( numVerts, verts, norms, duplicates, seams );
+		// smoothVertexNormals reads four floats at a time
+		verts += Vector3();
+		norms += Vector3();
+
+		QVector<Vector3> snorms( norms );
+		QElapsedTimer timer;
+		timer.start();
+		smoothVertexNormals( &( snorms[0][0] ), sizeof( Vector3 ), &( norms[0][0] ), &( verts.constFirst()[0] ), size_t( numVerts ), maxa, maxd );
+		double t = secondsSince( timer );
+
+		int errors = checkSmoothNormals( snorms, numVerts, duplicates, seams );
+		mismatches += errors;
+		out << QString( "  smooth normals, %1 vertices: %2 s, %3 M vertices/s%4" )
+			.arg( numVerts ).arg( t, 0, 'f', 3 ).arg( double( numVerts ) / std::max( t, 1.0e-9 ) / 1.0e6, 0, 'f', 2 )
+			.arg( errors ? QString( ", %1 errors" ).arg( errors ) : QString() ) << "\n";
+
+		verts.removeLast();
+		norms.removeLast();
+
+		// Only the pairs with the same normal are duplicates, the later vertex of each pair is the match
+		std::vector<int> expected( size_t( numVerts ), -1 );
+		for ( int i : duplicates )
+			expected[size_t( i )] = i + 1;
+
+		timer.restart();
+		const QVector<Vector3> & cnorms = norms;
+		std::vector<int> dup = findDuplicateVertices( &( verts.constFirst()[0] ), sizeof( Vector3 ) / sizeof( float ), size_t( numVerts ),
+													  [&cnorms]( int a, int b ) { return cnorms[a] == cnorms[b]; } );
+		t = secondsSince( timer );
+
+		bool same = ( dup == expected );
+		if ( !same )
+			mismatches++;
+		out << QString( "  duplicate vertices, %1 vertices: %2 s, %3 M vertices/s%4" )
+			.arg( numVerts ).arg( t, 0, 'f', 3 ).arg( double( numVerts ) / std::max( t, 1.0e-9 ) / 1.0e6, 0, 'f', 2 )
+			.arg( same ? "" : ", wrong duplicates" ) << "\n";
+	}
+
+	return ( mismatches > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,139 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "model/nifmodel.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+
+
+//! @file benchmark/save.cpp NIF saving benchmark
+
+namespace Benchmark
+{
+
+int saveBenchmark( const QString & rootFolder, QTextStream & out )
+{
+	QList<SourceFile> files = readFiles( rootFolder );
+	if ( files.isEmpty() )
+		return noFiles( rootFolder, out );
+
+	double mb = megabytes( files );
+	out << QString( "Save benchmark: %1 files, %2 MB" ).arg( files.size() ).arg( mb, 0, 'f', 1 ) << "\n";
+
+	NifModel nif;
+	BaseModel & model = nif;
+	QString tmpFile = QDir( QDir::tempPath() ).filePath( "nifskope_save_benchmark.nif" );
+
+	double tSizes = 0.0, tMemory = 0.0, tFile = 0.0;
+	double mbOutput = 0.0;
+	int failed = 0;
+	int sizeMismatches = 0;
+	int outputMismatches = 0;
+
+	for ( const SourceFile & f : files ) {
+		QBuffer in;
+		in.setData( f.data );
+		in.open( QIODevice::ReadOnly );
+		if ( !model.load( in, f.path.toStdString().c_str() ) ) {
+			failed++;
+			continue;
+		}
+
+		// The pass over all blocks that save() made through updateHeader() before writing them
+		QElapsedTimer timer;
+		timer.start();
+		QVector<int> sizes;
+		for ( int b = 0; b < nif.getBlockCount(); b++ )
+			sizes.append( nif.blockSize( nif.getBlockItem( b ) ) );
+		tSizes += secondsSince( timer );
+
+		QBuffer buf;
+		buf.open( QIODevice::WriteOnly );
+		timer.restart();
+		bool ok = model.save( buf );
+		tMemory += secondsSince( timer );
+
+		timer.restart();
+		ok = model.saveToFile( tmpFile ) && ok;
+		tFile += secondsSince( timer );
+		if ( !ok ) {
+			failed++;
+			continue;
+		}
+		mbOutput += double( buf.data().size() ) / ( 1024.0 * 1024.0 );
+
+		// The sizes recorded while writing must match the calculated ones
+		if ( nif.getVersionNumber() >= 0x14020000 && nif.getArray<int>( nif.getHeaderItem(), "Block Size" ) != sizes ) {
+			out << "  block sizes differ: " << f.path << "\n";
+			sizeMismatches++;
+		}
+
+		QFile saved( tmpFile );
+		if ( !saved.open( QIODevice::ReadOnly ) || saved.readAll() != buf.data() ) {
+			out << "  saved file differs from the output in memory: " << f.path << "\n";
+			outputMismatches++;
+			continue;
+		}
+
+		// Saving the reloaded output must give the same data
+		QBuffer reloaded;
+		reloaded.setData( buf.data() );
+		reloaded.open( QIODevice::ReadOnly );
+		QBuffer buf2;
+		buf2.open( QIODevice::WriteOnly );
+		if ( !model.load( reloaded, f.path.toStdString().c_str() ) || !model.save( buf2 ) || buf2.data() != buf.data() ) {
+			out << "  output changes when saved again: " << f.path << "\n";
+			outputMismatches++;
+		}
+	}
+	QFile::remove( tmpFile );
+
+	out << QString( "  block size pass (no longer needed): %1 s" ).arg( tSizes, 0, 'f', 3 ) << "\n";
+	out << QString( "  save to memory: %1 s, %2 MB/s" ).arg( tMemory, 0, 'f', 3 )
+		.arg( mbOutput / std::max( tMemory, 1.0e-9 ), 0, 'f', 1 ) << "\n";
+	out << QString( "  save to file: %1 s, %2 MB/s" ).arg( tFile, 0, 'f', 3 )
+		.arg( mbOutput / std::max( tFile, 1.0e-9 ), 0, 'f', 1 ) << "\n";
+	out << QString( "  %1 failed, %2 block size mismatches, %3 output mismatches" )
+		.arg( failed ).arg( sizeMismatches ).arg( outputMismatches ) << "\n";
+
+	return ( sizeMismatches > 0 || outputMismatches > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,123 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "model/nifmodel.h"
+
+#include <QBuffer>
+#include <QTextStream>
+
+#include <algorithm>
+
+
+//! @file benchmark/schema.cpp Schema loading benchmark
+
+namespace Benchmark
+{
+
+//! Saves a model with one block of every type inserted, and every file loaded with the current schema
+static QList<QByteArray> schemaOutput( const QList<SourceFile> & files )
+{
+	QList<QByteArray> output;
+
+	NifModel nif;
+	BaseModel & model = nif;
+	QStringList blockTypes = NifModel::allNiBlocks();
+	blockTypes.sort();
+	for ( const QString & type : blockTypes )
+		nif.insertNiBlock( type );
+
+	QBuffer buf;
+	buf.open( QIODevice::WriteOnly );
+	model.save( buf );
+	output.append( buf.data() );
+
+	int failed = 0;
+	QList<QByteArray> fileOutput;
+	loadFiles( files, { "", true, true }, fileOutput, failed );
+	output.append( fileOutput );
+
+	return output;
+}
+
+int schemaBenchmark( const QString & rootFolder, QTextStream & out )
+{
+	constexpr int iterations = 5;
+	QList<SourceFile> files = readFiles( rootFolder );
+	out << QString( "Schema benchmark: %1 iterations, %2 files to compare" ).arg( iterations ).arg( files.size() ) << "\n";
+
+	double tParse = 1.0e9;
+	for ( int i = 0; i < iterations; i++ ) {
+		if ( !NifModel::loadXML( false ) )
+			return 1;
+		tParse = std::min( tParse, NifModel::lastXmlLoadTime() );
+	}
+	QList<QByteArray> reference = schemaOutput( files );
+
+	// The first load writes the cache if it is missing or stale
+	(void) NifModel::loadXML( true );
+
+	double tCache = 1.0e9;
+	bool fromCache = true;
+	for ( int i = 0; i < iterations; i++ ) {
+		if ( !NifModel::loadXML( true ) )
+			return 1;
+		tCache = std::min( tCache, NifModel::lastXmlLoadTime() );
+		fromCache = fromCache && NifModel::lastXmlLoadFromCache();
+	}
+	QList<QByteArray> output = schemaOutput( files );
+
+	out << QString( "  %1: %2 ms" ).arg( "XML parser", -14 ).arg( tParse, 0, 'f', 2 ) << "\n";
+	out << QString( "  %1: %2 ms (%3x)" ).arg( "schema cache", -14 ).arg( tCache, 0, 'f', 2 )
+		.arg( tParse / std::max( tCache, 1.0e-6 ), 0, 'f', 2 ) << "\n";
+
+	int mismatches = 0;
+	if ( !fromCache ) {
+		out << "  the schema cache was not used\n";
+		mismatches++;
+	}
+	if ( output.value( 0 ) != reference.value( 0 ) ) {
+		out << "  inserted blocks differ\n";
+		mismatches++;
+	}
+	for ( qsizetype i = 1; i < reference.size(); i++ ) {
+		if ( output.value( i ) != reference.at( i ) ) {
+			out << "  output differs: " << files.at( i - 1 ).path << "\n";
+			mismatches++;
+		}
+	}
+
+	return ( mismatches > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
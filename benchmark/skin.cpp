@@ -0,0 +1,150 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "gl/glskin.h"
+#include "gl/gltools.h"
+
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+
+//! @file benchmark/skin.cpp Skinning benchmark
+
+namespace Benchmark
+{
+
+int skinBenchmark( [[maybe_unused]] const QString & rootFolder, QTextStream & out )
+{
+	const int numVerts = 30000;
+	const int numBones = 64;
+	const int numFrames = 120;
+
+	std::mt19937 rng( 12345 );
+	std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+
+	// a tube along the bone chain, each vertex weighted to up to 4 neighbouring bones
+	QVector<Vector3> verts( numVerts ), norms( numVerts ), tangents( numVerts ), bitangents( numVerts );
+	QVector<BoneWeights> weights( numBones );
+	for ( int v = 0; v < numVerts; v++ ) {
+		float a = unit( rng ) * 6.2831853f;
+		float z = unit( rng ) * float( numBones );
+		verts[v] = Vector3( std::cos( a ), std::sin( a ), z );
+		norms[v] = Vector3( std::cos( a ), std::sin( a ), 0.0f );
+		tangents[v] = Vector3( -std::sin( a ), std::cos( a ), 0.0f );
+		bitangents[v] = Vector3( 0.0f, 0.0f, 1.0f );
+
+		int b0 = std::clamp( int( z ) - 1, 0, numBones - 4 );
+		float w[4], wSum = 0.0f;
+		for ( int i = 0; i < 4; i++ ) {
+			w[i] = 1.0f / ( 0.5f + std::fabs( z - float( b0 + i ) - 0.5f ) );
+			wSum += w[i];
+		}
+		for ( int i = 0; i < 4; i++ )
+			weights[b0 + i].weights.append( VertexWeight( v, w[i] / wSum ) );
+	}
+
+	// recorded frames: the chain bends with a different phase per bone
+	QVector<QVector<Transform>> frames( numFrames );
+	for ( int f = 0; f < numFrames; f++ ) {
+		Transform parent;
+		frames[f].resize( numBones );
+		for ( int b = 0; b < numBones; b++ ) {
+			Transform local;
+			local.translation = Vector3( 0.0f, 0.0f, b > 0 ? 1.0f : 0.0f );
+			local.rotation.fromEuler( 0.05f * std::sin( float( f ) * 0.1f + float( b ) * 0.3f ), 0.03f * std::cos( float( f ) * 0.07f + float( b ) ), 0.0f );
+			parent = parent * local;
+			Transform bind;
+			bind.translation = Vector3( 0.0f, 0.0f, -float( b ) );
+			frames[f][b] = parent * bind;
+		}
+	}
+
+	out << QString( "Skinning benchmark: %1 vertices, %2 bones, %3 frames" ).arg( numVerts ).arg( numBones ).arg( numFrames ) << "\n";
+
+	SkinEngine skin;
+	skin.setInfluences( weights, numVerts );
+	skin.setBoneCount( numBones );
+
+	QVector<Vector3> outVerts, outNorms, outTangents, outBitangents;
+	float maxError = 0.0f;
+
+	// in the bind pose the weights sum to one, so the mesh must not move
+	for ( int b = 0; b < numBones; b++ )
+		skin.setBone( b, Transform() );
+	skin.skin( verts, norms, tangents, bitangents, outVerts, outNorms, outTangents, outBitangents );
+	for ( int v = 0; v < numVerts; v++ ) {
+		maxError = std::max( maxError, ( outVerts.at( v ) - verts.at( v ) ).length() );
+		maxError = std::max( maxError, ( outNorms.at( v ) - norms.at( v ) ).length() );
+	}
+
+	QVector<Vector3> singleVerts, singleNorms;
+	double times[2];
+	QElapsedTimer timer;
+	qsizetype threshold = SkinEngine::parallelThreshold;
+	for ( int pass = 0; pass < 2; pass++ ) {
+		SkinEngine::parallelThreshold = ( pass == 0 ? numVerts + 1 : threshold );
+		timer.start();
+		for ( const auto & frame : frames ) {
+			for ( int b = 0; b < numBones; b++ )
+				skin.setBone( b, frame.at( b ) );
+			skin.skin( verts, norms, tangents, bitangents, outVerts, outNorms, outTangents, outBitangents );
+		}
+		times[pass] = secondsSince( timer );
+		if ( pass == 0 ) {
+			singleVerts = outVerts;
+			singleNorms = outNorms;
+		}
+	}
+	SkinEngine::parallelThreshold = threshold;
+
+	// the last frame of both passes
+	for ( int v = 0; v < numVerts; v++ ) {
+		maxError = std::max( maxError, ( outVerts.at( v ) - singleVerts.at( v ) ).length() );
+		maxError = std::max( maxError, ( outNorms.at( v ) - singleNorms.at( v ) ).length() );
+	}
+	bool same = ( maxError < 1.0e-4f );
+
+	out << QString( "  SkinEngine, 1 thread: %1 ms/frame" ).arg( times[0] * 1000.0 / numFrames, 0, 'f', 3 ) << "\n";
+	out << QString( "  SkinEngine, threaded: %1 ms/frame (%2x)" ).arg( times[1] * 1000.0 / numFrames, 0, 'f', 3 )
+		.arg( times[0] / std::max( times[1], 1.0e-9 ), 0, 'f', 1 ) << "\n";
+	out << QString( "  max difference: %1%2" ).arg( maxError ).arg( same ? "" : ", output differs" ) << "\n";
+
+	return same ? 0 : 1;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,224 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "lib/skinpartition.h"
+
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+
+//! @file benchmark/skinpart.cpp Skin partition benchmark
+
+namespace Benchmark
+{
+
+/*! A tube of rings x segments vertices with a seam of duplicated vertices,
+ *  bones in bands along the tube and four sectors around it, six influences per vertex
+ */
+static void makeSkinnedTube( int rings, int segments, int bands, QVector<Vector3> & verts, QVector<Triangle> & tris,
+							 QVector<SkinPartitioner::VertexWeight> & weights )
+{
+	int cols = segments + 1;
+	verts.clear();
+	tris.clear();
+	weights.clear();
+
+	// one list per vertex in bone order
+	QVector<QList<QPair<int, float>>> influences;
+
+	for ( int r = 0; r < rings; r++ ) {
+		float band = float( r ) * float( bands - 1 ) / float( std::max( rings - 1, 1 ) );
+		for ( int s = 0; s < cols; s++ ) {
+			float a = float( s % segments ) / float( segments ) * 6.2831853f;
+			verts.append( Vector3( std::cos( a ), std::sin( a ), float( r ) * 0.1f ) );
+
+			float sector = float( s % segments ) / float( segments ) * 4.0f;
+			QList<QPair<int, float>> list;
+			int b0 = std::clamp( int( band ) - 1, 0, std::max( bands - 3, 0 ) );
+			for ( int b = b0; b < b0 + 3 && b < bands; b++ ) {
+				for ( int k = 0; k < 2; k++ ) {
+					int sec = ( int( sector ) + k ) % 4;
+					float w = 1.0f / ( 0.5f + std::fabs( band - float( b ) ) ) * ( k == 0 ? 1.0f - ( sector - std::floor( sector ) ) * 0.5f : 0.5f );
+					list.append( { b * 4 + sec, w } );
+				}
+			}
+			std::sort( list.begin(), list.end() );
+			float sum = 0.0f;
+			for ( const auto & bw : list )
+				sum += bw.second;
+			for ( auto & bw : list )
+				bw.second /= sum;
+			influences.append( list );
+		}
+	}
+
+	for ( int r = 0; r + 1 < rings; r++ ) {
+		for ( int s = 0; s < segments; s++ ) {
+			quint16 v = quint16( r * cols + s );
+			tris.append( Triangle( v, v + 1, v + cols ) );
+			tris.append( Triangle( v + 1, v + cols + 1, v + cols ) );
+		}
+	}
+
+	// NiSkinData lists the weights per bone
+	int numBones = bands * 4;
+	QVector<QVector<SkinPartitioner::VertexWeight>> perBone( numBones );
+	for ( int v = 0; v < influences.size(); v++ ) {
+		for ( const auto & bw : influences.at( v ) )
+			perBone[bw.first].append( { v, bw.first, bw.second } );
+	}
+	for ( const auto & list : perBone )
+		weights += list;
+}
+
+/*! Checks that every triangle is in exactly one partition, that no partition has too many bones
+ *  and that the partition of a triangle has all the bones of its vertices
+ */
+static bool checkPartitions( const SkinPartitioner & sp, const QVector<Triangle> & tris, int maxBonesPerPartition )
+{
+	auto key = []( const Triangle & t ) { return quint64( t[0] ) | ( quint64( t[1] ) << 16 ) | ( quint64( t[2] ) << 32 ); };
+
+	std::vector<quint64> expected, found;
+	for ( const Triangle & t : tris )
+		expected.push_back( key( t ) );
+
+	for ( const SkinPartitioner::Partition & part : sp.partitions() ) {
+		if ( part.bones.count() > maxBonesPerPartition )
+			return false;
+		for ( const Triangle & t : part.triangles ) {
+			found.push_back( key( t ) );
+			for ( int c = 0; c < 3; c++ ) {
+				for ( int i = 0; i < sp.influenceCount( t[c] ); i++ ) {
+					if ( !part.bones.contains( sp.influenceBone( t[c], i ) ) )
+						return false;
+				}
+			}
+		}
+	}
+
+	std::sort( expected.begin(), expected.end() );
+	std::sort( found.begin(), found.end() );
+	return ( expected == found );
+}
+
+int skinPartitionBenchmark( [[maybe_unused]] const QString & rootFolder, QTextStream & out )
+{
+	struct Case
+	{
+		int rings, segments, bands, maxBonesPerPartition;
+	};
+	static const Case cases[] = {
+		{ 20, 24, 6, 4 },
+		{ 100, 100, 30, 24 },
+		{ 150, 120, 50, 60 },
+	};
+	const int maxBonesPerVertex = 4;
+
+	int failures = 0;
+	out << "Skin partition benchmark: SkinPartitioner, 6 influences reduced to 4" << "\n";
+
+	// copies of every input for the runs over all shapes
+	std::vector<std::unique_ptr<SkinPartitioner>> serial, parallel;
+	QVector<QVector<Triangle>> shapeTris;
+
+	for ( const Case & c : cases ) {
+		QVector<Vector3> verts;
+		QVector<Triangle> tris;
+		QVector<SkinPartitioner::VertexWeight> weights;
+		makeSkinnedTube( c.rings, c.segments, c.bands, verts, tris, weights );
+
+		auto sp = std::make_unique<SkinPartitioner>();
+		QElapsedTimer timer;
+		timer.start();
+		sp->setWeights( verts.size(), weights );
+		sp->setVertices( verts );
+		sp->setTriangles( tris );
+		bool ok = sp->run( c.maxBonesPerPartition, maxBonesPerVertex );
+		double tNew = secondsSince( timer );
+
+		for ( auto * list : { &serial, &parallel } ) {
+			auto copy = std::make_unique<SkinPartitioner>();
+			copy->setWeights( verts.size(), weights );
+			copy->setVertices( verts );
+			copy->setTriangles( tris );
+			list->push_back( std::move( copy ) );
+		}
+		shapeTris.append( tris );
+
+		bool valid = ok && checkPartitions( *sp, tris, c.maxBonesPerPartition );
+		if ( !valid )
+			failures++;
+
+		out << QString( "  %1 vertices, %2 triangles, %3 bones per partition: %4 s, %5 partitions%6" )
+			.arg( verts.size() ).arg( tris.size() ).arg( c.maxBonesPerPartition ).arg( tNew, 0, 'f', 3 )
+			.arg( sp->partitions().size() ).arg( valid ? "" : ", invalid partitions" ) << "\n";
+	}
+
+	// all shapes at once, as "Make All Skin Partitions" runs them with the settings of one dialog
+	const int maxBonesPerPartition = 60;
+	QElapsedTimer timer;
+	timer.start();
+	for ( const auto & sp : serial )
+		sp->run( maxBonesPerPartition, maxBonesPerVertex );
+	double tSerial = secondsSince( timer );
+
+	QVector<SkinPartitioner *> partitioners;
+	for ( const auto & sp : parallel )
+		partitioners.append( sp.get() );
+
+	timer.restart();
+	SkinPartitioner::run( partitioners, maxBonesPerPartition, maxBonesPerVertex );
+	double tParallel = secondsSince( timer );
+
+	// the worker threads must produce the same partitions as the serial runs
+	bool same = true;
+	for ( size_t i = 0; i < serial.size(); i++ ) {
+		same = same && checkPartitions( *parallel[i], shapeTris.at( int( i ) ), maxBonesPerPartition )
+			&& parallel[i]->partitions().size() == serial[i]->partitions().size();
+	}
+	if ( !same )
+		failures++;
+
+	out << QString( "  all shapes, one after the other: %1 s, on worker threads: %2 s%3" )
+		.arg( tSerial, 0, 'f', 3 ).arg( tParallel, 0, 'f', 3 ).arg( same ? "" : ", output differs" ) << "\n";
+
+	return ( failures > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,141 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "model/nifmodel.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVariant>
+
+#include <algorithm>
+#include <utility>
+
+
+//! @file benchmark/values.cpp NifValue storage benchmark
+
+namespace Benchmark
+{
+
+//! Appends copies of the values of the items under \a item to \a values, skipping the elements of packed arrays
+static void collectValues( const NifItem * item, QVector<NifValue> & values )
+{
+	for ( auto child : item->childIter() ) {
+		values.append( child->value() );
+		if ( !child->isPacked() )
+			collectValues( child, values );
+	}
+}
+
+int valuesBenchmark( const QString & rootFolder, QTextStream & out )
+{
+	QList<SourceFile> files = readFiles( rootFolder );
+	if ( files.isEmpty() )
+		return noFiles( rootFolder, out );
+
+	double mb = megabytes( files );
+	out << QString( "Value benchmark: %1 files, %2 MB" ).arg( files.size() ).arg( mb, 0, 'f', 1 ) << "\n";
+
+	NifModel nif;
+	BaseModel & model = nif;
+
+	double tLoad = 0.0, tCopy = 0.0, tMove = 0.0, tVariant = 0.0;
+	qint64 numValues = 0, numInline = 0, numHeap = 0;
+	int failed = 0;
+	int mismatches = 0;
+
+	QVector<NifValue> values, copies, moved;
+	for ( const SourceFile & f : files ) {
+		QBuffer in;
+		in.setData( f.data );
+		in.open( QIODevice::ReadOnly );
+
+		QElapsedTimer timer;
+		timer.start();
+		bool ok = model.load( in, f.path.toStdString().c_str() );
+		tLoad += secondsSince( timer );
+		if ( !ok ) {
+			failed++;
+			continue;
+		}
+
+		values.clear();
+		collectValues( nif.getHeaderItem(), values );
+		for ( int b = 0; b < nif.getBlockCount(); b++ ) {
+			if ( auto block = nif.getBlockItem( b ) )
+				collectValues( block, values );
+		}
+		for ( const NifValue & v : values ) {
+			if ( NifValue::isInlineType( v.type() ) )
+				numInline++;
+			else if ( v.isString() || v.isMatrix() || v.isMatrix4() || v.isByteArray() || v.isByteMatrix() )
+				numHeap++;
+		}
+		numValues += values.size();
+
+		// Copies as made by toVariant() and the undo commands
+		timer.restart();
+		copies = values;
+		copies.detach();
+		tCopy += secondsSince( timer );
+
+		timer.restart();
+		for ( const NifValue & v : values ) {
+			QVariant var = QVariant::fromValue( v );
+			if ( !( var.value<NifValue>() == v ) )
+				mismatches++;
+		}
+		tVariant += secondsSince( timer );
+
+		timer.restart();
+		moved.clear();
+		moved.reserve( copies.size() );
+		for ( NifValue & v : copies )
+			moved.append( std::move( v ) );
+		tMove += secondsSince( timer );
+		if ( moved != values )
+			mismatches++;
+	}
+
+	out << QString( "  load: %1 s, %2 MB/s, %3 failed" ).arg( tLoad, 0, 'f', 3 )
+		.arg( mb / std::max( tLoad, 1.0e-9 ), 0, 'f', 1 ).arg( failed ) << "\n";
+	out << QString( "  values: %1, %2 stored inline (one heap allocation each before), %3 with heap data" )
+		.arg( numValues ).arg( numInline ).arg( numHeap ) << "\n";
+	out << QString( "  copy: %1 s, QVariant round trip: %2 s, move: %3 s, %4 mismatches" )
+		.arg( tCopy, 0, 'f', 3 ).arg( tVariant, 0, 'f', 3 ).arg( tMove, 0, 'f', 3 ).arg( mismatches ) << "\n";
+
+	return ( mismatches > 0 ) ? 1 : 0;
+}
+
+} // namespace Benchmark
@@ -0,0 +1,217 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "batchprocessor.h"
+
+#include "message.h"
+#include "spellbook.h"
+#include "model/nifmodel.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QReadWriteLock>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+
+
+//! @file batchprocessor.cpp BatchProcessor implementation
+
+BatchProcessor::BatchProcessor( Spell * s, const QString & rootFolder ) : spell( s ), rootDir( rootFolder )
+{
+}
+
+bool BatchProcessor::run()
+{
+	fileResults.clear();
+	numProcessed = numSaved = numFailed = numReadOnly = 0;
+	numThreads = 1;
+	elapsedTime = 0.0;
+
+	if ( !spell || !rootDir.exists() )
+		return false;
+
+	startTime = QDateTime::currentDateTime();
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QStringList files;
+	QDirIterator it( rootDir.absolutePath(), QDir::Files, QDirIterator::Subdirectories );
+	while ( it.hasNext() ) {
+		QString filePath = it.next();
+		if ( filePath.endsWith( ".nif", Qt::CaseInsensitive ) )
+			files.append( filePath );
+	}
+	// Directory iteration order depends on the file system
+	files.sort();
+
+	fileResults.resize( files.size() );
+
+	if ( spell->reentrant() ) {
+		numThreads = ( threadCount > 0 ) ? threadCount : QThread::idealThreadCount();
+		numThreads = int( std::clamp< qsizetype >( files.size(), 1, std::max( numThreads, 1 ) ) );
+	}
+
+	// Workers take the next file from a shared counter and store its result at the same index
+	Result * results = fileResults.data();
+	std::atomic< qsizetype > nextFile( 0 );
+
+	auto worker = [this, &files, results, &nextFile]() {
+		// The schema is shared read-only by all workers
+		QReadLocker lck( &NifModel::XMLlock );
+
+		// A model without views, reused for every file of this worker
+		NifModel nif;
+
+		for ( qsizetype i = nextFile++; i < files.size(); i = nextFile++ )
+			results[i] = processFile( nif, files.at( i ) );
+	};
+
+	if ( numThreads > 1 ) {
+		QList<QThread *> threads;
+		for ( int i = 0; i < numThreads; i++ ) {
+			QThread * thread = QThread::create( worker );
+			thread->start();
+			threads.append( thread );
+		}
+
+		for ( QThread * thread : threads ) {
+			thread->wait();
+			delete thread;
+		}
+	} else {
+		worker();
+	}
+
+	for ( const Result & r : fileResults ) {
+		if ( r.readOnly )
+			numReadOnly++;
+		else
+			numProcessed++;
+		if ( r.failed )
+			numFailed++;
+		if ( r.saved )
+			numSaved++;
+	}
+
+	elapsedTime = double( timer.nsecsElapsed() ) / 1.0e9;
+	return true;
+}
+
+BatchProcessor::Result BatchProcessor::processFile( NifModel & nif, const QString & filePath ) const
+{
+	Result r;
+	r.fileName = rootDir.relativeFilePath( filePath );
+
+	// NifModel::save does not report an error when the file cannot be written
+	if ( !spell->constant() && !QFileInfo( filePath ).isWritable() ) {
+		qWarning() << "Skipping read-only file:" << filePath;
+		r.readOnly = true;
+		return r;
+	}
+
+	// Messages of the spell and the model go to the log of this file
+	MessageSink sink( r.log );
+
+	if ( !nif.loadFromFile( filePath ) ) {
+		r.log << tr( "ERROR: failed to load file" );
+		r.failed = true;
+		return r;
+	}
+
+	bool noSignals = spell->batch();
+	if ( noSignals )
+		nif.setState( BaseModel::Processing );
+	bool modified = spell->castBatch( &nif, r.log );
+	if ( noSignals )
+		nif.resetState();
+
+	if ( !modified )
+		return r;
+
+	// Refresh the header, as SpellBook::cast does
+	nif.invalidateHeaderConditions();
+	nif.updateHeader();
+
+	if ( !nif.saveToFile( filePath ) ) {
+		r.log << tr( "ERROR: failed to save file" );
+		r.failed = true;
+		return r;
+	}
+
+	r.saved = true;
+	return r;
+}
+
+bool BatchProcessor::writeLog( const QString & logFileName ) const
+{
+	QFile logFile( logFileName );
+	if ( !logFile.open( QIODevice::WriteOnly | QIODevice::Text ) )
+		return false;
+
+	QTextStream logStream( &logFile );
+	logStream << "Spell Name: " << ( spell ? spell->name() : QString() ) << "\n";
+	logStream << "Date and Time: " << startTime.toString( "yyyy-MM-dd hh:mm:ss" ) << "\n";
+
+	for ( const Result & r : fileResults ) {
+		if ( r.readOnly )
+			continue;
+
+		logStream << "File: " << r.fileName << "\n";
+		for ( const QString & line : r.log )
+			logStream << line << "\n";
+	}
+
+	return true;
+}
+
+double BatchProcessor::filesPerSecond() const
+{
+	if ( elapsedTime <= 0.0 )
+		return 0.0;
+
+	return double( numProcessed ) / elapsedTime;
+}
+
+QString BatchProcessor::summary() const
+{
+	return tr( "Files processed: %1, saved: %2, failed: %3, read-only skipped: %4 in %5 s (%6 files/s, %7 threads)" )
+		.arg( numProcessed ).arg( numSaved ).arg( numFailed ).arg( numReadOnly )
+		.arg( elapsedTime, 0, 'f', 2 ).arg( filesPerSecond(), 0, 'f', 1 ).arg( numThreads );
+}
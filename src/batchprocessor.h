@@ -0,0 +1,127 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+
+//! @file batchprocessor.h BatchProcessor
+
+class NifModel;
+class Spell;
+
+//! Applies a Spell to every NIF file under a folder without any windows or views
+class BatchProcessor final
+{
+	Q_DECLARE_TR_FUNCTIONS( BatchProcessor )
+
+public:
+	//! The outcome of processing a single file
+	struct Result
+	{
+		//! Path of the file relative to the root folder
+		QString fileName;
+		//! Lines reported by the spell for this file
+		QStringList log;
+		//! Whether the file could not be loaded or saved
+		bool failed = false;
+		//! Whether the file was skipped because it is read-only
+		bool readOnly = false;
+		//! Whether the file was modified and saved
+		bool saved = false;
+	};
+
+	BatchProcessor( Spell * spell, const QString & rootFolder );
+
+	//! Sets the number of worker threads, 0 for one per core
+	/*!
+	 * Each worker owns its own NifModel and shares the XML schema and the
+	 * GameManager archives. Spells that are not Spell::reentrant() always run
+	 * on a single thread.
+	 */
+	void setThreadCount( int count ) { threadCount = count; }
+	//! Number of worker threads used by the last run
+	int threadsUsed() const { return numThreads; }
+
+	//! Processes all NIF files under the root folder, returns false if the folder does not exist
+	/*!
+	 * Files are processed in sorted path order and the results are kept in
+	 * that order regardless of the number of threads.
+	 */
+	bool run();
+
+	//! Writes the per-file log in the format used by the bulk spells
+	bool writeLog( const QString & logFileName ) const;
+
+	//! Results in the order the files were found
+	const QList<Result> & results() const { return fileResults; }
+
+	int filesProcessed() const { return numProcessed; }
+	int filesSaved() const { return numSaved; }
+	int filesFailed() const { return numFailed; }
+	int filesReadOnly() const { return numReadOnly; }
+
+	//! Wall time of the last run in seconds
+	double elapsed() const { return elapsedTime; }
+	//! Processing throughput of the last run
+	double filesPerSecond() const;
+
+	//! One line summary of the last run, including throughput
+	QString summary() const;
+
+private:
+	//! Loads, casts and saves one file using the given model
+	Result processFile( NifModel & nif, const QString & filePath ) const;
+
+	Spell * spell;
+	QDir rootDir;
+	QList<Result> fileResults;
+	QDateTime startTime;
+
+	int threadCount = 0;
+	int numThreads = 1;
+
+	int numProcessed = 0;
+	int numSaved = 0;
+	int numFailed = 0;
+	int numReadOnly = 0;
+	double elapsedTime = 0.0;
+};
+
+#endif
@@ -31,169 +31,543 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***** END LICENCE BLOCK *****/
 
 #include "bsamodel.h"
-#include "qtcompat.h"
 
-#include <QByteArray>
-#include <QDateTime>
-#include <QStringBuilder>
+#include <QRegularExpression>
 
+#include <algorithm>
+#include <iterator>
+#include <numeric>
 
-BSAModel::BSAModel( QObject * parent )
-	: QStandardItemModel( parent )
+
+//! Lower case conversion of Latin-1 characters, matching QChar::toLower() for the letters used in paths
+static inline unsigned char latin1Lower( unsigned char c )
 {
+	if ( ( c >= 'A' && c <= 'Z' ) || ( c >= 0xC0 && c <= 0xDE && c != 0xD7 ) )
+		return c + 0x20;
+	return c;
+}
 
+//! Number of distinct trigram keys, each character is reduced to a 6-bit code
+static constexpr quint32 trigramKeyCount = 1U << 18;
+
+static inline quint32 trigramCode( unsigned char c )
+{
+	c = latin1Lower( c );
+	if ( c >= 'a' && c <= 'z' )
+		return quint32( c - 'a' ) + 1;
+	if ( c >= '0' && c <= '9' )
+		return quint32( c - '0' ) + 27;
+	switch ( c ) {
+	case '_':
+		return 37;
+	case '-':
+		return 38;
+	case '.':
+		return 39;
+	case '/':
+		return 40;
+	case ' ':
+		return 41;
+	}
+	// Rare characters share the remaining codes, the matches are verified after the index search
+	return 42 + quint32( c % 22 );
 }
 
-void BSAModel::init()
+template< typename F > static void forEachTrigram( std::string_view s, F func )
 {
-	setColumnCount( 3 );
-	setHorizontalHeaderLabels( { "File", "Path", "Size" } );
+	if ( s.length() < 3 )
+		return;
+	quint32	k = ( trigramCode( (unsigned char) s[0] ) << 6 ) | trigramCode( (unsigned char) s[1] );
+	for ( size_t i = 2; i < s.length(); i++ ) {
+		k = ( ( k << 6 ) | trigramCode( (unsigned char) s[i] ) ) & ( trigramKeyCount - 1 );
+		func( k );
+	}
 }
 
-Qt::ItemFlags BSAModel::flags( const QModelIndex & index ) const
+static inline quint32 varintLength( quint32 n )
 {
-	return QStandardItemModel::flags( index ) ^ Qt::ItemIsEditable;
+	quint32	len = 1;
+	for ( ; n >= 0x80; n = n >> 7 )
+		len++;
+	return len;
 }
 
-bool BSAModel::fillModel( const BA2File * bsa, const QString & folder )
+void BSAModel::TrigramIndex::build( const std::vector< File > & files )
 {
-	if ( !bsa )
+	static constexpr quint32 noFile = 0xFFFFFFFFU;
+
+	std::vector< quint32 >	lastFile( trigramKeyCount, noFile );
+	offsets.assign( trigramKeyCount + 1, 0 );
+
+	// First pass: size of each posting list
+	for ( quint32 i = 0; i < quint32( files.size() ); i++ ) {
+		forEachTrigram( files[i].path, [&]( quint32 k ) {
+			if ( lastFile[k] == i )
+				return;
+			offsets[k + 1] += varintLength( lastFile[k] == noFile ? i : i - lastFile[k] );
+			lastFile[k] = i;
+		} );
+	}
+	for ( quint32 k = 0; k < trigramKeyCount; k++ )
+		offsets[k + 1] += offsets[k];
+
+	// Second pass: encode the differences between the file indices
+	postings.resize( offsets.back() );
+	std::vector< quint32 >	pos( offsets.begin(), offsets.end() - 1 );
+	std::fill( lastFile.begin(), lastFile.end(), noFile );
+	for ( quint32 i = 0; i < quint32( files.size() ); i++ ) {
+		forEachTrigram( files[i].path, [&]( quint32 k ) {
+			if ( lastFile[k] == i )
+				return;
+			quint32	d = ( lastFile[k] == noFile ? i : i - lastFile[k] );
+			for ( ; d >= 0x80; d = d >> 7 )
+				postings[pos[k]++] = (unsigned char) ( d | 0x80 );
+			postings[pos[k]++] = (unsigned char) d;
+			lastFile[k] = i;
+		} );
+	}
+}
+
+bool BSAModel::TrigramIndex::findCandidates( std::vector< quint32 > & candidates, const std::vector< std::string > & literals ) const
+{
+	std::vector< quint32 >	keys;
+	for ( const auto & s : literals )
+		forEachTrigram( s, [&keys]( quint32 k ) { keys.push_back( k ); } );
+	if ( keys.empty() )
 		return false;
 
-	FileScanFuncData	data;
-	data.p = this;
-	data.bsa = bsa;
-	data.path = folder.toStdString();
-	if ( !data.path.empty() && !data.path.ends_with( '/' ) )
-		data.path += '/';
+	// Intersect the shortest lists first
+	std::sort( keys.begin(), keys.end() );
+	keys.erase( std::unique( keys.begin(), keys.end() ), keys.end() );
+	std::sort( keys.begin(), keys.end(), [this]( quint32 a, quint32 b ) {
+		return ( offsets[a + 1] - offsets[a] ) < ( offsets[b + 1] - offsets[b] );
+	} );
+
+	std::vector< quint32 >	list;
+	std::vector< quint32 >	tmp;
+	candidates.clear();
+	for ( size_t n = 0; n < keys.size(); n++ ) {
+		list.clear();
+		quint32	i = 0;
+		for ( quint32 p = offsets[keys[n]], end = offsets[keys[n] + 1]; p < end; ) {
+			quint32	d = 0;
+			for ( int shift = 0; ; shift += 7 ) {
+				unsigned char	b = postings[p++];
+				d |= quint32( b & 0x7F ) << shift;
+				if ( !( b & 0x80 ) )
+					break;
+			}
+			i += d;
+			list.push_back( i );
+		}
+
+		if ( n == 0 ) {
+			candidates.swap( list );
+		} else {
+			tmp.clear();
+			std::set_intersection( candidates.begin(), candidates.end(), list.begin(), list.end(), std::back_inserter( tmp ) );
+			candidates.swap( tmp );
+		}
+		if ( candidates.empty() )
+			break;
+	}
+	return true;
+}
 
-	// List files
-	bsa->scanFileList( &fileListScanFunction, &data );
 
-	return ( rowCount() > 0 );
+BSAModel::BSAModel( QObject * parent )
+	: QAbstractItemModel( parent )
+{
+	resetTree();
 }
 
-bool BSAModel::fileListScanFunction( void * p, const BA2File::FileInfo & fd )
+bool BSAModel::fillModel( const BA2File * bsa, const QString & folder )
 {
-	FileScanFuncData & o = *( reinterpret_cast< FileScanFuncData * >( p ) );
+	beginResetModel();
+
+	files.clear();
+	shown.clear();
+	trigrams = TrigramIndex();
+
+	std::string	path = folder.toStdString();
+	if ( !path.empty() && !path.ends_with( '/' ) )
+		path += '/';
+	prefixLength = path.length();
+
+	struct FileScanFuncData {
+		BSAModel * p;
+		const std::string & path;
+	};
+	FileScanFuncData	data{ this, path };
+
+	// List files, the names remain valid as long as the archive is open
+	if ( bsa ) {
+		bsa->scanFileList( []( void * p, const BA2File::FileInfo & fd ) -> bool {
+			FileScanFuncData &	o = *( reinterpret_cast< FileScanFuncData * >( p ) );
+			if ( fd.fileName.length() <= o.path.length() || !( o.path.empty() || fd.fileName.starts_with( o.path ) ) )
+				return false;
+
+			quint64	bytes = ( fd.archiveType < 64 || fd.packedSize == 0 ? fd.unpackedSize : fd.packedSize );
+			o.p->files.emplace_back( File{ fd.fileName, bytes } );
+			return false;
+		}, &data );
+	}
 
-	if ( fd.fileName.length() <= o.path.length() || !( o.path.empty() || fd.fileName.starts_with( o.path ) ) )
-		return false;
+	std::sort( files.begin(), files.end(), []( const File & a, const File & b ) { return a.path < b.path; } );
+	shown.resize( files.size() );
+	std::iota( shown.begin(), shown.end(), quint32( 0 ) );
+	resetTree();
+
+	endResetModel();
+
+	if ( !filterPattern.isEmpty() )
+		applyFilter();
+
+	return !files.empty();
+}
+
+void BSAModel::clear()
+{
+	beginResetModel();
+
+	files.clear();
+	files.shrink_to_fit();
+	shown.clear();
+	shown.shrink_to_fit();
+	trigrams = TrigramIndex();
+	prefixLength = 0;
+	resetTree();
+
+	endResetModel();
+}
+
+void BSAModel::setFilter( const QString & pattern )
+{
+	if ( pattern == filterPattern )
+		return;
+
+	filterPattern = pattern;
+	applyFilter();
+}
+
+void BSAModel::setFilterByNameOnly( bool nameOnly )
+{
+	if ( nameOnly == filterByNameOnly )
+		return;
+
+	filterByNameOnly = nameOnly;
+	if ( !filterPattern.isEmpty() )
+		applyFilter();
+}
+
+void BSAModel::applyFilter()
+{
+	beginResetModel();
+
+	shown.clear();
+	if ( filterPattern.isEmpty() ) {
+		shown.resize( files.size() );
+		std::iota( shown.begin(), shown.end(), quint32( 0 ) );
+	} else {
+		// Literal parts of the pattern outside of wildcards and character sets
+		std::vector< std::string >	literals;
+		std::string	s;
+		bool	isLiteral = true;
+		bool	inCharSet = false;
+		for ( QChar c : filterPattern ) {
+			char16_t	u = c.unicode();
+			bool	isSpecial = ( u == '*' || u == '?' || u == '[' || u == ']' || u == '\\' || u > 0xFF );
+			if ( isSpecial )
+				isLiteral = false;
+			if ( u == '[' )
+				inCharSet = true;
+			else if ( u == ']' )
+				inCharSet = false;
+			if ( isSpecial || inCharSet ) {
+				if ( !s.empty() )
+					literals.push_back( std::move( s ) );
+				s.clear();
+				continue;
+			}
+			s += char( latin1Lower( (unsigned char) u ) );
+		}
+		if ( !s.empty() )
+			literals.push_back( std::move( s ) );
+
+		std::vector< quint32 >	candidates;
+		bool	haveCandidates = false;
+		if ( std::any_of( literals.begin(), literals.end(), []( const std::string & l ) { return l.length() >= 3; } ) ) {
+			if ( trigrams.isEmpty() )
+				trigrams.build( files );
+			haveCandidates = trigrams.findCandidates( candidates, literals );
+		}
 
-	qsizetype	bytes = qsizetype( fd.archiveType < 64 || fd.packedSize == 0 ? fd.unpackedSize : fd.packedSize );
-	QString	fileSize( (bytes > 1024) ? QString::number( bytes / 1024 ) + "KB" : QString::number( bytes ) + "B" );
+		QRegularExpression	re;
+		if ( !isLiteral )
+			re = QRegularExpression::fromWildcard( filterPattern, Qt::CaseInsensitive, QRegularExpression::UnanchoredWildcardConversion );
+
+		auto	matches = [&]( std::string_view path ) -> bool {
+			if ( filterByNameOnly )
+				path = path.substr( path.rfind( '/' ) + 1 );
+			if ( isLiteral ) {
+				const std::string &	needle = literals.front();
+				return std::search( path.begin(), path.end(), needle.begin(), needle.end(), []( char a, char b ) {
+					return char( latin1Lower( (unsigned char) a ) ) == b;
+				} ) != path.end();
+			}
+			return re.match( QString::fromLatin1( path.data(), qsizetype( path.length() ) ) ).hasMatch();
+		};
 
-	QString	fullPath( QString::fromLatin1( fd.fileName.data(), qsizetype(fd.fileName.length()) ) );
-	qsizetype	dirNameLen = fullPath.lastIndexOf( QChar( '/' ) );
-	QString	baseName( fullPath.mid( dirNameLen + 1 ) );
-	auto	folderItem = o.p->insertFolder( fullPath, o.path.length(), dirNameLen, o.folderMap );
+		if ( haveCandidates ) {
+			for ( quint32 i : candidates ) {
+				if ( matches( files[i].path ) )
+					shown.push_back( i );
+			}
+		} else {
+			for ( quint32 i = 0; i < quint32( files.size() ); i++ ) {
+				if ( matches( files[i].path ) )
+					shown.push_back( i );
+			}
+		}
+	}
+	resetTree();
 
-	auto	fileItem = new QStandardItem( baseName );
-	auto	pathItem = new QStandardItem( fullPath );
-	auto	sizeItem = new QStandardItem( fileSize );
+	endResetModel();
+}
 
-	folderItem->appendRow( { fileItem, pathItem, sizeItem } );
+void BSAModel::resetTree()
+{
+	nodes.clear();
+	children.clear();
+	nodes.push_back( Node{ 0, 0, 0, quint32( shown.size() ), 0, 0, -1, 0, false } );
+
+	// The top level is always listed
+	quint32	begin = quint32( children.size() );
+	quint32	count = createChildren( 0 );
+	nodes[0].childBegin = qint32( begin );
+	nodes[0].childCount = count;
+}
 
-	return false;
+std::string_view BSAModel::nodeName( const Node & n ) const
+{
+	if ( n.first >= n.last )
+		return {};
+	return files[shown[n.first]].path.substr( n.nameBegin, n.nameEnd - n.nameBegin );
 }
 
-QStandardItem * BSAModel::insertFolder( const QString & path, qsizetype pos1, qsizetype pos2, QHash< QString, QStandardItem * > & folderMap )
+bool BSAModel::nodeLessThan( quint32 a, quint32 b ) const
 {
-	if ( pos2 <= pos1 )
-		return invisibleRootItem();
+	const Node &	x = nodes[a];
+	const Node &	y = nodes[b];
+
+	// Folders are always listed first
+	if ( x.isFile != y.isFile )
+		return !x.isFile;
+
+	int	c = 0;
+	if ( sortColumn == SizeCol && x.isFile ) {
+		quint64	sx = files[shown[x.first]].size;
+		quint64	sy = files[shown[y.first]].size;
+		c = ( sx < sy ? -1 : ( sx > sy ? 1 : 0 ) );
+	}
+	if ( !c )
+		c = nodeName( x ).compare( nodeName( y ) );
 
-	QString	key( path.left( pos2 ) );
-	for ( auto i = folderMap.find( key ); i != folderMap.end(); )
-		return i.value();
+	return ( sortOrder == Qt::AscendingOrder ? c < 0 : c > 0 );
+}
 
-	qsizetype	i1 = path.lastIndexOf( QChar('/'), pos2 - 1 );
-	QStandardItem *	parent;
-	// Recurse through folders
-	if ( i1 > pos1 )
-		parent = insertFolder( path, pos1, i1, folderMap );
-	else
-		parent = invisibleRootItem();
-	QStandardItem *	folderItem = new QStandardItem( path.mid( i1 + 1, pos2 - ( i1 + 1 ) ) );
-	auto pathDummy = new QStandardItem();
-	auto sizeDummy = new QStandardItem();
+quint32 BSAModel::createChildren( quint32 n )
+{
+	const Node	p = nodes[n];
+	size_t	depth = ( n == 0 ? prefixLength : size_t( p.nameEnd ) + 1 );
+	quint32	begin = quint32( children.size() );
+
+	// The files of a folder are contiguous in the sorted list, group them by the next path component
+	for ( quint32 i = p.first; i < p.last; ) {
+		std::string_view	path = files[shown[i]].path;
+		Node	c{ n, 0, i, i + 1, quint32( depth ), quint32( path.length() ), -1, 0, true };
+
+		size_t	slash = path.find( '/', depth );
+		if ( slash != std::string_view::npos ) {
+			std::string_view	folder = path.substr( 0, slash + 1 );
+			while ( c.last < p.last && files[shown[c.last]].path.starts_with( folder ) )
+				c.last++;
+			c.nameEnd = quint32( slash );
+			c.isFile = false;
+		}
 
-	parent->appendRow( { folderItem, pathDummy, sizeDummy } );
-	folderMap.insert( key, folderItem );
+		children.push_back( quint32( nodes.size() ) );
+		nodes.push_back( c );
+		i = c.last;
+	}
 
-	return folderItem;
+	quint32	count = quint32( children.size() ) - begin;
+	sortChildren( begin, count );
+	return count;
 }
 
+void BSAModel::sortChildren( quint32 begin, quint32 count )
+{
+	auto	i = children.begin() + begin;
+	std::sort( i, i + count, [this]( quint32 a, quint32 b ) { return nodeLessThan( a, b ); } );
+	for ( quint32 row = 0; row < count; row++ )
+		nodes[children[begin + row]].row = row;
+}
 
-BSAProxyModel::BSAProxyModel( QObject * parent )
-	: QSortFilterProxyModel( parent )
+QModelIndex BSAModel::index( int row, int column, const QModelIndex & parent ) const
 {
+	if ( row < 0 || column < 0 || column >= NumColumns || ( parent.isValid() && parent.column() != 0 ) )
+		return QModelIndex();
+
+	const Node &	p = nodes[parent.isValid() ? size_t( parent.internalId() ) : 0];
+	if ( p.childBegin < 0 || quint32( row ) >= p.childCount )
+		return QModelIndex();
 
+	return createIndex( row, column, quintptr( children[size_t( p.childBegin ) + size_t( row )] ) );
 }
 
-void BSAProxyModel::setFiletypes( QStringList types )
+QModelIndex BSAModel::parent( const QModelIndex & index ) const
 {
-	filetypes = types;
+	if ( !index.isValid() )
+		return QModelIndex();
+
+	quint32	p = nodes[size_t( index.internalId() )].parent;
+	if ( p == 0 )
+		return QModelIndex();
+
+	return createIndex( int( nodes[p].row ), 0, quintptr( p ) );
 }
 
-void BSAProxyModel::setFilterByNameOnly( bool nameOnly )
+int BSAModel::rowCount( const QModelIndex & parent ) const
 {
-	filterByNameOnly = nameOnly;
+	if ( parent.column() > 0 )
+		return 0;
 
-	setFilterRegularExpression( filterRegularExpression() );
+	const Node &	n = nodes[parent.isValid() ? size_t( parent.internalId() ) : 0];
+	return ( n.childBegin < 0 ? 0 : int( n.childCount ) );
 }
 
-void BSAProxyModel::resetFilter()
+int BSAModel::columnCount( const QModelIndex & ) const
 {
-	setFilterRegularExpression( QRegularExpression() );
+	return NumColumns;
 }
 
-bool BSAProxyModel::filterAcceptsRow( int sourceRow, const QModelIndex & sourceParent ) const
+bool BSAModel::hasChildren( const QModelIndex & parent ) const
 {
-	if ( !filterRegularExpression().pattern().isEmpty() ) {
+	if ( parent.column() > 0 )
+		return false;
 
-		QModelIndex sourceIndex0 = sourceModel()->index( sourceRow, 0, sourceParent );
-		QModelIndex sourceIndex1 = sourceModel()->index( sourceRow, 1, sourceParent );
-		if ( sourceIndex0.isValid() ) {
-			// If children match, parent matches
-			int c = sourceModel()->rowCount( sourceIndex0 );
-			for ( int i = 0; i < c; ++i ) {
-				if ( filterAcceptsRow( i, sourceIndex0 ) )
-					return true;
-			}
+	// Folders always contain at least one file
+	const Node &	n = nodes[parent.isValid() ? size_t( parent.internalId() ) : 0];
+	return ( !n.isFile && ( n.childBegin < 0 || n.childCount > 0 ) );
+}
 
-			QString key0 = sourceModel()->data( sourceIndex0, filterRole() ).toString();
-			QString key1 = sourceModel()->data( sourceIndex1, filterRole() ).toString();
+bool BSAModel::canFetchMore( const QModelIndex & parent ) const
+{
+	if ( parent.column() > 0 )
+		return false;
 
-			bool typeMatch = true;
-			if ( filetypes.count() ) {
-				typeMatch = false;
-				for ( auto f : filetypes ) {
-					typeMatch |= key1.endsWith( f, Qt::CaseInsensitive );
-				}
-			}
+	const Node &	n = nodes[parent.isValid() ? size_t( parent.internalId() ) : 0];
+	return ( !n.isFile && n.childBegin < 0 );
+}
 
-			bool stringMatch = (filterByNameOnly) ? key0.contains( filterRegularExpression() ) : key1.contains( filterRegularExpression() );
+void BSAModel::fetchMore( const QModelIndex & parent )
+{
+	if ( !canFetchMore( parent ) )
+		return;
+
+	quint32	n = ( parent.isValid() ? quint32( parent.internalId() ) : 0 );
+	quint32	begin = quint32( children.size() );
+	quint32	count = createChildren( n );
+
+	if ( count )
+		beginInsertRows( parent, 0, int( count ) - 1 );
+	nodes[n].childBegin = qint32( begin );
+	nodes[n].childCount = count;
+	if ( count )
+		endInsertRows();
+}
 
-			return typeMatch && stringMatch;
+QVariant BSAModel::data( const QModelIndex & index, int role ) const
+{
+	if ( !index.isValid() || ( role != Qt::DisplayRole && role != Qt::EditRole ) )
+		return QVariant();
+
+	const Node &	n = nodes[size_t( index.internalId() )];
+	switch ( index.column() ) {
+	case NameCol:
+		{
+			std::string_view	s = nodeName( n );
+			return QString::fromLatin1( s.data(), qsizetype( s.length() ) );
+		}
+	case PathCol:
+		if ( n.isFile ) {
+			std::string_view	s = files[shown[n.first]].path;
+			return QString::fromLatin1( s.data(), qsizetype( s.length() ) );
 		}
+		break;
+	case SizeCol:
+		if ( n.isFile ) {
+			quint64	bytes = files[shown[n.first]].size;
+			return ( bytes > 1024 ) ? QString::number( bytes / 1024 ) + "KB" : QString::number( bytes ) + "B";
+		}
+		break;
 	}
 
-	return QSortFilterProxyModel::filterAcceptsRow( sourceRow, sourceParent );
+	return QVariant();
 }
 
-bool BSAProxyModel::lessThan( const QModelIndex & left, const QModelIndex & right ) const
+QVariant BSAModel::headerData( int section, Qt::Orientation orientation, int role ) const
 {
-	QString leftString = sourceModel()->data( left ).toString();
-	QString rightString = sourceModel()->data( right ).toString();
+	if ( orientation != Qt::Horizontal || role != Qt::DisplayRole )
+		return QVariant();
+
+	switch ( section ) {
+	case NameCol:
+		return tr( "File" );
+	case PathCol:
+		return tr( "Path" );
+	case SizeCol:
+		return tr( "Size" );
+	}
 
-	QModelIndex leftChild = QModelIndex_child( left );
-	QModelIndex rightChild = QModelIndex_child( right );
+	return QVariant();
+}
 
-	if ( !leftChild.isValid() && rightChild.isValid() )
-		return false;
+Qt::ItemFlags BSAModel::flags( const QModelIndex & index ) const
+{
+	if ( !index.isValid() )
+		return Qt::NoItemFlags;
+
+	Qt::ItemFlags	f = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+	if ( nodes[size_t( index.internalId() )].isFile )
+		f |= Qt::ItemNeverHasChildren;
+	return f;
+}
+
+void BSAModel::sort( int column, Qt::SortOrder order )
+{
+	if ( column != SizeCol )
+		column = NameCol;
+	if ( column == sortColumn && order == sortOrder )
+		return;
+
+	emit layoutAboutToBeChanged( {}, QAbstractItemModel::VerticalSortHint );
+
+	sortColumn = column;
+	sortOrder = order;
+	// Only the folders that have been expanded have children to sort
+	for ( const Node & n : nodes ) {
+		if ( n.childBegin >= 0 )
+			sortChildren( quint32( n.childBegin ), n.childCount );
+	}
 
-	if ( leftChild.isValid() && !rightChild.isValid() )
-		return true;
+	QModelIndexList	from = persistentIndexList();
+	QModelIndexList	to;
+	to.reserve( from.size() );
+	for ( const QModelIndex & i : from )
+		to.append( createIndex( int( nodes[size_t( i.internalId() )].row ), i.column(), i.internalId() ) );
+	changePersistentIndexList( from, to );
 
-	return leftString < rightString;
+	emit layoutChanged( {}, QAbstractItemModel::VerticalSortHint );
 }
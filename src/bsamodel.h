@@ -35,54 +35,122 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "libfo76utils/src/ba2file.hpp"
 
-#include <QStandardItemModel>
-#include <QSortFilterProxyModel>
-#include <QHash>
-
-class BSAModel : public QStandardItemModel
+#include <QAbstractItemModel>
+
+#include <string_view>
+#include <vector>
+
+
+//! Archive browser model listing the files of a BA2File under a folder
+/*!
+ * The paths are stored as the string views returned by BA2File::scanFileList() in a sorted
+ * array, and the folder tree is a prefix tree over that array: each node covers a contiguous
+ * range of files, and its children are only created when the node is expanded. Name filtering
+ * uses a trigram index of the paths that is built on the first search.
+ *
+ * The archive must not be deleted before clear() is called.
+ */
+class BSAModel final : public QAbstractItemModel
 {
 	Q_OBJECT
 
 public:
 	BSAModel( QObject * parent = nullptr );
 
-	void init();
-
-	Qt::ItemFlags flags( const QModelIndex & index ) const override;
-	bool fillModel( const BA2File * bsa, const QString & folder );
-protected:
-	struct FileScanFuncData {
-		BSAModel * p;
-		const BA2File * bsa;
-		std::string path;
-		QHash< QString, QStandardItem * > folderMap;
+	enum Column
+	{
+		NameCol = 0,
+		PathCol = 1,
+		SizeCol = 2,
+		NumColumns = 3
 	};
-	static bool fileListScanFunction( void * p, const BA2File::FileInfo & fd );
-	QStandardItem * insertFolder( const QString & path, qsizetype pos1, qsizetype pos2, QHash< QString, QStandardItem * > & folderMap );
-};
 
-
-class BSAProxyModel : public QSortFilterProxyModel
-{
-	Q_OBJECT
-
-public:
-	BSAProxyModel( QObject * parent = nullptr );
-
-	void setFiletypes( QStringList types );
-
-	void resetFilter();
+	//! Lists the files of \a bsa under \a folder, returns false if there are none
+	bool fillModel( const BA2File * bsa, const QString & folder );
+	//! Removes all files and the filter index
+	void clear();
+
+	//! Shows only the files matching a case insensitive, unanchored wildcard pattern
+	void setFilter( const QString & pattern );
+	//! Number of files shown with the current filter
+	qsizetype shownFileCount() const { return qsizetype( shown.size() ); }
+
+	QModelIndex index( int row, int column, const QModelIndex & parent = QModelIndex() ) const override;
+	QModelIndex parent( const QModelIndex & index ) const override;
+	int rowCount( const QModelIndex & parent = QModelIndex() ) const override;
+	int columnCount( const QModelIndex & parent = QModelIndex() ) const override;
+	bool hasChildren( const QModelIndex & parent = QModelIndex() ) const override;
+	bool canFetchMore( const QModelIndex & parent ) const override;
+	void fetchMore( const QModelIndex & parent ) override;
+
+	QVariant data( const QModelIndex & index, int role = Qt::DisplayRole ) const override;
+	QVariant headerData( int section, Qt::Orientation orientation, int role = Qt::DisplayRole ) const override;
+	Qt::ItemFlags flags( const QModelIndex & index ) const override;
+	void sort( int column, Qt::SortOrder order = Qt::AscendingOrder ) override;
 
 public slots:
+	//! Matches the filter against the file names instead of the full paths
 	void setFilterByNameOnly( bool nameOnly );
 
 protected:
-	bool filterAcceptsRow( int sourceRow, const QModelIndex & sourceParent ) const;
-	bool lessThan( const QModelIndex & left, const QModelIndex & right ) const;
+	struct File
+	{
+		std::string_view path;
+		quint64 size;
+	};
 
-private:
-	QStringList filetypes;
+	//! Node of the prefix tree, node 0 is the root
+	struct Node
+	{
+		quint32 parent;
+		quint32 row;
+		//! Range of the node in shown
+		quint32 first;
+		quint32 last;
+		//! Name of the node in the path of its first file
+		quint32 nameBegin;
+		quint32 nameEnd;
+		//! Position of the children in the children array, -1 if they have not been created yet
+		qint32 childBegin;
+		quint32 childCount;
+		bool isFile;
+	};
+
+	//! Trigram index of the lower case file paths
+	struct TrigramIndex
+	{
+		//! Start of the posting list of each trigram in postings, the lists are delta and varint encoded
+		std::vector< quint32 > offsets;
+		std::vector< unsigned char > postings;
+
+		bool isEmpty() const { return offsets.empty(); }
+		void build( const std::vector< File > & files );
+		//! Stores the sorted indices of the files containing all trigrams of \a literals, returns false if there are none
+		bool findCandidates( std::vector< quint32 > & candidates, const std::vector< std::string > & literals ) const;
+	};
+
+	std::string_view nodeName( const Node & n ) const;
+	bool nodeLessThan( quint32 a, quint32 b ) const;
+	//! Appends the children of node \a n to the children array and returns their count
+	quint32 createChildren( quint32 n );
+	void sortChildren( quint32 begin, quint32 count );
+	void resetTree();
+	void applyFilter();
+
+	//! All files under the folder, sorted by path
+	std::vector< File > files;
+	//! Indices of the files matching the filter
+	std::vector< quint32 > shown;
+	std::vector< Node > nodes;
+	std::vector< quint32 > children;
+	size_t prefixLength = 0;
+
+	TrigramIndex trigrams;
+	QString filterPattern;
 	bool filterByNameOnly = false;
+
+	int sortColumn = NameCol;
+	Qt::SortOrder sortOrder = Qt::AscendingOrder;
 };
 
 #endif
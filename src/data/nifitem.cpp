@@ -33,6 +33,199 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "nifitem.h"
 #include "model/basemodel.h"
 
+#include <QReadWriteLock>
+#include <atomic>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+/*
+ *  NifFieldId
+ */
+
+namespace
+{
+struct FieldNameHash
+{
+	using is_transparent = void;
+
+	size_t operator()( std::u16string_view s ) const noexcept { return std::hash<std::u16string_view>()( s ); }
+};
+
+using FieldNameMap = std::unordered_map<std::u16string, int, FieldNameHash, std::equal_to<>>;
+
+//! All the interned field names
+/*!
+ * The names of nif.xml are interned while it is loaded and are read without locking
+ * once the table is frozen. Names interned later go to a separate table with a lock.
+ */
+struct FieldNames
+{
+	std::atomic<bool> frozen = false;
+	FieldNameMap ids;
+	QStringList names;
+
+	QReadWriteLock lock;
+	FieldNameMap extraIds;
+	QStringList extraNames;
+	std::atomic<int> extraCount = 0;
+};
+
+FieldNames & fieldNames()
+{
+	static FieldNames n;
+	return n;
+}
+
+std::u16string_view toView( const QString & s )
+{
+	return std::u16string_view( reinterpret_cast<const char16_t *>( s.constData() ), size_t( s.size() ) );
+}
+
+int findName( std::u16string_view name )
+{
+	FieldNames & n = fieldNames();
+	if ( !n.frozen.load( std::memory_order_acquire ) ) {
+		QReadLocker lck( &n.lock );
+		auto it = n.ids.find( name );
+		return ( it != n.ids.end() ) ? it->second : -1;
+	}
+
+	auto it = n.ids.find( name );
+	if ( it != n.ids.end() )
+		return it->second;
+	if ( n.extraCount.load( std::memory_order_acquire ) == 0 )
+		return -1;
+
+	QReadLocker lck( &n.lock );
+	auto e = n.extraIds.find( name );
+	return ( e != n.extraIds.end() ) ? e->second : -1;
+}
+}
+
+int NifFieldId::intern( const QString & name )
+{
+	if ( name.isEmpty() )
+		return -1;
+
+	int id = findName( toView( name ) );
+	if ( id >= 0 )
+		return id;
+
+	FieldNames & n = fieldNames();
+	QWriteLocker lck( &n.lock );
+	if ( !n.frozen.load( std::memory_order_relaxed ) ) {
+		auto r = n.ids.emplace( std::u16string( toView( name ) ), int( n.names.size() ) );
+		if ( r.second )
+			n.names.append( name );
+		return r.first->second;
+	}
+
+	// The IDs of the extra names follow the frozen ones
+	auto r = n.extraIds.emplace( std::u16string( toView( name ) ), int( n.names.size() + n.extraNames.size() ) );
+	if ( r.second ) {
+		n.extraNames.append( name );
+		n.extraCount.store( int( n.extraNames.size() ), std::memory_order_release );
+	}
+	return r.first->second;
+}
+
+void NifFieldId::freeze()
+{
+	FieldNames & n = fieldNames();
+	QWriteLocker lck( &n.lock );
+	n.frozen.store( true, std::memory_order_release );
+}
+
+QString NifFieldId::name() const
+{
+	if ( id < 0 )
+		return QString();
+
+	FieldNames & n = fieldNames();
+	if ( n.frozen.load( std::memory_order_acquire ) && id < n.names.size() )
+		return n.names.at( id );
+
+	QReadLocker lck( &n.lock );
+	if ( id < n.names.size() )
+		return n.names.at( id );
+	return n.extraNames.value( id - int( n.names.size() ) );
+}
+
+NifFieldId NifFieldId::find( const QString & name )
+{
+	NifFieldId r;
+	r.id = findName( toView( name ) );
+	return r;
+}
+
+NifFieldId NifFieldId::find( const QLatin1String & name )
+{
+	// Widen on the stack, field names are short
+	constexpr qsizetype bufSize = 128;
+	char16_t buf[bufSize];
+	if ( name.size() > bufSize )
+		return find( QString( name ) );
+
+	for ( qsizetype i = 0; i < name.size(); i++ )
+		buf[i] = char16_t( uchar( name.data()[i] ) );
+
+	NifFieldId r;
+	r.id = findName( std::u16string_view( buf, size_t( name.size() ) ) );
+	return r;
+}
+
+
+/*
+ *  NifFieldTable
+ */
+
+NifFieldTable::NifFieldTable( const QVector<NifFieldId> & fields )
+	: fieldCount( fields.count() )
+{
+	for ( int row = 0; row < fields.count(); row++ ) {
+		if ( fields.at( row ).isValid() )
+			table[fields.at( row ).value()].append( row );
+	}
+}
+
+
+/*
+ *  NifData
+ */
+
+bool NifData::write( QDataStream & ds ) const
+{
+	ds << d->name << d->type << d->templ << d->arg << d->arr1 << d->arr2 << d->cond << d->ver1 << d->ver2
+		<< d->text << d->vercond << quint32( d->flags.toInt() );
+	d->argexpr.write( ds );
+	d->condexpr.write( ds );
+	d->arr1expr.write( ds );
+	d->verexpr.write( ds );
+	return value.writeData( ds );
+}
+
+void NifData::read( QDataStream & ds )
+{
+	quint32 flags = 0;
+	ds >> d->name >> d->type >> d->templ >> d->arg >> d->arr1 >> d->arr2 >> d->cond >> d->ver1 >> d->ver2
+		>> d->text >> d->vercond >> flags;
+	d->nameId = NifFieldId( d->name );
+	d->flags = NifSharedData::DataFlags::fromInt( int( flags ) );
+	d->argexpr = NifExpr::read( ds );
+	d->condexpr = NifExpr::read( ds );
+	d->arr1expr = NifExpr::read( ds );
+	d->verexpr = NifExpr::read( ds );
+	value.readData( ds );
+}
+
+
+/*
+ *  NifItem
+ */
+
 bool NifItem::isDescendantOf( const NifItem * testAncestor ) const
 {
 	if ( testAncestor ) {
@@ -79,8 +272,29 @@ const NifItem * NifItem::ancestorAt( int testLevel ) const
 	return nullptr;
 }
 
+void NifItem::setPackedChildren( const NifData & data, int n )
+{
+	killChildren();
+	packed.reset( new PackedArray{ this, data, QVector<NifValue>( n, data.value ) } );
+}
+
+void NifItem::unpackChildren() const
+{
+	// The elements of packed arrays are never links, so the link caches stay empty
+	std::unique_ptr<const PackedArray> p( packed.release() );
+
+	childItems.reserve( p->values.count() );
+	for ( const NifValue & v : p->values ) {
+		NifItem * item = new NifItem( parentModel, p->element, p->owner );
+		item->itemData.value = v;
+		item->rowIdx = childItems.count();
+		childItems.append( item );
+	}
+}
+
 void NifItem::registerChild( NifItem * item, int at )
 {
+	ensureUnpacked();
 	int nOldChildren = childItems.count();
 	if ( at < 0 || at >= nOldChildren ) {
 		at = nOldChildren;
@@ -97,6 +311,7 @@ void NifItem::registerChild( NifItem * item, int at )
 
 NifItem * NifItem::unregisterChild( int at )
 {
+	ensureUnpacked();
 	if ( at >= 0 && at < childItems.count() ) {
 		NifItem * item = childItems.at( at );
 		childItems.remove( at );
@@ -37,12 +37,76 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "xml/nifexpr.h"
 
 #include <QSharedData> // Inherited
+#include <QHash>
 #include <QPointer>
 #include <QString>
 #include <QVector>
 
+#include <memory>
 
-//! @file nifitem.h NifItem, NifBlock, NifData, NifSharedData
+
+//! @file nifitem.h NifItem, NifBlock, NifData, NifSharedData, NifFieldId, NifFieldTable
+
+//! An interned field name; IDs compare in constant time
+class NifFieldId final
+{
+public:
+	//! An invalid ID, which matches no field
+	NifFieldId() = default;
+	//! Interns \a name
+	explicit NifFieldId( const QString & name ) : id( intern( name ) ) {}
+	//! Interns \a name
+	explicit NifFieldId( const char * name ) : id( intern( QString( QLatin1String( name ) ) ) ) {}
+
+	//! Does the ID refer to a name?
+	bool isValid() const { return id >= 0; }
+	//! Return the integer value of the ID
+	int value() const { return id; }
+	//! Return the interned name
+	QString name() const;
+
+	bool operator==( const NifFieldId & other ) const { return id == other.id; }
+	bool operator!=( const NifFieldId & other ) const { return id != other.id; }
+
+	//! Find the ID of \a name without interning it; the ID is invalid if no field has this name
+	static NifFieldId find( const QString & name );
+	//! Find the ID of \a name without interning it; the ID is invalid if no field has this name
+	static NifFieldId find( const QLatin1String & name );
+	//! The ID with the integer value \a value, as returned by value()
+	static NifFieldId fromValue( int value ) { NifFieldId f; f.id = value; return f; }
+
+	//! Make the names interned so far read-only, so that looking them up takes no lock
+	/*!
+	 * Called when nif.xml has been loaded. Names interned afterwards are still found, through a locked table.
+	 */
+	static void freeze();
+
+private:
+	static int intern( const QString & name );
+
+	int id = -1;
+};
+
+//! The rows of the fields of a compound or block by name, as inserted by NifModel::insertType
+class NifFieldTable final
+{
+public:
+	//! Build the table from the names of the fields in row order
+	explicit NifFieldTable( const QVector<NifFieldId> & fields );
+
+	//! Return the number of fields, which is the child count of an item of this type
+	int count() const { return fieldCount; }
+	//! Return the rows of the fields named \a id in ascending order, or nullptr if there are none
+	const QVector<int> * rows( NifFieldId id ) const
+	{
+		auto it = table.constFind( id.value() );
+		return ( it != table.cend() ) ? &it.value() : nullptr;
+	}
+
+private:
+	int fieldCount;
+	QHash<int, QVector<int>> table;
+};
 
 /*! Shared data for NifData.
  *
@@ -73,22 +137,24 @@ private:
 
 	NifSharedData( const QString & n, const QString & t, const QString & tt, const QString & a, const QString & a1,
 				   const QString & a2, const QString & c, quint32 v1, quint32 v2, NifSharedData::DataFlags f )
-		: QSharedData(), name( n ), type( t ), templ( tt ), arg( a ), argexpr( a ), arr1( a1 ), arr2( a2 ),
+		: QSharedData(), name( n ), nameId( n ), type( t ), templ( tt ), arg( a ), argexpr( a ), arr1( a1 ), arr2( a2 ),
 		cond( c ), ver1( v1 ), ver2( v2 ), condexpr( c ), arr1expr( a1 ), flags( f )
 	{
 	}
 
 	NifSharedData( const QString & n, const QString & t )
-		: QSharedData(), name( n ), type( t ) {}
+		: QSharedData(), name( n ), nameId( n ), type( t ) {}
 
 	NifSharedData( const QString & n, const QString & t, const QString & txt )
-		: QSharedData(), name( n ), type( t ), text( txt ) {}
+		: QSharedData(), name( n ), nameId( n ), type( t ), text( txt ) {}
 
 	NifSharedData()
 		: QSharedData() {}
 
 	//! Name.
 	QString name;
+	//! Interned name.
+	NifFieldId nameId;
 	//! Type.
 	QString type;
 	//! Template type.
@@ -119,6 +185,9 @@ private:
 	NifExpr verexpr;
 
 	DataFlags flags = None;
+
+	//! Field rows of the compound or block type, see NifFieldTable.
+	std::shared_ptr<const NifFieldTable> fields;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( NifSharedData::DataFlags );
@@ -141,6 +210,10 @@ public:
 
 	//! Get the name of the data.
 	inline const QString & name() const { return d->name; }
+	//! Get the interned name of the data.
+	inline NifFieldId nameId() const { return d->nameId; }
+	//! Get the field rows of the compound or block type of the data.
+	inline const std::shared_ptr<const NifFieldTable> & fieldTable() const { return d->fields; }
 	//! Get the type of the data.
 	inline const QString & type() const { return d->type; }
 	//! Get the template type of the data.
@@ -190,7 +263,13 @@ public:
 	inline bool isMixin() const { return d->flags & NifSharedData::Mixin; }
 
 	//! Sets the name of the data.
-	void setName( const QString & name ) { d->name = name; }
+	void setName( const QString & name )
+	{
+		d->name = name;
+		d->nameId = NifFieldId( name );
+	}
+	//! Sets the field rows of the compound or block type of the data.
+	void setFieldTable( const std::shared_ptr<const NifFieldTable> & fields ) { d->fields = fields; }
 	//! Sets the type of the data.
 	void setType( const QString & type ) { d->type = type; }
 	//! Sets the template type of the data.
@@ -251,6 +330,14 @@ public:
 	//! Sets the type condition data flag (does the data's condition checks only the type of the parent block).
 	inline void setHasTypeCondition( bool flag ) { setFlag( NifSharedData::TypeCondition, flag ); }
 
+	//! Writes the attributes, parsed expressions and default value of the data, for the schema cache.
+	/*!
+	 * Returns false if the default value cannot be stored, see NifValue::writeData().
+	 */
+	bool write( QDataStream & ds ) const;
+	//! Reads data written by write() without parsing the expressions again, sets the status of \a ds on invalid data.
+	void read( QDataStream & ds );
+
 	//! Gets the data's value type (NifValue::Type).
 	inline NifValue::Type valueType() const { return value.type(); }
 	//! Check if the type of the data's value is a color type (Color3 or Color4 in xml).
@@ -314,6 +401,8 @@ struct NifBlock
 	bool abstract = false;
 	//! Data present.
 	QList<NifData> types;
+	//! Rows of the fields of the compound, or of the block including its ancestors.
+	std::shared_ptr<const NifFieldTable> fields;
 };
 
 //! An item which contains NifData
@@ -360,6 +449,7 @@ public:
 	 */
 	void prepareInsert( int e )
 	{
+		ensureUnpacked();
 		childItems.reserve( childItems.count() + e );
 	}
 
@@ -392,15 +482,39 @@ public:
 		const QVector<NifItem*> & m_children;
 	};
 
-	const QVector<NifItem *> & childIter() { return childItems; }
+	const QVector<NifItem *> & childIter() { ensureUnpacked(); return childItems; }
 
-	ChildIterator<const NifItem *> childIter() const { return ChildIterator<const NifItem *>(childItems); }
+	ChildIterator<const NifItem *> childIter() const { ensureUnpacked(); return ChildIterator<const NifItem *>(childItems); }
 
 	//! Get QVector of child items.
-	const QVector<NifItem *> & children() { return childItems; }
+	const QVector<NifItem *> & children() { ensureUnpacked(); return childItems; }
 
 	//! Return the number of child items.
-	int childCount() const { return childItems.count(); }
+	int childCount() const { return packed ? int( packed->values.count() ) : childItems.count(); }
+
+	//! Is the item an array which stores its elements as packed values instead of child items?
+	bool isPacked() const { return bool( packed ); }
+
+	/*! Store the elements of the array as packed values instead of child items
+	 *
+	 * Existing child items are removed. The child items are created from the values
+	 * the first time they are accessed (see unpackChildren).
+	 *
+	 * @param data	The data shared by all the elements, its value sets the value type
+	 * @param n		The number of elements
+	 */
+	void setPackedChildren( const NifData & data, int n );
+
+	//! Resize the packed array, new elements get the default value of the element data.
+	void resizePackedChildren( int n ) { packed->values.resize( n, packed->element.value ); }
+
+	//! Return the packed element values of the array (isPacked() must be true)
+	QVector<NifValue> & packedValues() { return packed->values; }
+	//! Return the packed element values of the array (isPacked() must be true)
+	const QVector<NifValue> & packedValues() const { return packed->values; }
+
+	//! Create the child items of a packed array from its values.
+	void unpackChildren() const;
 
 	//! Checks if the item is testAncestor itself or its child or a child of a child, etc.
 	bool isDescendantOf( const NifItem * testAncestor ) const;
@@ -506,6 +620,7 @@ public:
 	 */
 	void removeChildren( int row, int count )
 	{
+		ensureUnpacked();
 		int iStart = std::max( row, 0 );
 		int iEnd = std::min( row + count, int( childItems.count() ) );
 		if ( iStart < iEnd ) {
@@ -521,14 +636,15 @@ public:
 	}
 
 	//! Return the child item at the specified row
-	NifItem * child( int row ) { return childItems.value( row ); }
+	NifItem * child( int row ) { ensureUnpacked(); return childItems.value( row ); }
 
 	//! Return the child item at the specified row
-	const NifItem * child( int row ) const { return childItems.value( row ); }
+	const NifItem * child( int row ) const { ensureUnpacked(); return childItems.value( row ); }
 
 	//! Remove all child items
 	void killChildren()
 	{
+		packed.reset();
 		qDeleteAll( childItems );
 		childItems.clear();
 
@@ -587,6 +703,13 @@ private:
 	//! Invalidate the cached at index
 	void invalidateRow() { rowIdx = -1; }
 
+	//! Create the child items of a packed array if they do not exist yet
+	void ensureUnpacked() const
+	{
+		if ( packed )
+			unpackChildren();
+	}
+
 	void updateChildRows( int iStartChild = 0 )
 	{
 		for ( int i = iStartChild; i < childItems.count(); i++ )
@@ -612,6 +735,10 @@ public:
 
 	//! Return the name of the data
 	inline const QString & name() const { return itemData.name(); }
+	//! Return the interned name of the data
+	inline NifFieldId nameId() const { return itemData.nameId(); }
+	//! Return the field rows of the item's compound or block type, if known
+	inline const std::shared_ptr<const NifFieldTable> & fieldTable() const { return itemData.fieldTable(); }
 	//! Return the type of the data (the "type" attribute in the XML file).
 	inline const QString & strType() const { return itemData.type(); }
 	//! Return the template type of the data
@@ -661,6 +788,8 @@ public:
 
 	//! Does the item's name match testName?
 	inline bool hasName( const QString & testName ) const { return itemData.name() == testName; }
+	//! Does the item's name match testId?
+	inline bool hasName( NifFieldId testId ) const { return itemData.nameId() == testId; }
 	//! Does the item's name match testName?
 	inline bool hasName( const QLatin1String & testName ) const { return itemData.name() == testName; }
 	//! Does the item's name match testName?
@@ -677,6 +806,8 @@ public:
 
 	//! Set the name
 	inline void setName( const QString & name ) {   itemData.setName( name );   }
+	//! Set the field rows of the item's compound or block type
+	inline void setFieldTable( const std::shared_ptr<const NifFieldTable> & fields ) { itemData.setFieldTable( fields ); }
 	//! Set the string type
 	inline void setStrType( const QString & type ) { itemData.setType( type ); }
 	//! Set the template type
@@ -776,11 +907,16 @@ public:
 	template <typename T> QVector<T> getArray() const
 	{
 		QVector<T> array;
-		int nSize = childItems.count();
+		int nSize = childCount();
 		if ( nSize > 0 ) {
 			array.reserve( nSize );
-			for ( const NifItem * child : childItems )
-				array.append( child->get<T>() );
+			if ( packed ) {
+				for ( const NifValue & v : packedValues() )
+					array.append( v.get<T>( parentModel, this ) );
+			} else {
+				for ( const NifItem * child : childItems )
+					array.append( child->get<T>() );
+			}
 		}
 		return array;
 	}
@@ -798,7 +934,7 @@ public:
 	//! Set the child items' values from an array.
 	template <typename T> bool setArray( const QVector<T> & array )
 	{
-		int nSize = childItems.count();
+		int nSize = childCount();
 		if ( nSize != array.count() ) {
 			reportError( 
 				__func__,
@@ -806,6 +942,14 @@ public:
 			);
 			return false;
 		}
+		if ( packed ) {
+			for ( int i = 0; i < nSize; i++ ) {
+				if ( !packed->values[i].set<T>( array.at(i), parentModel, this ) )
+					return false;
+			}
+
+			return true;
+		}
 		for ( int i = 0; i < nSize; i++ ) {
 			if ( !childItems.at(i)->set<T>( array.at(i) ) )
 				return false;
@@ -817,6 +961,14 @@ public:
 	//! Set the child items' values from a single value.
 	template <typename T> bool fillArray( const T & val )
 	{
+		if ( packed ) {
+			for ( NifValue & v : packed->values ) {
+				if ( !v.set<T>( val, parentModel, this ) )
+					return false;
+			}
+
+			return true;
+		}
 		for ( NifItem * child : childItems ) {
 			if ( !child->set<T>( val ) )
 				return false;
@@ -854,8 +1006,26 @@ private:
 	BaseModel * parentModel = nullptr;
 	//! The parent of this item
 	NifItem * parentItem = nullptr;
-	//! The child items
-	QVector<NifItem *> childItems;
+	/*! The child items
+	 *
+	 * Mutable because the child items of a packed array are created on first access,
+	 * which may come through a const accessor (child(), childIter()). Creating them does
+	 * not change the observable state of the item: childCount() and the values stay the same.
+	 */
+	mutable QVector<NifItem *> childItems;
+
+	//! Element values of an array whose child items have not been created yet
+	struct PackedArray
+	{
+		//! The array item, stored when the array is packed so that unpacking can parent the child items to it
+		NifItem * owner;
+		//! The data shared by all the elements
+		NifData element;
+		//! The element values
+		QVector<NifValue> values;
+	};
+	//! Packed array storage, replaces childItems until the elements are accessed as items; mutable like childItems
+	mutable std::unique_ptr<PackedArray> packed;
 
 	//! Rows which have links under them at any level
 	QVector<ushort> linkAncestorRows;
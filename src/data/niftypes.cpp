@@ -32,10 +32,14 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "niftypes.h"
 
+#include "model/niffields.h"
 #include "model/nifmodel.h"
 
 #include <QStringList>
 
+#include <algorithm>
+#include <vector>
+
 
 //! @file niftypes.cpp Type functions
 
@@ -689,16 +693,16 @@ bool Transform::canConstruct( const NifModel * nif, const QModelIndex & parent )
 
 Transform::Transform( const NifModel * nif, const QModelIndex & transform )
 {
-	QModelIndex t = nif->getIndex( transform, "Transform" );
+	QModelIndex t = nif->getIndex( transform, fieldTransform );
 	if ( !t.isValid() ) {
-		t = nif->getIndex( transform, "Skin Transform" );
+		t = nif->getIndex( transform, fieldSkinTransform );
 		if ( !t.isValid() )
 			t = transform;
 	}
 
-	rotation = nif->get<Matrix>( t, "Rotation" );
-	translation = nif->get<Vector3>( t, "Translation" );
-	scale = nif->get<float>( t, "Scale" );
+	rotation = nif->get<Matrix>( t, fieldRotation );
+	translation = nif->get<Vector3>( t, fieldTranslation );
+	scale = nif->get<float>( t, fieldScale );
 }
 
 void Transform::writeBack( NifModel * nif, const QModelIndex & transform ) const
@@ -740,3 +744,56 @@ Matrix4 Transform::toMatrix4() const
 	return m;
 }
 
+
+QVector<TriangleChunk> splitTriangles( const quint32 * indices, qsizetype numTriangles, quint32 maxVertices )
+{
+	QVector<TriangleChunk> chunks;
+	maxVertices = std::clamp< quint32 >( maxVertices, 3, 65536 );
+
+	quint32 maxIndex = 0;
+	for ( qsizetype i = 0; i < numTriangles * 3; i++ )
+		maxIndex = std::max( maxIndex, indices[i] );
+
+	if ( maxIndex < maxVertices ) {
+		// everything fits, keep the original vertex numbering
+		TriangleChunk & chunk = chunks.emplace_back();
+		chunk.triangles.resize( numTriangles );
+		for ( qsizetype i = 0; i < numTriangles; i++, indices = indices + 3 )
+			chunk.triangles[i].set( quint16( indices[0] ), quint16( indices[1] ), quint16( indices[2] ) );
+		return chunks;
+	}
+
+	// local vertex number of each source vertex in the current chunk, or 0xFFFFFFFF
+	std::vector<quint32> remap( size_t( maxIndex ) + 1, 0xFFFFFFFFU );
+	TriangleChunk * chunk = nullptr;
+
+	for ( qsizetype i = 0; i < numTriangles; i++, indices = indices + 3 ) {
+		quint32 newVerts = 0;
+		if ( chunk ) {
+			for ( int j = 0; j < 3; j++ ) {
+				if ( remap[indices[j]] == 0xFFFFFFFFU && ( j < 1 || indices[j] != indices[0] ) && ( j < 2 || indices[j] != indices[1] ) )
+					newVerts++;
+			}
+		}
+		if ( !chunk || quint32( chunk->vertices.size() ) + newVerts > maxVertices ) {
+			if ( chunk ) {
+				for ( quint32 v : chunk->vertices )
+					remap[v] = 0xFFFFFFFFU;
+			}
+			chunk = &( chunks.emplace_back() );
+		}
+
+		Triangle t;
+		for ( int j = 0; j < 3; j++ ) {
+			quint32 & n = remap[indices[j]];
+			if ( n == 0xFFFFFFFFU ) {
+				n = quint32( chunk->vertices.size() );
+				chunk->vertices.append( indices[j] );
+			}
+			t[j] = quint16( n );
+		}
+		chunk->triangles.append( t );
+	}
+
+	return chunks;
+}
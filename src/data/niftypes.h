@@ -1298,6 +1298,27 @@ inline QDataStream & operator>>( QDataStream & ds, Triangle & t )
 	return ds;
 }
 
+//! A part of a larger mesh that can be stored with 16-bit triangle indices
+struct TriangleChunk
+{
+	//! Source vertex number of each local vertex, empty if the source numbering is kept
+	QVector<quint32> vertices;
+	//! Triangles using local vertex numbers
+	QVector<Triangle> triangles;
+};
+
+/*! Converts triangles with 32-bit vertex indices to Triangle lists
+ *
+ * If all indices fit in 16 bits, a single chunk is returned with the original vertex
+ * numbering. Otherwise the triangles are split in order into chunks that each reference
+ * at most \a maxVertices vertices.
+ *
+ * @param indices		Three vertex indices per triangle
+ * @param numTriangles	Number of triangles
+ * @param maxVertices	Vertex limit per chunk, at most 65536
+ */
+QVector<TriangleChunk> splitTriangles( const quint32 * indices, qsizetype numTriangles, quint32 maxVertices = 65536 );
+
 //! Clamps a float to have a value between 0 and 1 inclusive
 inline float clamp01( float a )
 {
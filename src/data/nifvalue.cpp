@@ -37,6 +37,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QRegularExpression>
 #include <QSettings>
 
+#include <type_traits>
+
 
 //! @file nifvalue.cpp NifValue
 
@@ -52,6 +54,15 @@ static int OPT_PER_LINE = -1;
  *  NifValue
  */
 
+// The types stored in Value::fixed are copied with the union and not destroyed
+template <typename T> static constexpr bool isFixedStorageType = ( sizeof( T ) <= 16 && alignof( T ) <= alignof( quint64 )
+                                                                   && std::is_trivially_copyable_v<T>
+                                                                   && std::is_trivially_destructible_v<T> );
+static_assert( isFixedStorageType<Vector2> && isFixedStorageType<Vector3> && isFixedStorageType<Vector4>
+               && isFixedStorageType<ByteVector4> && isFixedStorageType<UDecVector4> && isFixedStorageType<Quat>
+               && isFixedStorageType<Triangle> && isFixedStorageType<Color3> && isFixedStorageType<Color4>
+               && isFixedStorageType<ByteColor4> && isFixedStorageType<ByteColor4BGRA> && isFixedStorageType<BSVertexDesc> );
+
 NifValue::NifValue( Type t )
 {
 	changeType( t );
@@ -62,6 +73,150 @@ NifValue::NifValue( const NifValue & other )
 	operator=(other);
 }
 
+//! Write the elements of a vector, color or triangle
+template <typename T> static void writeElements( QDataStream & ds, const void * data, int n )
+{
+	const T & v = *static_cast<const T *>( data );
+	for ( int i = 0; i < n; i++ )
+		ds << v[i];
+}
+
+//! Read the elements of a vector, color or triangle
+template <typename T> static void readElements( QDataStream & ds, void * data, int n )
+{
+	T & v = *static_cast<T *>( data );
+	for ( int i = 0; i < n; i++ )
+		ds >> v[i];
+}
+
+bool NifValue::writeData( QDataStream & ds ) const
+{
+	ds << quint8( typ );
+
+	switch ( typ ) {
+	case tVector2:
+	case tHalfVector2:
+		writeElements<Vector2>( ds, dataPtr(), 2 );
+		return true;
+	case tVector3:
+	case tHalfVector3:
+	case tShortVector3:
+	case tUshortVector3:
+	case tByteVector3:
+		writeElements<Vector3>( ds, dataPtr(), 3 );
+		return true;
+	case tVector4:
+	case tByteVector4:
+	case tUDecVector4:
+		writeElements<Vector4>( ds, dataPtr(), 4 );
+		return true;
+	case tQuat:
+	case tQuatXYZW:
+		writeElements<Quat>( ds, dataPtr(), 4 );
+		return true;
+	case tTriangle:
+		writeElements<Triangle>( ds, dataPtr(), 3 );
+		return true;
+	case tColor3:
+		writeElements<Color3>( ds, dataPtr(), 3 );
+		return true;
+	case tColor4:
+	case tByteColor4:
+	case tByteColor4BGRA:
+		writeElements<Color4>( ds, dataPtr(), 4 );
+		return true;
+	case tString:
+	case tSizedString:
+	case tSizedString16:
+	case tText:
+	case tShortString:
+	case tHeaderString:
+	case tLineString:
+	case tChar8String:
+		ds << *static_cast<const QString *>( val.data );
+		return true;
+	case tMatrix:
+	case tMatrix4:
+	case tByteArray:
+	case tStringPalette:
+	case tByteMatrix:
+	case tBSVertexDesc:
+	case tBlob:
+		return false;
+	default:
+		ds << val.u64;
+		return true;
+	}
+}
+
+void NifValue::readData( QDataStream & ds )
+{
+	quint8 t = tNone;
+	ds >> t;
+	if ( t > tNormbyte && t != tNone )
+		ds.setStatus( QDataStream::ReadCorruptData );
+	if ( ds.status() != QDataStream::Ok )
+		return;
+
+	changeType( Type( t ) );
+
+	switch ( typ ) {
+	case tVector2:
+	case tHalfVector2:
+		readElements<Vector2>( ds, dataPtr(), 2 );
+		break;
+	case tVector3:
+	case tHalfVector3:
+	case tShortVector3:
+	case tUshortVector3:
+	case tByteVector3:
+		readElements<Vector3>( ds, dataPtr(), 3 );
+		break;
+	case tVector4:
+	case tByteVector4:
+	case tUDecVector4:
+		readElements<Vector4>( ds, dataPtr(), 4 );
+		break;
+	case tQuat:
+	case tQuatXYZW:
+		readElements<Quat>( ds, dataPtr(), 4 );
+		break;
+	case tTriangle:
+		readElements<Triangle>( ds, dataPtr(), 3 );
+		break;
+	case tColor3:
+		readElements<Color3>( ds, dataPtr(), 3 );
+		break;
+	case tColor4:
+	case tByteColor4:
+	case tByteColor4BGRA:
+		readElements<Color4>( ds, dataPtr(), 4 );
+		break;
+	case tString:
+	case tSizedString:
+	case tSizedString16:
+	case tText:
+	case tShortString:
+	case tHeaderString:
+	case tLineString:
+	case tChar8String:
+		ds >> *static_cast<QString *>( val.data );
+		break;
+	case tMatrix:
+	case tMatrix4:
+	case tByteArray:
+	case tStringPalette:
+	case tByteMatrix:
+	case tBSVertexDesc:
+	case tBlob:
+		ds.setStatus( QDataStream::ReadCorruptData );
+		break;
+	default:
+		ds >> val.u64;
+		break;
+	}
+}
+
 NifValue::~NifValue()
 {
 	clear();
@@ -234,6 +389,71 @@ bool NifValue::registerEnumType( const QString & eid, EnumType eTyp )
 	return true;
 }
 
+void NifValue::writeTypeTables( QDataStream & ds )
+{
+	ds << quint32( typeMap.size() );
+	for ( auto i = typeMap.cbegin(); i != typeMap.cend(); i++ )
+		ds << i.key() << quint8( i.value() );
+
+	ds << aliasMap << typeTxt;
+
+	ds << quint32( enumMap.size() );
+	for ( auto i = enumMap.cbegin(); i != enumMap.cend(); i++ ) {
+		ds << i.key() << quint8( i.value().t ) << quint32( i.value().o.size() );
+		for ( auto j = i.value().o.cbegin(); j != i.value().o.cend(); j++ )
+			ds << j.key() << j.value().first << j.value().second;
+	}
+}
+
+bool NifValue::readTypeTables( QDataStream & ds )
+{
+	typeMap.clear();
+	aliasMap.clear();
+	typeTxt.clear();
+	enumMap.clear();
+
+	quint32 n = 0;
+	ds >> n;
+	for ( quint32 i = 0; i < n && ds.status() == QDataStream::Ok; i++ ) {
+		QString id;
+		quint8 t = tNone;
+		ds >> id >> t;
+		if ( t > tNormbyte )
+			ds.setStatus( QDataStream::ReadCorruptData );
+		typeMap.insert( id, Type( t ) );
+	}
+
+	ds >> aliasMap >> typeTxt;
+
+	n = 0;
+	ds >> n;
+	for ( quint32 i = 0; i < n && ds.status() == QDataStream::Ok; i++ ) {
+		QString eid;
+		quint8 t = eNone;
+		quint32 optionCount = 0;
+		ds >> eid >> t >> optionCount;
+		if ( t > eFlags ) {
+			ds.setStatus( QDataStream::ReadCorruptData );
+			break;
+		}
+
+		EnumOptions & e = enumMap[eid];
+		e.t = EnumType( t );
+		for ( quint32 j = 0; j < optionCount && ds.status() == QDataStream::Ok; j++ ) {
+			quint32 v = 0;
+			QPair<QString, QString> o;
+			ds >> v >> o.first >> o.second;
+			e.o.insert( v, o );
+		}
+	}
+
+	if ( ds.status() != QDataStream::Ok ) {
+		initialize();
+		return false;
+	}
+	return true;
+}
+
 NifValue::EnumType NifValue::enumType( const QString & eid )
 {
 	return (enumMap.contains( eid )) ? enumMap[eid].t : EnumType::eNone;
@@ -364,32 +584,12 @@ const NifValue::EnumOptions & NifValue::enumOptionData( const QString & eid )
 void NifValue::clear()
 {
 	switch ( typ ) {
-	case tVector4:
-	case tByteVector4:
-	case tUDecVector4:
-		delete static_cast<Vector4 *>( val.data );
-		break;
-	case tVector3:
-	case tHalfVector3:
-	case tShortVector3:
-	case tUshortVector3:
-	case tByteVector3:
-		delete static_cast<Vector3 *>( val.data );
-		break;
-	case tVector2:
-	case tHalfVector2:
-		delete static_cast<Vector2 *>( val.data );
-		break;
 	case tMatrix:
 		delete static_cast<Matrix *>( val.data );
 		break;
 	case tMatrix4:
 		delete static_cast<Matrix4 *>( val.data );
 		break;
-	case tQuat:
-	case tQuatXYZW:
-		delete static_cast<Quat *>( val.data );
-		break;
 	case tByteMatrix:
 		delete static_cast<ByteMatrix *>( val.data );
 		break;
@@ -397,9 +597,6 @@ void NifValue::clear()
 	case tStringPalette:
 		delete static_cast<QByteArray *>( val.data );
 		break;
-	case tTriangle:
-		delete static_cast<Triangle *>( val.data );
-		break;
 	case tString:
 	case tSizedString:
 	case tSizedString16:
@@ -410,21 +607,11 @@ void NifValue::clear()
 	case tChar8String:
 		delete static_cast<QString *>( val.data );
 		break;
-	case tColor3:
-		delete static_cast<Color3 *>( val.data );
-		break;
-	case tColor4:
-	case tByteColor4:
-	case tByteColor4BGRA:
-		delete static_cast<Color4 *>( val.data );
-		break;
-	case tBSVertexDesc:
-		delete static_cast<BSVertexDesc *>(val.data);
-		break;
 	case tBlob:
 		delete static_cast<QByteArray *>( val.data );
 		break;
 	default:
+		// Scalars and the types stored inline in Value::fixed, which are trivially destructible
 		break;
 	}
 
@@ -450,14 +637,14 @@ void NifValue::changeType( Type t )
 	case tShortVector3:
 	case tUshortVector3:
 	case tByteVector3:
-		val.data = new Vector3();
+		new( val.fixed ) Vector3();
 		break;
 	case tVector4:
-		val.data = new Vector4();
+		new( val.fixed ) Vector4();
 		return;
 	case tByteVector4:
 	case tUDecVector4:
-		val.data = new ByteVector4();
+		new( val.fixed ) ByteVector4();
 		return;
 	case tMatrix:
 		val.data = new Matrix();
@@ -467,14 +654,14 @@ void NifValue::changeType( Type t )
 		return;
 	case tQuat:
 	case tQuatXYZW:
-		val.data = new Quat();
+		new( val.fixed ) Quat();
 		return;
 	case tVector2:
 	case tHalfVector2:
-		val.data = new Vector2();
+		new( val.fixed ) Vector2();
 		return;
 	case tTriangle:
-		val.data = new Triangle();
+		new( val.fixed ) Triangle();
 		return;
 	case tString:
 	case tSizedString:
@@ -487,12 +674,12 @@ void NifValue::changeType( Type t )
 		val.data = new QString();
 		return;
 	case tColor3:
-		val.data = new Color3();
+		new( val.fixed ) Color3();
 		return;
 	case tColor4:
 	case tByteColor4:
 	case tByteColor4BGRA:
-		val.data = new Color4();
+		new( val.fixed ) Color4();
 		return;
 	case tByteArray:
 	case tStringPalette:
@@ -506,7 +693,7 @@ void NifValue::changeType( Type t )
 		val.u32 = 0xffffffff;
 		return;
 	case tBSVertexDesc:
-		val.data = new BSVertexDesc();
+		new( val.fixed ) BSVertexDesc();
 		return;
 	case tBlob:
 		val.data = new QByteArray();
@@ -523,32 +710,12 @@ void NifValue::operator=( const NifValue & other )
 		changeType( other.typ );
 
 	switch ( typ ) {
-	case tVector3:
-	case tHalfVector3:
-	case tShortVector3:
-	case tUshortVector3:
-	case tByteVector3:
-		*static_cast<Vector3 *>( val.data ) = *static_cast<Vector3 *>( other.val.data );
-		return;
-	case tVector4:
-	case tByteVector4:
-	case tUDecVector4:
-		*static_cast<Vector4 *>( val.data ) = *static_cast<Vector4 *>( other.val.data );
-		return;
 	case tMatrix:
 		*static_cast<Matrix *>( val.data ) = *static_cast<Matrix *>( other.val.data );
 		return;
 	case tMatrix4:
 		*static_cast<Matrix4 *>( val.data ) = *static_cast<Matrix4 *>( other.val.data );
 		return;
-	case tQuat:
-	case tQuatXYZW:
-		*static_cast<Quat *>( val.data ) = *static_cast<Quat *>( other.val.data );
-		return;
-	case tVector2:
-	case tHalfVector2:
-		*static_cast<Vector2 *>( val.data ) = *static_cast<Vector2 *>( other.val.data );
-		return;
 	case tString:
 	case tSizedString:
 	case tSizedString16:
@@ -559,14 +726,6 @@ void NifValue::operator=( const NifValue & other )
 	case tChar8String:
 		*static_cast<QString *>( val.data ) = *static_cast<QString *>( other.val.data );
 		return;
-	case tColor3:
-		*static_cast<Color3 *>( val.data ) = *static_cast<Color3 *>( other.val.data );
-		return;
-	case tColor4:
-	case tByteColor4:
-	case tByteColor4BGRA:
-		*static_cast<Color4 *>( val.data ) = *static_cast<Color4 *>( other.val.data );
-		return;
 	case tByteArray:
 	case tStringPalette:
 		*static_cast<QByteArray *>( val.data ) = *static_cast<QByteArray *>( other.val.data );
@@ -574,21 +733,28 @@ void NifValue::operator=( const NifValue & other )
 	case tByteMatrix:
 		*static_cast<ByteMatrix *>( val.data ) = *static_cast<ByteMatrix *>( other.val.data );
 		return;
-	case tTriangle:
-		*static_cast<Triangle *>( val.data ) = *static_cast<Triangle *>( other.val.data );
-		return;
 	case tBlob:
 		*static_cast<QByteArray *>( val.data ) = *static_cast<QByteArray *>( other.val.data );
 		return;
-	case tBSVertexDesc:
-		*static_cast<BSVertexDesc *>(val.data) = *static_cast<BSVertexDesc *>(other.val.data);
-		return;
 	default:
+		// Scalars and the types stored inline
 		val = other.val;
 		return;
 	}
 }
 
+void NifValue::operator=( NifValue && other ) noexcept
+{
+	if ( this == &other )
+		return;
+
+	clear();
+	typ = other.typ;
+	val = other.val;
+	other.typ = tNone;
+	other.val.u64 = 0;
+}
+
 bool NifValue::operator==( const NifValue & other ) const
 {
 	switch ( typ ) {
@@ -644,8 +810,8 @@ bool NifValue::operator==( const NifValue & other ) const
 
 	case tColor3:
 	{
-		Color3 * c1 = static_cast<Color3 *>(val.data);
-		Color3 * c2 = static_cast<Color3 *>(other.val.data);
+		Color3 * c1 = static_cast<Color3 *>(dataPtr());
+		Color3 * c2 = static_cast<Color3 *>(other.dataPtr());
 
 		if ( !c1 || !c2 )
 			return false;
@@ -657,8 +823,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tByteColor4:
 	case tByteColor4BGRA:
 	{
-		Color4 * c1 = static_cast<Color4 *>(val.data);
-		Color4 * c2 = static_cast<Color4 *>(other.val.data);
+		Color4 * c1 = static_cast<Color4 *>(dataPtr());
+		Color4 * c2 = static_cast<Color4 *>(other.dataPtr());
 
 		if ( !c1 || !c2 )
 			return false;
@@ -669,8 +835,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tVector2:
 	case tHalfVector2:
 	{
-		Vector2 * vec1 = static_cast<Vector2 *>(val.data);
-		Vector2 * vec2 = static_cast<Vector2 *>(other.val.data);
+		Vector2 * vec1 = static_cast<Vector2 *>(dataPtr());
+		Vector2 * vec2 = static_cast<Vector2 *>(other.dataPtr());
 
 		if ( !vec1 || !vec2 )
 			return false;
@@ -684,8 +850,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tUshortVector3:
 	case tByteVector3:
 	{
-		Vector3 * vec1 = static_cast<Vector3 *>(val.data);
-		Vector3 * vec2 = static_cast<Vector3 *>(other.val.data);
+		Vector3 * vec1 = static_cast<Vector3 *>(dataPtr());
+		Vector3 * vec2 = static_cast<Vector3 *>(other.dataPtr());
 
 		if ( !vec1 || !vec2 )
 			return false;
@@ -697,8 +863,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tByteVector4:
 	case tUDecVector4:
 	{
-		Vector4 * vec1 = static_cast<Vector4 *>(val.data);
-		Vector4 * vec2 = static_cast<Vector4 *>(other.val.data);
+		Vector4 * vec1 = static_cast<Vector4 *>(dataPtr());
+		Vector4 * vec2 = static_cast<Vector4 *>(other.dataPtr());
 
 		if ( !vec1 || !vec2 )
 			return false;
@@ -709,8 +875,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tQuat:
 	case tQuatXYZW:
 	{
-		Quat * quat1 = static_cast<Quat *>(val.data);
-		Quat * quat2 = static_cast<Quat *>(other.val.data);
+		Quat * quat1 = static_cast<Quat *>(dataPtr());
+		Quat * quat2 = static_cast<Quat *>(other.dataPtr());
 
 		if ( !quat1 || !quat2 )
 			return false;
@@ -720,8 +886,8 @@ bool NifValue::operator==( const NifValue & other ) const
 
 	case tTriangle:
 	{
-		Triangle * tri1 = static_cast<Triangle *>(val.data);
-		Triangle * tri2 = static_cast<Triangle *>(other.val.data);
+		Triangle * tri1 = static_cast<Triangle *>(dataPtr());
+		Triangle * tri2 = static_cast<Triangle *>(other.dataPtr());
 
 		if ( !tri1 || !tri2 )
 			return false;
@@ -765,8 +931,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	}
 	case tBSVertexDesc:
 	{
-		auto d1 = static_cast<BSVertexDesc *>(val.data);
-		auto d2 = static_cast<BSVertexDesc *>(other.val.data);
+		auto d1 = static_cast<BSVertexDesc *>(dataPtr());
+		auto d2 = static_cast<BSVertexDesc *>(other.dataPtr());
 
 		if ( !d1 || !d2 )
 			return false;
@@ -882,13 +1048,13 @@ bool NifValue::setFromString( const QString & s, const BaseModel * model, const
 		ok = true;
 		break;
 	case tColor3:
-		static_cast<Color3 *>( val.data )->fromQColor( QColor( s ) );
+		static_cast<Color3 *>( dataPtr() )->fromQColor( QColor( s ) );
 		ok = true;
 		break;
 	case tColor4:
 	case tByteColor4:
 	case tByteColor4BGRA:
-		static_cast<Color4 *>( val.data )->fromQColor( QColor( s ) );
+		static_cast<Color4 *>( dataPtr() )->fromQColor( QColor( s ) );
 		ok = true;
 		break;
 	case tFileVersion:
@@ -897,22 +1063,22 @@ bool NifValue::setFromString( const QString & s, const BaseModel * model, const
 		ok = (val.u32 != 0);
 		break;
 	case tVector2:
-		static_cast<Vector2 *>( val.data )->fromString( s );
+		static_cast<Vector2 *>( dataPtr() )->fromString( s );
 		ok = true;
 		break;
 	case tVector3:
-		static_cast<Vector3 *>( val.data )->fromString( s );
+		static_cast<Vector3 *>( dataPtr() )->fromString( s );
 		ok = true;
 		break;
 	case tVector4:
 	case tByteVector4:
 	case tUDecVector4:
-		static_cast<Vector4 *>( val.data )->fromString( s );
+		static_cast<Vector4 *>( dataPtr() )->fromString( s );
 		ok = true;
 		break;
 	case tQuat:
 	case tQuatXYZW:
-		static_cast<Quat *>( val.data )->fromString( s );
+		static_cast<Quat *>( dataPtr() )->fromString( s );
 		ok = true;
 		break;
 	default:
@@ -968,7 +1134,7 @@ QString NifValue::toString() const
 		return *static_cast<QString *>( val.data );
 	case tColor3:
 		{
-			Color3 * col = static_cast<Color3 *>( val.data );
+			Color3 * col = static_cast<Color3 *>( dataPtr() );
 			float r = col->red(), g = col->green(), b = col->blue();
 
 			// HDR Colors
@@ -984,7 +1150,7 @@ QString NifValue::toString() const
 	case tByteColor4:
 	case tByteColor4BGRA:
 		{
-			Color4 * col = static_cast<Color4 *>( val.data );
+			Color4 * col = static_cast<Color4 *>( dataPtr() );
 			float r = col->red(), g = col->green(), b = col->blue(), a = col->alpha();
 
 			// HDR Colors
@@ -1003,7 +1169,7 @@ QString NifValue::toString() const
 	case tVector2:
 	case tHalfVector2:
 		{
-			Vector2 * v = static_cast<Vector2 *>( val.data );
+			Vector2 * v = static_cast<Vector2 *>( dataPtr() );
 
 			return QString( "X %1 Y %2" )
 			       .arg( NumOrMinMax( (*v)[0], 'f', VECTOR_DECIMALS ) )
@@ -1015,7 +1181,7 @@ QString NifValue::toString() const
 	case tUshortVector3:
 	case tByteVector3:
 		{
-			Vector3 * v = static_cast<Vector3 *>( val.data );
+			Vector3 * v = static_cast<Vector3 *>( dataPtr() );
 
 			return QString( "X %1 Y %2 Z %3" )
 			       .arg( NumOrMinMax( (*v)[0], 'f', VECTOR_DECIMALS ) )
@@ -1026,7 +1192,7 @@ QString NifValue::toString() const
 	case tByteVector4:
 	case tUDecVector4:
 		{
-			Vector4 * v = static_cast<Vector4 *>( val.data );
+			Vector4 * v = static_cast<Vector4 *>( dataPtr() );
 
 			return QString( "X %1 Y %2 Z %3 W %4" )
 			       .arg( NumOrMinMax( (*v)[0], 'f', VECTOR_DECIMALS ) )
@@ -1043,7 +1209,7 @@ QString NifValue::toString() const
 			if ( typ == tMatrix )
 				m = *( static_cast<Matrix *>( val.data ) );
 			else
-				m.fromQuat( *( static_cast<Quat *>( val.data ) ) );
+				m.fromQuat( *( static_cast<Quat *>( dataPtr() ) ) );
 
 			float x, y, z;
 			QString pre, suf;
@@ -1103,7 +1269,7 @@ QString NifValue::toString() const
 		return NifModel::version2string( val.u32 );
 	case tTriangle:
 		{
-			Triangle * tri = static_cast<Triangle *>( val.data );
+			Triangle * tri = static_cast<Triangle *>( dataPtr() );
 			return QString( "%1 %2 %3" )
 			       .arg( tri->v1() )
 			       .arg( tri->v2() )
@@ -1114,7 +1280,7 @@ QString NifValue::toString() const
 			return *static_cast<QString *>( val.data );
 		}
 	case tBSVertexDesc:
-		return static_cast<BSVertexDesc *>(val.data)->toString();
+		return static_cast<BSVertexDesc *>(dataPtr())->toString();
 	case tBlob:
 		{
 			QByteArray * array = static_cast<QByteArray *>( val.data );
@@ -1210,11 +1376,11 @@ QColor NifValue::toColor( const BaseModel * model, const NifItem * item ) const
 {
 	switch ( type() ) {
 	case tColor3:
-		return static_cast<Color3 *>( val.data )->toQColor();
+		return static_cast<Color3 *>( dataPtr() )->toQColor();
 	case tColor4:
 	case tByteColor4:
 	case tByteColor4BGRA:
-		return static_cast<Color4 *>( val.data )->toQColor();
+		return static_cast<Color4 *>( dataPtr() )->toQColor();
 	default:
 		if ( model )
 			reportConvertToError(model, item, "a color");
@@ -36,6 +36,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "data/niftypes.h"
 
 #include <QByteArray>
+#include <QDataStream>
 #include <QHash>
 #include <QPair>
 #include <QString>
@@ -156,12 +157,21 @@ public:
 	NifValue( Type t );
 	//! Copy constructor.
 	NifValue( const NifValue & other );
+	//! Move constructor, \a other is left as tNone.
+	NifValue( NifValue && other ) noexcept
+		: typ( other.typ ), val( other.val )
+	{
+		other.typ = tNone;
+		other.val.u64 = 0;
+	}
 	//! Destructor.
 	~NifValue();
 
 
 	//! Assignment. Performs a deep copy of the data.
 	void operator=(const NifValue & other);
+	//! Move assignment, \a other is left as tNone.
+	void operator=( NifValue && other ) noexcept;
 	//! Custom comparator for QVariant::operator==()
 	bool operator==(const NifValue & other) const;
 	//! Necessary for QMetaType::registerComparators(), but unused
@@ -172,6 +182,12 @@ public:
 
 	//! Get the type.
 	Type type() const { return typ; }
+	//! Returns true if the data of type \a t is stored inline, false for scalars and heap allocated types
+	static constexpr bool isInlineType( Type t )
+	{
+		return ( t >= tColor3 && t <= tQuatXYZW ) || ( t >= tVector2 && t <= tTriangle )
+		       || t == tHalfVector2 || t == tBSVertexDesc;
+	}
 
 	/*! Change the type of data stored.
 	 *
@@ -218,6 +234,11 @@ public:
 	//! Register an enum type.
 	static bool registerEnumType( const QString & eid, EnumType eTyp );
 
+	//! Write the type, alias, description and enum tables built from the XML, for the schema cache.
+	static void writeTypeTables( QDataStream & ds );
+	//! Replace the type tables with ones written by writeTypeTables(), returns false on invalid data.
+	static bool readTypeTables( QDataStream & ds );
+
 	/*! Register an option for an enum type.
 	 *
 	 * @param eid	The name of the enum type.
@@ -353,6 +374,14 @@ public:
 	 */
 	bool setFromVariant( const QVariant & );
 
+	/*! Write the type and the data, for the default values in the schema cache.
+	 *
+	 * @return False if the type cannot be stored, matrices and blobs are not used as defaults.
+	 */
+	bool writeData( QDataStream & ds ) const;
+	//! Read a value written by writeData(), sets the status of \a ds on invalid data.
+	void readData( QDataStream & ds );
+
 	//! Get the data in the form of something of type T.
 	template <typename T> T get( const BaseModel * model, const NifItem * item ) const;
 	//! Set the data from an instance of type T. Return true if successful.
@@ -372,12 +401,18 @@ protected:
 		quint64 u64;
 		qint64 i64;
 		float f32;
+		//! Heap allocated data of the matrix, string and byte array types
 		void * data;
+		//! Inline storage of the vector, quaternion, color and triangle types
+		quint32 fixed[4];
 	};
 
 	//! The data value.
 	Value val = {0};
 
+	//! Pointer to the data of the types that are not scalars, not const like Value::data
+	void * dataPtr() const { return isInlineType( typ ) ? const_cast<quint32 *>( val.fixed ) : val.data; }
+
 	/*! Get the data as an object of type T.
 	 *
 	 * If the type t is not equal to the actual type of the data, then return T(). Serves
@@ -520,7 +555,7 @@ inline bool NifValue::setFileVersion( quint32 v, const BaseModel * model, const
 template <typename T> inline T NifValue::getType( Type t, const BaseModel * model, const NifItem * item ) const
 {
 	if ( typ == t )
-		return *static_cast<T *>( val.data ); // WARNING: this throws an exception if the type of v is not the original type by which val.data was initialized; the programmer must make sure that T matches t.
+		return *static_cast<T *>( dataPtr() ); // WARNING: this throws an exception if the type of v is not the original type by which the data was initialized; the programmer must make sure that T matches t.
 
 	if ( model )
 		reportConvertToError( model, item, getTypeDebugStr( t ) );
@@ -530,7 +565,7 @@ template <typename T> inline T NifValue::getType( Type t, const BaseModel * mode
 template <typename T> inline bool NifValue::setType( Type t, T v, const BaseModel * model, const NifItem * item )
 {
 	if ( typ == t ) {
-		*static_cast<T *>( val.data ) = v; // WARNING: this throws an exception if the type of v is not the original type by which val.data was initialized; the programmer must make sure that T matches t.
+		*static_cast<T *>( dataPtr() ) = v; // WARNING: this throws an exception if the type of v is not the original type by which the data was initialized; the programmer must make sure that T matches t.
 		return true;
 	}
 
@@ -594,7 +629,7 @@ template <> inline Matrix4 NifValue::get( const BaseModel * model, const NifItem
 template <> inline Vector4 NifValue::get( const BaseModel * model, const NifItem * item ) const
 {
 	if ( typ >= tVector4 && typ <= tUDecVector4 )
-		return *static_cast<Vector4 *>(val.data);
+		return *static_cast<Vector4 *>( dataPtr() );
 
 	if ( model )
 		reportConvertToError( model, item, "a Vector4" );
@@ -611,7 +646,7 @@ template <> inline UDecVector4 NifValue::get( const BaseModel * model, const Nif
 template <> inline Vector3 NifValue::get( const BaseModel * model, const NifItem * item ) const
 {
 	if ( typ >= tVector3 && typ <= tByteVector3 )
-		return *static_cast<Vector3 *>(val.data);
+		return *static_cast<Vector3 *>( dataPtr() );
 
 	if ( model )
 		reportConvertToError( model, item, "a Vector3" );
@@ -640,7 +675,7 @@ template <> inline HalfVector2 NifValue::get( const BaseModel * model, const Nif
 template <> inline Vector2 NifValue::get( const BaseModel * model, const NifItem * item ) const
 {
 	if ( typ == tVector2 || typ == tHalfVector2 )
-		return *static_cast<Vector2 *>(val.data);
+		return *static_cast<Vector2 *>( dataPtr() );
 
 	if ( model )
 		reportConvertToError( model, item, "a Vector2" );
@@ -661,7 +696,7 @@ template <> inline ByteColor4BGRA NifValue::get( const BaseModel * model, const
 template <> inline Color4 NifValue::get( const BaseModel * model, const NifItem * item ) const
 {
 	if ( typ >= tColor4 && typ <= tByteColor4BGRA )
-		return *static_cast<Color4 *>(val.data);
+		return *static_cast<Color4 *>( dataPtr() );
 
 	if ( model )
 		reportConvertToError( model, item, "a Color4" );
@@ -701,7 +736,7 @@ template <> inline QByteArray * NifValue::get( const BaseModel * model, const Ni
 template <> inline Quat NifValue::get( const BaseModel * model, const NifItem * item ) const
 {
 	if ( isQuat() )
-		return *static_cast<Quat *>( val.data );
+		return *static_cast<Quat *>( dataPtr() );
 
 	if ( model )
 		reportConvertToError( model, item, "Quat" );
@@ -878,7 +913,7 @@ template <> inline bool NifValue::set( const QByteArray & x, const BaseModel * m
 template <> inline bool NifValue::set( const Quat & x, const BaseModel * model, const NifItem * item )
 {
 	if ( isQuat() ) {
-		*static_cast<Quat *>( val.data ) = x;
+		*static_cast<Quat *>( dataPtr() ) = x;
 		return true;
 	}
 
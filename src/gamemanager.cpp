@@ -1,18 +1,24 @@
 #include "gamemanager.h"
 
 #include "ba2file.hpp"
+#include "io/resourceindex.h"
 #include "bsrefl.hpp"
 #include "material.hpp"
 #include "message.h"
 #include "model/nifmodel.h"
 
 #include <QSettings>
+#include <QApplication>
 #include <QCoreApplication>
 #include <QProgressDialog>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QMap>
 #include <QMessageBox>
+#include <QSet>
 #include <QStringBuilder>
+#include <QThread>
 
 namespace Game
 {
@@ -75,6 +81,7 @@ static const ResourceListMap FOLDERS = {
 
 std::uint64_t	GameManager::material_db_prv_id = 0;
 GameManager::GameResources	GameManager::archives[NUM_GAMES];
+QRecursiveMutex	GameManager::resourceLock;
 std::unordered_map< const NifModel *, GameManager::GameResources * >	GameManager::nifResourceMap;
 QString	GameManager::gamePaths[NUM_GAMES];
 bool	GameManager::gameStatus[NUM_GAMES] = { true, true, true, true, true, true, true, true, true };
@@ -166,40 +173,175 @@ GameManager::GameResources::~GameResources()
 {
 	if ( sfMaterials && !( parent && sfMaterials == parent->sfMaterials ) )
 		delete sfMaterials;
-	if ( ba2File )
-		delete ba2File;
 }
 
-void GameManager::GameResources::init_archives()
+//! Archive set with the lock that serializes extracting files from it
+struct LockedArchive : public BA2File
 {
-	if ( sfMaterialDB_ID )
-		close_materials();
-	if ( ba2File ) {
-		delete ba2File;
-		ba2File = nullptr;
-	}
+	QMutex	extractLock;
+};
 
-	if ( parent && !parent->ba2File )
-		parent->init_archives();
+//! Report an error opening resources, resources can also be loaded by the texture worker threads
+static void resourceError( const QString & msg )
+{
+	if ( QThread::currentThread() == QCoreApplication::instance()->thread() )
+		QMessageBox::critical( nullptr, "NifSkope error", msg );
+	else
+		qWarning() << msg;
+}
 
+QStringList GameManager::GameResources::resource_paths() const
+{
 	QStringList	tmp;
 	if ( gameStatus[game] ) {
 		tmp = dataPaths;
 		if ( !parent && otherGamesFallback && game != OTHER && gameStatus[OTHER] )
 			tmp.append( archives[OTHER].dataPaths );
 	}
+	return tmp;
+}
+
+void GameManager::GameResources::init_archives()
+{
+	QMutexLocker	lock( &resourceLock );
+	if ( sfMaterialDB_ID )
+		close_materials();
+	ba2File.reset();
+
+	if ( parent && !parent->ba2File )
+		parent->init_archives();
+
+	QStringList	tmp( resource_paths() );
 	if ( tmp.isEmpty() )
 		return;
-	ba2File = new BA2File();
+	ba2File = std::make_shared< LockedArchive >();
 	for ( const auto & i : tmp ) {
 		try {
 			ba2File->loadArchivePath( i.toStdString().c_str(), archiveFilterFuncTable[game] );
 		} catch ( FO76UtilsError & e ) {
-			QMessageBox::critical( nullptr, "NifSkope error", QString("Error opening resource path '%1': %2").arg(i).arg(e.what()) );
+			resourceError( QString("Error opening resource path '%1': %2").arg(i).arg(e.what()) );
 		}
 	}
 }
 
+//! Archives of the resource paths by game and canonical path, shared by all the resources that use the path
+static std::map< std::pair< int, QString >, std::weak_ptr< BA2File > >	sharedPathArchives;
+//! Folder resource paths (canonical) whose cached index may be out of date, they are indexed again on next use
+static QSet< QString >	staleFolderIndexes;
+
+static QString canonicalResourcePath( const QString & path )
+{
+	QFileInfo	fi( path );
+	QString	p( fi.canonicalFilePath() );
+	return ( p.isEmpty() ? fi.absoluteFilePath() : p );
+}
+
+//! Open the archive of resource path 'path' and share it with the other resources that use the same path
+static std::shared_ptr< BA2File > loadPathArchive( GameMode game, const QString & path )
+{
+	auto	archive = std::make_shared< LockedArchive >();
+	try {
+		archive->loadArchivePath( path.toStdString().c_str(), archiveFilterFuncTable[game] );
+	} catch ( FO76UtilsError & e ) {
+		resourceError( QString("Error opening resource path '%1': %2").arg(path).arg(e.what()) );
+	}
+	sharedPathArchives[{ int(game), canonicalResourcePath( path ) }] = archive;
+	return archive;
+}
+
+static bool indexScanFunction( void * p, const BA2File::FileInfo & fd )
+{
+	reinterpret_cast< std::vector< std::string_view > * >( p )->push_back( fd.fileName );
+	return false;
+}
+
+void GameManager::GameResources::init_index()
+{
+	QMutexLocker	lock( &resourceLock );
+	close_archives();
+
+	QElapsedTimer	timer;
+	timer.start();
+	int	cacheHits = 0;
+
+	ResourceIndex::Statistics &	stats = ResourceIndex::statistics();
+	indexedPaths = resource_paths();
+	pathArchives.resize( size_t(indexedPaths.size()) );
+	for ( const auto & i : indexedPaths ) {
+		QByteArray	stamp( ResourceIndex::stamp( i ) );
+		std::shared_ptr< const ResourceIndex >	index;
+		if ( !staleFolderIndexes.remove( canonicalResourcePath( i ) ) )
+			index = ResourceIndex::load( i, int(game), stamp );
+		if ( index ) {
+			cacheHits++;
+			stats.cacheHits++;
+		} else {
+			// Build the index from the archive, which is kept open for the files that are requested later
+			QElapsedTimer	buildTimer;
+			buildTimer.start();
+			auto	archive = loadPathArchive( game, i );
+			std::vector< std::string_view >	names;
+			archive->scanFileList( &indexScanFunction, &names );
+			index = ResourceIndex::create( i, int(game), stamp, names );
+			pathArchives[pathIndexes.size()] = archive;
+			stats.cacheMisses++;
+			stats.buildMsecs += buildTimer.elapsed();
+		}
+		pathIndexes.push_back( index );
+	}
+	indexed = true;
+
+	if ( !indexedPaths.isEmpty() ) {
+		qDebug() << QString( "Resource index for %1: %2 paths, %3 from the cache, %4 ms" )
+			.arg( StringForMode( game ) ).arg( indexedPaths.size() ).arg( cacheHits ).arg( timer.elapsed() );
+	}
+}
+
+std::shared_ptr< BA2File > GameManager::GameResources::find_archive( const std::string_view & fullPath )
+{
+	QMutexLocker	lock( &resourceLock );
+	if ( !indexed )
+		init_index();
+
+	ResourceIndex::Statistics &	stats = ResourceIndex::statistics();
+	stats.lookups++;
+
+	// The resource paths are in priority order (loose folders, then mod, DLC and base game archives,
+	// see find_paths), the first one that contains the file is the one the full archive set extracts it from
+	for ( size_t i = 0; i < pathIndexes.size(); i++ ) {
+		if ( pathIndexes[i]->contains( fullPath ) ) {
+			stats.lookupHits++;
+			return open_path_archive( int(i) );
+		}
+	}
+	return nullptr;
+}
+
+std::shared_ptr< BA2File > GameManager::GameResources::open_path_archive( int i )
+{
+	QMutexLocker	lock( &resourceLock );
+	std::shared_ptr< BA2File > &	archive = pathArchives[size_t(i)];
+	if ( !archive ) {
+		auto	j = sharedPathArchives.find( { int(game), canonicalResourcePath( indexedPaths[i] ) } );
+		if ( j != sharedPathArchives.end() )
+			archive = j->second.lock();
+		if ( !archive )
+			archive = loadPathArchive( game, indexedPaths[i] );
+	}
+	return archive;
+}
+
+bool GameManager::GameResources::have_files() const
+{
+	if ( ba2File && ba2File->size() > 0 )
+		return true;
+	for ( const auto & i : pathIndexes ) {
+		if ( i->size() > 0 )
+			return true;
+	}
+	return false;
+}
+
 static bool archiveScanFunctionMat( [[maybe_unused]] void * p, const BA2File::FileInfo & fd )
 {
 	if ( fd.fileName.ends_with( ".mat" ) || fd.fileName.ends_with( ".cdb" ) )
@@ -209,6 +351,7 @@ static bool archiveScanFunctionMat( [[maybe_unused]] void * p, const BA2File::Fi
 
 CE2MaterialDB * GameManager::GameResources::init_materials()
 {
+	QMutexLocker	lock( &resourceLock );
 	if ( game != STARFIELD )
 		return nullptr;
 
@@ -234,9 +377,10 @@ CE2MaterialDB * GameManager::GameResources::init_materials()
 	if ( parent )
 		sfMaterials->copyFrom( *(parent->sfMaterials) );
 	try {
+		QMutexLocker	extractLock( &( static_cast< LockedArchive * >( ba2File.get() )->extractLock ) );
 		sfMaterials->loadArchives( *ba2File );
 	} catch ( FO76UtilsError & e ) {
-		QMessageBox::critical( nullptr, "NifSkope error", QString("Error loading Starfield material database: %1").arg(e.what()) );
+		resourceError( QString("Error loading Starfield material database: %1").arg(e.what()) );
 	}
 
 	return sfMaterials;
@@ -244,16 +388,37 @@ CE2MaterialDB * GameManager::GameResources::init_materials()
 
 void GameManager::GameResources::close_archives()
 {
+	QMutexLocker	lock( &resourceLock );
 	if ( sfMaterialDB_ID )
 		close_materials();
-	if ( ba2File ) {
-		delete ba2File;
-		ba2File = nullptr;
+	// Threads that are extracting a file keep their archive until they are done
+	ba2File.reset();
+	// The archives are opened again on next use, do not share the ones that are being closed
+	for ( size_t i = 0; i < pathArchives.size(); i++ ) {
+		if ( !pathArchives[i] )
+			continue;
+		auto	j = sharedPathArchives.find( { int(game), canonicalResourcePath( indexedPaths[qsizetype(i)] ) } );
+		if ( j != sharedPathArchives.end() && j->second.lock() == pathArchives[i] )
+			sharedPathArchives.erase( j );
+	}
+	pathArchives.clear();
+	std::erase_if( sharedPathArchives, []( const auto & i ) { return i.second.expired(); } );
+	// Closing the resources also reloads the loose files, including those below the top level
+	// subfolders, which the stamp of a folder does not cover
+	for ( const auto & i : indexedPaths ) {
+		if ( QFileInfo( i ).isDir() )
+			staleFolderIndexes.insert( canonicalResourcePath( i ) );
 	}
+	if ( indexed && !indexedPaths.isEmpty() )
+		qDebug() << ResourceIndex::statisticsReport();
+	pathIndexes.clear();
+	indexedPaths.clear();
+	indexed = false;
 }
 
 void GameManager::GameResources::close_materials()
 {
+	QMutexLocker	lock( &resourceLock );
 	if ( sfMaterialDB_ID && !parent ) {
 		for ( auto i = GameManager::nifResourceMap.begin(); i != GameManager::nifResourceMap.end(); i++ ) {
 			if ( i->second->parent == this )
@@ -268,9 +433,22 @@ void GameManager::GameResources::close_materials()
 
 QString GameManager::GameResources::find_file( const std::string_view & fullPath )
 {
-	if ( !ba2File && !dataPaths.isEmpty() )
-		init_archives();
-	if ( ba2File && ba2File->findFile( fullPath ) )
+	QMutexLocker	lock( &resourceLock );
+	bool	found = false;
+	if ( ba2File ) {
+		found = bool( ba2File->findFile( fullPath ) );
+	} else if ( !dataPaths.isEmpty() ) {
+		// The index answers without opening any archive
+		if ( !indexed )
+			init_index();
+		for ( const auto & i : pathIndexes ) {
+			if ( i->contains( fullPath ) ) {
+				found = true;
+				break;
+			}
+		}
+	}
+	if ( found )
 		return QString::fromUtf8( fullPath.data(), qsizetype(fullPath.length()) );
 	if ( parent )
 		return parent->find_file( fullPath );
@@ -286,11 +464,18 @@ static unsigned char * byteArrayAllocFunc( void * bufPtr, size_t nBytes )
 
 bool GameManager::GameResources::get_file( QByteArray & data, const std::string_view & fullPath )
 {
-	if ( !ba2File && !dataPaths.isEmpty() )
-		init_archives();
+	std::shared_ptr< BA2File >	archive;
 	const BA2File::FileInfo *	fd = nullptr;
-	if ( ba2File )
-		fd = ba2File->findFile( fullPath );
+	{
+		// The global lock only covers finding the file, the extraction runs without it
+		QMutexLocker	lock( &resourceLock );
+		// Only the resource paths that contain the file are opened, unless the full archive set is loaded already
+		archive = ba2File;
+		if ( !archive && !dataPaths.isEmpty() )
+			archive = find_archive( fullPath );
+		if ( archive )
+			fd = archive->findFile( fullPath );
+	}
 	if ( !fd ) {
 		if ( parent )
 			return parent->get_file( data, fullPath );
@@ -299,13 +484,19 @@ bool GameManager::GameResources::get_file( QByteArray & data, const std::string_
 		return false;
 	}
 	try {
-		ba2File->extractFile( &data, &byteArrayAllocFunc, *fd );
+		QMutexLocker	extractLock( &( static_cast< LockedArchive * >( archive.get() )->extractLock ) );
+		archive->extractFile( &data, &byteArrayAllocFunc, *fd );
 	} catch ( FO76UtilsError & e ) {
 		if ( std::string_view(e.what()).starts_with( "BA2File: unexpected change to size of loose file" ) ) {
-			close_archives();
+			{
+				// Another thread may have reopened the archives already
+				QMutexLocker	lock( &resourceLock );
+				if ( archive == ba2File || ( !ba2File && find_archive( fullPath ) == archive ) )
+					close_archives();
+			}
 			return get_file( data, fullPath );
 		}
-		QMessageBox::critical( nullptr, "NifSkope error", QString("Error loading resource file '%1': %2").arg( QLatin1String( fullPath.data(), qsizetype(fullPath.length()) ) ).arg( e.what() ) );
+		resourceError( QString("Error loading resource file '%1': %2").arg( QLatin1String( fullPath.data(), qsizetype(fullPath.length()) ) ).arg( e.what() ) );
 		data.resize( 0 );
 		return false;
 	}
@@ -330,12 +521,23 @@ void GameManager::GameResources::list_files(
 	std::set< std::string_view > & fileSet,
 	bool (*fileListFilterFunc)( void * p, const std::string_view & fileName ), void * fileListFilterFuncData )
 {
+	QMutexLocker	lock( &resourceLock );
 	if ( parent )
 		parent->list_files( fileSet, fileListFilterFunc, fileListFilterFuncData );
-	// make sure that archives are loaded
-	if ( !ba2File )
-		init_archives();
-	if ( !( ba2File && ba2File->size() > 0 ) )
+	if ( !ba2File ) {
+		// list the indexed names, the archives do not need to be opened
+		if ( !indexed )
+			init_index();
+		for ( const auto & index : pathIndexes ) {
+			for ( quint32 i = 0; i < index->size(); i++ ) {
+				std::string_view	fileName( index->name( i ) );
+				if ( !fileListFilterFunc || fileListFilterFunc( fileListFilterFuncData, fileName ) )
+					fileSet.insert( fileName );
+			}
+		}
+		return;
+	}
+	if ( !( ba2File->size() > 0 ) )
 		return;
 	list_files_scan_function_data	tmp;
 	tmp.fileSet = &fileSet;
@@ -352,10 +554,14 @@ GameManager::GameManager()
 	QSettings settings;
 	int manager_version = settings.value( GAME_MGR_VER, 0 ).toInt();
 	if ( manager_version == 0 ) {
-		auto dlg = prog_dialog( "Initializing the Game Manager" );
+		// No progress dialog in command line mode
+		QProgressDialog * dlg = nullptr;
+		if ( qobject_cast<QApplication *>( QCoreApplication::instance() ) )
+			dlg = prog_dialog( "Initializing the Game Manager" );
 		// Initial game manager settings
 		init_settings( manager_version, dlg );
-		dlg->close();
+		if ( dlg )
+			dlg->close();
 	}
 
 	if ( manager_version == 1 ) {
@@ -521,6 +727,7 @@ bool GameManager::status( const GameMode game )
 
 GameManager::GameResources * GameManager::addNIFResourcePath( const NifModel * nif, const QString & dataPath )
 {
+	QMutexLocker	lock( &resourceLock );
 	if ( !nif ) [[unlikely]]
 		return &(GameManager::archives[OTHER]);
 
@@ -557,6 +764,7 @@ GameManager::GameResources * GameManager::addNIFResourcePath( const NifModel * n
 
 void GameManager::removeNIFResourcePath( const NifModel * nif )
 {
+	QMutexLocker	lock( &resourceLock );
 	auto	i = nifResourceMap.find( nif );
 	if ( i == nifResourceMap.end() )
 		return;
@@ -567,6 +775,37 @@ void GameManager::removeNIFResourcePath( const NifModel * nif )
 		delete r;
 }
 
+GameManager::GameResources * GameManager::get_resources( const GameMode game )
+{
+	if ( !( game >= OTHER && game < NUM_GAMES ) ) [[unlikely]]
+		return &(archives[OTHER]);
+	return &(archives[game]);
+}
+
+GameManager::GameResources * GameManager::acquireNIFResources( const NifModel * nif )
+{
+	QMutexLocker	lock( &resourceLock );
+	if ( !nif )
+		return &(archives[OTHER]);
+	auto	i = nifResourceMap.find( nif );
+	if ( i == nifResourceMap.end() )
+		return &(archives[get_game(nif)]);
+	// resources of loose NIFs are deleted when the last reference is released
+	GameResources *	r = i->second;
+	r->refCnt++;
+	return r;
+}
+
+void GameManager::releaseNIFResources( GameResources * r )
+{
+	QMutexLocker	lock( &resourceLock );
+	if ( r->parent ) {
+		r->refCnt--;
+		if ( r->refCnt < 0 )
+			delete r;
+	}
+}
+
 std::string GameManager::get_full_path( const QString & name, const char * archive_folder, const char * extension )
 {
 	if ( name.isEmpty() )
@@ -599,6 +838,45 @@ std::string GameManager::get_full_path( const QString & name, const char * archi
 	return s;
 }
 
+std::string GameManager::get_resource_path( const NifModel * nif, const NifItem * item )
+{
+	if ( !nif || !item )
+		return std::string();
+
+	NifValue::Type	vt = item->valueType();
+	if ( vt != NifValue::tStringIndex && vt != NifValue::tSizedString && vt != NifValue::tSizedString16 ) {
+		if ( !( nif->checkVersion( 0x14010003, 0 ) && ( vt == NifValue::tString || vt == NifValue::tFilePath ) ) )
+			return std::string();
+	}
+
+	const char *	archiveFolder = nullptr;
+	const char *	extension = nullptr;
+
+	const NifItem *	parent = item->parent();
+	const QString &	name = item->name();
+	quint32	bsVersion = nif->getBSVersion();
+	if ( parent && bsVersion >= 130 && name == "Name"
+		&& ( parent->name() == "BSLightingShaderProperty" || parent->name() == "BSEffectShaderProperty" ) ) {
+		// Fallout 4, 76 or Starfield material
+		archiveFolder = "materials/";
+		if ( parent->name() == "BSLightingShaderProperty" )
+			extension = ( bsVersion < 170 ? ".bgsm" : ".mat" );
+		else
+			extension = ( bsVersion < 170 ? ".bgem" : ".mat" );
+	} else if ( !( ( parent && parent->name() == "Textures" )
+					|| name == "Path" || name == "Mesh Path" || name.startsWith( "Texture " ) ) ) {
+		return std::string();
+	} else if ( ( parent && parent->name() == "Textures" ) || name.contains( "Texture" ) || ( bsVersion >= 170 && name == "Path" ) ) {
+		archiveFolder = "textures/";
+		extension = ".dds";
+	} else if ( bsVersion >= 170 && name == "Mesh Path" ) {
+		archiveFolder = "geometries/";
+		extension = ".mesh";
+	}
+
+	return get_full_path( nif->resolveString( item ), archiveFolder, extension );
+}
+
 QString GameManager::find_file(
 	const GameMode game, const QString & path, const char * archiveFolder, const char * extension )
 {
@@ -640,10 +918,11 @@ std::uint64_t GameManager::get_material_db_id( const GameMode game )
 
 void GameManager::close_resources( bool nifResourcesFirst )
 {
+	QMutexLocker	lock( &resourceLock );
 	bool	haveNIFResources = false;
 
 	for ( auto i = nifResourceMap.begin(); i != nifResourceMap.end(); i++ ) {
-		if ( i->second->ba2File && i->second->ba2File->size() > 0 )
+		if ( i->second->have_files() )
 			haveNIFResources = true;
 		i->second->close_materials();
 		i->second->close_archives();
@@ -3,14 +3,20 @@
 
 #include "libfo76utils/src/common.hpp"
 
+#include <map>
+#include <memory>
 #include <unordered_map>
+#include <vector>
+#include <QMutex>
 #include <QString>
 #include <QStringList>
 
 class QProgressDialog;
 class NifModel;
+class NifItem;
 class BA2File;
 class CE2MaterialDB;
+class ResourceIndex;
 
 namespace Game
 {
@@ -92,14 +98,35 @@ public:
 	{
 		GameMode	game = OTHER;
 		std::int32_t	refCnt = 0;
-		BA2File *	ba2File = nullptr;
+		// archives are shared with the threads extracting files from them, which do not hold resourceLock
+		std::shared_ptr< BA2File >	ba2File;
 		CE2MaterialDB *	sfMaterials = nullptr;
 		std::uint64_t	sfMaterialDB_ID = 0;
 		GameResources *	parent = nullptr;
 		// list of data paths, empty for archived NIFs
 		QStringList	dataPaths;
+		// file name indexes of the resource paths, loaded from the on-disk cache if possible
+		bool	indexed = false;
+		QStringList	indexedPaths;
+		std::vector< std::shared_ptr< const ResourceIndex > >	pathIndexes;
+		// archives of the resource paths (by index), opened on demand when they contain a requested file
+		// and shared by canonical path with the other resources (see open_path_archive)
+		std::vector< std::shared_ptr< BA2File > >	pathArchives;
 		~GameResources();
+		//! Data paths to load, including the fallback paths
+		QStringList resource_paths() const;
+		//! Load the full archive set into ba2File
 		void init_archives();
+		//! Load or build the file name index of every resource path, without opening the archives if possible
+		void init_index();
+		//! Return the archive of the resource path with the highest priority that contains 'fullPath', opening it if necessary
+		std::shared_ptr< BA2File > find_archive( const std::string_view & fullPath );
+		//! Return the archive of resource path 'i', shared with other resources that use the same path
+		std::shared_ptr< BA2File > open_path_archive( int i );
+		//! Rebuild the file name index of the folder resource path 'i' if 'fullPath' is a loose file added to it
+		bool update_folder_index( int i, const std::string_view & fullPath );
+		//! Are any files indexed or loaded?
+		bool have_files() const;
 		CE2MaterialDB * init_materials();
 		void close_archives();
 		void close_materials();
@@ -112,11 +139,18 @@ public:
 
 	static GameResources * addNIFResourcePath( const NifModel * nif, const QString & dataPath );
 	static void removeNIFResourcePath( const NifModel * nif );
-	static inline GameResources & getNIFResources( const NifModel * nif );
+	//! Return the resources shared by all NIFs of 'game' that have no resource path of their own
+	static GameResources * get_resources( const GameMode game );
+	//! Return the resources of 'nif' with a reference held until releaseNIFResources(), for use on another thread
+	static GameResources * acquireNIFResources( const NifModel * nif );
+	static void releaseNIFResources( GameResources * r );
 
 	//! Convert 'name' to lower case, replace backslashes with forward slashes, and make sure that the path
 	// begins with 'archive_folder' and ends with 'extension' (e.g. "textures" and ".dds").
 	static std::string get_full_path( const QString & name, const char * archive_folder, const char * extension );
+	//! Return the full path (see get_full_path) of the texture, material or mesh file referenced by string 'item',
+	// or an empty string if the item is not a resource path or is empty.
+	static std::string get_resource_path( const NifModel * nif, const NifItem * item );
 	//! Search for file 'path' in the resource archives and folders, and return the full path if the file is found,
 	// or an empty string otherwise.
 	static QString find_file(
@@ -182,6 +216,8 @@ private:
 	static void insert_status( const GameMode game, bool status );
 
 	static GameResources	archives[NUM_GAMES];
+	// guards the archives and nifResourceMap, NIFs may be loaded from worker threads (batch mode, XML checker)
+	static QRecursiveMutex	resourceLock;
 	// resources associated with loose NIF files
 	static std::unordered_map< const NifModel *, GameResources * >	nifResourceMap;
 	static std::uint64_t	material_db_prv_id;
@@ -190,14 +226,6 @@ private:
 	static bool	otherGamesFallback;
 };
 
-inline GameManager::GameResources & GameManager::getNIFResources( const NifModel * nif )
-{
-	auto	i = nifResourceMap.find( nif );
-	if ( i != nifResourceMap.end() ) [[likely]]
-		return *(i->second);
-	return archives[get_game(nif)];
-}
-
 QString GameManager::path( const QString & game )
 {
 	return path( ModeForString(game) );
@@ -4,6 +4,7 @@
 #include "gl/glscene.h"
 #include "gl/renderer.h"
 #include "io/nifstream.h"
+#include "model/niffields.h"
 #include "model/nifmodel.h"
 #include "qtcompat.h"
 #include "glview.h"
@@ -11,18 +12,48 @@
 #include <QDir>
 #include <QBuffer>
 
-
 BSMesh::BSMesh(Scene* s, const QModelIndex& iBlock) : Shape(s, iBlock)
 {
 }
 
 void BSMesh::transformShapes()
 {
-	// TODO: implement this
-#if 0
 	if ( isHidden() )
 		return;
-#endif
+
+	bool wasRigid = transformRigid;
+	transformRigid = true;
+
+	// the skeleton is usually not part of the NIF, skin only if all bones are present
+	if ( skinID >= 0 && !verts.isEmpty() && weightsUNORM.size() == verts.size()
+		&& boneNames.size() == boneTransforms.size() && scene->hasOption(Scene::DoSkinning) ) {
+		skin.resolveBones( findParent( 0 ), boneNames );
+		if ( skin.allBonesFound() ) {
+			if ( !skin.hasInfluences() )
+				skin.setInfluences( weightsUNORM );
+
+			skin.setBoneCount( boneNames.size() );
+			for ( int b = 0; b < boneNames.size(); b++ )
+				skin.setBone( b, scene->view * skin.boneNode( b )->localTrans( 0 ) * boneTransforms.at( b ) );
+
+			skin.skin( verts, norms, tangents, bitangents, transVerts, transNorms, transTangents, transBitangents );
+			transformRigid = false;
+
+			boundSphere = BoundSphere( transVerts );
+			boundSphere.applyInv( viewTrans() );
+			needUpdateBounds = false;
+			invalidateTransformBuffers();
+		}
+	}
+
+	if ( transformRigid && !wasRigid ) {
+		transVerts = verts;
+		transNorms = norms;
+		transTangents = tangents;
+		transBitangents = bitangents;
+		needUpdateBounds = true;
+		invalidateTransformBuffers();
+	}
 }
 
 void BSMesh::drawShapes( NodeList * secondPass )
@@ -40,10 +71,13 @@ void BSMesh::drawShapes( NodeList * secondPass )
 	if ( lodLevel != scene->lodLevel ) {
 		lodLevel = scene->lodLevel;
 		updateData(nif);
+		invalidateBuffers();
 	}
 
-	glPushMatrix();
-	glMultMatrix(viewTrans());
+	if ( transformRigid ) {
+		glPushMatrix();
+		glMultMatrix(viewTrans());
+	}
 
 	glEnable(GL_POLYGON_OFFSET_FILL);
 	if ( drawInSecondPass )
@@ -53,7 +87,7 @@ void BSMesh::drawShapes( NodeList * secondPass )
 
 
 	glEnableClientState(GL_VERTEX_ARRAY);
-	glVertexPointer(3, GL_FLOAT, 0, transVerts.constData());
+	setVertexPointer(transVerts);
 
 	if ( !Node::SELECTING ) [[likely]] {
 		glEnable(GL_FRAMEBUFFER_SRGB);
@@ -61,18 +95,17 @@ void BSMesh::drawShapes( NodeList * secondPass )
 
 		if ( transNorms.count() ) {
 			glEnableClientState(GL_NORMAL_ARRAY);
-			glNormalPointer(GL_FLOAT, 0, transNorms.constData());
+			setNormalPointer(transNorms);
 		}
 
 		if ( transColors.count() && scene->hasOption(Scene::DoVertexColors) ) {
 			glEnableClientState(GL_COLOR_ARRAY);
-			glColorPointer(4, GL_FLOAT, 0, transColors.constData());
+			setColorPointer(transColors);
 		} else {
 			glColor(Color3(1.0f, 1.0f, 1.0f));
 		}
 
-		if ( sortedTriangles.count() )
-			glDrawElements(GL_TRIANGLES, sortedTriangles.count() * 3, GL_UNSIGNED_SHORT, sortedTriangles.constData());
+		drawTriangles(sortedTriangles);
 
 		scene->renderer->stopProgram();
 
@@ -88,8 +121,8 @@ void BSMesh::drawShapes( NodeList * secondPass )
 			glColor4f( 0, 0, 0, 1 );
 		}
 
-		if ( sortedTriangles.count() && !( drawInSecondPass && scene->isSelModeVertex() ) )
-			glDrawElements(GL_TRIANGLES, sortedTriangles.count() * 3, GL_UNSIGNED_SHORT, sortedTriangles.constData());
+		if ( !( drawInSecondPass && scene->isSelModeVertex() ) )
+			drawTriangles(sortedTriangles);
 	}
 
 	glDisableClientState(GL_VERTEX_ARRAY);
@@ -99,7 +132,8 @@ void BSMesh::drawShapes( NodeList * secondPass )
 	if ( scene->isSelModeVertex() )
 		drawVerts();
 
-	glPopMatrix();
+	if ( transformRigid )
+		glPopMatrix();
 }
 
 void BSMesh::drawSelection() const
@@ -127,8 +161,10 @@ void BSMesh::drawSelection() const
 	glDisable(GL_CULL_FACE);
 
 	glDisable(GL_FRAMEBUFFER_SRGB);
-	glPushMatrix();
-	glMultMatrix(viewTrans());
+	if ( transformRigid ) {
+		glPushMatrix();
+		glMultMatrix(viewTrans());
+	}
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
@@ -218,7 +254,7 @@ void BSMesh::drawSelection() const
 		int	s;
 		if ( n == p && ( s = idx.row() ) >= 0 ) {
 			if ( n == "Weights" ) {
-				int	weightsPerVertex = int( nif->get<quint32>(idx.parent().parent(), "Weights Per Vertex") );
+				int	weightsPerVertex = int( nif->get<quint32>(idx.parent().parent(), fieldWeightsPerVertex) );
 				if ( weightsPerVertex > 1 )
 					s /= weightsPerVertex;
 			}
@@ -241,11 +277,11 @@ void BSMesh::drawSelection() const
 		lines( transBitangents, s );
 		lines( transTangents, s, true );
 	} else if ( n == "Skin" ) {
-		auto	iSkin = nif->getBlockIndex( nif->getLink( idx.parent(), "Skin" ) );
+		auto	iSkin = nif->getBlockIndex( nif->getLink( idx.parent(), fieldSkin ) );
 		if ( iSkin.isValid() && nif->isNiBlock( iSkin, "BSSkin::Instance" ) ) {
-			auto	iBoneData = nif->getBlockIndex( nif->getLink( iSkin, "Data" ) );
+			auto	iBoneData = nif->getBlockIndex( nif->getLink( iSkin, fieldData ) );
 			if ( iBoneData.isValid() && nif->isNiBlock( iBoneData, "BSSkin::BoneData" ) ) {
-				auto	iBones = nif->getIndex( iBoneData, "Bone List" );
+				auto	iBones = nif->getIndex( iBoneData, fieldBoneList );
 				int	numBones;
 				if ( iBones.isValid() && nif->isArray( iBones ) && ( numBones = nif->rowCount( iBones ) ) > 0 ) {
 					for ( int i = 0; i < numBones; i++ ) {
@@ -274,14 +310,14 @@ void BSMesh::drawSelection() const
 			s = idx.row();
 
 		QModelIndex	iMeshlets;
-		if ( s < 0 && n == "Meshlets" && ( iMeshlets = nif->getIndex( idx.parent(), "Meshlets" ) ).isValid() ) {
+		if ( s < 0 && n == "Meshlets" && ( iMeshlets = nif->getIndex( idx.parent(), fieldMeshlets ) ).isValid() ) {
 			// draw all meshlets
 			quint32	triangleOffset = 0;
 			quint32	triangleCount = 0;
 			glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
 			int	numMeshlets = nif->rowCount( iMeshlets );
 			for ( int i = 0; i < numMeshlets && triangleOffset < quint32(sortedTriangles.size()); i++ ) {
-				triangleCount = nif->get<quint32>( QModelIndex_child( iMeshlets, i ), "Triangle Count" );
+				triangleCount = nif->get<quint32>( QModelIndex_child( iMeshlets, i ), fieldTriangleCount );
 				std::uint32_t	j = std::uint32_t(i);
 				j = ( ( j & 0x0001U ) << 7 ) | ( ( j & 0x0008U ) << 3 ) | ( ( j & 0x0040U ) >> 1 )
 					| ( ( j & 0x0200U ) >> 5 ) | ( ( j & 0x1000U ) >> 9 )
@@ -330,13 +366,13 @@ void BSMesh::drawSelection() const
 				glVertex( transVerts.value(tri.v1()) );
 				glVertex( transVerts.value(tri.v2()) );
 				glVertex( transVerts.value(tri.v3()) );
-			} else if ( ( iMeshlets = nif->getIndex( idx.parent().parent(), "Meshlets" ) ).isValid() ) {
+			} else if ( ( iMeshlets = nif->getIndex( idx.parent().parent(), fieldMeshlets ) ).isValid() ) {
 				// draw selected meshlet
 				quint32	triangleOffset = 0;
 				quint32	triangleCount = 0;
 				for ( int i = 0; i <= s; i++ ) {
 					triangleOffset += triangleCount;
-					triangleCount = nif->get<quint32>( QModelIndex_child( iMeshlets, i ), "Triangle Count" );
+					triangleCount = nif->get<quint32>( QModelIndex_child( iMeshlets, i ), fieldTriangleCount );
 				}
 				for ( ; triangleCount && triangleOffset < quint32(sortedTriangles.size()); triangleCount-- ) {
 					Triangle tri = sortedTriangles.value( qsizetype(triangleOffset) );
@@ -357,7 +393,8 @@ void BSMesh::drawSelection() const
 	drawSphereSimple(boundSphere.center, boundSphere.radius, 72);
 #endif
 
-	glPopMatrix();
+	if ( transformRigid )
+		glPopMatrix();
 }
 
 BoundSphere BSMesh::bounds() const
@@ -418,7 +455,7 @@ void BSMesh::drawVerts() const
 			if ( n == "Weights" ) {
 				auto	nif = NifModel::fromValidIndex( idx );
 				int	weightsPerVertex;
-				if ( nif && ( weightsPerVertex = nif->get<int>( idx.parent().parent(), "Weights Per Vertex" ) ) > 0 )
+				if ( nif && ( weightsPerVertex = nif->get<int>( idx.parent().parent(), fieldWeightsPerVertex ) ) > 0 )
 					vertexSelected /= weightsPerVertex;
 				else
 					vertexSelected = -1;
@@ -445,7 +482,7 @@ QModelIndex BSMesh::vertexAt( int c ) const
 	if ( !iMeshData.isValid() )
 		return QModelIndex();
 	for ( auto nif = NifModel::fromValidIndex( iMeshData ); nif && nif->blockInherits( iMeshData, "BSGeometry" ); ) {
-		iMeshData = nif->getIndex( iMeshData, "Meshes" );
+		iMeshData = nif->getIndex( iMeshData, fieldMeshes );
 		if ( !( iMeshData.isValid() && nif->isArray( iMeshData ) ) )
 			break;
 		int	l = 0;
@@ -454,10 +491,10 @@ QModelIndex BSMesh::vertexAt( int c ) const
 		iMeshData = QModelIndex_child( iMeshData, l );
 		if ( !iMeshData.isValid() )
 			break;
-		iMeshData = nif->getIndex( iMeshData, "Mesh" );
+		iMeshData = nif->getIndex( iMeshData, fieldMesh );
 		if ( !iMeshData.isValid() )
 			break;
-		iMeshData = nif->getIndex( iMeshData, "Mesh Data" );
+		iMeshData = nif->getIndex( iMeshData, fieldMeshData );
 		if ( !iMeshData.isValid() )
 			break;
 		QModelIndex	iVerts;
@@ -465,20 +502,20 @@ QModelIndex BSMesh::vertexAt( int c ) const
 		if ( idx.isValid() ) {
 			auto	n = idx.data( NifSkopeDisplayRole ).toString();
 			if ( n == "UVs" )
-				iVerts = nif->getIndex( iMeshData, "UVs" );
+				iVerts = nif->getIndex( iMeshData, fieldUVs );
 			else if ( n == "UVs 2" )
-				iVerts = nif->getIndex( iMeshData, "UVs 2" );
+				iVerts = nif->getIndex( iMeshData, fieldUVs2 );
 			else if ( n == "Vertex Colors" )
-				iVerts = nif->getIndex( iMeshData, "Vertex Colors" );
+				iVerts = nif->getIndex( iMeshData, fieldVertexColors );
 			else if ( n == "Normals" )
-				iVerts = nif->getIndex( iMeshData, "Normals" );
+				iVerts = nif->getIndex( iMeshData, fieldNormals );
 			else if ( n == "Tangents" )
-				iVerts = nif->getIndex( iMeshData, "Tangents" );
+				iVerts = nif->getIndex( iMeshData, fieldTangents );
 			else if ( n == "Weights" )
-				iVerts = nif->getIndex( iMeshData, "Weights" );
+				iVerts = nif->getIndex( iMeshData, fieldWeights );
 		}
 		if ( !iVerts.isValid() )
-			iVerts = nif->getIndex( iMeshData, "Vertices" );
+			iVerts = nif->getIndex( iMeshData, fieldVertices );
 		if ( !( iVerts.isValid() && nif->isArray( iVerts ) ) )
 			break;
 		int	n = nif->rowCount( iVerts );
@@ -497,7 +534,7 @@ void BSMesh::updateImpl(const NifModel* nif, const QModelIndex& index)
 		return;
 
 	iData = index;
-	iMeshes = nif->getIndex(index, "Meshes");
+	iMeshes = nif->getIndex(index, fieldMeshes);
 	meshes.clear();
 	for ( int i = 0; i < 4; i++ ) {
 		auto meshArray = QModelIndex_child( iMeshes, i );
@@ -522,6 +559,7 @@ void BSMesh::updateData(const NifModel* nif)
 	gpuLODs.clear();
 	boneNames.clear();
 	boneTransforms.clear();
+	transformRigid = true;
 
 	if ( meshes.size() == 0 )
 		return;
@@ -575,10 +613,10 @@ void BSMesh::updateData(const NifModel* nif)
 		auto idx = nif->getBlockIndex(link);
 		if ( nif->blockInherits(idx, "BSSkin::Instance") ) {
 			iSkin = idx;
-			iSkinData = nif->getBlockIndex(nif->getLink(nif->getIndex(idx, "Data")));
+			iSkinData = nif->getBlockIndex(nif->getLink(nif->getIndex(idx, fieldData)));
 			skinID = nif->getBlockNumber(iSkin);
 
-			auto iBones = nif->getLinkArray(iSkin, "Bones");
+			auto iBones = nif->getLinkArray(iSkin, fieldBones);
 			for ( const auto b : iBones ) {
 				if ( b == -1 )
 					continue;
@@ -586,15 +624,15 @@ void BSMesh::updateData(const NifModel* nif)
 				boneNames.append(nif->resolveString(iBone, "Name"));
 			}
 
-			auto numBones = nif->get<int>(iSkinData, "Num Bones");
+			auto numBones = nif->get<int>(iSkinData, fieldNumBones);
 			boneTransforms.resize(numBones);
-			auto iBoneList = nif->getIndex(iSkinData, "Bone List");
+			auto iBoneList = nif->getIndex(iSkinData, fieldBoneList);
 			for ( int i = 0; i < numBones; i++ ) {
 				auto iBone = QModelIndex_child( iBoneList, i );
 				Transform trans;
-				trans.rotation = nif->get<Matrix>(iBone, "Rotation");
-				trans.translation = nif->get<Vector3>(iBone, "Translation");
-				trans.scale = nif->get<float>(iBone, "Scale");
+				trans.rotation = nif->get<Matrix>(iBone, fieldRotation);
+				trans.translation = nif->get<Vector3>(iBone, fieldTranslation);
+				trans.scale = nif->get<float>(iBone, fieldScale);
 				boneTransforms[i] = trans;
 			}
 		}
@@ -603,10 +641,10 @@ void BSMesh::updateData(const NifModel* nif)
 	for ( const auto link : links ) {
 		auto idx = nif->getBlockIndex(link);
 		if ( nif->blockInherits(idx, "SkinAttach") ) {
-			boneNames = nif->getArray<QString>(idx, "Bones");
+			boneNames = nif->getArray<QString>(idx, fieldBones);
 			if ( std::all_of(boneNames.begin(), boneNames.end(), [](const QString& name) { return name.isEmpty(); }) ) {
 				boneNames.clear();
-				auto iBones = nif->getLinkArray(nif->getIndex(iSkin, "Bones"));
+				auto iBones = nif->getLinkArray(nif->getIndex(iSkin, fieldBones));
 				for ( const auto& b : iBones ) {
 					auto iBone = nif->getBlockIndex(b);
 					boneNames.append(nif->resolveString(iBone, "Name"));
@@ -614,4 +652,12 @@ void BSMesh::updateData(const NifModel* nif)
 			}
 		}
 	}
+
+	// Keep the untransformed vertex data for skinning, the arrays are shared until transformShapes() skins them
+	if ( skinID >= 0 && weightsUNORM.size() == transVerts.size() ) {
+		verts = transVerts;
+		norms = transNorms;
+		tangents = transTangents;
+		bitangents = transBitangents;
+	}
 }
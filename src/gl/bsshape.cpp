@@ -4,6 +4,7 @@
 #include "gl/glscene.h"
 #include "gl/renderer.h"
 #include "io/material.h"
+#include "model/niffields.h"
 #include "model/nifmodel.h"
 #include "qtcompat.h"
 #include "glview.h"
@@ -21,7 +22,7 @@ void BSShape::updateImpl( const NifModel * nif, const QModelIndex & index )
 
 void BSShape::updateData( const NifModel * nif )
 {
-	auto vertexFlags = nif->get<BSVertexDesc>(iBlock, "Vertex Desc");
+	auto vertexFlags = nif->get<BSVertexDesc>(iBlock, fieldVertexDesc);
 
 	isDynamic = nif->blockInherits(iBlock, "BSDynamicTriShape");
 
@@ -43,11 +44,11 @@ void BSShape::updateData( const NifModel * nif )
 			skinDataName = "NiSkinData";
 		}
 
-		iSkin = nif->getBlockIndex( nif->getLink( nif->getIndex( iBlock, "Skin" ) ), skinInstName );
+		iSkin = nif->getBlockIndex( nif->getLink( nif->getIndex( iBlock, fieldSkin ) ), skinInstName );
 		if ( iSkin.isValid() ) {
-			iSkinData = nif->getBlockIndex( nif->getLink( iSkin, "Data" ), skinDataName );
+			iSkinData = nif->getBlockIndex( nif->getLink( iSkin, fieldData ), skinDataName );
 			if ( nif->getBSVersion() == 100 )
-				iSkinPart = nif->getBlockIndex( nif->getLink( iSkin, "Skin Partition" ), "NiSkinPartition" );
+				iSkinPart = nif->getBlockIndex( nif->getLink( iSkin, fieldSkinPartition ), "NiSkinPartition" );
 		}
 	}
 
@@ -57,13 +58,13 @@ void BSShape::updateData( const NifModel * nif )
 	if ( isSkinned && iSkinPart.isValid() ) {
 		// For skinned geometry, the vertex data is stored in the NiSkinPartition
 		// The triangles are split up among the partitions
-		iData = nif->getIndex( iSkinPart, "Vertex Data" );
-		int dataSize = nif->get<int>( iSkinPart, "Data Size" );
-		int vertexSize = nif->get<int>( iSkinPart, "Vertex Size" );
+		iData = nif->getIndex( iSkinPart, fieldVertexData );
+		int dataSize = nif->get<int>( iSkinPart, fieldDataSize );
+		int vertexSize = nif->get<int>( iSkinPart, fieldVertexSize );
 		if ( iData.isValid() && dataSize > 0 && vertexSize > 0 )
 			numVerts = dataSize / vertexSize;
 	} else {
-		iData = nif->getIndex( iBlock, "Vertex Data" );
+		iData = nif->getIndex( iBlock, fieldVertexData );
 		if ( iData.isValid() )
 			numVerts = nif->rowCount( iData );
 	}
@@ -72,7 +73,7 @@ void BSShape::updateData( const NifModel * nif )
 
 	QVector<Vector4> dynVerts;
 	if ( isDynamic ) {
-		dynVerts = nif->getArray<Vector4>( iBlock, "Vertices" );
+		dynVerts = nif->getArray<Vector4>( iBlock, fieldVertices );
 		int nDynVerts = dynVerts.count();
 		if ( nDynVerts < numVerts )
 			numVerts = nDynVerts;
@@ -87,20 +88,20 @@ void BSShape::updateData( const NifModel * nif )
 			verts << Vector3( dynv );
 			bitX = dynv[3];
 		} else {
-			verts << nif->get<Vector3>( idx, "Vertex" );
-			bitX = nif->get<float>( idx, "Bitangent X" );
+			verts << nif->get<Vector3>( idx, fieldVertex );
+			bitX = nif->get<float>( idx, fieldBitangentX );
 		}
 
 		// Bitangent Y/Z
-		auto bitY = nif->get<float>( idx, "Bitangent Y" );
-		auto bitZ = nif->get<float>( idx, "Bitangent Z" );
+		auto bitY = nif->get<float>( idx, fieldBitangentY );
+		auto bitZ = nif->get<float>( idx, fieldBitangentZ );
 
-		coordset << nif->get<HalfVector2>( idx, "UV" );
-		norms += nif->get<ByteVector3>( idx, "Normal" );
-		tangents += nif->get<ByteVector3>( idx, "Tangent" );
+		coordset << nif->get<HalfVector2>( idx, fieldUV );
+		norms += nif->get<ByteVector3>( idx, fieldNormal );
+		tangents += nif->get<ByteVector3>( idx, fieldTangent );
 		bitangents += Vector3( bitX, bitY, bitZ );
 
-		auto vcIdx = nif->getIndex( idx, "Vertex Colors" );
+		auto vcIdx = nif->getIndex( idx, fieldVertexColors );
 		colors += vcIdx.isValid() ? nif->get<ByteColor4>( vcIdx ) : Color4(0, 0, 0, 1);
 	}
 
@@ -111,14 +112,14 @@ void BSShape::updateData( const NifModel * nif )
 
 	// Fill triangle data
 	if ( isSkinned && iSkinPart.isValid() ) {
-		auto iPartitions = nif->getIndex( iSkinPart, "Partitions" );
+		auto iPartitions = nif->getIndex( iSkinPart, fieldPartitions );
 		if ( iPartitions.isValid() ) {
 			int n = nif->rowCount( iPartitions );
 			for ( int i = 0; i < n; i++ )
-				triangles << nif->getArray<Triangle>( nif->index( i, 0, iPartitions ), "Triangles" );
+				triangles << nif->getArray<Triangle>( nif->index( i, 0, iPartitions ), fieldTriangles );
 		}
 	} else {
-		auto iTriData = nif->getIndex( iBlock, "Triangles" );
+		auto iTriData = nif->getIndex( iBlock, fieldTriangles );
 		if ( iTriData.isValid() )
 			triangles = nif->getArray<Triangle>( iTriData );
 	}
@@ -127,11 +128,11 @@ void BSShape::updateData( const NifModel * nif )
 	// Fill skeleton data
 	resetSkeletonData();
 	if ( isSkinned && iSkin.isValid() ) {
-		skeletonRoot = nif->getLink( iSkin, "Skeleton Root" );
+		skeletonRoot = nif->getLink( iSkin, fieldSkeletonRoot );
 		if ( nif->getBSVersion() < 130 )
 			skeletonTrans = Transform( nif, iSkinData );
 
-		bones = nif->getLinkArray( iSkin, "Bones" );
+		bones = nif->getLinkArray( iSkin, fieldBones );
 		auto nTotalBones = bones.count();
 
 		weights.fill( BoneWeights(), nTotalBones );
@@ -141,8 +142,8 @@ void BSShape::updateData( const NifModel * nif )
 
 		for ( int i = 0; i < numVerts; i++ ) {
 			auto idx = nif->index( i, 0, iData );
-			auto wts = nif->getArray<float>( idx, "Bone Weights" );
-			auto bns = nif->getArray<quint8>( idx, "Bone Indices" );
+			auto wts = nif->getArray<float>( idx, fieldBoneWeights );
+			auto bns = nif->getArray<quint8>( idx, fieldBoneIndices );
 			if ( wts.count() < 4 || bns.count() < 4 )
 				continue;
 
@@ -155,7 +156,7 @@ void BSShape::updateData( const NifModel * nif )
 			}
 		}
 
-		auto b = nif->getIndex( iSkinData, "Bone List" );
+		auto b = nif->getIndex( iSkinData, fieldBoneList );
 		for ( int i = 0; i < nTotalWeights; i++ )
 			weights[i].setTransform( nif, QModelIndex_child( b, i ) );
 	}
@@ -171,12 +172,12 @@ QModelIndex BSShape::vertexAt( int idx ) const
 	auto blk = iBlock;
 	if ( iSkinPart.isValid() ) {
 		if ( isDynamic )
-			return QModelIndex_child( nif->getIndex( blk, "Vertices" ), idx );
+			return QModelIndex_child( nif->getIndex( blk, fieldVertices ), idx );
 
 		blk = iSkinPart;
 	}
 
-	return nif->getIndex( QModelIndex_child( nif->getIndex( blk, "Vertex Data" ), idx ), "Vertex" );
+	return nif->getIndex( QModelIndex_child( nif->getIndex( blk, "Vertex Data" ), idx ), fieldVertex );
 }
 
 void BSShape::transformShapes()
@@ -192,51 +193,39 @@ void BSShape::transformShapes()
 
 	Node::transformShapes();
 
+	bool wasRigid = transformRigid;
 	transformRigid = true;
 
 	if ( isSkinned && weights.count() && scene->hasOption(Scene::DoSkinning) ) {
 		transformRigid = false;
 
-		transVerts.resize( numVerts );
-		transVerts.fill( Vector3() );
-		transNorms.resize( numVerts );
-		transNorms.fill( Vector3() );
-		transTangents.resize( numVerts );
-		transTangents.fill( Vector3() );
-		transBitangents.resize( numVerts );
-		transBitangents.fill( Vector3() );
-
-		Node * root = findParent( 0 );
-		for ( const BoneWeights & bw : weights ) {
-			Node * bone = root ? root->findChild( bw.bone ) : nullptr;
-			if ( bone ) {
-				Transform t = scene->view * bone->localTrans( 0 ) * bw.trans;
-				for ( const VertexWeight & w : bw.weights ) {
-					if ( w.vertex >= numVerts )
-						continue;
-
-					transVerts[w.vertex] += t * verts[w.vertex] * w.weight;
-					transNorms[w.vertex] += t.rotation * norms[w.vertex] * w.weight;
-					transTangents[w.vertex] += t.rotation * tangents[w.vertex] * w.weight;
-					transBitangents[w.vertex] += t.rotation * bitangents[w.vertex] * w.weight;
-				}
-			}
+		if ( !skin.hasInfluences() )
+			skin.setInfluences( weights, numVerts );
+
+		skin.resolveBones( findParent( 0 ), bones );
+		skin.setBoneCount( weights.count() );
+		for ( int b = 0; b < weights.count(); b++ ) {
+			Node * bone = skin.boneNode( b );
+			if ( bone )
+				skin.setBone( b, scene->view * bone->localTrans( 0 ) * weights.at( b ).trans );
+			else
+				skin.clearBone( b );
 		}
 
-		for ( int n = 0; n < numVerts; n++ ) {
-			transNorms[n].normalize();
-			transTangents[n].normalize();
-			transBitangents[n].normalize();
-		}
+		skin.skin( verts, norms, tangents, bitangents, transVerts, transNorms, transTangents, transBitangents );
 
 		boundSphere = BoundSphere( transVerts );
 		boundSphere.applyInv( viewTrans() );
 		needUpdateBounds = false;
+		invalidateTransformBuffers();
 	} else {
 		transVerts = verts;
 		transNorms = norms;
 		transTangents = tangents;
 		transBitangents = bitangents;
+		// the buffers still hold the skinned arrays
+		if ( !wasRigid )
+			invalidateTransformBuffers();
 	}
 
 	transColors = colors;
@@ -285,11 +274,11 @@ void BSShape::drawShapes( NodeList * secondPass )
 		glPolygonOffset( 1.0f, 2.0f );
 
 	glEnableClientState( GL_VERTEX_ARRAY );
-	glVertexPointer( 3, GL_FLOAT, 0, transVerts.constData() );
+	setVertexPointer( transVerts );
 
 	if ( !Node::SELECTING ) [[likely]] {
 		glEnableClientState( GL_NORMAL_ARRAY );
-		glNormalPointer( GL_FLOAT, 0, transNorms.constData() );
+		setNormalPointer( transNorms );
 
 		bool doVCs = ( bssp && bssp->hasSF2(ShaderFlags::SLSF2_Vertex_Colors) );
 		// Always do vertex colors for FO4 if colors present
@@ -298,7 +287,7 @@ void BSShape::drawShapes( NodeList * secondPass )
 
 		if ( transColors.count() && scene->hasOption(Scene::DoVertexColors) && doVCs ) {
 			glEnableClientState( GL_COLOR_ARRAY );
-			glColorPointer( 4, GL_FLOAT, 0, transColors.constData() );
+			setColorPointer( transColors );
 		} else if ( nif->getBSVersion() < 130 && !hasVertexColors && (bslsp && bslsp->hasVertexColors) ) {
 			// Correctly blacken the mesh if SLSF2_Vertex_Colors is still on
 			//	yet "Has Vertex Colors" is not.
@@ -333,36 +322,29 @@ void BSShape::drawShapes( NodeList * secondPass )
 
 	if ( isDoubleSided ) {
 		glCullFace( GL_FRONT );
-		glDrawElements( GL_TRIANGLES, triangles.count() * 3, GL_UNSIGNED_SHORT, triangles.constData() );
+		drawTriangles( triangles );
 		glCullFace( GL_BACK );
 	}
 
 	if ( !isLOD ) {
-		glDrawElements( GL_TRIANGLES, triangles.count() * 3, GL_UNSIGNED_SHORT, triangles.constData() );
+		drawTriangles( triangles );
 	} else if ( triangles.count() ) {
-		auto lod0 = nif->get<uint>( iBlock, "LOD0 Size" );
-		auto lod1 = nif->get<uint>( iBlock, "LOD1 Size" );
-		auto lod2 = nif->get<uint>( iBlock, "LOD2 Size" );
-
-		auto lod0tris = triangles.mid( 0, lod0 );
-		auto lod1tris = triangles.mid( lod0, lod1 );
-		auto lod2tris = triangles.mid( lod0 + lod1, lod2 );
+		auto lod0 = nif->get<uint>( iBlock, fieldLOD0Size );
+		auto lod1 = nif->get<uint>( iBlock, fieldLOD1Size );
+		auto lod2 = nif->get<uint>( iBlock, fieldLOD2Size );
 
 		// If Level2, render all
 		// If Level1, also render Level0
 		switch ( scene->lodLevel ) {
 		case Scene::Level0:
-			if ( lod2tris.count() )
-				glDrawElements( GL_TRIANGLES, lod2tris.count() * 3, GL_UNSIGNED_SHORT, lod2tris.constData() );
+			drawTriangles( triangles, qsizetype( lod0 ) + lod1, lod2 );
 			[[fallthrough]];
 		case Scene::Level1:
-			if ( lod1tris.count() )
-				glDrawElements( GL_TRIANGLES, lod1tris.count() * 3, GL_UNSIGNED_SHORT, lod1tris.constData() );
+			drawTriangles( triangles, lod0, lod1 );
 			[[fallthrough]];
 		case Scene::Level2:
 		default:
-			if ( lod0tris.count() )
-				glDrawElements( GL_TRIANGLES, lod0tris.count() * 3, GL_UNSIGNED_SHORT, lod0tris.constData() );
+			drawTriangles( triangles, 0, lod0 );
 			break;
 		}
 	}
@@ -546,17 +528,17 @@ void BSShape::drawSelection() const
 		if ( n == "Bounding Sphere" ) {
 			idxs += idx;
 		} else if ( n.startsWith( "BSPackedCombined" ) ) {
-			auto data = nif->getIndex( idx, "Object Data" );
+			auto data = nif->getIndex( idx, fieldObjectData );
 			int dataCt = nif->rowCount( data );
 
 			for ( int i = 0; i < dataCt; i++ ) {
 				auto d = QModelIndex_child( data, i );
 
-				auto c = nif->getIndex( d, "Combined" );
+				auto c = nif->getIndex( d, fieldCombined );
 				int cCt = nif->rowCount( c );
 
 				for ( int j = 0; j < cCt; j++ ) {
-					idxs += nif->getIndex( QModelIndex_child( c, j ), "Bounding Sphere" );
+					idxs += nif->getIndex( QModelIndex_child( c, j ), fieldBoundingSphere );
 				}
 			}
 		}
@@ -567,9 +549,9 @@ void BSShape::drawSelection() const
 		}
 
 #if 0
-		Vector3 pTrans = nif->get<Vector3>( QModelIndex_child( pBlock, 1 ), "Translation" );
+		Vector3 pTrans = nif->get<Vector3>( QModelIndex_child( pBlock, 1 ), fieldTranslation );
 #endif
-		auto iBSphere = nif->getIndex( pBlock, "Bounding Sphere" );
+		auto iBSphere = nif->getIndex( pBlock, fieldBoundingSphere );
 		Vector3 pbvC = nif->get<Vector3>( QModelIndex_child( iBSphere, 0, 2 ) );
 		float pbvR = nif->get<float>( QModelIndex_child( iBSphere, 1, 2 ) );
 
@@ -583,12 +565,12 @@ void BSShape::drawSelection() const
 		for ( auto i : idxs ) {
 			// Transform compound
 			auto iTrans = QModelIndex_child( i.parent(), 1 );
-			Matrix mat = nif->get<Matrix>( iTrans, "Rotation" );
-			//auto trans = nif->get<Vector3>( iTrans, "Translation" );
-			float scale = nif->get<float>( iTrans, "Scale" );
+			Matrix mat = nif->get<Matrix>( iTrans, fieldRotation );
+			//auto trans = nif->get<Vector3>( iTrans, fieldTranslation );
+			float scale = nif->get<float>( iTrans, fieldScale );
 
-			Vector3 bvC = nif->get<Vector3>( i, "Center" );
-			float bvR = nif->get<float>( i, "Radius" );
+			Vector3 bvC = nif->get<Vector3>( i, fieldCenter );
+			float bvR = nif->get<float>( i, fieldRadius );
 
 			Transform t;
 			t.rotation = mat.inverted();
@@ -787,7 +769,7 @@ void BSShape::drawSelection() const
 	if ( n == "NiSkinData" || n == "BSSkin::BoneData" ) {
 		// Get shape block
 		if ( nif->getBlockIndex( nif->getParent( nif->getParent( blk ) ) ) == iBlock ) {
-			auto iBones = nif->getIndex( blk, "Bone List" );
+			auto iBones = nif->getIndex( blk, fieldBoneList );
 			int ct = nif->rowCount( iBones );
 
 			for ( int i = 0; i < ct; i++ ) {
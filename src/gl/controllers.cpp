@@ -36,6 +36,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "gl/glparticles.h"
 #include "gl/glproperty.h"
 #include "gl/glscene.h"
+#include "model/niffields.h"
 #include "model/nifmodel.h"
 #include "qtcompat.h"
 
@@ -51,23 +52,23 @@ bool ControllerManager::update( const NifModel * nif, const QModelIndex & index
 	if ( Controller::update( nif, index ) ) {
 		if ( target ) {
 			Scene * scene = target->scene;
-			QVector<qint32> lSequences = nif->getLinkArray( index, "Controller Sequences" );
+			QVector<qint32> lSequences = nif->getLinkArray( index, fieldControllerSequences );
 			for ( const auto l : lSequences ) {
 				QModelIndex iSeq = nif->getBlockIndex( l, "NiControllerSequence" );
 
 				if ( iSeq.isValid() ) {
-					QString name = nif->get<QString>( iSeq, "Name" );
+					QString name = nif->get<QString>( iSeq, fieldName );
 
 					if ( !scene->animGroups.contains( name ) ) {
 						scene->animGroups.append( name );
 
 						QMap<QString, float> tags = scene->animTags[name];
 
-						QModelIndex iKeys = nif->getBlockIndex( nif->getLink( iSeq, "Text Keys" ), "NiTextKeyExtraData" );
-						QModelIndex iTags = nif->getIndex( iKeys, "Text Keys" );
+						QModelIndex iKeys = nif->getBlockIndex( nif->getLink( iSeq, fieldTextKeys ), "NiTextKeyExtraData" );
+						QModelIndex iTags = nif->getIndex( iKeys, fieldTextKeys );
 
 						for ( int r = 0; r < nif->rowCount( iTags ); r++ ) {
-							tags.insert( nif->get<QString>( QModelIndex_child( iTags, r ), "Value" ), nif->get<float>( QModelIndex_child( iTags, r ), "Time" ) );
+							tags.insert( nif->get<QString>( QModelIndex_child( iTags, r ), fieldValue ), nif->get<float>( QModelIndex_child( iTags, r ), fieldTime ) );
 						}
 
 						scene->animTags[name] = tags;
@@ -94,63 +95,63 @@ void ControllerManager::setSequence( const QString & seqname )
 			}
 		}
 
-		QVector<qint32> lSequences = nif->getLinkArray( iBlock, "Controller Sequences" );
+		QVector<qint32> lSequences = nif->getLinkArray( iBlock, fieldControllerSequences );
 		for ( const auto l : lSequences ) {
 			QModelIndex iSeq = nif->getBlockIndex( l, "NiControllerSequence" );
 
-			if ( iSeq.isValid() && nif->get<QString>( iSeq, "Name" ) == seqname ) {
-				start = nif->get<float>( iSeq, "Start Time" );
-				stop = nif->get<float>( iSeq, "Stop Time" );
-				phase = nif->get<float>( iSeq, "Phase" );
-				frequency = nif->get<float>( iSeq, "Frequency" );
+			if ( iSeq.isValid() && nif->get<QString>( iSeq, fieldName ) == seqname ) {
+				start = nif->get<float>( iSeq, fieldStartTime );
+				stop = nif->get<float>( iSeq, fieldStopTime );
+				phase = nif->get<float>( iSeq, fieldPhase );
+				frequency = nif->get<float>( iSeq, fieldFrequency );
 
-				QModelIndex iCtrlBlcks = nif->getIndex( iSeq, "Controlled Blocks" );
+				QModelIndex iCtrlBlcks = nif->getIndex( iSeq, fieldControlledBlocks );
 
 				for ( int r = 0; r < nif->rowCount( iCtrlBlcks ); r++ ) {
 					QModelIndex iCB = QModelIndex_child( iCtrlBlcks, r );
 
-					QModelIndex iInterp = nif->getBlockIndex( nif->getLink( iCB, "Interpolator" ), "NiInterpolator" );
+					QModelIndex iInterp = nif->getBlockIndex( nif->getLink( iCB, fieldInterpolator ), "NiInterpolator" );
 
-					QModelIndex iController = nif->getBlockIndex( nif->getLink( iCB, "Controller" ), "NiTimeController" );
+					QModelIndex iController = nif->getBlockIndex( nif->getLink( iCB, fieldController ), "NiTimeController" );
 
-					QString nodename = nif->get<QString>( iCB, "Node Name" );
+					QString nodename = nif->get<QString>( iCB, fieldNodeName );
 
 					if ( nodename.isEmpty() ) {
-						QModelIndex idx = nif->getIndex( iCB, "Node Name Offset" );
+						QModelIndex idx = nif->getIndex( iCB, fieldNodeNameOffset );
 						nodename = idx.sibling( idx.row(), NifModel::ValueCol ).data( NifSkopeDisplayRole ).toString();
 
 						if ( nodename.isEmpty() )
-							nodename = nif->get<QString>( iCB, "Target Name" );
+							nodename = nif->get<QString>( iCB, fieldTargetName );
 					}
 
-					QString proptype = nif->get<QString>( iCB, "Property Type" );
+					QString proptype = nif->get<QString>( iCB, fieldPropertyType );
 
 					if ( proptype.isEmpty() ) {
-						QModelIndex idx = nif->getIndex( iCB, "Property Type Offset" );
+						QModelIndex idx = nif->getIndex( iCB, fieldPropertyTypeOffset );
 						proptype = idx.sibling( idx.row(), NifModel::ValueCol ).data( NifSkopeDisplayRole ).toString();
 					}
 
-					QString ctrltype = nif->get<QString>( iCB, "Controller Type" );
+					QString ctrltype = nif->get<QString>( iCB, fieldControllerType );
 
 					if ( ctrltype.isEmpty() ) {
-						QModelIndex idx = nif->getIndex( iCB, "Controller Type Offset" );
+						QModelIndex idx = nif->getIndex( iCB, fieldControllerTypeOffset );
 						ctrltype = idx.sibling( idx.row(), NifModel::ValueCol ).data( NifSkopeDisplayRole ).toString();
 
 						if ( ctrltype.isEmpty() && iController.isValid() )
 							ctrltype = nif->itemName( iController );
 					}
 
-					QString var1 = nif->get<QString>( iCB, "Controller ID" );
+					QString var1 = nif->get<QString>( iCB, fieldControllerID );
 
 					if ( var1.isEmpty() ) {
-						QModelIndex idx = nif->getIndex( iCB, "Controller ID Offset" );
+						QModelIndex idx = nif->getIndex( iCB, fieldControllerIDOffset );
 						var1 = idx.sibling( idx.row(), NifModel::ValueCol ).data( NifSkopeDisplayRole ).toString();
 					}
 
-					QString var2 = nif->get<QString>( iCB, "Interpolator ID" );
+					QString var2 = nif->get<QString>( iCB, fieldInterpolatorID );
 
 					if ( var2.isEmpty() ) {
-						QModelIndex idx = nif->getIndex( iCB, "Interpolator ID Offset" );
+						QModelIndex idx = nif->getIndex( iCB, fieldInterpolatorIDOffset );
 						var2 = idx.sibling( idx.row(), NifModel::ValueCol ).data( NifSkopeDisplayRole ).toString();
 					}
 
@@ -204,7 +205,7 @@ void ControllerManager::setSequence( const QString & seqname )
 // `NiKeyframeController` blocks
 
 KeyframeController::KeyframeController( Node * node, const QModelIndex & index )
-	: Controller( index ), target( node ), lTrans( 0 ), lRotate( 0 ), lScale( 0 )
+	: Controller( index ), target( node )
 {
 }
 
@@ -215,21 +216,14 @@ void KeyframeController::updateTime( float time )
 
 	time = ctrlTime( time );
 
-	interpolate( target->local.rotation, iRotations, time, lRotate );
-	interpolate( target->local.translation, iTranslations, time, lTrans );
-	interpolate( target->local.scale, iScales, time, lScale );
+	keys.interpolate( target->local, time );
 }
 
 bool KeyframeController::update( const NifModel * nif, const QModelIndex & index )
 {
-	if ( Controller::update( nif, index ) ) {
-		iTranslations = nif->getIndex( iData, "Translations" );
-		iRotations = nif->getIndex( iData, "Rotations" );
-
-		if ( !iRotations.isValid() )
-			iRotations = iData;
-
-		iScales = nif->getIndex( iData, "Scales" );
+	// the decoded keys are stale after an edit of the data block, as in TransformInterpolator::update
+	if ( Controller::update( nif, index ) || ( index.isValid() && index == iData ) ) {
+		keys.load( nif, iData );
 		return true;
 	}
 
@@ -256,6 +250,17 @@ void TransformController::updateTime( float time )
 	}
 }
 
+bool TransformController::update( const NifModel * nif, const QModelIndex & index )
+{
+	bool updated = Controller::update( nif, index );
+
+	// the interpolator decodes its keys again if its data block was edited
+	if ( interpolator && interpolator->update( nif, index ) )
+		updated = true;
+
+	return updated;
+}
+
 void TransformController::setInterpolator( const QModelIndex & idx )
 {
 	auto nif = NifModel::fromValidIndex(idx);
@@ -308,7 +313,7 @@ bool MultiTargetTransformController::update( const NifModel * nif, const QModelI
 			Scene * scene = target->scene;
 			extraTargets.clear();
 
-			QVector<qint32> lTargets = nif->getLinkArray( index, "Extra Targets" );
+			QVector<qint32> lTargets = nif->getLinkArray( index, fieldExtraTargets );
 			for ( const auto l : lTargets ) {
 				Node * node = scene->getNode( nif, nif->getBlockIndex( l ) );
 
@@ -321,13 +326,13 @@ bool MultiTargetTransformController::update( const NifModel * nif, const QModelI
 		return true;
 	}
 
-#if 0
+	bool updated = false;
 	for ( const TransformTarget& tt : extraTargets ) {
-		// TODO: update the interpolators
+		if ( tt.second && tt.second->update( nif, index ) )
+			updated = true;
 	}
-#endif
 
-	return false;
+	return updated;
 }
 
 bool MultiTargetTransformController::setInterpolatorNode( Node * node, const QModelIndex & idx )
@@ -440,6 +445,7 @@ void MorphController::updateTime( float time )
 	}
 
 	target->needUpdateBounds = true;
+	target->invalidateTransformBuffers();
 }
 
 bool MorphController::update( const NifModel * nif, const QModelIndex & index )
@@ -448,15 +454,15 @@ bool MorphController::update( const NifModel * nif, const QModelIndex & index )
 		qDeleteAll( morph );
 		morph.clear();
 
-		QModelIndex midx = nif->getIndex( iData, "Morphs" );
+		QModelIndex midx = nif->getIndex( iData, fieldMorphs );
 
 		for ( int r = 0; r < nif->rowCount( midx ); r++ ) {
 			QModelIndex iInterpolators, iInterpolatorWeights;
 
 			if ( nif->checkVersion( 0, 0x14000005 ) ) {
-				iInterpolators = nif->getIndex( iBlock, "Interpolators" );
+				iInterpolators = nif->getIndex( iBlock, fieldInterpolators );
 			} else if ( nif->checkVersion( 0x14010003, 0 ) ) {
-				iInterpolatorWeights = nif->getIndex( iBlock, "Interpolator Weights" );
+				iInterpolatorWeights = nif->getIndex( iBlock, fieldInterpolatorWeights );
 			}
 
 			QModelIndex iKey = QModelIndex_child( midx, r );
@@ -468,12 +474,12 @@ bool MorphController::update( const NifModel * nif, const QModelIndex & index )
 			if ( iInterpolators.isValid() ) {
 				key->iFrames = nif->getIndex( nif->getBlockIndex( nif->getLink( nif->getBlockIndex( nif->getLink( QModelIndex_child( iInterpolators, r ) ), "NiFloatInterpolator" ), "Data" ), "NiFloatData" ), "Data" );
 			} else if ( iInterpolatorWeights.isValid() ) {
-				key->iFrames = nif->getIndex( nif->getBlockIndex( nif->getLink( nif->getBlockIndex( nif->getLink( QModelIndex_child( iInterpolatorWeights, r ), "Interpolator" ), "NiFloatInterpolator" ), "Data" ), "NiFloatData" ), "Data" );
+				key->iFrames = nif->getIndex( nif->getBlockIndex( nif->getLink( nif->getBlockIndex( nif->getLink( QModelIndex_child( iInterpolatorWeights, r ), fieldInterpolator ), "NiFloatInterpolator" ), "Data" ), "NiFloatData" ), "Data" );
 			} else {
 				key->iFrames = iKey;
 			}
 
-			key->verts = nif->getArray<Vector3>( nif->getIndex( iKey, "Vectors" ) );
+			key->verts = nif->getArray<Vector3>( nif->getIndex( iKey, fieldVectors ) );
 
 			morph.append( key );
 		}
@@ -499,7 +505,7 @@ UVController::~UVController()
 void UVController::updateTime( float time )
 {
 	auto nif = NifModel::fromIndex( iData );
-	QModelIndex uvGroups = nif->getIndex( iData, "UV Groups" );
+	QModelIndex uvGroups = nif->getIndex( iData, fieldUVGroups );
 
 	// U trans, V trans, U scale, V scale
 	// see NiUVData compound in nif.xml
@@ -524,6 +530,7 @@ void UVController::updateTime( float time )
 		}
 	}
 
+	target->invalidateBuffers();
 	target->needUpdateData = true; // TODO (Gavrant): it's probably wrong (because the target shape would reset its UV map then)
 }
 
@@ -565,48 +572,48 @@ bool ParticleController::update( const NifModel * nif, const QModelIndex & index
 		return false;
 
 	if ( Controller::update( nif, index ) || (index.isValid() && iExtras.contains( index )) ) {
-		emitNode = target->scene->getNode( nif, nif->getBlockIndex( nif->getLink( iBlock, "Emitter" ) ) );
-		emitStart = nif->get<float>( iBlock, "Emit Start Time" );
-		emitStop = nif->get<float>( iBlock, "Emit Stop Time" );
-		emitRate = nif->get<float>( iBlock, "Birth Rate" );
-		emitRadius = nif->get<Vector3>( iBlock, "Emitter Dimensions" );
+		emitNode = target->scene->getNode( nif, nif->getBlockIndex( nif->getLink( iBlock, fieldEmitter ) ) );
+		emitStart = nif->get<float>( iBlock, fieldEmitStartTime );
+		emitStop = nif->get<float>( iBlock, fieldEmitStopTime );
+		emitRate = nif->get<float>( iBlock, fieldBirthRate );
+		emitRadius = nif->get<Vector3>( iBlock, fieldEmitterDimensions );
 		emitAccu = 0;
 		emitLast = emitStart;
 
-		spd = nif->get<float>( iBlock, "Speed" );
-		spdRnd = nif->get<float>( iBlock, "Speed Variation" );
+		spd = nif->get<float>( iBlock, fieldSpeed );
+		spdRnd = nif->get<float>( iBlock, fieldSpeedVariation );
 
-		ttl = nif->get<float>( iBlock, "Lifetime" );
-		ttlRnd = nif->get<float>( iBlock, "Lifetime Variation" );
+		ttl = nif->get<float>( iBlock, fieldLifetime );
+		ttlRnd = nif->get<float>( iBlock, fieldLifetimeVariation );
 
-		inc = nif->get<float>( iBlock, "Declination" );
-		incRnd = nif->get<float>( iBlock, "Declination Variation" );
+		inc = nif->get<float>( iBlock, fieldDeclination );
+		incRnd = nif->get<float>( iBlock, fieldDeclinationVariation );
 
-		dec = nif->get<float>( iBlock, "Planar Angle" );
-		decRnd = nif->get<float>( iBlock, "Planar Angle Variation" );
+		dec = nif->get<float>( iBlock, fieldPlanarAngle );
+		decRnd = nif->get<float>( iBlock, fieldPlanarAngleVariation );
 
-		size = nif->get<float>( iBlock, "Initial Size" );
+		size = nif->get<float>( iBlock, fieldInitialSize );
 		grow = 0.0;
 		fade = 0.0;
 
 		list.clear();
 
-		QModelIndex iParticles = nif->getIndex( iBlock, "Particles" );
+		QModelIndex iParticles = nif->getIndex( iBlock, fieldParticles );
 
 		if ( iParticles.isValid() ) {
-			emitMax = nif->get<int>( iBlock, "Num Particles" );
-			int numValid = nif->get<int>( iBlock, "Num Valid" );
+			emitMax = nif->get<int>( iBlock, fieldNumParticles );
+			int numValid = nif->get<int>( iBlock, fieldNumValid );
 
-			//iParticles = nif->getIndex( iParticles, "Particles" );
+			//iParticles = nif->getIndex( iParticles, fieldParticles );
 			//if ( iParticles.isValid() )
 			//{
 			for ( int p = 0; p < numValid && p < nif->rowCount( iParticles ); p++ ) {
 				Particle particle;
-				particle.velocity = nif->get<Vector3>( QModelIndex_child( iParticles, p ), "Velocity" );
-				particle.lifetime = nif->get<float>( QModelIndex_child( iParticles, p ), "Age" );
-				particle.lifespan = nif->get<float>( QModelIndex_child( iParticles, p ), "Life Span" );
-				particle.lasttime = nif->get<float>( QModelIndex_child( iParticles, p ), "Last Update" );
-				particle.vertex = nif->get<int>( QModelIndex_child( iParticles, p ), "Code" );
+				particle.velocity = nif->get<Vector3>( QModelIndex_child( iParticles, p ), fieldVelocity );
+				particle.lifetime = nif->get<float>( QModelIndex_child( iParticles, p ), fieldAge );
+				particle.lifespan = nif->get<float>( QModelIndex_child( iParticles, p ), fieldLifeSpan );
+				particle.lasttime = nif->get<float>( QModelIndex_child( iParticles, p ), fieldLastUpdate );
+				particle.vertex = nif->get<int>( QModelIndex_child( iParticles, p ), fieldCode );
 				// Display saved particle start on initial load
 				list.append( particle );
 			}
@@ -614,14 +621,14 @@ bool ParticleController::update( const NifModel * nif, const QModelIndex & index
 			//}
 		}
 
-		if ( nif->get<bool>( iBlock, "Use Birth Rate" ) == 0 ) {
+		if ( nif->get<bool>( iBlock, fieldUseBirthRate ) == 0 ) {
 			emitRate = emitMax / (ttl + ttlRnd / 2);
 		}
 
 		iExtras.clear();
 		grav.clear();
 		iColorKeys = QModelIndex();
-		QModelIndex iExtra = nif->getBlockIndex( nif->getLink( iBlock, "Particle Modifier" ) );
+		QModelIndex iExtra = nif->getBlockIndex( nif->getLink( iBlock, fieldParticleModifier ) );
 
 		while ( iExtra.isValid() ) {
 			iExtras.append( iExtra );
@@ -629,20 +636,20 @@ bool ParticleController::update( const NifModel * nif, const QModelIndex & index
 			QString name = nif->itemName( iExtra );
 
 			if ( name == "NiParticleGrowFade" ) {
-				grow = nif->get<float>( iExtra, "Grow" );
-				fade = nif->get<float>( iExtra, "Fade" );
+				grow = nif->get<float>( iExtra, fieldGrow );
+				fade = nif->get<float>( iExtra, fieldFade );
 			} else if ( name == "NiParticleColorModifier" ) {
-				iColorKeys = nif->getIndex( nif->getBlockIndex( nif->getLink( iExtra, "Color Data" ), "NiColorData" ), "Data" );
+				iColorKeys = nif->getIndex( nif->getBlockIndex( nif->getLink( iExtra, "Color Data" ), "NiColorData" ), fieldData );
 			} else if ( name == "NiGravity" ) {
 				Gravity g;
-				g.force = nif->get<float>( iExtra, "Force" );
-				g.type = nif->get<int>( iExtra, "Type" );
-				g.position = nif->get<Vector3>( iExtra, "Position" );
-				g.direction = nif->get<Vector3>( iExtra, "Direction" );
+				g.force = nif->get<float>( iExtra, fieldForce );
+				g.type = nif->get<int>( iExtra, fieldType );
+				g.position = nif->get<Vector3>( iExtra, fieldPosition );
+				g.direction = nif->get<Vector3>( iExtra, fieldDirection );
 				grav.append( g );
 			}
 
-			iExtra = nif->getBlockIndex( nif->getLink( iExtra, "Next Modifier" ) );
+			iExtra = nif->getBlockIndex( nif->getLink( iExtra, fieldNextModifier ) );
 		}
 
 		return true;
@@ -852,9 +859,9 @@ bool MaterialColorController::update( const NifModel * nif, const QModelIndex &
 {
 	if ( Controller::update( nif, index ) ) {
 		if ( nif->checkVersion( 0x0A010000, 0 ) ) {
-			tColor = nif->get<int>( iBlock, "Target Color" );
+			tColor = nif->get<int>( iBlock, fieldTargetColor );
 		} else {
-			tColor = ((nif->get<int>( iBlock, "Flags" ) >> 4) & 7);
+			tColor = ((nif->get<int>( iBlock, fieldFlags ) >> 4) & 7);
 		}
 
 		return true;
@@ -900,13 +907,13 @@ void TexFlipController::updateTime( float time )
 bool TexFlipController::update( const NifModel * nif, const QModelIndex & index )
 {
 	if ( Controller::update( nif, index ) ) {
-		flipDelta = nif->get<float>( iBlock, "Delta" );
-		flipSlot = nif->get<int>( iBlock, "Texture Slot" );
+		flipDelta = nif->get<float>( iBlock, fieldDelta );
+		flipSlot = nif->get<int>( iBlock, fieldTextureSlot );
 
 		if ( nif->checkVersion( 0x04000000, 0 ) ) {
-			iSources = nif->getIndex( iBlock, "Sources" );
+			iSources = nif->getIndex( iBlock, fieldSources );
 		} else {
-			iSources = nif->getIndex( iBlock, "Images" );
+			iSources = nif->getIndex( iBlock, fieldImages );
 		}
 
 		return true;
@@ -960,8 +967,8 @@ void TexTransController::updateTime( float time )
 bool TexTransController::update( const NifModel * nif, const QModelIndex & index )
 {
 	if ( Controller::update( nif, index ) ) {
-		texSlot = nif->get<int>( iBlock, "Texture Slot" );
-		texOP = nif->get<int>( iBlock, "Operation" );
+		texSlot = nif->get<int>( iBlock, fieldTextureSlot );
+		texOP = nif->get<int>( iBlock, fieldOperation );
 		return true;
 	}
 
@@ -1041,7 +1048,7 @@ void EffectFloatController::updateTime( float time )
 bool EffectFloatController::update( const NifModel * nif, const QModelIndex & index )
 {
 	if ( Controller::update( nif, index ) ) {
-		variable = EffectFloat::Variable( nif->get<int>( iBlock, "Controlled Variable" ) );
+		variable = EffectFloat::Variable( nif->get<int>( iBlock, fieldControlledVariable ) );
 		return true;
 	}
 
@@ -1077,7 +1084,7 @@ void EffectColorController::updateTime( float time )
 bool EffectColorController::update( const NifModel * nif, const QModelIndex & index )
 {
 	if ( Controller::update( nif, index ) ) {
-		variable = nif->get<int>( iBlock, "Controlled Color" );
+		variable = nif->get<int>( iBlock, fieldControlledColor );
 		return true;
 	}
 
@@ -1143,7 +1150,7 @@ void LightingFloatController::updateTime( float time )
 bool LightingFloatController::update( const NifModel * nif, const QModelIndex & index )
 {
 	if ( Controller::update( nif, index ) ) {
-		variable = LightingFloat::Variable(nif->get<int>( iBlock, "Controlled Variable" ));
+		variable = LightingFloat::Variable(nif->get<int>( iBlock, fieldControlledVariable ));
 		return true;
 	}
 
@@ -1182,7 +1189,7 @@ void LightingColorController::updateTime( float time )
 bool LightingColorController::update( const NifModel * nif, const QModelIndex & index )
 {
 	if ( Controller::update( nif, index ) ) {
-		variable = nif->get<int>( iBlock, "Controlled Color" );
+		variable = nif->get<int>( iBlock, fieldControlledColor );
 		return true;
 	}
 
@@ -74,9 +74,7 @@ public:
 protected:
 	QPointer<Node> target;
 
-	QPersistentModelIndex iTranslations, iRotations, iScales;
-
-	int lTrans, lRotate, lScale;
+	TransformKeys keys;
 };
 
 
@@ -88,6 +86,8 @@ public:
 
 	void updateTime( float time ) override final;
 
+	bool update( const NifModel * nif, const QModelIndex & index ) override final;
+
 	void setInterpolator( const QModelIndex & idx ) override final;
 
 protected:
@@ -33,9 +33,12 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "glcontroller.h"
 
 #include "gl/glscene.h"
+#include "model/niffields.h"
 #include "model/nifmodel.h"
 #include "qtcompat.h"
 
+#include <algorithm>
+
 //! @file glcontroller.cpp Controllable management, Interpolation management
 
 /*
@@ -118,10 +121,10 @@ void IControllable::updateImpl(const NifModel * nif, const QModelIndex & index)
 	}
 
 	if ( doUpdate ) {
-		name = nif->get<QString>( iBlock, "Name" );
+		name = nif->get<QString>( iBlock, fieldName );
 		// sync the list of attached controllers
 		QList<Controller *> rem( controllers );
-		QModelIndex iCtrl = nif->getBlockIndex( nif->getLink( iBlock, "Controller" ) );
+		QModelIndex iCtrl = nif->getBlockIndex( nif->getLink( iBlock, fieldController ) );
 
 		while ( iCtrl.isValid() && nif->blockInherits( iCtrl, "NiTimeController" ) ) {
 			bool add = true;
@@ -136,7 +139,7 @@ void IControllable::updateImpl(const NifModel * nif, const QModelIndex & index)
 			if ( add )
 				setController( nif, iCtrl );
 
-			iCtrl = nif->getBlockIndex( nif->getLink( iCtrl, "Next Controller" ) );
+			iCtrl = nif->getBlockIndex( nif->getLink( iCtrl, fieldNextController ) );
 		}
 
 		for ( Controller * ctrl : rem ) {
@@ -212,18 +215,18 @@ void Controller::setInterpolator( const QModelIndex & index )
 
 	auto nif = NifModel::fromIndex( index );
 	if ( nif )
-		iData = nif->getBlockIndex( nif->getLink( iInterpolator, "Data" ) );
+		iData = nif->getBlockIndex( nif->getLink( iInterpolator, fieldData ) );
 }
 
 bool Controller::update( const NifModel * nif, const QModelIndex & index )
 {
 	if ( index == iBlock && iBlock.isValid() ) {
-		start = nif->get<float>( index, "Start Time" );
-		stop  = nif->get<float>( index, "Stop Time" );
-		phase = nif->get<float>( index, "Phase" );
-		frequency = nif->get<float>( index, "Frequency" );
+		start = nif->get<float>( index, fieldStartTime );
+		stop  = nif->get<float>( index, fieldStopTime );
+		phase = nif->get<float>( index, fieldPhase );
+		frequency = nif->get<float>( index, fieldFrequency );
 
-		int flags = nif->get<int>( index, "Flags" );
+		int flags = nif->get<int>( index, fieldFlags );
 		active = flags & 0x08;
 		extrapolation = (Extrapolation)( ( flags & 0x06 ) >> 1 );
 
@@ -231,12 +234,12 @@ bool Controller::update( const NifModel * nif, const QModelIndex & index )
 		// TODO: Bit 5 (32) - Generally only set when sequences are present.
 		// TODO: Bit 6 (64) - Always seems to be set on Skyrim NIFs, unknown function.
 
-		QModelIndex idx = nif->getBlockIndex( nif->getLink( iBlock, "Interpolator" ) );
+		QModelIndex idx = nif->getBlockIndex( nif->getLink( iBlock, fieldInterpolator ) );
 
 		if ( idx.isValid() ) {
 			setInterpolator( idx );
 		} else {
-			idx = nif->getBlockIndex( nif->getLink( iBlock, "Data" ) );
+			idx = nif->getBlockIndex( nif->getLink( iBlock, fieldData ) );
 
 			if ( idx.isValid() )
 				iData = idx;
@@ -244,7 +247,7 @@ bool Controller::update( const NifModel * nif, const QModelIndex & index )
 	}
 
 	if ( index == iInterpolator && iInterpolator.isValid() )
-		iData = nif->getBlockIndex( nif->getLink( iInterpolator, "Data" ) );
+		iData = nif->getBlockIndex( nif->getLink( iInterpolator, fieldData ) );
 
 	return ( index.isValid() && (index == iBlock || index == iInterpolator || index == iData) );
 }
@@ -302,14 +305,14 @@ bool Controller::timeIndex( float time, const NifModel * nif, const QModelIndex
 	int count;
 
 	if ( array.isValid() && ( count = nif->rowCount( array ) ) > 0 ) {
-		if ( time <= nif->get<float>( QModelIndex_child( array ), "Time" ) ) {
+		if ( time <= nif->get<float>( QModelIndex_child( array ), fieldTime ) ) {
 			i = j = 0;
 			x = 0.0;
 
 			return true;
 		}
 
-		if ( time >= nif->get<float>( QModelIndex_child( array, count - 1 ), "Time" ) ) {
+		if ( time >= nif->get<float>( QModelIndex_child( array, count - 1 ), fieldTime ) ) {
 			i = j = count - 1;
 			x = 0.0;
 
@@ -319,13 +322,13 @@ bool Controller::timeIndex( float time, const NifModel * nif, const QModelIndex
 		if ( i < 0 || i >= count )
 			i = 0;
 
-		float tI = nif->get<float>( QModelIndex_child( array, i ), "Time" );
+		float tI = nif->get<float>( QModelIndex_child( array, i ), fieldTime );
 
 		if ( time > tI ) {
 			j = i + 1;
 			float tJ;
 
-			while ( time >= ( tJ = nif->get<float>( QModelIndex_child( array, j ), "Time" ) ) ) {
+			while ( time >= ( tJ = nif->get<float>( QModelIndex_child( array, j ), fieldTime ) ) ) {
 				i  = j++;
 				tI = tJ;
 			}
@@ -337,7 +340,7 @@ bool Controller::timeIndex( float time, const NifModel * nif, const QModelIndex
 			j = i - 1;
 			float tJ;
 
-			while ( time <= ( tJ = nif->get<float>( QModelIndex_child( array, j ), "Time" ) ) ) {
+			while ( time <= ( tJ = nif->get<float>( QModelIndex_child( array, j ), fieldTime ) ) ) {
 				i  = j--;
 				tI = tJ;
 			}
@@ -375,15 +378,15 @@ template <typename T> bool interpolate( T & value, const QModelIndex & array, fl
 {
 	auto nif = NifModel::fromValidIndex(array);
 	if ( nif ) {
-		QModelIndex frames = nif->getIndex( array, "Keys" );
+		QModelIndex frames = nif->getIndex( array, fieldKeys );
 		int next;
 		float x;
 
 		if ( Controller::timeIndex( time, nif, frames, last, next, x ) ) {
-			T v1 = nif->get<T>( QModelIndex_child( frames, last ), "Value" );
-			T v2 = nif->get<T>( QModelIndex_child( frames, next ), "Value" );
+			T v1 = nif->get<T>( QModelIndex_child( frames, last ), fieldValue );
+			T v2 = nif->get<T>( QModelIndex_child( frames, next ), fieldValue );
 
-			switch ( nif->get<int>( array, "Interpolation" ) ) {
+			switch ( nif->get<int>( array, fieldInterpolation ) ) {
 
 			case 2:
 			{
@@ -395,9 +398,9 @@ template <typename T> bool interpolate( T & value, const QModelIndex & array, fl
 				*/
 
 				// Tangent 1
-				T t1 = nif->get<T>( QModelIndex_child( frames, last ), "Backward" );
+				T t1 = nif->get<T>( QModelIndex_child( frames, last ), fieldBackward );
 				// Tangent 2
-				T t2 = nif->get<T>( QModelIndex_child( frames, next ), "Forward" );
+				T t2 = nif->get<T>( QModelIndex_child( frames, next ), fieldForward );
 
 				float x2 = x * x;
 				float x3 = x2 * x;
@@ -454,10 +457,10 @@ template <> bool Controller::interpolate( bool & value, const QModelIndex & arra
 
 	auto nif = NifModel::fromValidIndex(array);
 	if ( nif ) {
-		QModelIndex frames = nif->getIndex( array, "Keys" );
+		QModelIndex frames = nif->getIndex( array, fieldKeys );
 
 		if ( timeIndex( time, nif, frames, last, next, x ) ) {
-			value = nif->get<int>( QModelIndex_child( frames, last ), "Value" );
+			value = nif->get<int>( QModelIndex_child( frames, last ), fieldValue );
 
 			return true;
 		}
@@ -473,10 +476,10 @@ template <> bool Controller::interpolate( Matrix & value, const QModelIndex & ar
 
 	auto nif = NifModel::fromValidIndex(array);
 	if ( nif ) {
-		switch ( nif->get<int>( array, "Rotation Type" ) ) {
+		switch ( nif->get<int>( array, fieldRotationType ) ) {
 		case 4:
 			{
-				QModelIndex subkeys = nif->getIndex( array, "XYZ Rotations" );
+				QModelIndex subkeys = nif->getIndex( array, fieldXYZRotations );
 
 				if ( subkeys.isValid() ) {
 					float r[3] = {};
@@ -494,11 +497,11 @@ template <> bool Controller::interpolate( Matrix & value, const QModelIndex & ar
 			break;
 		default:
 			{
-				QModelIndex frames = nif->getIndex( array, "Quaternion Keys" );
+				QModelIndex frames = nif->getIndex( array, fieldQuaternionKeys );
 
 				if ( timeIndex( time, nif, frames, last, next, x ) ) {
-					Quat v1 = nif->get<Quat>( QModelIndex_child( frames, last ), "Value" );
-					Quat v2 = nif->get<Quat>( QModelIndex_child( frames, next ), "Value" );
+					Quat v1 = nif->get<Quat>( QModelIndex_child( frames, last ), fieldValue );
+					Quat v2 = nif->get<Quat>( QModelIndex_child( frames, next ), fieldValue );
 
 					if ( Quat::dotproduct( v1, v2 ) < 0 )
 						v1.negate(); // don't take the long path
@@ -525,6 +528,210 @@ template <> bool Controller::interpolate( Matrix & value, const QModelIndex & ar
 	return false;
 }
 
+/*
+ *  KeyGroup
+ */
+
+template <typename T> bool KeyGroup<T>::load( const NifModel * nif, const QModelIndex & group )
+{
+	if ( !( nif && group.isValid() ) ) {
+		clear();
+		return false;
+	}
+
+	return load( nif, nif->getIndex( group, fieldKeys ), nif->get<int>( group, fieldInterpolation ) );
+}
+
+template <typename T> bool KeyGroup<T>::load( const NifModel * nif, const QModelIndex & keys, int keyType )
+{
+	clear();
+
+	int count;
+	if ( !( nif && keys.isValid() && ( count = nif->rowCount( keys ) ) > 0 ) )
+		return false;
+
+	type = keyType;
+	times.resize( count );
+	values.resize( count );
+	if ( type == 2 ) {
+		forward.resize( count );
+		backward.resize( count );
+	}
+
+	for ( int r = 0; r < count; r++ ) {
+		QModelIndex iKey = QModelIndex_child( keys, r );
+		times[r] = nif->get<float>( iKey, fieldTime );
+		values[r] = nif->get<T>( iKey, fieldValue );
+		if ( type == 2 ) {
+			forward[r] = nif->get<T>( iKey, fieldForward );
+			backward[r] = nif->get<T>( iKey, fieldBackward );
+		}
+	}
+
+	return true;
+}
+
+template <typename T> void KeyGroup<T>::clear()
+{
+	times.clear();
+	values.clear();
+	forward.clear();
+	backward.clear();
+	type = 1;
+}
+
+template <typename T> bool KeyGroup<T>::timeIndex( float time, int & i, int & j, float & x ) const
+{
+	qsizetype count = times.size();
+	if ( count < 1 )
+		return false;
+
+	const float * t = times.constData();
+	x = 0.0f;
+
+	if ( time <= t[0] ) {
+		i = j = 0;
+		return true;
+	}
+
+	if ( time >= t[count - 1] ) {
+		i = j = int( count - 1 );
+		return true;
+	}
+
+	// Playback mostly stays within the same pair of keys or moves on to the next one,
+	// try those before searching
+	if ( i < 0 || i >= count - 1 || !( t[i] <= time ) ) {
+		i = int( std::upper_bound( t, t + count, time ) - t ) - 1;
+	} else if ( !( time < t[i + 1] ) ) {
+		if ( i + 2 < count && time < t[i + 2] )
+			i++;
+		else
+			i = int( std::upper_bound( t + i + 1, t + count, time ) - t ) - 1;
+	}
+
+	j = i + 1;
+	x = ( time - t[i] ) / ( t[j] - t[i] );
+
+	return true;
+}
+
+template <typename T> bool KeyGroup<T>::interpolate( T & value, float time, int & last ) const
+{
+	int next;
+	float x;
+
+	if ( !timeIndex( time, last, next, x ) )
+		return false;
+
+	const T & v1 = values.at( last );
+	const T & v2 = values.at( next );
+
+	switch ( type ) {
+	case 2:
+		{
+			// Cubic Hermite spline with the same tangents as Controller::interpolate()
+			float x2 = x * x;
+			float x3 = x2 * x;
+			float h1 = 2.0f * x3 - 3.0f * x2 + 1.0f;
+			float h2 = -2.0f * x3 + 3.0f * x2;
+			float h3 = x3 - 2.0f * x2 + x;
+			float h4 = x3 - x2;
+
+			value = v1 * h1 + v2 * h2 + backward.at( last ) * h3 + forward.at( next ) * h4;
+		}
+		return true;
+	case 5:
+		// Constant
+		value = ( x < 0.5f ) ? v1 : v2;
+		return true;
+	default:
+		value = v1 + ( v2 - v1 ) * x;
+		return true;
+	}
+}
+
+template <> bool KeyGroup<Quat>::interpolate( Quat & value, float time, int & last ) const
+{
+	int next;
+	float x;
+
+	if ( !timeIndex( time, last, next, x ) )
+		return false;
+
+	Quat v1 = values.at( last );
+	const Quat & v2 = values.at( next );
+
+	if ( Quat::dotproduct( v1, v2 ) < 0 )
+		v1.negate(); // don't take the long path
+
+	value = Quat::slerp( x, v1, v2 );
+	return true;
+}
+
+template class KeyGroup<float>;
+template class KeyGroup<Vector3>;
+template class KeyGroup<Color3>;
+template class KeyGroup<Color4>;
+template class KeyGroup<Quat>;
+
+
+/*
+ *  TransformKeys
+ */
+
+void TransformKeys::load( const NifModel * nif, const QModelIndex & iData )
+{
+	clear();
+	if ( !( nif && iData.isValid() ) )
+		return;
+
+	int rotationType = nif->get<int>( iData, fieldRotationType );
+	if ( rotationType == 4 ) {
+		QModelIndex subkeys = nif->getIndex( iData, fieldXYZRotations );
+		useXYZ = subkeys.isValid();
+		for ( int s = 0; s < 3 && s < nif->rowCount( subkeys ); s++ )
+			xyzRotations[s].load( nif, QModelIndex_child( subkeys, s ) );
+	} else {
+		rotations.load( nif, nif->getIndex( iData, fieldQuaternionKeys ), rotationType );
+	}
+
+	translations.load( nif, nif->getIndex( iData, fieldTranslations ) );
+	scales.load( nif, nif->getIndex( iData, fieldScales ) );
+}
+
+void TransformKeys::clear()
+{
+	rotations.clear();
+	for ( auto & k : xyzRotations )
+		k.clear();
+	translations.clear();
+	scales.clear();
+	useXYZ = false;
+
+	lRotate = lTrans = lScale = 0;
+	lXYZ[0] = lXYZ[1] = lXYZ[2] = 0;
+}
+
+void TransformKeys::interpolate( Transform & tm, float time )
+{
+	if ( useXYZ ) {
+		float r[3] = {};
+		for ( int s = 0; s < 3; s++ )
+			xyzRotations[s].interpolate( r[s], time, lXYZ[s] );
+
+		tm.rotation = Matrix::euler( 0, 0, r[2] ) * Matrix::euler( 0, r[1], 0 ) * Matrix::euler( r[0], 0, 0 );
+	} else {
+		Quat q;
+		if ( rotations.interpolate( q, time, lRotate ) )
+			tm.rotation.fromQuat( q );
+	}
+
+	translations.interpolate( tm.translation, time, lTrans );
+	scales.interpolate( tm.scale, time, lScale );
+}
+
+
 /*********************************************************************
 Simple b-spline curve algorithm
 
@@ -538,29 +745,6 @@ Modified by: Theo
 - removed point structure in favor of arbitrary sized float array
 **********************************************************************/
 
-/*! Used to enable static arrays to be members of vectors */
-template <typename T>
-struct qarray
-{
-	qarray( const QModelIndex & array, uint off = 0 )
-		: array_( array ), off_( off )
-	{
-		nif_ = NifModel::fromIndex( array_ );
-	}
-	qarray( const qarray & other, uint off = 0 )
-		: nif_( other.nif_ ), array_( other.array_ ), off_( other.off_ + off )
-	{
-	}
-
-	T operator[]( uint index ) const
-	{
-		return nif_->get<T>( QModelIndex_child( array_, index + off_ ) );
-	}
-	const NifModel * nif_;
-	const QModelIndex & array_;
-	uint off_;
-};
-
 template <typename T>
 struct SplineTraits
 {
@@ -577,13 +761,13 @@ struct SplineTraits
 		return ( sizeof(T) / sizeof(float) );
 	}
 
-	// Compute point from short array and mult/bias
-	static T & Compute( T & v, qarray<short> & c, float mult )
+	// Compute point from decoded control points and mult/bias
+	static T & Compute( T & v, const float * c, float mult )
 	{
 		float * vf = (float *)&v; // assume default data is a vector of floats. specialize if necessary.
 
 		for ( int i = 0; i < CountOf(); ++i )
-			vf[i] = vf[i] + ( float(c[i]) / float(SHRT_MAX) ) * mult;
+			vf[i] = vf[i] + c[i] * mult;
 
 		return v;
 	}
@@ -605,10 +789,10 @@ template <> struct SplineTraits<Quat>
 		v = Quat(); v[0] = 0.0f; return v;
 	}
 	static int CountOf() { return 4; }
-	static Quat & Compute( Quat & v, qarray<short> & c, float mult )
+	static Quat & Compute( Quat & v, const float * c, float mult )
 	{
 		for ( int i = 0; i < CountOf(); ++i )
-			v[i] = v[i] + ( float(c[i]) / float(SHRT_MAX) ) * mult;
+			v[i] = v[i] + c[i] * mult;
 
 		return v;
 	}
@@ -622,7 +806,7 @@ template <> struct SplineTraits<Quat>
 };
 
 // calculate the blending value
-static float blend( int k, int t, int * u, float v )
+static float blend( int k, int t, const int * u, float v )
 {
 	float value;
 
@@ -658,41 +842,44 @@ static void compute_intervals( int * u, int n, int t )
 }
 
 template <typename T>
-static void compute_point( int * u, int n, int t, float v, qarray<short> & control, T & output, float mult, float bias )
+static void compute_point( const int * u, int n, int t, float v, const float * control, T & output, float mult, float bias )
 {
 	// initialize the variables that will hold our output
 	int l = SplineTraits<T>::CountOf();
 	SplineTraits<T>::Init( output );
 
 	for ( int k = 0; k <= n; k++ ) {
-		qarray<short> qa( control, k * l );
-		SplineTraits<T>::Compute( output, qa, blend( k, t, u, v ) );
+		// the basis function of control point k is zero outside of [u[k], u[k+t])
+		if ( v < float(u[k]) || v >= float(u[k + t]) )
+			continue;
+
+		SplineTraits<T>::Compute( output, control + k * l, blend( k, t, u, v ) );
 	}
 
 	SplineTraits<T>::Adjust( output, mult, bias );
 }
 
 template <typename T>
-bool bsplineinterpolate( T & value, int degree, float interval, uint nctrl, const QModelIndex & array, uint off, float mult, float bias )
+bool bsplineinterpolate( T & value, int degree, float interval, uint nctrl, const QVector<float> & control, const QVector<int> & knots, uint off, float mult, float bias )
 {
 	if ( off == USHRT_MAX )
 		return false;
 
-	qarray<short> subArray( array, off );
 	int t = degree + 1;
 	int n = nctrl - 1;
 	int l = SplineTraits<T>::CountOf();
 
+	if ( n < 0 || qsizetype(off) + qsizetype(nctrl) * l > control.size() || knots.size() != n + t + 1 )
+		return false;
+
+	const float * subArray = control.constData() + off;
+
 	if ( interval >= float(nctrl - degree) ) {
 		SplineTraits<T>::Init( value );
-		qarray<short> sa( subArray, n * l );
-		SplineTraits<T>::Compute( value, sa, 1.0f );
+		SplineTraits<T>::Compute( value, subArray + n * l, 1.0f );
 		SplineTraits<T>::Adjust( value, mult, bias );
 	} else {
-		int * u = new int[ n + t + 1 ];
-		compute_intervals( u, n, t );
-		compute_point( u, n, t, interval, subArray, value, mult, bias );
-		delete [] u;
+		compute_point( knots.constData(), n, t, interval, subArray, value, mult, bias );
 	}
 
 	return true;
@@ -713,33 +900,31 @@ QPersistentModelIndex Interpolator::GetControllerData()
 }
 
 TransformInterpolator::TransformInterpolator( Controller * owner )
-	: Interpolator( owner ), lTrans( 0 ), lRotate( 0 ), lScale( 0 )
+	: Interpolator( owner )
 {
 }
 
 bool TransformInterpolator::update( const NifModel * nif, const QModelIndex & index )
 {
-	if ( Interpolator::update( nif, index ) ) {
-		QModelIndex iData = nif->getBlockIndex( nif->getLink( index, "Data" ), "NiKeyframeData" );
-		iTranslations = nif->getIndex( iData, "Translations" );
-		iRotations = nif->getIndex( iData, "Rotations" );
-
-		if ( !iRotations.isValid() )
-			iRotations = iData;
-
-		iScales = nif->getIndex( iData, "Scales" );
+	if ( !Interpolator::update( nif, index ) )
+		return false;
 
-		return true;
+	if ( iBlock.isValid() && index != iBlock ) {
+		if ( !( index.isValid() && index == iKeyData ) )
+			return false;
+	} else {
+		iBlock = index;
+		iKeyData = nif->getBlockIndex( nif->getLink( index, fieldData ), "NiKeyframeData" );
 	}
 
-	return false;
+	keys.load( nif, iKeyData );
+
+	return true;
 }
 
 bool TransformInterpolator::updateTransform( Transform & tm, float time )
 {
-	Controller::interpolate( tm.rotation, iRotations, time, lRotate );
-	Controller::interpolate( tm.translation, iTranslations, time, lTrans );
-	Controller::interpolate( tm.scale, iScales, time, lScale );
+	keys.interpolate( tm, time );
 
 	return true;
 }
@@ -751,34 +936,57 @@ BSplineTransformInterpolator::BSplineTransformInterpolator( Controller * owner )
 
 bool BSplineTransformInterpolator::update( const NifModel * nif, const QModelIndex & index )
 {
+	if ( iBlock.isValid() && index != iBlock ) {
+		// an edit of the spline or basis data block, decode everything again
+		if ( !( index.isValid() && ( index == iSpline || index == iBasis ) ) )
+			return false;
+
+		return update( nif, iBlock );
+	}
+
 	if ( Interpolator::update( nif, index ) ) {
-		start = nif->get<float>( index, "Start Time" );
-		stop  = nif->get<float>( index, "Stop Time" );
+		iBlock = index;
+		start = nif->get<float>( index, fieldStartTime );
+		stop  = nif->get<float>( index, fieldStopTime );
 
-		iSpline = nif->getBlockIndex( nif->getLink( index, "Spline Data" ) );
-		iBasis  = nif->getBlockIndex( nif->getLink( index, "Basis Data" ) );
+		iSpline = nif->getBlockIndex( nif->getLink( index, fieldSplineData ) );
+		iBasis  = nif->getBlockIndex( nif->getLink( index, fieldBasisData ) );
 
 		if ( iSpline.isValid() )
-			iControl = nif->getIndex( iSpline, "Compact Control Points" );
+			iControl = nif->getIndex( iSpline, fieldCompactControlPoints );
 
 		if ( iBasis.isValid() )
-			nCtrl = nif->get<uint>( iBasis, "Num Control Points" );
-
-		auto trans = nif->getIndex( index, "Transform" );
-
-		lTrans  = nif->getIndex( trans, "Translation" );
-		lRotate = nif->getIndex( trans, "Rotation" );
-		lScale  = nif->getIndex( trans, "Scale" );
+			nCtrl = nif->get<uint>( iBasis, fieldNumControlPoints );
+
+		auto trans = nif->getIndex( index, fieldTransform );
+
+		lTrans  = nif->getIndex( trans, fieldTranslation );
+		lRotate = nif->getIndex( trans, fieldRotation );
+		lScale  = nif->getIndex( trans, fieldScale );
+
+		lTransOff   = nif->get<uint>( index, fieldTranslationHandle );
+		lRotateOff  = nif->get<uint>( index, fieldRotationHandle );
+		lScaleOff   = nif->get<uint>( index, fieldScaleHandle );
+		lTransMult  = nif->get<float>( index, fieldTranslationHalfRange );
+		lRotateMult = nif->get<float>( index, fieldRotationHalfRange );
+		lScaleMult  = nif->get<float>( index, fieldScaleHalfRange );
+		lTransBias  = nif->get<float>( index, fieldTranslationOffset );
+		lRotateBias = nif->get<float>( index, fieldRotationOffset );
+		lScaleBias  = nif->get<float>( index, fieldScaleOffset );
+
+		controlPoints.clear();
+		if ( iControl.isValid() ) {
+			int count = nif->rowCount( iControl );
+			controlPoints.resize( count );
+			for ( int r = 0; r < count; r++ )
+				controlPoints[r] = float( nif->get<short>( QModelIndex_child( iControl, r ) ) ) / float(SHRT_MAX);
+		}
 
-		lTransOff   = nif->get<uint>( index, "Translation Handle" );
-		lRotateOff  = nif->get<uint>( index, "Rotation Handle" );
-		lScaleOff   = nif->get<uint>( index, "Scale Handle" );
-		lTransMult  = nif->get<float>( index, "Translation Half Range" );
-		lRotateMult = nif->get<float>( index, "Rotation Half Range" );
-		lScaleMult  = nif->get<float>( index, "Scale Half Range" );
-		lTransBias  = nif->get<float>( index, "Translation Offset" );
-		lRotateBias = nif->get<float>( index, "Rotation Offset" );
-		lScaleBias  = nif->get<float>( index, "Scale Offset" );
+		knots.clear();
+		if ( nCtrl > 0 ) {
+			knots.resize( nCtrl + degree + 1 );
+			compute_intervals( knots.data(), nCtrl - 1, degree + 1 );
+		}
 
 		return true;
 	}
@@ -791,11 +999,11 @@ bool BSplineTransformInterpolator::updateTransform( Transform & transform, float
 	float interval = ( ( time - start ) / ( stop - start ) ) * float(nCtrl - degree);
 	Quat q = transform.rotation.toQuat();
 
-	if ( ::bsplineinterpolate<Quat>( q, degree, interval, nCtrl, iControl, lRotateOff, lRotateMult, lRotateBias ) )
+	if ( ::bsplineinterpolate<Quat>( q, degree, interval, nCtrl, controlPoints, knots, lRotateOff, lRotateMult, lRotateBias ) )
 		transform.rotation.fromQuat( q );
 
-	::bsplineinterpolate<Vector3>( transform.translation, degree, interval, nCtrl, iControl, lTransOff, lTransMult, lTransBias );
-	::bsplineinterpolate<float>( transform.scale, degree, interval, nCtrl, iControl, lScaleOff, lScaleMult, lScaleBias );
+	::bsplineinterpolate<Vector3>( transform.translation, degree, interval, nCtrl, controlPoints, knots, lTransOff, lTransMult, lTransBias );
+	::bsplineinterpolate<float>( transform.scale, degree, interval, nCtrl, controlPoints, knots, lScaleOff, lScaleMult, lScaleBias );
 
 	return true;
 }
@@ -40,7 +40,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QString>
 
 
-//! @file glcontroller.h Controller, Interpolator, TransformInterpolator, BSplineTransformInterpolator
+//! @file glcontroller.h Controller, KeyGroup, TransformKeys, Interpolator, TransformInterpolator, BSplineTransformInterpolator
 
 class Transform;
 
@@ -135,6 +135,69 @@ template <typename T> bool Controller::interpolate( T & value, const QModelIndex
 	return false;
 }
 
+/*! A KeyGroup decoded from the model into contiguous arrays of times and values
+ *
+ * Sampling does not touch the model, so the keys are decoded once when the controller is set up
+ * and again when the data block is edited.
+ */
+template <typename T> class KeyGroup
+{
+public:
+	//! Decodes the "Interpolation" and "Keys" of the KeyGroup at \a group, returns false if it has no keys
+	bool load( const NifModel * nif, const QModelIndex & group );
+	//! Decodes the key array \a keys with the key type \a type
+	bool load( const NifModel * nif, const QModelIndex & keys, int type );
+
+	void clear();
+
+	bool isEmpty() const { return times.isEmpty(); }
+	qsizetype size() const { return times.size(); }
+
+	/*! Finds the keys around a time, same results as Controller::timeIndex()
+	 *
+	 * @param[in]     time	The controller time
+	 * @param[in,out] i		The previous key, the result of the last call is tried first
+	 * @param[out]    j		The next key
+	 * @param[out]    x		The fraction of the way from key \a i to key \a j
+	 */
+	bool timeIndex( float time, int & i, int & j, float & x ) const;
+
+	//! Interpolates the value at \a time, \a last is the cursor kept between calls
+	bool interpolate( T & value, float time, int & last ) const;
+
+protected:
+	QVector<float> times;
+	QVector<T> values;
+	//! Tangents of quadratic keys, empty for the other key types
+	QVector<T> forward, backward;
+	int type = 1;
+};
+
+template <> bool KeyGroup<Quat>::interpolate( Quat & value, float time, int & last ) const;
+
+//! The rotation, translation and scale keys of a `NiKeyframeData` or `NiTransformData` block
+class TransformKeys
+{
+public:
+	//! Decodes the keys of the data block \a iData, leaves them empty if it is not valid
+	void load( const NifModel * nif, const QModelIndex & iData );
+
+	void clear();
+
+	//! Sets the animated components of \a tm for \a time
+	void interpolate( Transform & tm, float time );
+
+protected:
+	KeyGroup<Quat> rotations;
+	KeyGroup<float> xyzRotations[3];
+	KeyGroup<Vector3> translations;
+	KeyGroup<float> scales;
+	bool useXYZ = false;
+
+	int lRotate = 0, lTrans = 0, lScale = 0;
+	int lXYZ[3] = {};
+};
+
 class Interpolator : public QObject
 {
 public:
@@ -152,12 +215,13 @@ class TransformInterpolator : public Interpolator
 public:
 	TransformInterpolator( Controller * owner );
 
+	//! Update for the interpolator block, or re-decode the keys if \a index is its data block
 	bool update( const NifModel * nif, const QModelIndex & index ) override;
 	virtual bool updateTransform( Transform & tm, float time );
 
 protected:
-	QPersistentModelIndex iTranslations, iRotations, iScales;
-	int lTrans, lRotate, lScale;
+	QPersistentModelIndex iBlock, iKeyData;
+	TransformKeys keys;
 };
 
 class BSplineTransformInterpolator : public TransformInterpolator
@@ -177,6 +241,11 @@ protected:
 	float lTransBias = 0, lRotateBias = 0, lScaleBias = 0;
 	uint nCtrl = 0;
 	int degree = 3;
+
+	//! The compact control points scaled to [-1, 1]
+	QVector<float> controlPoints;
+	//! The knot vector for nCtrl and degree
+	QVector<int> knots;
 };
 
 
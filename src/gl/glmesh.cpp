@@ -38,6 +38,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "gl/renderer.h"
 #include "io/material.h"
 #include "io/nifstream.h"
+#include "model/niffields.h"
 #include "model/nifmodel.h"
 #include "qtcompat.h"
 #include "glview.h"
@@ -64,6 +65,7 @@ void Mesh::updateImpl( const NifModel * nif, const QModelIndex & index )
 
 	} else if ( index == iData || index == iTangentData ) {
 		needUpdateData = true;
+		invalidateBuffers();
 
 	}
 }
@@ -82,31 +84,31 @@ void Mesh::updateData( const NifModel * nif )
 	if ( iSkin.isValid() ) {
 		isSkinned = true;
 
-		iSkinData = nif->getBlockIndex( nif->getLink( iSkin, "Data" ), "NiSkinData" );
+		iSkinData = nif->getBlockIndex( nif->getLink( iSkin, fieldData ), "NiSkinData" );
 
-		iSkinPart = nif->getBlockIndex( nif->getLink( iSkin, "Skin Partition" ), "NiSkinPartition" );
+		iSkinPart = nif->getBlockIndex( nif->getLink( iSkin, fieldSkinPartition ), "NiSkinPartition" );
 		if ( !iSkinPart.isValid() && iSkinData.isValid() ) {
 			// nif versions < 10.2.0.0 have skin partition linked in the skin data block
-			iSkinPart = nif->getBlockIndex( nif->getLink( iSkinData, "Skin Partition" ), "NiSkinPartition" );
+			iSkinPart = nif->getBlockIndex( nif->getLink( iSkinData, fieldSkinPartition ), "NiSkinPartition" );
 		}
 
-		skeletonRoot = nif->getLink( iSkin, "Skeleton Root" );
+		skeletonRoot = nif->getLink( iSkin, fieldSkeletonRoot );
 		skeletonTrans = Transform( nif, iSkinData );
 
-		bones = nif->getLinkArray( iSkin, "Bones" );
+		bones = nif->getLinkArray( iSkin, fieldBones );
 
-		QModelIndex idxBones = nif->getIndex( iSkinData, "Bone List" );
+		QModelIndex idxBones = nif->getIndex( iSkinData, fieldBoneList );
 		if ( idxBones.isValid() ) {
 			int nTotalBones = bones.count();
 			int nBoneList = nif->rowCount( idxBones );
 			// Ignore weights listed in NiSkinData if NiSkinPartition exists
-			int vcnt = ( nif->get<unsigned char>( iSkinData, "Has Vertex Weights" ) && !iSkinPart.isValid() ) ? numVerts : 0;
+			int vcnt = ( nif->get<unsigned char>( iSkinData, fieldHasVertexWeights ) && !iSkinPart.isValid() ) ? numVerts : 0;
 			for ( int b = 0; b < nBoneList && b < nTotalBones; b++ )
 				weights.append( BoneWeights( nif, QModelIndex_child( idxBones, b ), bones[b], vcnt ) );
 		}
 
 		if ( iSkinPart.isValid() ) {
-			QModelIndex idx = nif->getIndex( iSkinPart, "Partitions" );
+			QModelIndex idx = nif->getIndex( iSkinPart, fieldPartitions );
 
 			uint numTris = 0;
 			uint numStrips = 0;
@@ -132,7 +134,7 @@ void Mesh::updateData( const NifModel * nif )
 
 void Mesh::updateData_NiMesh( const NifModel * nif )
 {
-	iData = nif->getIndex( iBlock, "Datastreams" );
+	iData = nif->getIndex( iBlock, fieldDatastreams );
 	if ( !iData.isValid() )
 		return;
 	int nTotalStreams = nif->rowCount( iData );
@@ -147,26 +149,26 @@ void Mesh::updateData_NiMesh( const NifModel * nif )
 	for ( int i = 0; i < nTotalStreams; i++ ) {
 		auto iStreamEntry = QModelIndex_child( iData, i );
 
-		auto stream = nif->getLink( iStreamEntry, "Stream" );
+		auto stream = nif->getLink( iStreamEntry, fieldStream );
 		auto iDataStream = nif->getBlockIndex( stream );
 
-		auto usage = NiMesh::DataStreamUsage( nif->get<uint>( iDataStream, "Usage" ) );
-		auto access = nif->get<uint>( iDataStream, "Access" );
+		auto usage = NiMesh::DataStreamUsage( nif->get<uint>( iDataStream, fieldUsage ) );
+		auto access = nif->get<uint>( iDataStream, fieldAccess );
 
 		// Invalid Usage and Access, abort
 		if ( usage == access && access == 0 )
 			return;
 
 		// For each datastream, store the semantic and the index (used for E_TEXCOORD)
-		auto iComponentSemantics = nif->getIndex( iStreamEntry, "Component Semantics" );
-		uint numComponents = nif->get<uint>( iStreamEntry, "Num Components" );
+		auto iComponentSemantics = nif->getIndex( iStreamEntry, fieldComponentSemantics );
+		uint numComponents = nif->get<uint>( iStreamEntry, fieldNumComponents );
 		CompSemIdxMap compSemanticIndexMap;
 		for ( uint j = 0; j < numComponents; j++ ) {
 			auto iComponentEntry = QModelIndex_child( iComponentSemantics, j );
 
-			auto name = nif->get<QString>( iComponentEntry, "Name" );
+			auto name = nif->get<QString>( iComponentEntry, fieldName );
 			auto sem = NiMesh::semanticStrings.value( name );
-			uint idx = nif->get<uint>( iComponentEntry, "Index" );
+			uint idx = nif->get<uint>( iComponentEntry, fieldIndex );
 			compSemanticIndexMap.insert( j, {sem, idx} );
 
 			// Create UV stubs for multi-coord systems
@@ -211,16 +213,16 @@ void Mesh::updateData_NiMesh( const NifModel * nif )
 		auto iStreamEntry = QModelIndex_child( iData, i );
 
 		QMap<ushort, ushort> submeshMap;
-		ushort numSubmeshes = nif->get<ushort>( iStreamEntry, "Num Submeshes" );
-		auto iSubmeshMap = nif->getIndex( iStreamEntry, "Submesh To Region Map" );
+		ushort numSubmeshes = nif->get<ushort>( iStreamEntry, fieldNumSubmeshes );
+		auto iSubmeshMap = nif->getIndex( iStreamEntry, fieldSubmeshToRegionMap );
 		for ( ushort j = 0; j < numSubmeshes; j++ )
 			submeshMap.insert( j, nif->get<ushort>( QModelIndex_child( iSubmeshMap, j ) ) );
 
 		// Get the datastream
-		quint32 stream = nif->getLink( iStreamEntry, "Stream" );
+		quint32 stream = nif->getLink( iStreamEntry, fieldStream );
 		auto iDataStream = nif->getBlockIndex( stream );
 
-		auto usage = NiMesh::DataStreamUsage(nif->get<uint>( iDataStream, "Usage" ));
+		auto usage = NiMesh::DataStreamUsage(nif->get<uint>( iDataStream, fieldUsage ));
 		// Only process USAGE_VERTEX and USAGE_VERTEX_INDEX
 		if ( usage > NiMesh::USAGE_VERTEX )
 			continue;
@@ -229,12 +231,12 @@ void Mesh::updateData_NiMesh( const NifModel * nif )
 		// Each region has a Start Index which is added as an offset to the index read from the stream
 		QVector<QPair<quint32, quint32>> regions;
 		quint32 numIndices = 0;
-		auto iRegions = nif->getIndex( iDataStream, "Regions" );
+		auto iRegions = nif->getIndex( iDataStream, fieldRegions );
 		if ( iRegions.isValid() ) {
-			quint32 numRegions = nif->get<quint32>( iDataStream, "Num Regions" );
+			quint32 numRegions = nif->get<quint32>( iDataStream, fieldNumRegions );
 			for ( quint32 j = 0; j < numRegions; j++ ) {
 				auto iRegionEntry = QModelIndex_child( iRegions, j );
-				regions.append( { nif->get<quint32>( iRegionEntry, "Start Index" ), nif->get<quint32>( iRegionEntry, "Num Indices" ) } );
+				regions.append( { nif->get<quint32>( iRegionEntry, fieldStartIndex ), nif->get<quint32>( iRegionEntry, fieldNumIndices ) } );
 
 				numIndices += regions[j].second;
 			}
@@ -266,8 +268,8 @@ void Mesh::updateData_NiMesh( const NifModel * nif )
 
 		// Get the format of each component
 		QVector<NiMesh::DataStreamFormat> datastreamFormats;
-		uint numStreamComponents = nif->get<uint>( iDataStream, "Num Components" );
-		auto iComponentFormats = nif->getIndex( iDataStream, "Component Formats" );
+		uint numStreamComponents = nif->get<uint>( iDataStream, fieldNumComponents );
+		auto iComponentFormats = nif->getIndex( iDataStream, fieldComponentFormats );
 		for ( uint j = 0; j < numStreamComponents; j++ ) {
 			auto format = nif->get<uint>( QModelIndex_child( iComponentFormats, j ) );
 			datastreamFormats.append( NiMesh::DataStreamFormat(format) );
@@ -277,7 +279,7 @@ void Mesh::updateData_NiMesh( const NifModel * nif )
 
 		auto tempMdl = std::make_unique<NifModel>( this );
 
-		QByteArray streamData = nif->get<QByteArray>( QModelIndex_child( nif->getIndex( iDataStream, "Data" ), 0 ) );
+		QByteArray streamData = nif->get<QByteArray>( QModelIndex_child( nif->getIndex( iDataStream, fieldData ), 0 ) );
 		QBuffer streamBuffer( &streamData );
 		streamBuffer.open( QIODevice::ReadOnly );
 
@@ -450,7 +452,7 @@ void Mesh::updateData_NiMesh( const NifModel * nif )
 
 	// Make geometry
 	triangles.resize( indices.size() / 3 );
-	auto meshPrimitiveType = nif->get<uint>( iBlock, "Primitive Type" );
+	auto meshPrimitiveType = nif->get<uint>( iBlock, fieldPrimitiveType );
 	switch ( meshPrimitiveType ) {
 	case NiMesh::PRIMITIVE_TRIANGLES:
 		for ( int k = 0, t = 0; k < indices.size(); k += 3, t++ )
@@ -500,31 +502,31 @@ void Mesh::updateData_NiTriShape( const NifModel * nif )
 		return;
 
 	// Fill vertex data
-	verts = nif->getArray<Vector3>( iData, "Vertices" );
+	verts = nif->getArray<Vector3>( iData, fieldVertices );
 	numVerts = verts.count();
 
-	norms = nif->getArray<Vector3>( iData, "Normals" );
+	norms = nif->getArray<Vector3>( iData, fieldNormals );
 	if ( norms.count() < numVerts )
 		norms.clear();
 
-	colors = nif->getArray<Color4>( iData, "Vertex Colors" );
+	colors = nif->getArray<Color4>( iData, fieldVertexColors );
 	if ( colors.count() < numVerts )
 		colors.clear();
 	// Detect if "Has Vertex Colors" is set to Yes in NiTriShape
 	//	Used to compare against SLSF2_Vertex_Colors
 	hasVertexColors = (colors.count() > 0);
 
-	tangents   = nif->getArray<Vector3>( iData, "Tangents" );
-	bitangents = nif->getArray<Vector3>( iData, "Bitangents" );
+	tangents   = nif->getArray<Vector3>( iData, fieldTangents );
+	bitangents = nif->getArray<Vector3>( iData, fieldBitangents );
 
-	QModelIndex iExtraData = nif->getIndex( iBlock, "Extra Data List" );
+	QModelIndex iExtraData = nif->getIndex( iBlock, fieldExtraDataList );
 	if ( iExtraData.isValid() ) {
 		int nExtra = nif->rowCount( iExtraData );
 		for ( int e = 0; e < nExtra; e++ ) {
 			QModelIndex iExtra = nif->getBlockIndex( nif->getLink( QModelIndex_child( iExtraData, e ) ), "NiBinaryExtraData" );
-			if ( nif->get<QString>( iExtra, "Name" ) == "Tangent space (binormal & tangent vectors)" ) {
+			if ( nif->get<QString>( iExtra, fieldName ) == "Tangent space (binormal & tangent vectors)" ) {
 				iTangentData = iExtra;
-				QByteArray data = nif->get<QByteArray>( iExtra, "Binary Data" );
+				QByteArray data = nif->get<QByteArray>( iExtra, fieldBinaryData );
 				if ( data.size() == numVerts * 4 * 3 * 2 ) {
 					tangents.resize( numVerts );
 					bitangents.resize( numVerts );
@@ -541,7 +543,7 @@ void Mesh::updateData_NiTriShape( const NifModel * nif )
 	}
 
 	coords.clear();
-	QModelIndex iUVSets = nif->getIndex( iData, "UV Sets" );
+	QModelIndex iUVSets = nif->getIndex( iData, fieldUVSets );
 	if ( iUVSets.isValid() ) {
 		int nSets = nif->rowCount( iUVSets );
 		for ( int r = 0; r < nSets; r++ ) {
@@ -558,7 +560,7 @@ void Mesh::updateData_NiTriShape( const NifModel * nif )
 		// check indexes
 		// TODO: check other indexes as well
 		// TODO (Gavrant): test this!
-		QVector<Triangle> dataTris = nif->getArray<Triangle>( iData, "Triangles" );
+		QVector<Triangle> dataTris = nif->getArray<Triangle>( iData, fieldTriangles );
 		int nDataTris = dataTris.count();
 
 		for ( int i = 0; i < nDataTris; i++ ) {
@@ -569,13 +571,13 @@ void Mesh::updateData_NiTriShape( const NifModel * nif )
 
 		int diff = nDataTris - triangles.count();
 		if ( diff > 0 ) {
-			int block_idx = nif->getBlockNumber( nif->getIndex( iData, "Triangles" ) );
+			int block_idx = nif->getBlockNumber( nif->getIndex( iData, fieldTriangles ) );
 			Message::append( tr( "Warnings were generated while rendering mesh." ),
 				tr( "Block %1: %2 invalid indices in NiTriShapeData.Triangles" ).arg( block_idx ).arg( diff )
 			);
 		}
 	} else if ( dataName == "NiTriStripsData" ) {
-		QModelIndex points = nif->getIndex( iData, "Points" );
+		QModelIndex points = nif->getIndex( iData, fieldPoints );
 		if ( points.isValid() ) {
 			int nStrips = nif->rowCount( points );
 			for ( int r = 0; r < nStrips; r++ )
@@ -596,7 +598,7 @@ QModelIndex Mesh::vertexAt( int idx ) const
 	if ( !nif )
 		return QModelIndex();
 
-	auto iVertexData = nif->getIndex( iData, "Vertices" );
+	auto iVertexData = nif->getIndex( iData, fieldVertices );
 	auto iVertex = QModelIndex_child( iVertexData, idx );
 
 	return iVertex;
@@ -614,114 +616,59 @@ void Mesh::transformShapes()
 
 	Node::transformShapes();
 
+	bool wasRigid = transformRigid;
 	transformRigid = true;
 
 	if ( isSkinned && ( weights.count() || partitions.count() ) && scene->hasOption(Scene::DoSkinning) ) {
 		transformRigid = false;
 
-		int vcnt = verts.count();
-		int ncnt = norms.count();
-		int tcnt = tangents.count();
-		int bcnt = bitangents.count();
-
-		transVerts.resize( vcnt );
-		transVerts.fill( Vector3() );
-		transNorms.resize( vcnt );
-		transNorms.fill( Vector3() );
-		transTangents.resize( vcnt );
-		transTangents.fill( Vector3() );
-		transBitangents.resize( vcnt );
-		transBitangents.fill( Vector3() );
+		if ( !skin.hasInfluences() ) {
+			if ( partitions.count() )
+				skin.setInfluences( partitions, verts.count() );
+			else
+				skin.setInfluences( weights, verts.count() );
+		}
 
 		Node * root = findParent( skeletonRoot );
+		skin.resolveBones( root, bones );
+		skin.setBoneCount( bones.count() );
 
 		if ( partitions.count() ) {
-			for ( const SkinPartition& part : partitions ) {
-				QVector<Transform> boneTrans( part.boneMap.count() );
-
-				for ( int t = 0; t < boneTrans.count(); t++ ) {
-					Node * bone = root ? root->findChild( bones.value( part.boneMap[t] ) ) : 0;
-					boneTrans[ t ] = scene->view;
-
-					if ( bone )
-						boneTrans[ t ] = boneTrans[ t ] * bone->localTrans( skeletonRoot ) * weights.value( part.boneMap[t] ).trans;
-
-					//if ( bone ) boneTrans[ t ] = bone->viewTrans() * weights.value( part.boneMap[t] ).trans;
-				}
-
-				for ( int v = 0; v < part.vertexMap.count(); v++ ) {
-					int vindex = part.vertexMap[ v ];
-					if ( vindex < 0 || vindex >= vcnt )
-						break;
-
-					if ( transVerts[vindex] == Vector3() ) {
-						for ( int w = 0; w < part.numWeightsPerVertex; w++ ) {
-							QPair<int, float> weight = part.weights[ v * part.numWeightsPerVertex + w ];
-
-
-							Transform trans = boneTrans.value( weight.first );
-
-							if ( vcnt > vindex )
-								transVerts[vindex] += trans * verts[vindex] * weight.second;
-							if ( ncnt > vindex )
-								transNorms[vindex] += trans.rotation * norms[vindex] * weight.second;
-							if ( tcnt > vindex )
-								transTangents[vindex] += trans.rotation * tangents[vindex] * weight.second;
-							if ( bcnt > vindex )
-								transBitangents[vindex] += trans.rotation * bitangents[vindex] * weight.second;
-						}
-					}
-				}
-			}
-		} else {
-			int x = 0;
-			for ( const BoneWeights& bw : weights ) {
-				Transform trans = viewTrans() * skeletonTrans;
-				Node * bone = root ? root->findChild( bw.bone ) : 0;
-
+			for ( int b = 0; b < bones.count(); b++ ) {
+				Node * bone = skin.boneNode( b );
 				if ( bone )
-					trans = trans * bone->localTrans( skeletonRoot ) * bw.trans;
-
-				if ( bone )
-					weights[x++].tcenter = bone->viewTrans() * bw.center;
+					skin.setBone( b, scene->view * bone->localTrans( skeletonRoot ) * weights.value( b ).trans );
 				else
-					x++;
-
-				for ( const VertexWeight& vw : bw.weights ) {
-					int vindex = vw.vertex;
-					if ( vindex < 0 || vindex >= vcnt )
-						break;
-
-					if ( vcnt > vindex )
-						transVerts[vindex] += trans * verts[vindex] * vw.weight;
-					if ( ncnt > vindex )
-						transNorms[vindex] += trans.rotation * norms[vindex] * vw.weight;
-					if ( tcnt > vindex )
-						transTangents[vindex] += trans.rotation * tangents[vindex] * vw.weight;
-					if ( bcnt > vindex )
-						transBitangents[vindex] += trans.rotation * bitangents[vindex] * vw.weight;
+					skin.setBone( b, scene->view );
+			}
+		} else {
+			for ( int b = 0; b < weights.count(); b++ ) {
+				BoneWeights & bw = weights[b];
+				Node * bone = skin.boneNode( b );
+				if ( bone ) {
+					skin.setBone( b, viewTrans() * skeletonTrans * bone->localTrans( skeletonRoot ) * bw.trans );
+					bw.tcenter = bone->viewTrans() * bw.center;
+				} else {
+					skin.setBone( b, viewTrans() * skeletonTrans );
 				}
 			}
 		}
 
-		for ( int n = 0; n < transNorms.count(); n++ )
-			transNorms[n].normalize();
-
-		for ( int t = 0; t < transTangents.count(); t++ )
-			transTangents[t].normalize();
-
-		for ( int t = 0; t < transBitangents.count(); t++ )
-			transBitangents[t].normalize();
+		skin.skin( verts, norms, tangents, bitangents, transVerts, transNorms, transTangents, transBitangents );
 
 		boundSphere = BoundSphere( transVerts );
 		boundSphere.applyInv( viewTrans() );
 		needUpdateBounds = false;
+		invalidateTransformBuffers();
 	} else {
 		transVerts = verts;
 		transNorms = norms;
 		transTangents = tangents;
 		transBitangents = bitangents;
 		transColors = colors;
+		// the buffers still hold the skinned arrays
+		if ( !wasRigid )
+			invalidateTransformBuffers();
 	}
 
 	sortedTriangles = triangles;
@@ -733,8 +680,15 @@ void Mesh::transformShapes()
 
 		for ( int c = 0; c < colors.count(); c++ )
 			transColors[c] = colors[c].blend( a );
+		transColorsBlended = true;
+		invalidateTransformBuffers();
 	} else {
 		transColors = colors;
+		// the color buffer still holds the blended colors
+		if ( transColorsBlended ) {
+			transColorsBlended = false;
+			invalidateTransformBuffers();
+		}
 		// TODO (Gavrant): suspicious code. Should the check be replaced with !bssp.hasVertexAlpha ?
 		if ( bslsp && !bslsp->hasSF1(ShaderFlags::SLSF1_Vertex_Alpha) ) {
 			for ( int c = 0; c < colors.count(); c++ )
@@ -789,7 +743,7 @@ void Mesh::drawShapes( NodeList * secondPass )
 
 	//if ( !Node::SELECTING ) {
 	//	qDebug() << viewTrans().translation;
-		//qDebug() << Vector3( nif->get<Vector4>( iBlock, "Translation" ) );
+		//qDebug() << Vector3( nif->get<Vector4>( iBlock, fieldTranslation ) );
 	//}
 
 	// Debug axes
@@ -805,12 +759,12 @@ void Mesh::drawShapes( NodeList * secondPass )
 		glPolygonOffset( 1.0f, 2.0f );
 
 	glEnableClientState( GL_VERTEX_ARRAY );
-	glVertexPointer( 3, GL_FLOAT, 0, transVerts.constData() );
+	setVertexPointer( transVerts );
 
 	if ( !Node::SELECTING ) [[likely]] {
 		if ( transNorms.count() ) {
 			glEnableClientState( GL_NORMAL_ARRAY );
-			glNormalPointer( GL_FLOAT, 0, transNorms.constData() );
+			setNormalPointer( transNorms );
 		}
 
 		// Do VCs if legacy or if either bslsp or bsesp is set
@@ -818,7 +772,7 @@ void Mesh::drawShapes( NodeList * secondPass )
 
 		if ( transColors.count() && scene->hasOption(Scene::DoVertexColors) && doVCs ) {
 			glEnableClientState( GL_COLOR_ARRAY );
-			glColorPointer( 4, GL_FLOAT, 0, transColors.constData() );
+			setColorPointer( transColors );
 		} else {
 			if ( !hasVertexColors && (bslsp && bslsp->hasVertexColors) ) {
 				// Correctly blacken the mesh if SLSF2_Vertex_Colors is still on
@@ -853,33 +807,25 @@ void Mesh::drawShapes( NodeList * secondPass )
 
 	if ( !isLOD ) {
 		// render the triangles
-		if ( sortedTriangles.count() )
-			glDrawElements( GL_TRIANGLES, sortedTriangles.count() * 3, GL_UNSIGNED_SHORT, sortedTriangles.constData() );
+		drawTriangles( sortedTriangles );
 
 	} else if ( sortedTriangles.count() ) {
-		auto lod0 = nif->get<uint>( iBlock, "LOD0 Size" );
-		auto lod1 = nif->get<uint>( iBlock, "LOD1 Size" );
-		auto lod2 = nif->get<uint>( iBlock, "LOD2 Size" );
-
-		auto lod0tris = sortedTriangles.mid( 0, lod0 );
-		auto lod1tris = sortedTriangles.mid( lod0, lod1 );
-		auto lod2tris = sortedTriangles.mid( lod0 + lod1, lod2 );
+		auto lod0 = nif->get<uint>( iBlock, fieldLOD0Size );
+		auto lod1 = nif->get<uint>( iBlock, fieldLOD1Size );
+		auto lod2 = nif->get<uint>( iBlock, fieldLOD2Size );
 
 		// If Level0, render all
 		// If Level1, also render Level2
 		switch ( scene->lodLevel ) {
 		case Scene::Level0:
-			if ( lod2tris.count() )
-				glDrawElements( GL_TRIANGLES, lod2tris.count() * 3, GL_UNSIGNED_SHORT, lod2tris.constData() );
+			drawTriangles( sortedTriangles, qsizetype( lod0 ) + lod1, lod2 );
 			[[fallthrough]];
 		case Scene::Level1:
-			if ( lod1tris.count() )
-				glDrawElements( GL_TRIANGLES, lod1tris.count() * 3, GL_UNSIGNED_SHORT, lod1tris.constData() );
+			drawTriangles( sortedTriangles, lod0, lod1 );
 			[[fallthrough]];
 		case Scene::Level2:
 		default:
-			if ( lod0tris.count() )
-				glDrawElements( GL_TRIANGLES, lod0tris.count() * 3, GL_UNSIGNED_SHORT, lod0tris.constData() );
+			drawTriangles( sortedTriangles, 0, lod0 );
 			break;
 		}
 	}
@@ -1025,7 +971,7 @@ void Mesh::drawSelection() const
 	if ( n == "Points" ) {
 		glBegin( GL_POINTS );
 		auto nif = NifModel::fromIndex( iData );
-		QModelIndex points = nif->getIndex( iData, "Points" );
+		QModelIndex points = nif->getIndex( iData, fieldPoints );
 
 		if ( points.isValid() ) {
 			for ( int j = 0; j < nif->rowCount( points ); j++ ) {
@@ -324,6 +324,8 @@ void Node::makeParent( Node * newParent )
 
 	if ( parent )
 		parent->children.add( this );
+
+	scene->invalidateNodeTable();
 }
 
 void Node::setController( const NifModel * nif, const QModelIndex & iController )
@@ -356,10 +358,39 @@ void Node::activeProperties( PropertyList & list ) const
 		parent->activeProperties( list );
 }
 
+FlatTransform * Node::flatTransform() const
+{
+	if ( flatIndex < 0 || size_t( flatIndex ) >= scene->flatTransforms.size() )
+		return nullptr;
+	FlatTransform * t = &( scene->flatTransforms[flatIndex] );
+	return ( t->node == this ? t : nullptr );
+}
+
+const Transform * Node::cachedViewTrans() const
+{
+	if ( const FlatTransform * t = flatTransform() )
+		return ( t->viewFrame == scene->transformFrame ? &( t->view ) : nullptr );
+
+	auto i = scene->viewTrans.constFind( nodeId );
+	return ( i != scene->viewTrans.cend() ? &( i.value() ) : nullptr );
+}
+
+const Transform & Node::cacheViewTrans( const Transform & t ) const
+{
+	if ( FlatTransform * f = flatTransform() ) {
+		f->view = t;
+		f->viewFrame = scene->transformFrame;
+		return f->view;
+	}
+
+	scene->viewTrans.insert( nodeId, t );
+	return scene->viewTrans[ nodeId ];
+}
+
 const Transform & Node::viewTrans() const
 {
-	if ( scene->viewTrans.contains( nodeId ) )
-		return scene->viewTrans[ nodeId ];
+	if ( const Transform * t = cachedViewTrans() )
+		return *t;
 
 	Transform t;
 
@@ -368,12 +399,23 @@ const Transform & Node::viewTrans() const
 	else
 		t = scene->view * worldTrans();
 
-	scene->viewTrans.insert( nodeId, t );
-	return scene->viewTrans[ nodeId ];
+	return cacheViewTrans( t );
 }
 
 const Transform & Node::worldTrans() const
 {
+	// nodes in the scene graph are normally updated by Scene::updateFlatTransforms(),
+	// this is only reached if a controller needs the transform earlier in the frame
+	if ( FlatTransform * f = flatTransform() ) {
+		if ( f->worldFrame != scene->transformFrame ) {
+			f->local = local;
+			f->world = parent ? parent->worldTrans() * local : local;
+			f->worldFrame = scene->transformFrame;
+			f->changed = true;
+		}
+		return f->world;
+	}
+
 	if ( scene->worldTrans.contains( nodeId ) )
 		return scene->worldTrans[ nodeId ];
 
@@ -421,6 +463,15 @@ Node * Node::findParent( int id ) const
 
 Node * Node::findChild( int id ) const
 {
+	if ( scene->hasNodeTable() ) {
+		// one node per block, check that it is below this node
+		Node * node = scene->nodeForBlock( id );
+		for ( const Node * p = ( node ? node->parent.data() : nullptr ); p; p = p->parent )
+			if ( p == this )
+				return node;
+		return nullptr;
+	}
+
 	for ( Node * child : children.list() ) {
 		if ( child ) {
 			if ( child->nodeId == id )
@@ -1934,8 +1985,8 @@ BillboardNode::BillboardNode( Scene * scene, const QModelIndex & iBlock )
 
 const Transform & BillboardNode::viewTrans() const
 {
-	if ( scene->viewTrans.contains( nodeId ) )
-		return scene->viewTrans[ nodeId ];
+	if ( const Transform * t = cachedViewTrans() )
+		return *t;
 
 	Transform t;
 
@@ -1946,6 +1997,5 @@ const Transform & BillboardNode::viewTrans() const
 
 	t.rotation = Matrix();
 
-	scene->viewTrans.insert( nodeId, t );
-	return scene->viewTrans[ nodeId ];
+	return cacheViewTrans( t );
 }
@@ -73,6 +73,23 @@ protected:
 	QVector<Node *> nodes;
 };
 
+//! A node in the flattened scene graph with its cached transforms, see Scene::flatTransforms
+struct FlatTransform
+{
+	QPointer<Node> node;
+	//! Position of the parent in Scene::flatTransforms, -1 for a root
+	int parent = -1;
+	//! The local transform that world was calculated from
+	Transform local;
+	Transform world;
+	Transform view;
+	//! Value of Scene::transformFrame when world and view were last calculated
+	quint32 worldFrame = 0;
+	quint32 viewFrame = 0;
+	//! World transform changed in the current frame
+	bool changed = true;
+};
+
 class Node : public IControllable
 {
 	friend class ControllerManager;
@@ -82,6 +99,7 @@ class Node : public IControllable
 	friend class VisibilityController;
 	friend class NodeList;
 	friend class LODNode;
+	friend class Scene;
 
 	typedef union
 	{
@@ -155,6 +173,13 @@ protected:
 	void glHighlightColor() const;
 	void glNormalColor() const;
 
+	//! Returns the entry of the node in Scene::flatTransforms, or nullptr if it has none
+	FlatTransform * flatTransform() const;
+	//! Returns the view transform cached in the current frame, or nullptr
+	const Transform * cachedViewTrans() const;
+	//! Caches the view transform for the current frame
+	const Transform & cacheViewTrans( const Transform & t ) const;
+
 	QPointer<Node> parent;
 	NodeList children;
 
@@ -175,6 +200,8 @@ protected:
 
 	int nodeId;
 	int ref;
+	//! Position in Scene::flatTransforms, or -1
+	int flatIndex = -1;
 };
 
 template <typename T> inline T * Node::findProperty() const
@@ -43,6 +43,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "model/nifmodel.h"
 
 #include <QAction>
+#include <QElapsedTimer>
 #include <QOpenGLContext>
 #include <QOpenGLFunctions>
 #include <QSettings>
@@ -116,6 +117,11 @@ void Scene::updateShaders()
 
 void Scene::clear( [[maybe_unused]] bool flushTextures )
 {
+	// called with the context current, the buffer objects cannot be destroyed later
+	for ( Shape * s : shapes )
+		s->releaseBuffers();
+
+	invalidateNodeTable();
 	nodes.clear();
 	properties.clear();
 	roots.clear();
@@ -138,6 +144,7 @@ void Scene::update( const NifModel * nif, const QModelIndex & index )
 		return;
 
 	nifModel = nif;
+	invalidateNodeTable();
 
 	if ( index.isValid() ) {
 		QModelIndex block = nif->getBlockIndex( index );
@@ -313,6 +320,9 @@ void Scene::setSequence( const QString & seqname )
 
 void Scene::transform( const Transform & trans, float time )
 {
+	QElapsedTimer timer;
+	timer.start();
+
 	view = trans;
 	this->time = time;
 
@@ -320,15 +330,23 @@ void Scene::transform( const Transform & trans, float time )
 	viewTrans.clear();
 	bhkBodyTrans.clear();
 
+	if ( !nodeTableValid )
+		buildNodeTable();
+	transformFrame++;
+
 	for ( Property * prop : properties ) {
 		prop->transform();
 	}
 	for ( Node * node : roots.list() ) {
 		node->transform();
 	}
+	updateFlatTransforms();
+	transformStats.nodeTime = double( timer.nsecsElapsed() ) / 1.0e6;
+
 	for ( Node * node : roots.list() ) {
 		node->transformShapes();
 	}
+	transformStats.shapeTime = double( timer.nsecsElapsed() ) / 1.0e6 - transformStats.nodeTime;
 
 	sceneBoundsValid = false;
 
@@ -467,11 +485,87 @@ float Scene::timeMax() const
 
 QString Scene::textStats()
 {
+	QString stats = QString( "\n\ntransform: %1 ms nodes, %2 ms shapes\n%3 of %4 node transforms updated\n" )
+						.arg( transformStats.nodeTime, 0, 'f', 3 ).arg( transformStats.shapeTime, 0, 'f', 3 )
+						.arg( transformStats.updated ).arg( flatTransforms.size() );
+
 	for ( Node * node : nodes.list() ) {
 		if ( node->index() == currentBlock ) {
-			return node->textStats();
+			return node->textStats() + stats;
+		}
+	}
+	return stats.mid( 2 );
+}
+
+Node * Scene::nodeForBlock( int id ) const
+{
+	if ( !nodeTableValid || id < 0 || id >= nodeTable.size() )
+		return nullptr;
+	return nodeTable.at( id ).data();
+}
+
+void Scene::buildNodeTable()
+{
+	nodeTable.clear();
+	flatTransforms.clear();
+	for ( Node * node : nodes.list() ) {
+		node->flatIndex = -1;
+		int id = node->id();
+		if ( id < 0 )
+			continue;
+		if ( id >= nodeTable.size() )
+			nodeTable.resize( id + 1 );
+		nodeTable[id] = node;
+	}
+
+	// parents before children, in the order of the child lists
+	std::vector<std::pair<Node *, int>> stack;
+	for ( qsizetype i = roots.list().size() - 1; i >= 0; i-- )
+		stack.emplace_back( roots.list().at( i ), -1 );
+	while ( !stack.empty() ) {
+		auto [node, parent] = stack.back();
+		stack.pop_back();
+		if ( !node || node->flatIndex >= 0 )
+			continue;
+
+		node->flatIndex = int( flatTransforms.size() );
+		FlatTransform & t = flatTransforms.emplace_back();
+		t.node = node;
+		t.parent = parent;
+
+		const QVector<Node *> & children = node->children.list();
+		for ( qsizetype i = children.size() - 1; i >= 0; i-- )
+			stack.emplace_back( children.at( i ), node->flatIndex );
+	}
+
+	nodeTableValid = true;
+}
+
+void Scene::updateFlatTransforms()
+{
+	// world transforms not calculated yet by the controllers, in one pass, skipping unchanged subtrees
+	int updated = 0;
+	for ( FlatTransform & t : flatTransforms ) {
+		const Node * node = t.node.data();
+		if ( !node )
+			continue;
+		if ( t.worldFrame == transformFrame ) {
+			updated++;
+			continue;
+		}
+
+		const FlatTransform * p = ( t.parent >= 0 && node->parent ) ? &( flatTransforms[t.parent] ) : nullptr;
+		const Transform & local = node->local;
+		bool dirty = ( t.worldFrame == 0 || ( p && p->changed )
+					   || !( t.local.rotation == local.rotation && t.local.translation == local.translation && t.local.scale == local.scale ) );
+		if ( dirty ) {
+			t.local = local;
+			t.world = p ? p->world * local : local;
+			updated++;
 		}
+		t.changed = dirty;
+		t.worldFrame = transformFrame;
 	}
-	return QString();
+	transformStats.updated = updated;
 }
 
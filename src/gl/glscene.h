@@ -46,6 +46,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QStack>
 #include <QStringList>
 
+#include <vector>
+
 
 //! @file glscene.h Scene
 
@@ -194,10 +196,23 @@ public:
 
 	NodeList roots;
 
+	//! World and view transforms of nodes that are not reachable from the roots
 	mutable QHash<int, Transform> worldTrans;
 	mutable QHash<int, Transform> viewTrans;
 	mutable QHash<int, Transform> bhkBodyTrans;
 
+	//! Nodes reachable from the roots, parents before their children
+	mutable std::vector<FlatTransform> flatTransforms;
+	//! Incremented by transform(), invalidates the cached world and view transforms
+	quint32 transformFrame = 1;
+
+	//! Returns the node of a block from the node table, or nullptr if there is none or the table is out of date
+	Node * nodeForBlock( int id ) const;
+	//! Returns true if the node table is up to date with the node tree
+	bool hasNodeTable() const { return nodeTableValid; }
+	//! Schedules rebuilding the node table and the flattened scene graph on the next transform()
+	void invalidateNodeTable() { nodeTableValid = false; }
+
 	Transform view;
 
 	bool animate;
@@ -235,6 +250,21 @@ protected:
 	mutable float tMin = 0, tMax = 0;
 
 	void updateTimeBounds() const;
+
+	void buildNodeTable();
+	void updateFlatTransforms();
+
+	//! Nodes indexed by block number
+	QVector<QPointer<Node>> nodeTable;
+	bool nodeTableValid = false;
+
+	//! Statistics of the last transform() call
+	struct TransformStatistics
+	{
+		double nodeTime = 0.0;
+		double shapeTime = 0.0;
+		int updated = 0;
+	} transformStats;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( Scene::SceneOptions )
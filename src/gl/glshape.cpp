@@ -43,6 +43,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 Shape::Shape( Scene * s, const QModelIndex & b ) : Node( s, b )
 {
 	shapeNumber = s->shapes.count();
+	buffers[IndexBuffer].buffer = QOpenGLBuffer( QOpenGLBuffer::IndexBuffer );
 }
 
 void Shape::clear()
@@ -128,10 +129,12 @@ void Shape::updateImpl( const NifModel * nif, const QModelIndex & index )
 		alphaProperty = properties.get<AlphaProperty>();
 
 		needUpdateData = true;
+		invalidateBuffers();
 		updateShader();
 
 	} else if ( isSkinned && (index == iSkin || index == iSkinData || index == iSkinPart) ) {
 		needUpdateData = true;
+		invalidateBuffers();
 
 	} else if ( (bssp && bssp->isParamBlock(index)) || (alphaProperty && index == alphaProperty->index()) ) {
 		updateShader();
@@ -188,6 +191,122 @@ void Shape::resetSkeletonData()
 	bones.clear();
 	weights.clear();
 	partitions.clear();
+	skin.clear();
+}
+
+void Shape::releaseBuffers()
+{
+	for ( CachedBuffer & b : buffers ) {
+		b.buffer.destroy();
+		b.size = 0;
+		b.dirty = true;
+		b.uploaded = false;
+	}
+}
+
+void Shape::invalidateBuffers()
+{
+	for ( CachedBuffer & b : buffers )
+		b.dirty = true;
+}
+
+void Shape::invalidateTransformBuffers()
+{
+	// the texture coordinates and triangles do not depend on the transform
+	for ( int i = 0; i < CoordBuffer; i++ )
+		buffers[i].dirty = true;
+}
+
+bool Shape::bindBuffer( int slot, const void * data, qsizetype size )
+{
+	CachedBuffer &	b = buffers[slot];
+	if ( !b.buffer.isCreated() ) {
+		// fails if there is no current context, or buffer objects are not supported
+		if ( size <= 0 || !b.buffer.create() )
+			return false;
+	}
+	if ( !b.buffer.bind() )
+		return false;
+
+	if ( b.dirty || size != b.size ) {
+		if ( size == b.size && b.uploaded ) {
+			// data that changes every frame is streamed into the existing buffer
+			b.buffer.write( 0, data, int( size ) );
+		} else {
+			b.buffer.setUsagePattern( b.uploaded ? QOpenGLBuffer::DynamicDraw : QOpenGLBuffer::StaticDraw );
+			b.buffer.allocate( data, int( size ) );
+		}
+		b.size = size;
+		b.dirty = false;
+		b.uploaded = true;
+	}
+	return true;
+}
+
+void Shape::setArrayPointer( int slot, const void * data, qsizetype size, void (*setPointer)( const void * ) )
+{
+	if ( bindBuffer( slot, data, size ) ) {
+		setPointer( nullptr );
+		// other arrays may still be set from client memory
+		QOpenGLBuffer::release( QOpenGLBuffer::VertexBuffer );
+	} else {
+		setPointer( data );
+	}
+}
+
+void Shape::setVertexPointer( const QVector<Vector3> & data )
+{
+	setArrayPointer( VertexBuffer, data.constData(), data.size() * qsizetype( sizeof( Vector3 ) ),
+						[]( const void * p ) { glVertexPointer( 3, GL_FLOAT, 0, p ); } );
+}
+
+void Shape::setNormalPointer( const QVector<Vector3> & data )
+{
+	setArrayPointer( NormalBuffer, data.constData(), data.size() * qsizetype( sizeof( Vector3 ) ),
+						[]( const void * p ) { glNormalPointer( GL_FLOAT, 0, p ); } );
+}
+
+void Shape::setColorPointer( const QVector<Color4> & data )
+{
+	setArrayPointer( ColorBuffer, data.constData(), data.size() * qsizetype( sizeof( Color4 ) ),
+						[]( const void * p ) { glColorPointer( 4, GL_FLOAT, 0, p ); } );
+}
+
+void Shape::setTexCoordPointer( int slot, const QVector<Vector2> & data )
+{
+	setArrayPointer( slot, data.constData(), data.size() * qsizetype( sizeof( Vector2 ) ),
+						[]( const void * p ) { glTexCoordPointer( 2, GL_FLOAT, 0, p ); } );
+}
+
+void Shape::setTexCoordPointer( int slot, const QVector<Vector3> & data )
+{
+	setArrayPointer( slot, data.constData(), data.size() * qsizetype( sizeof( Vector3 ) ),
+						[]( const void * p ) { glTexCoordPointer( 3, GL_FLOAT, 0, p ); } );
+}
+
+void Shape::setTexCoordPointer( int slot, const QVector<Vector4> & data )
+{
+	setArrayPointer( slot, data.constData(), data.size() * qsizetype( sizeof( Vector4 ) ),
+						[]( const void * p ) { glTexCoordPointer( 4, GL_FLOAT, 0, p ); } );
+}
+
+void Shape::drawTriangles( const QVector<Triangle> & tris, qsizetype first, qsizetype count )
+{
+	qsizetype	n = tris.size();
+	if ( first < 0 || first >= n )
+		return;
+	if ( count < 0 || count > ( n - first ) )
+		count = n - first;
+	if ( count <= 0 )
+		return;
+
+	if ( bindBuffer( IndexBuffer, tris.constData(), n * qsizetype( sizeof( Triangle ) ) ) ) {
+		glDrawElements( GL_TRIANGLES, GLsizei( count * 3 ), GL_UNSIGNED_SHORT,
+						reinterpret_cast< const void * >( size_t( first ) * sizeof( Triangle ) ) );
+		QOpenGLBuffer::release( QOpenGLBuffer::IndexBuffer );
+	} else {
+		glDrawElements( GL_TRIANGLES, GLsizei( count * 3 ), GL_UNSIGNED_SHORT, tris.constData() + first );
+	}
 }
 
 void Shape::updateShader()
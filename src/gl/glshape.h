@@ -34,8 +34,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define GLSHAPE_H
 
 #include "gl/glnode.h" // Inherited
+#include "gl/glskin.h"
 #include "gl/gltools.h"
 
+#include <QOpenGLBuffer>
 #include <QPersistentModelIndex>
 #include <QVector>
 #include <QString>
@@ -63,6 +65,9 @@ public:
 	virtual void drawVerts() const {};
 	virtual QModelIndex vertexAt( int ) const { return QModelIndex(); };
 
+	//! Destroy the buffer objects, the OpenGL context they were created in must be current
+	void releaseBuffers();
+
 protected:
 	int shapeNumber;
 
@@ -119,6 +124,8 @@ protected:
 	QVector<Vector3> transNorms;
 	//! Transformed colors (alpha blended)
 	QVector<Color4> transColors;
+	//! Were the transformed colors alpha blended by a material property?
+	bool transColorsBlended = false;
 	//! Transformed tangents
 	QVector<Vector3> transTangents;
 	//! Transformed bitangents
@@ -132,6 +139,8 @@ protected:
 	QVector<int> bones;
 	QVector<BoneWeights> weights;
 	QVector<SkinPartition> partitions;
+	//! Skinning influences and bone palette, cleared with the skeleton data
+	SkinEngine skin;
 
 	void resetSkeletonData();
 
@@ -165,6 +174,50 @@ protected:
 	mutable bool needUpdateBounds = false;
 
 	bool isLOD = false;
+
+	//! Buffer object slots, one per vertex array and one for the triangles
+	enum BufferSlot
+	{
+		VertexBuffer = 0,
+		NormalBuffer,
+		ColorBuffer,
+		TangentBuffer,
+		BitangentBuffer,
+		CoordBuffer,
+		MeshCoordBuffer = CoordBuffer + 8,
+		IndexBuffer,
+		NumBufferSlots
+	};
+
+	//! GPU copy of a vertex array or of the triangles
+	struct CachedBuffer
+	{
+		QOpenGLBuffer buffer;
+		qsizetype size = 0;
+		bool dirty = true;
+		bool uploaded = false;
+	};
+	CachedBuffer buffers[NumBufferSlots];
+
+	//! Mark all buffers for upload, called when the model notifies that the shape data has changed
+	void invalidateBuffers();
+	//! Mark the buffers of the vertex-derived arrays for upload (skinning, morphing, material alpha)
+	void invalidateTransformBuffers();
+
+	//! Bind the buffer for \a slot, uploading \a data first if the buffer has been invalidated; returns false if buffer objects are not available
+	bool bindBuffer( int slot, const void * data, qsizetype size );
+	//! Set a vertex array pointer from the buffer for \a slot, or from client memory if buffer objects are not available
+	void setArrayPointer( int slot, const void * data, qsizetype size, void (*setPointer)( const void * ) );
+
+	void setVertexPointer( const QVector<Vector3> & data );
+	void setNormalPointer( const QVector<Vector3> & data );
+	void setColorPointer( const QVector<Color4> & data );
+	void setTexCoordPointer( int slot, const QVector<Vector2> & data );
+	void setTexCoordPointer( int slot, const QVector<Vector3> & data );
+	void setTexCoordPointer( int slot, const QVector<Vector4> & data );
+
+	//! Draw \a count triangles from \a first, clamped to the size of \a tris, using the index buffer for \a tris
+	void drawTriangles( const QVector<Triangle> & tris, qsizetype first = 0, qsizetype count = -1 );
 };
 
 #endif
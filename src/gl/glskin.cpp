@@ -0,0 +1,414 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "glskin.h"
+
+#include "gl/glnode.h"
+#include "gl/gltools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+//! @file glskin.cpp SkinEngine
+
+qsizetype SkinEngine::parallelThreshold = 8192;
+
+//! Worker threads shared by all skinned shapes
+class SkinThreads final
+{
+public:
+	static SkinThreads & get()
+	{
+		static SkinThreads	threads;
+		return threads;
+	}
+
+	//! Calls \a f on blocks of [0, n), the calling thread also processes blocks
+	void run( qsizetype n, qsizetype blockSize, const std::function<void( qsizetype, qsizetype )> & f )
+	{
+		std::unique_lock<std::mutex>	lock( mutex );
+		// another shape may be skinned on a different thread, only one job runs at a time
+		idle.wait( lock, [this]() { return !job; } );
+		job = &f;
+		jobSize = n;
+		jobBlockSize = blockSize;
+		nextBlock = 0;
+		numBlocks = ( n + blockSize - 1 ) / blockSize;
+		wake.notify_all();
+
+		processBlocks( lock );
+		done.wait( lock, [this]() { return nextBlock >= numBlocks && running == 0; } );
+		job = nullptr;
+		idle.notify_one();
+	}
+
+private:
+	SkinThreads()
+	{
+		int	n = std::min( std::max( int( std::thread::hardware_concurrency() ) - 1, 0 ), 7 );
+		for ( int i = 0; i < n; i++ )
+			threads.emplace_back( [this]() { worker(); } );
+	}
+
+	~SkinThreads()
+	{
+		{
+			std::lock_guard<std::mutex>	lock( mutex );
+			quit = true;
+		}
+		wake.notify_all();
+		for ( auto & t : threads )
+			t.join();
+	}
+
+	//! Processes blocks of the current job until none are left, \a lock is held on return
+	void processBlocks( std::unique_lock<std::mutex> & lock )
+	{
+		while ( job && nextBlock < numBlocks ) {
+			qsizetype	first = nextBlock * jobBlockSize;
+			qsizetype	last = std::min( first + jobBlockSize, jobSize );
+			const auto *	f = job;
+			nextBlock++;
+			running++;
+			lock.unlock();
+			( *f )( first, last );
+			lock.lock();
+			running--;
+		}
+		if ( nextBlock >= numBlocks && running == 0 )
+			done.notify_all();
+	}
+
+	void worker()
+	{
+		std::unique_lock<std::mutex>	lock( mutex );
+		while ( true ) {
+			wake.wait( lock, [this]() { return quit || ( job && nextBlock < numBlocks ); } );
+			if ( quit )
+				return;
+			processBlocks( lock );
+		}
+	}
+
+	std::mutex	mutex;
+	std::condition_variable	wake;
+	std::condition_variable	done;
+	std::condition_variable	idle;
+	std::vector<std::thread>	threads;
+
+	const std::function<void( qsizetype, qsizetype )> *	job = nullptr;
+	qsizetype	jobSize = 0;
+	qsizetype	jobBlockSize = 0;
+	qsizetype	nextBlock = 0;
+	qsizetype	numBlocks = 0;
+	int	running = 0;
+	bool	quit = false;
+};
+
+void SkinEngine::clear()
+{
+	influencesSet = false;
+	offsets.clear();
+	influenceBones.clear();
+	influenceWeights.clear();
+	palette.clear();
+
+	skeletonRoot = nullptr;
+	skeletonIds.clear();
+	skeletonNames.clear();
+	boneNodes.clear();
+	bonesFound = 0;
+}
+
+void SkinEngine::finishInfluences( int numVerts )
+{
+	// offsets holds the number of influences per vertex, convert it to the first influence
+	quint32	n = 0;
+	for ( int v = 0; v < numVerts; v++ ) {
+		quint32	cnt = offsets[v];
+		offsets[v] = n;
+		n += cnt;
+	}
+	offsets[numVerts] = n;
+	influenceBones.resize( n );
+	influenceWeights.resize( n );
+	influencesSet = true;
+}
+
+void SkinEngine::setInfluences( const QVector<BoneWeights> & weights, int numVerts )
+{
+	numVerts = std::max( numVerts, 0 );
+	offsets.assign( size_t( numVerts ) + 1, 0 );
+	for ( const BoneWeights & bw : weights ) {
+		for ( const VertexWeight & vw : bw.weights ) {
+			if ( vw.vertex >= 0 && vw.vertex < numVerts )
+				offsets[vw.vertex]++;
+		}
+	}
+	finishInfluences( numVerts );
+
+	std::vector<quint32>	pos( offsets.begin(), offsets.end() - 1 );
+	for ( qsizetype b = 0; b < weights.size(); b++ ) {
+		for ( const VertexWeight & vw : weights.at( b ).weights ) {
+			if ( vw.vertex >= 0 && vw.vertex < numVerts ) {
+				quint32	i = pos[vw.vertex]++;
+				influenceBones[i] = quint16( b );
+				influenceWeights[i] = vw.weight;
+			}
+		}
+	}
+}
+
+void SkinEngine::setInfluences( const QVector<SkinPartition> & partitions, int numVerts )
+{
+	numVerts = std::max( numVerts, 0 );
+	offsets.assign( size_t( numVerts ) + 1, 0 );
+
+	// partition and partition vertex that skin each vertex
+	std::vector<std::pair<int, int>>	owner( size_t( numVerts ), std::pair<int, int>( -1, -1 ) );
+	for ( qsizetype p = 0; p < partitions.size(); p++ ) {
+		const SkinPartition &	part = partitions.at( p );
+		for ( qsizetype v = 0; v < part.vertexMap.size(); v++ ) {
+			int	vindex = part.vertexMap.at( v );
+			if ( vindex < 0 || vindex >= numVerts )
+				break;
+			if ( owner[vindex].first >= 0 )
+				continue;
+			owner[vindex] = std::pair<int, int>( int( p ), int( v ) );
+			for ( int w = 0; w < part.numWeightsPerVertex; w++ ) {
+				const auto &	weight = part.weights.value( v * part.numWeightsPerVertex + w );
+				if ( weight.first >= 0 && weight.first < part.boneMap.size() )
+					offsets[vindex]++;
+			}
+		}
+	}
+	finishInfluences( numVerts );
+
+	for ( int vindex = 0; vindex < numVerts; vindex++ ) {
+		if ( owner[vindex].first < 0 )
+			continue;
+		const SkinPartition &	part = partitions.at( owner[vindex].first );
+		int	v = owner[vindex].second;
+		quint32	i = offsets[vindex];
+		for ( int w = 0; w < part.numWeightsPerVertex; w++ ) {
+			const auto &	weight = part.weights.value( v * part.numWeightsPerVertex + w );
+			if ( weight.first >= 0 && weight.first < part.boneMap.size() ) {
+				influenceBones[i] = quint16( part.boneMap.at( weight.first ) );
+				influenceWeights[i] = weight.second;
+				i++;
+			}
+		}
+	}
+}
+
+void SkinEngine::setInfluences( const QVector<BoneWeightsUNorm> & weights )
+{
+	int	numVerts = int( weights.size() );
+	offsets.assign( size_t( numVerts ) + 1, 0 );
+	for ( int v = 0; v < numVerts; v++ ) {
+		for ( const BoneWeightUNORM16 & w : weights.at( v ).weightsUNORM ) {
+			if ( w.weight > 0.0f )
+				offsets[v]++;
+		}
+	}
+	finishInfluences( numVerts );
+
+	quint32	i = 0;
+	for ( int v = 0; v < numVerts; v++ ) {
+		for ( const BoneWeightUNORM16 & w : weights.at( v ).weightsUNORM ) {
+			if ( w.weight > 0.0f ) {
+				influenceBones[i] = w.bone;
+				influenceWeights[i] = w.weight;
+				i++;
+			}
+		}
+	}
+}
+
+void SkinEngine::resolveBones( Node * root, const QVector<int> & boneIds )
+{
+	bool	changed = ( root != skeletonRoot.data() || boneIds != skeletonIds || !skeletonNames.isEmpty() );
+	// bones found earlier may have been deleted
+	if ( !changed && bonesFound > 0 )
+		changed = ( std::count_if( boneNodes.cbegin(), boneNodes.cend(), []( const QPointer<Node> & n ) { return !n.isNull(); } ) != bonesFound );
+	if ( !changed )
+		return;
+
+	skeletonRoot = root;
+	skeletonIds = boneIds;
+	skeletonNames.clear();
+	boneNodes.resize( boneIds.size() );
+	bonesFound = 0;
+	for ( qsizetype i = 0; i < boneIds.size(); i++ ) {
+		boneNodes[i] = ( root ? root->findChild( boneIds.at( i ) ) : nullptr );
+		bonesFound += int( !boneNodes.at( i ).isNull() );
+	}
+}
+
+void SkinEngine::resolveBones( Node * root, const QVector<QString> & boneNames )
+{
+	bool	changed = ( root != skeletonRoot.data() || boneNames != skeletonNames || !skeletonIds.isEmpty() );
+	if ( !changed && bonesFound > 0 )
+		changed = ( std::count_if( boneNodes.cbegin(), boneNodes.cend(), []( const QPointer<Node> & n ) { return !n.isNull(); } ) != bonesFound );
+	if ( !changed )
+		return;
+
+	skeletonRoot = root;
+	skeletonIds.clear();
+	skeletonNames = boneNames;
+	boneNodes.resize( boneNames.size() );
+	bonesFound = 0;
+	for ( qsizetype i = 0; i < boneNames.size(); i++ ) {
+		boneNodes[i] = ( root ? root->findChild( boneNames.at( i ) ) : nullptr );
+		bonesFound += int( !boneNodes.at( i ).isNull() );
+	}
+}
+
+Node * SkinEngine::boneNode( int bone ) const
+{
+	if ( bone < 0 || bone >= boneNodes.size() )
+		return nullptr;
+	return boneNodes.at( bone ).data();
+}
+
+bool SkinEngine::allBonesFound() const
+{
+	return ( bonesFound == boneNodes.size() );
+}
+
+void SkinEngine::setBoneCount( int n )
+{
+	size_t	n0 = palette.size();
+	palette.resize( size_t( std::max( n, 0 ) ) );
+	for ( size_t i = n0; i < palette.size(); i++ )
+		setBone( int( i ), Transform() );
+}
+
+void SkinEngine::setBone( int bone, const Transform & t )
+{
+	if ( bone < 0 || size_t( bone ) >= palette.size() )
+		return;
+
+	BoneMatrix &	m = palette[bone];
+	for ( int j = 0; j < 3; j++ ) {
+		m.rotation[j] = FloatVector4( t.rotation( 0, j ), t.rotation( 1, j ), t.rotation( 2, j ), 0.0f );
+		m.scaledRotation[j] = m.rotation[j] * t.scale;
+	}
+	m.translation = FloatVector4( t.translation[0], t.translation[1], t.translation[2], 0.0f );
+}
+
+void SkinEngine::clearBone( int bone )
+{
+	if ( bone < 0 || size_t( bone ) >= palette.size() )
+		return;
+
+	BoneMatrix &	m = palette[bone];
+	for ( int j = 0; j < 3; j++ ) {
+		m.rotation[j] = FloatVector4( 0.0f );
+		m.scaledRotation[j] = FloatVector4( 0.0f );
+	}
+	m.translation = FloatVector4( 0.0f );
+}
+
+void SkinEngine::skinRange( qsizetype first, qsizetype last, const Vector3 * const * in, const qsizetype * inSize, Vector3 * const * out ) const
+{
+	qsizetype	numInfluenced = qsizetype( offsets.empty() ? 0 : offsets.size() - 1 );
+	size_t	numBones = palette.size();
+
+	for ( qsizetype v = first; v < last; v++ ) {
+		// blend the bone matrices, then transform all vectors of the vertex with the result
+		FloatVector4	r0( 0.0f ), r1( 0.0f ), r2( 0.0f );
+		FloatVector4	s0( 0.0f ), s1( 0.0f ), s2( 0.0f );
+		FloatVector4	t( 0.0f );
+		if ( v < numInfluenced ) {
+			for ( quint32 i = offsets[v]; i < offsets[v + 1]; i++ ) {
+				size_t	b = influenceBones[i];
+				if ( b >= numBones )
+					continue;
+				const BoneMatrix &	m = palette[b];
+				float	w = influenceWeights[i];
+				r0 += m.rotation[0] * w;
+				r1 += m.rotation[1] * w;
+				r2 += m.rotation[2] * w;
+				s0 += m.scaledRotation[0] * w;
+				s1 += m.scaledRotation[1] * w;
+				s2 += m.scaledRotation[2] * w;
+				t += m.translation * w;
+			}
+		}
+
+		if ( v < inSize[0] ) {
+			const Vector3 &	p = in[0][v];
+			out[0][v].fromFloatVector4( s0 * p[0] + s1 * p[1] + s2 * p[2] + t );
+		}
+		for ( int k = 1; k < 4; k++ ) {
+			FloatVector4	d( 0.0f );
+			if ( v < inSize[k] ) {
+				const Vector3 &	a = in[k][v];
+				d = r0 * a[0] + r1 * a[1] + r2 * a[2];
+				float	l = d.dotProduct3( d );
+				if ( l > 0.0f )
+					d = d * ( 1.0f / std::sqrt( l ) );
+			}
+			out[k][v].fromFloatVector4( d );
+		}
+	}
+}
+
+void SkinEngine::skin( const QVector<Vector3> & verts, const QVector<Vector3> & norms,
+					   const QVector<Vector3> & tangents, const QVector<Vector3> & bitangents,
+					   QVector<Vector3> & outVerts, QVector<Vector3> & outNorms,
+					   QVector<Vector3> & outTangents, QVector<Vector3> & outBitangents ) const
+{
+	qsizetype	n = verts.size();
+	outVerts.resize( n );
+	outNorms.resize( n );
+	outTangents.resize( n );
+	outBitangents.resize( n );
+
+	const Vector3 *	in[4] = { verts.constData(), norms.constData(), tangents.constData(), bitangents.constData() };
+	qsizetype	inSize[4] = { n, std::min( norms.size(), n ), std::min( tangents.size(), n ), std::min( bitangents.size(), n ) };
+	Vector3 *	out[4] = { outVerts.data(), outNorms.data(), outTangents.data(), outBitangents.data() };
+
+	if ( n < parallelThreshold ) {
+		skinRange( 0, n, in, inSize, out );
+		return;
+	}
+	SkinThreads::get().run( n, 2048, [&]( qsizetype first, qsizetype last ) {
+		skinRange( first, last, in, inSize, out );
+	} );
+}
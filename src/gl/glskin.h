@@ -0,0 +1,131 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef GLSKIN_H
+#define GLSKIN_H
+
+#include "data/niftypes.h"
+
+#include <QPointer>
+#include <QString>
+#include <QVector>
+
+#include <vector>
+
+
+//! @file glskin.h SkinEngine
+
+class Node;
+class BoneWeights;
+class BoneWeightsUNorm;
+class SkinPartition;
+
+//! CPU skinning of shape vertex data
+/*!
+ * The vertex influences are flattened once per skin into per-vertex ranges of (bone, weight) arrays,
+ * and the bone nodes are looked up once per skeleton. Every frame the caller fills the palette with
+ * the bone transforms, and skin() blends them per vertex and transforms the positions, normals,
+ * tangents and bitangents in a single pass, split across worker threads for large meshes.
+ */
+class SkinEngine final
+{
+public:
+	//! Removes the influences, the bone palette and the cached bone nodes
+	void clear();
+
+	//! Returns true if the influences have been set since the last clear()
+	bool hasInfluences() const { return influencesSet; }
+
+	//! Sets the influences from per-bone vertex weight lists, the bone number is the index in \a weights
+	void setInfluences( const QVector<BoneWeights> & weights, int numVerts );
+	//! Sets the influences from skin partitions, a vertex is skinned by the first partition that uses it
+	void setInfluences( const QVector<SkinPartition> & partitions, int numVerts );
+	//! Sets the influences from per-vertex weights
+	void setInfluences( const QVector<BoneWeightsUNorm> & weights );
+
+	//! Finds the bone nodes by block number under \a root, the search is repeated only if the skeleton changed
+	void resolveBones( Node * root, const QVector<int> & boneIds );
+	//! Finds the bone nodes by name under \a root, the search is repeated only if the skeleton changed
+	void resolveBones( Node * root, const QVector<QString> & boneNames );
+	//! Returns the node of a bone, or nullptr if it was not found
+	Node * boneNode( int bone ) const;
+	//! Returns true if every bone has been found
+	bool allBonesFound() const;
+
+	//! Resizes the bone palette, new bones have the identity transform
+	void setBoneCount( int n );
+	//! Sets the transform of a bone in the palette
+	void setBone( int bone, const Transform & t );
+	//! Sets a bone in the palette to a zero matrix, so that it does not contribute to its vertices
+	void clearBone( int bone );
+
+	/*! Skins the vertex data with the current palette
+	 *
+	 * The output arrays are resized to the size of \a verts. An input array may be shorter than
+	 * \a verts, the missing vertices are output as zero vectors.
+	 */
+	void skin( const QVector<Vector3> & verts, const QVector<Vector3> & norms,
+			   const QVector<Vector3> & tangents, const QVector<Vector3> & bitangents,
+			   QVector<Vector3> & outVerts, QVector<Vector3> & outNorms,
+			   QVector<Vector3> & outTangents, QVector<Vector3> & outBitangents ) const;
+
+	//! Minimum number of vertices for skinning on multiple threads
+	static qsizetype parallelThreshold;
+
+protected:
+	//! A bone transform with the scale applied separately for the tangent space
+	struct BoneMatrix
+	{
+		FloatVector4 rotation[3];
+		FloatVector4 scaledRotation[3];
+		FloatVector4 translation;
+	};
+
+	void skinRange( qsizetype first, qsizetype last, const Vector3 * const * in, const qsizetype * inSize, Vector3 * const * out ) const;
+	void finishInfluences( int numVerts );
+
+	bool influencesSet = false;
+	//! First influence of each vertex, numVerts + 1 elements
+	std::vector<quint32> offsets;
+	std::vector<quint16> influenceBones;
+	std::vector<float> influenceWeights;
+
+	std::vector<BoneMatrix> palette;
+
+	QPointer<Node> skeletonRoot;
+	QVector<int> skeletonIds;
+	QVector<QString> skeletonNames;
+	QVector<QPointer<Node>> boneNodes;
+	int bonesFound = 0;
+};
+
+#endif
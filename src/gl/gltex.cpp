@@ -35,6 +35,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "message.h"
 #include "gl/glscene.h"
 #include "gl/gltexloaders.h"
+#include "gl/gltexqueue.h"
 #include "model/nifmodel.h"
 
 #include <QDebug>
@@ -59,6 +60,7 @@ int TexCache::num_txtunits_client = 0;
 int TexCache::pbrCubeMapResolution = 512;
 int TexCache::pbrImportanceSamples = 256;
 int TexCache::hdrToneMapLevel = 8;
+bool TexCache::asyncLoading = true;
 
 //! Maximum anisotropy
 float max_anisotropy = 1.0f;
@@ -203,6 +205,10 @@ TexCache::TexCache( QObject * parent ) : QObject( parent )
 	textureHashMask = 0;
 	textureCount = 0;
 	rehashTextures();
+
+	loadQueue = new TexLoadQueue( this );
+	// request a repaint when a texture is ready for upload
+	connect( loadQueue, &TexLoadQueue::sigReady, this, &TexCache::sigRefresh, Qt::QueuedConnection );
 }
 
 TexCache::~TexCache()
@@ -210,6 +216,7 @@ TexCache::~TexCache()
 #if 0
 	flush();
 #endif
+	delete loadQueue;
 	delete[] textures;
 }
 
@@ -387,7 +394,13 @@ int TexCache::bind( const QStringView & fname, const NifModel * nif )
 		if ( tx->id[0] )
 			return 0;
 
-		return loadTex( *tx, nif );
+		int mipmaps = loadTex( *tx, nif, asyncLoading );
+		if ( !mipmaps && tx->imageInfo->pending ) {
+			// keep the texture unit in a defined state until TexLoadQueue delivers the image
+			bindPlaceholder();
+			return 1;
+		}
+		return mipmaps;
 	}
 
 	if ( !tx->target ) [[unlikely]]
@@ -434,10 +447,39 @@ bool TexCache::bindCube( const QString & fname, const NifModel * nif, bool useSe
 	return true;
 }
 
-std::uint16_t TexCache::loadTex( Tex & tx, const NifModel * nif )
+std::uint16_t TexCache::loadTex( Tex & tx, const NifModel * nif, bool async )
 {
 	Tex::ImageInfo *	i = tx.imageInfo;
 
+	if ( i->pending ) {
+		// only the upload is done here, the file has been read and decoded by a worker thread
+		TexLoadQueue::Result	r;
+		if ( !loadQueue->takeResult( i, r ) )
+			return 0;
+		i->pending = false;
+
+		if ( !tx.id[0] )
+			glGenTextures( 1, tx.id );
+
+		if ( tx.target )
+			glBindTexture( tx.target, tx.id[0] );
+
+		try
+		{
+			if ( !r.error.isEmpty() )
+				throw r.error;
+			i->mipmaps = texLoad( nif, i->filepath, r.data, &r.texture, i->format, tx.target, i->width, i->height, tx.id );
+			tx.mipmaps = std::uint16_t( i->mipmaps );
+		}
+		catch ( QString & e )
+		{
+			i->status = e;
+		}
+		loadQueue->finished( r );
+
+		return tx.mipmaps;
+	}
+
 	if ( !isSupported( i->filename ) ) {
 		tx.id[0] = GLuint( -1 );
 		return 0;
@@ -445,6 +487,13 @@ std::uint16_t TexCache::loadTex( Tex & tx, const NifModel * nif )
 
 	i->filepath = find( i->filename, nif );
 
+	// solid colors are generated, everything else is read on a worker thread
+	if ( async && !i->filepath.startsWith( '#' ) ) {
+		i->pending = true;
+		loadQueue->request( i, i->filepath, nif );
+		return 0;
+	}
+
 	if ( !tx.id[0] )
 		glGenTextures( 1, tx.id );
 
@@ -464,6 +513,23 @@ std::uint16_t TexCache::loadTex( Tex & tx, const NifModel * nif )
 	return tx.mipmaps;
 }
 
+void TexCache::bindPlaceholder()
+{
+	if ( placeholder ) {
+		glBindTexture( GL_TEXTURE_2D, placeholder );
+		return;
+	}
+
+	// white is neutral for the texture modulation of the fixed function pipeline and most shader slots
+	static const std::uint8_t	white[4] = { 255, 255, 255, 255 };
+	glGenTextures( 1, &placeholder );
+	glBindTexture( GL_TEXTURE_2D, placeholder );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0 );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white );
+}
+
 int TexCache::bind( const QModelIndex & iSource )
 {
 	auto nif = NifModel::fromValidIndex(iSource);
@@ -504,6 +570,8 @@ int TexCache::bind( const QModelIndex & iSource )
 
 void TexCache::flush()
 {
+	loadQueue->cancel();
+
 	for ( size_t i = 0; i <= textureHashMask; i++ ) {
 		Tex &	tx = textures[i];
 		if ( tx.isLoaded() )
@@ -522,6 +590,11 @@ void TexCache::flush()
 			delete tx.imageInfo;
 	}
 	embedTextures.clear();
+
+	if ( placeholder ) {
+		glDeleteTextures( 1, &placeholder );
+		placeholder = 0;
+	}
 }
 
 void TexCache::setNifFolder( const QString & folder )
@@ -640,6 +713,8 @@ bool TexCache::loadSettings( QSettings & settings )
 	r = r | ( tmp != hdrToneMapLevel );
 	hdrToneMapLevel = tmp;
 
+	asyncLoading = settings.value( "Settings/Render/General/Async Texture Loading", true ).toBool();
+
 	return r;
 }
 
@@ -46,6 +46,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 class NifModel;
 class QOpenGLContext;
 class QSettings;
+class TexLoadQueue;
 
 typedef unsigned int GLuint;
 typedef unsigned int GLenum;
@@ -105,6 +106,8 @@ public:
 			TexFmt format;
 			//! Status messages
 			QString status;
+			//! The file is being read by a worker thread
+			bool pending = false;
 
 			//! Save the texture as pixel data
 			bool savePixelData( NifModel * nif, QModelIndex & iData ) const;
@@ -149,7 +152,7 @@ public:
 	TexCache( QObject * parent = nullptr );
 	~TexCache();
 
-	//! Bind a texture from filename
+	//! Bind a texture from filename, a placeholder is bound while the texture is being loaded
 	int bind( const QStringView & fname, const NifModel * nif = nullptr );
 	//! Bind a cube map from filename
 	bool bindCube( const QString & fname, const NifModel * nif, bool useSecondTexture );
@@ -180,6 +183,8 @@ public:
 	static int	pbrCubeMapResolution;
 	static int	pbrImportanceSamples;
 	static int	hdrToneMapLevel;
+	//! Read and decode textures on worker threads
+	static bool	asyncLoading;
 
 signals:
 	void sigRefresh();
@@ -200,10 +205,17 @@ protected:
 	std::uint32_t textureCount;
 	QHash<QModelIndex, Tex> embedTextures;
 
+	//! Worker threads for asynchronous loading
+	TexLoadQueue * loadQueue;
+	//! 1x1 opaque white texture bound in place of the textures that are being loaded
+	GLuint placeholder = 0;
+
 	template< typename T > inline Tex * insertTex( const T & file );
 	Tex * rehashTextures( Tex * p = nullptr );
-	//! Load the texture
-	static std::uint16_t loadTex( Tex & tx, const NifModel * nif );
+	//! Load the texture, or queue it for loading on a worker thread if \a async is true
+	std::uint16_t loadTex( Tex & tx, const NifModel * nif, bool async = false );
+	//! Bind the placeholder texture, creating it on first use
+	void bindPlaceholder();
 
 public:
 	const Tex::ImageInfo * getTextureInfo( const QStringView & file ) const;
@@ -629,26 +629,20 @@ GLuint texLoadBMP( QIODevice & f, TexCache::TexFmt & texformat, GLenum & target,
 	return 0;
 }
 
-GLuint texLoadDDS( const QString & filepath, GLenum & target, QByteArray & data, GLuint * id )
+static GLuint texLoadGLI( const QString & filepath, GLenum & target, gli::texture & texture, GLuint * id )
 {
-	if ( data.size() < 128 )
-		return 0;
-
 	GLuint mipmaps = 0;
 	GLuint result = 0;
-	gli::texture texture;
-	if ( extStorageSupported ) {
-		texture = load_if_valid( data.constData(), data.size() );
-		if ( !texture.empty() )
+	if ( !texture.empty() ) {
+		if ( extStorageSupported ) {
 			result = GLI_create_texture( texture, target, id );
 #ifdef Q_OS_WIN32
-	} else if ( glCompressedTexImage2D ) {
+		} else if ( glCompressedTexImage2D ) {
 #else
-	} else {
+		} else {
 #endif
-		texture = load_if_valid( data.constData(), data.size() );
-		if ( !texture.empty() )
 			result = GLI_create_texture_fallback( texture, target, id );
+		}
 	}
 
 	if ( result ) {
@@ -667,6 +661,15 @@ GLuint texLoadDDS( const QString & filepath, GLenum & target, QByteArray & data,
 	return mipmaps;
 }
 
+GLuint texLoadDDS( const QString & filepath, GLenum & target, QByteArray & data, GLuint * id )
+{
+	if ( data.size() < 128 )
+		return 0;
+
+	gli::texture texture( load_if_valid( data.constData(), data.size() ) );
+	return texLoadGLI( filepath, target, texture, id );
+}
+
 static SFCubeMapCache	sfCubeMapCache;
 
 void TexCache::clearCubeCache()
@@ -1266,7 +1269,6 @@ static void extract_pbr_lut_data( QByteArray & data )
 GLuint texLoad( const NifModel * nif, const QString & filepath, TexCache::TexFmt & format, GLenum & target, GLuint & width, GLuint & height, GLuint * id )
 {
 	width = height = 0;
-	GLuint	mipmaps = 0;
 
 	QByteArray	data;
 	if ( filepath.startsWith('#') && (filepath.length() == 9 || filepath.length() == 10) ) {
@@ -1284,42 +1286,70 @@ GLuint texLoad( const NifModel * nif, const QString & filepath, TexCache::TexFmt
 			throw QString( "could not open file" );
 	}
 
-	if ( data.isEmpty() )
-		return 0;
+	return texLoad( nif, filepath, data, nullptr, format, target, width, height, id );
+}
+
+bool texDecode( const QString & filepath, QByteArray & data, gli::texture & texture )
+{
+	if ( !filepath.endsWith( ".dds", Qt::CaseInsensitive ) || data.size() < 148 )
+		return false;
+	// cube maps may need to be patched or converted first, which is done by texLoad() on the GL thread
+	if ( FileBuffer::readUInt32Fast( data.data() ) != 0x20534444 || ( data.data()[113] & 0x02 ) )
+		return false;
+
+	texture = load_if_valid( data.constData(), data.size() );
+	if ( texture.empty() )
+		return false;
+	data.clear();
+	return true;
+}
+
+GLuint texLoad( const NifModel * nif, const QString & filepath, QByteArray & data, gli::texture * texture,
+				TexCache::TexFmt & format, GLenum & target, GLuint & width, GLuint & height, GLuint * id )
+{
+	width = height = 0;
+	GLuint	mipmaps = 0;
 
-	if ( filepath.endsWith( ".dds", Qt::CaseInsensitive ) || ( filepath.endsWith( ".hdr", Qt::CaseInsensitive ) && nif && nif->getBSVersion() >= 151 ) ) {
-		bool	isCubeMap = false;
-		if ( data.size() >= 148 ) {
-			if ( FileBuffer::readUInt32Fast( data.data() ) == 0x20534444 ) {	// "DDS "
-				if ( data.data()[113] & 0x02 ) {	// DDSCAPS2_CUBEMAP
+	if ( texture && !texture->empty() ) {
+		mipmaps = texLoadGLI( filepath, target, *texture, id );
+	} else {
+		if ( data.isEmpty() )
+			return 0;
+
+		if ( filepath.endsWith( ".dds", Qt::CaseInsensitive ) || ( filepath.endsWith( ".hdr", Qt::CaseInsensitive ) && nif && nif->getBSVersion() >= 151 ) ) {
+			bool	isCubeMap = false;
+			if ( data.size() >= 148 ) {
+				if ( FileBuffer::readUInt32Fast( data.data() ) == 0x20534444 ) {	// "DDS "
+					if ( data.data()[113] & 0x02 ) {	// DDSCAPS2_CUBEMAP
+						isCubeMap = true;
+						if ( nif->getBSVersion() < 170 && FileBuffer::readUInt32Fast( data.data() + 84 ) == 0x30315844 && data.data()[128] == 0x57 )
+							data[128] = 0x5B;	// Fallout 76: DXGI_FORMAT_B8G8R8A8_UNORM -> DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
+					}
+				} else if ( FileBuffer::readUInt64Fast( data.data() ) == 0x4E41494441523F23ULL ) {	// "#?RADIAN"
 					isCubeMap = true;
-					if ( nif->getBSVersion() < 170 && FileBuffer::readUInt32Fast( data.data() + 84 ) == 0x30315844 && data.data()[128] == 0x57 )
-						data[128] = 0x5B;	// Fallout 76: DXGI_FORMAT_B8G8R8A8_UNORM -> DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
 				}
-			} else if ( FileBuffer::readUInt64Fast( data.data() ) == 0x4E41494441523F23ULL ) {	// "#?RADIAN"
-				isCubeMap = true;
 			}
-		}
-		if ( isCubeMap && nif && nif->getBSVersion() >= 151 ) {
-			mipmaps = texLoadPBRCubeMap( nif, filepath, target, data, id );
+			if ( isCubeMap && nif && nif->getBSVersion() >= 151 ) {
+				mipmaps = texLoadPBRCubeMap( nif, filepath, target, data, id );
+			} else {
+				mipmaps = texLoadDDS( filepath, target, data, id );
+			}
 		} else {
-			mipmaps = texLoadDDS( filepath, target, data, id );
+			QBuffer f( &data );
+			if ( !f.open( QIODevice::ReadWrite ) )
+				throw QString( "could not open buffer" );
+
+			if ( filepath.endsWith( ".tga", Qt::CaseInsensitive ) )
+				mipmaps = texLoadTGA( f, format, target, width, height, id );
+			else if ( filepath.endsWith( ".bmp", Qt::CaseInsensitive ) )
+				mipmaps = texLoadBMP( f, format, target, width, height, id );
+			else if ( filepath.endsWith( ".nif", Qt::CaseInsensitive ) || filepath.endsWith( ".texcache", Qt::CaseInsensitive ) )
+				mipmaps = texLoadNIF( f, format, target, width, height, id );
+
+			f.close();
 		}
-	} else {
-		QBuffer f( &data );
-		if ( !f.open( QIODevice::ReadWrite ) )
-			throw QString( "could not open buffer" );
-
-		if ( filepath.endsWith( ".tga", Qt::CaseInsensitive ) )
-			mipmaps = texLoadTGA( f, format, target, width, height, id );
-		else if ( filepath.endsWith( ".bmp", Qt::CaseInsensitive ) )
-			mipmaps = texLoadBMP( f, format, target, width, height, id );
-		else if ( filepath.endsWith( ".nif", Qt::CaseInsensitive ) || filepath.endsWith( ".texcache", Qt::CaseInsensitive ) )
-			mipmaps = texLoadNIF( f, format, target, width, height, id );
-
-		f.close();
+		data.clear();
 	}
-	data.clear();
 
 	if ( !target )
 		target = GL_TEXTURE_2D;
@@ -79,6 +79,27 @@ extern gli::texture load_if_valid( const char * data, unsigned int size );
  */
 extern GLuint texLoad( const NifModel * nif, const QString & filepath, TexCache::TexFmt & format, GLenum & target, GLuint & width, GLuint & height, GLuint * id );
 
+/*! Decodes a texture that was read on a worker thread, without calling any GL functions.
+ *
+ * Only plain (not cube map) DDS textures are decoded, other formats are left in \a data for texLoad().
+ *
+ * @param filepath	The full path to the texture
+ * @param data		The contents of the file, cleared if the texture is decoded
+ * @param texture	Contains the decoded texture on success
+ * @return			True if the texture was decoded
+ */
+extern bool texDecode( const QString & filepath, QByteArray & data, gli::texture & texture );
+
+/*! A function for loading textures that have already been read, and optionally decoded with texDecode().
+ *
+ * Must be called on the GL thread. Returns the number of mipmaps on success, and throws a QString otherwise.
+ *
+ * @param data		The contents of the file, used if \a texture is null or empty
+ * @param texture	The decoded texture, or nullptr
+ */
+extern GLuint texLoad( const NifModel * nif, const QString & filepath, QByteArray & data, gli::texture * texture,
+					   TexCache::TexFmt & format, GLenum & target, GLuint & width, GLuint & height, GLuint * id );
+
 /*! A function for loading textures.
  *
  * Loads a texture pointed to by model index.
@@ -0,0 +1,188 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "gltexqueue.h"
+
+#include "message.h"
+
+#include <QDebug>
+#include <QThread>
+
+#include <algorithm>
+
+
+//! @file gltexqueue.cpp TexLoadQueue
+
+TexLoadQueue::TexLoadQueue( QObject * parent ) : QObject( parent )
+{
+	timer.start();
+
+	// Extracting from the same archive set is serialized, so a few threads are enough to keep decoding busy
+	int	n = std::min( std::max( QThread::idealThreadCount() - 1, 1 ), 4 );
+	for ( int i = 0; i < n; i++ ) {
+		QThread *	thread = QThread::create( [this]() { run(); } );
+		thread->start( QThread::LowPriority );
+		threads.append( thread );
+	}
+}
+
+TexLoadQueue::~TexLoadQueue()
+{
+	cancel();
+	{
+		QMutexLocker	lock( &mutex );
+		quit = true;
+		wake.wakeAll();
+	}
+	for ( QThread * thread : threads ) {
+		thread->wait();
+		delete thread;
+	}
+}
+
+void TexLoadQueue::request( const void * key, const QString & filepath, const NifModel * nif )
+{
+	Request	r;
+	r.key = key;
+	r.filepath = filepath;
+	r.fullPath = Game::GameManager::get_full_path( filepath, "textures", "" );
+	r.resources = Game::GameManager::acquireNIFResources( nif );
+
+	QMutexLocker	lock( &mutex );
+	r.queuedTime = timer.elapsed();
+	if ( batchStart < 0 )
+		batchStart = r.queuedTime;
+	queue.enqueue( r );
+	stats.requests++;
+	stats.pending++;
+	stats.maxDepth = std::max( stats.maxDepth, stats.pending );
+	wake.wakeOne();
+}
+
+bool TexLoadQueue::takeResult( const void * key, Result & result )
+{
+	QMutexLocker	lock( &mutex );
+	auto	i = results.find( key );
+	if ( i == results.end() )
+		return false;
+	result = std::move( i->second );
+	results.erase( i );
+	return true;
+}
+
+void TexLoadQueue::finished( const Result & result )
+{
+	QMutexLocker	lock( &mutex );
+	qint64	latency = timer.elapsed() - result.queuedTime;
+	stats.uploads++;
+	stats.totalLatency += latency;
+	stats.maxLatency = std::max( stats.maxLatency, latency );
+}
+
+void TexLoadQueue::cancel()
+{
+	QMutexLocker	lock( &mutex );
+	while ( !queue.isEmpty() ) {
+		Game::GameManager::releaseNIFResources( queue.dequeue().resources );
+		stats.cancelled++;
+		stats.pending--;
+	}
+	while ( running > 0 )
+		idle.wait( &mutex );
+	stats.cancelled += qint64( results.size() );
+	results.clear();
+
+	bool	report = ( batchStart >= 0 );
+	if ( report ) {
+		stats.batchTime = timer.elapsed() - batchStart;
+		batchStart = -1;
+	}
+	lock.unlock();
+	if ( report )
+		qCDebug( nsGl ) << statisticsReport();
+}
+
+TexLoadQueue::Statistics TexLoadQueue::statistics()
+{
+	QMutexLocker	lock( &mutex );
+	return stats;
+}
+
+QString TexLoadQueue::statisticsReport()
+{
+	Statistics	s = statistics();
+	return QString( "Texture queue: %1 requests, %2 uploaded, %3 cancelled, last batch %4 ms, max. depth %5, average wait %6 ms, average latency %7 ms (max. %8 ms)" )
+		.arg( s.requests ).arg( s.uploads ).arg( s.cancelled ).arg( s.batchTime ).arg( s.maxDepth )
+		.arg( s.requests ? double( s.totalWait ) / double( s.requests ) : 0.0, 0, 'f', 1 )
+		.arg( s.uploads ? double( s.totalLatency ) / double( s.uploads ) : 0.0, 0, 'f', 1 )
+		.arg( s.maxLatency );
+}
+
+void TexLoadQueue::run()
+{
+	QMutexLocker	lock( &mutex );
+	while ( true ) {
+		while ( queue.isEmpty() && !quit )
+			wake.wait( &mutex );
+		if ( quit )
+			break;
+
+		Request	r = queue.dequeue();
+		stats.totalWait += timer.elapsed() - r.queuedTime;
+		running++;
+		lock.unlock();
+
+		Result	result;
+		result.queuedTime = r.queuedTime;
+		if ( r.resources->get_file( result.data, r.fullPath ) )
+			texDecode( r.filepath, result.data, result.texture );
+		else
+			result.error = QString( "could not open file" );
+		Game::GameManager::releaseNIFResources( r.resources );
+
+		lock.relock();
+		results.insert_or_assign( r.key, std::move( result ) );
+		running--;
+		stats.pending--;
+		idle.wakeAll();
+		emit sigReady();
+
+		// The batch is complete when all of its requests have been read, whether or not they are bound again
+		if ( stats.pending <= 0 && batchStart >= 0 ) {
+			stats.batchTime = timer.elapsed() - batchStart;
+			batchStart = -1;
+			lock.unlock();
+			qCDebug( nsGl ) << statisticsReport();
+			lock.relock();
+		}
+	}
+}
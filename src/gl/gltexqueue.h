@@ -0,0 +1,142 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef GLTEXQUEUE_H
+#define GLTEXQUEUE_H
+
+#include "gamemanager.h"
+#include "gl/gltexloaders.h"
+
+#include <QObject> // Inherited
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QWaitCondition>
+
+#include <string>
+#include <unordered_map>
+
+
+//! @file gltexqueue.h TexLoadQueue
+
+class QThread;
+
+//! Reads and decodes textures on worker threads, for upload by TexCache on the GL thread
+class TexLoadQueue final : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! A texture read by a worker thread
+	struct Result
+	{
+		//! The file contents, empty if the texture was decoded
+		QByteArray data;
+		//! The decoded texture
+		gli::texture texture;
+		//! Error message if the file could not be read
+		QString error;
+		//! Time the request was queued, in milliseconds since the queue was created
+		qint64 queuedTime = 0;
+	};
+
+	//! Queue statistics, times are in milliseconds
+	struct Statistics
+	{
+		//! Requests that are queued or being read
+		int pending = 0;
+		int maxDepth = 0;
+		qint64 requests = 0;
+		qint64 uploads = 0;
+		//! Requests discarded by cancel() before or after they were read
+		qint64 cancelled = 0;
+		qint64 totalWait = 0;
+		qint64 totalLatency = 0;
+		qint64 maxLatency = 0;
+		//! Time from the first request of the last batch until all of its requests were read
+		qint64 batchTime = 0;
+	};
+
+	TexLoadQueue( QObject * parent = nullptr );
+	~TexLoadQueue();
+
+	//! Queue reading \a filepath from the resources of \a nif, the result is looked up by \a key
+	void request( const void * key, const QString & filepath, const NifModel * nif );
+	//! Move the result for \a key to \a result, returns false if it is not ready yet
+	bool takeResult( const void * key, Result & result );
+	//! Record that a result taken with takeResult() has been uploaded or discarded
+	void finished( const Result & result );
+	//! Discard all queued requests and results, waiting for the ones that are being read
+	void cancel();
+
+	Statistics statistics();
+	//! Summary of the statistics for the log
+	/*!
+	 * Written to the nifskope.gl debug category whenever a batch of requests has been read or cancelled.
+	 * Results that are never taken, because their texture is not bound again, do not hold up the report.
+	 */
+	QString statisticsReport();
+
+signals:
+	//! Emitted on a worker thread when a result becomes available
+	void sigReady();
+
+protected:
+	struct Request
+	{
+		const void * key;
+		QString filepath;
+		std::string fullPath;
+		Game::GameManager::GameResources * resources;
+		qint64 queuedTime;
+	};
+
+	void run();
+
+	QList<QThread *> threads;
+	QMutex mutex;
+	QWaitCondition wake;
+	QWaitCondition idle;
+	QQueue<Request> queue;
+	std::unordered_map<const void *, Result> results;
+	int running = 0;
+	bool quit = false;
+
+	QElapsedTimer timer;
+	qint64 batchStart = -1;
+	Statistics stats;
+};
+
+#endif
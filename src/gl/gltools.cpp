@@ -32,6 +32,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "gltools.h"
 
+#include "model/niffields.h"
 #include "model/nifmodel.h"
 #include "qtcompat.h"
 #include "glview.h"
@@ -58,11 +59,11 @@ BoneWeights::BoneWeights( const NifModel * nif, const QModelIndex & index, int b
 	radius = sph.radius;
 	bone = b;
 
-	QModelIndex idxWeights = nif->getIndex( index, "Vertex Weights" );
+	QModelIndex idxWeights = nif->getIndex( index, fieldVertexWeights );
 	if ( vcnt && idxWeights.isValid() ) {
 		for ( int c = 0; c < nif->rowCount( idxWeights ); c++ ) {
 			QModelIndex idx = QModelIndex_child( idxWeights, c );
-			weights.append( VertexWeight( nif->get<int>( idx, "Index" ), nif->get<float>( idx, "Weight" ) ) );
+			weights.append( VertexWeight( nif->get<int>( idx, fieldIndex ), nif->get<float>( idx, fieldWeight ) ) );
 		}
 	}
 }
@@ -83,24 +84,35 @@ BoneWeightsUNorm::BoneWeightsUNorm( QVector<QPair<quint16, quint16>> weights, [[
 	}
 }
 
+void BoneWeightsUNorm::setWeights( const unsigned char * data, int n )
+{
+	weightsUNORM.resize( 8 );
+	BoneWeightUNORM16 *	dst = weightsUNORM.data();
+	int	i = 0;
+	for ( ; i < n; i++, data += 4 )
+		dst[i] = BoneWeightUNORM16( FileBuffer::readUInt16Fast( data ), FileBuffer::readUInt16Fast( data + 2 ) / 65535.0 );
+	for ( ; i < 8; i++ )
+		dst[i] = BoneWeightUNORM16();
+}
+
 
 SkinPartition::SkinPartition( const NifModel * nif, const QModelIndex & index )
 {
-	numWeightsPerVertex = nif->get<int>( index, "Num Weights Per Vertex" );
+	numWeightsPerVertex = nif->get<int>( index, fieldNumWeightsPerVertex );
 
-	vertexMap = nif->getArray<int>( index, "Vertex Map" );
+	vertexMap = nif->getArray<int>( index, fieldVertexMap );
 
 	if ( vertexMap.isEmpty() ) {
-		vertexMap.resize( nif->get<int>( index, "Num Vertices" ) );
+		vertexMap.resize( nif->get<int>( index, fieldNumVertices ) );
 
 		for ( int x = 0; x < vertexMap.count(); x++ )
 			vertexMap[x] = x;
 	}
 
-	boneMap = nif->getArray<int>( index, "Bones" );
+	boneMap = nif->getArray<int>( index, fieldBones );
 
-	QModelIndex iWeights = nif->getIndex( index, "Vertex Weights" );
-	QModelIndex iBoneIndices = nif->getIndex( index, "Bone Indices" );
+	QModelIndex iWeights = nif->getIndex( index, fieldVertexWeights );
+	QModelIndex iBoneIndices = nif->getIndex( index, fieldBoneIndices );
 
 	weights.resize( vertexMap.count() * numWeightsPerVertex );
 
@@ -114,13 +126,13 @@ SkinPartition::SkinPartition( const NifModel * nif, const QModelIndex & index )
 		}
 	}
 
-	QModelIndex iStrips = nif->getIndex( index, "Strips" );
+	QModelIndex iStrips = nif->getIndex( index, fieldStrips );
 
 	for ( int s = 0; s < nif->rowCount( iStrips ); s++ ) {
 		tristrips << nif->getArray<quint16>( QModelIndex_child( iStrips, s ) );
 	}
 
-	triangles = nif->getArray<Triangle>( index, "Triangles" );
+	triangles = nif->getArray<Triangle>( index, fieldTriangles );
 }
 
 QVector<Triangle> SkinPartition::getRemappedTriangles() const
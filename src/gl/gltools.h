@@ -141,6 +141,9 @@ public:
 	BoneWeightsUNorm() {}
 	BoneWeightsUNorm(QVector<QPair<quint16, quint16>> weights, int v);
 
+	//! Sets the weights from n (bone, weight) pairs of little endian 16-bit integers, padded to 8 weights
+	void setWeights( const unsigned char * data, int n );
+
 	QVector<BoneWeightUNORM16> weightsUNORM;
 };
 
@@ -1274,10 +1274,10 @@ bool Renderer::setupProgramCE2( const NifModel * nif, Program * prog, Shape * me
 		if ( it == Program::CT_TANGENT ) {
 			if ( mesh->transTangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->transTangents.constData() );
+				mesh->setTexCoordPointer( Shape::TangentBuffer, mesh->transTangents );
 			} else if ( mesh->tangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->tangents.constData() );
+				mesh->setTexCoordPointer( Shape::TangentBuffer, mesh->tangents );
 			} else {
 				return false;
 			}
@@ -1285,10 +1285,10 @@ bool Renderer::setupProgramCE2( const NifModel * nif, Program * prog, Shape * me
 		} else if ( it == Program::CT_BITANGENT ) {
 			if ( mesh->transBitangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->transBitangents.constData() );
+				mesh->setTexCoordPointer( Shape::BitangentBuffer, mesh->transBitangents );
 			} else if ( mesh->bitangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->bitangents.constData() );
+				mesh->setTexCoordPointer( Shape::BitangentBuffer, mesh->bitangents );
 			} else {
 				return false;
 			}
@@ -1304,7 +1304,7 @@ bool Renderer::setupProgramCE2( const NifModel * nif, Program * prog, Shape * me
 				return false;
 
 			glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-			glTexCoordPointer( 4, GL_FLOAT, 0, sfMesh->coords.constData() );
+			mesh->setTexCoordPointer( Shape::MeshCoordBuffer, sfMesh->coords );
 		}
 	}
 
@@ -1634,10 +1634,10 @@ bool Renderer::setupProgramCE1( const NifModel * nif, Program * prog, Shape * me
 		if ( it == Program::CT_TANGENT ) {
 			if ( mesh->transTangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->transTangents.constData() );
+				mesh->setTexCoordPointer( Shape::TangentBuffer, mesh->transTangents );
 			} else if ( mesh->tangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->tangents.constData() );
+				mesh->setTexCoordPointer( Shape::TangentBuffer, mesh->tangents );
 			} else {
 				return false;
 			}
@@ -1645,10 +1645,10 @@ bool Renderer::setupProgramCE1( const NifModel * nif, Program * prog, Shape * me
 		} else if ( it == Program::CT_BITANGENT ) {
 			if ( mesh->transBitangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->transBitangents.constData() );
+				mesh->setTexCoordPointer( Shape::BitangentBuffer, mesh->transBitangents );
 			} else if ( mesh->bitangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->bitangents.constData() );
+				mesh->setTexCoordPointer( Shape::BitangentBuffer, mesh->bitangents );
 			} else {
 				return false;
 			}
@@ -1663,7 +1663,7 @@ bool Renderer::setupProgramCE1( const NifModel * nif, Program * prog, Shape * me
 				return false;
 
 			glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-			glTexCoordPointer( 2, GL_FLOAT, 0, mesh->coords[set].constData() );
+			mesh->setTexCoordPointer( Shape::CoordBuffer + std::min( set, 7 ), mesh->coords[set] );
 		}
 	}
 
@@ -1941,10 +1941,10 @@ bool Renderer::setupProgramFO3( const NifModel * nif, Program * prog, Shape * me
 		if ( it == Program::CT_TANGENT ) {
 			if ( mesh->transTangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->transTangents.constData() );
+				mesh->setTexCoordPointer( Shape::TangentBuffer, mesh->transTangents );
 			} else if ( mesh->tangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->tangents.constData() );
+				mesh->setTexCoordPointer( Shape::TangentBuffer, mesh->tangents );
 			} else {
 				return false;
 			}
@@ -1952,10 +1952,10 @@ bool Renderer::setupProgramFO3( const NifModel * nif, Program * prog, Shape * me
 		} else if ( it == Program::CT_BITANGENT ) {
 			if ( mesh->transBitangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->transBitangents.constData() );
+				mesh->setTexCoordPointer( Shape::BitangentBuffer, mesh->transBitangents );
 			} else if ( mesh->bitangents.count() ) {
 				glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-				glTexCoordPointer( 3, GL_FLOAT, 0, mesh->bitangents.constData() );
+				mesh->setTexCoordPointer( Shape::BitangentBuffer, mesh->bitangents );
 			} else {
 				return false;
 			}
@@ -1970,7 +1970,7 @@ bool Renderer::setupProgramFO3( const NifModel * nif, Program * prog, Shape * me
 				return false;
 
 			glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-			glTexCoordPointer( 2, GL_FLOAT, 0, mesh->coords[set].constData() );
+			mesh->setTexCoordPointer( Shape::CoordBuffer + std::min( set, 7 ), mesh->coords[set] );
 		} else if ( bsprop ) {
 			int txid = it;
 			if ( txid < 0 )
@@ -1982,7 +1982,7 @@ bool Renderer::setupProgramFO3( const NifModel * nif, Program * prog, Shape * me
 				return false;
 
 			glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-			glTexCoordPointer( 2, GL_FLOAT, 0, mesh->coords[set].constData() );
+			mesh->setTexCoordPointer( Shape::CoordBuffer + std::min( set, 7 ), mesh->coords[set] );
 		}
 	}
 
@@ -167,10 +167,16 @@ GLView::GLView( QWindow * p )
 
 GLView::~GLView()
 {
+	// the shape buffers, textures and shaders are released in the context they were created in
+	makeCurrent();
+
+	scene->clear();
 	flush();
 
 	delete textures;
 	delete scene;
+
+	doneCurrent();
 }
 
 QWidget * GLView::createWindowContainer( QWidget * parent )
@@ -429,6 +435,7 @@ void GLView::glProjection( int x, int y )
 void GLView::paintGL()
 {
 	updatePending = 0;
+	frameTimer.start();
 
 	if ( isDisabled || !scene->haveRenderer() ) [[unlikely]] {
 		glClearColor( cfg.background.redF(), cfg.background.greenF(), cfg.background.blueF(), cfg.background.alphaF() );
@@ -736,6 +743,17 @@ void GLView::paintGL()
 	while ( ( err = glGetError() ) != GL_NO_ERROR )
 		qDebug() << tr( "glview.cpp - GL ERROR (paint): " ) << getGLErrorString( int(err) );
 
+	if ( nsGl().isDebugEnabled() ) {
+		// include the time the driver needs to finish drawing
+		glFinish();
+		frameTimeTotal += frameTimer.nsecsElapsed();
+		if ( ++frameCount >= 100 ) {
+			qCDebug( nsGl ) << "Average frame time:" << double( frameTimeTotal ) / ( double( frameCount ) * 1000000.0 ) << "ms";
+			frameTimeTotal = 0;
+			frameCount = 0;
+		}
+	}
+
 	emit paintUpdate();
 }
 
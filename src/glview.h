@@ -39,6 +39,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QOpenGLWindow> // Inherited
 #include <QGraphicsView>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QPersistentModelIndex>
 
 
@@ -251,6 +252,11 @@ private:
 	bool doCenter;
 	unsigned char updatePending = 0;
 
+	//! Frame time counter, logged to the nifskope.gl debug category
+	QElapsedTimer frameTimer;
+	qint64 frameTimeTotal = 0;
+	int frameCount = 0;
+
 	QTimer * lightVisTimer;
 	int lightVisTimeout;
 
@@ -3,9 +3,11 @@
 #include "qtcompat.h"
 
 #include <QByteArray>
-#include <QDataStream>
-#include <QBuffer>
+#include <QtEndian>
 #include "fp32vec4.hpp"
+#include "filebuf.hpp"
+
+#include <bit>
 
 #if 0
 // x/32767 matches the min/max bounds in BSGeometry more accurately on average
@@ -47,167 +49,219 @@ void MeshFile::clear()
 	haveData = false;
 }
 
+//! Reads the little endian data of a .mesh file in place, checking the size of each section before it is decoded
+class MeshFileReader
+{
+public:
+	MeshFileReader( const void * data, size_t size )
+		: ptr( reinterpret_cast< const unsigned char * >( data ) ), end( ptr + size )
+	{
+	}
+
+	//! Returns the next n * elementSize bytes and skips them, or nullptr if the buffer is too short
+	const unsigned char * section( quint32 n, size_t elementSize )
+	{
+		size_t	bytes = size_t( n ) * elementSize;
+		if ( bytes > size_t( end - ptr ) ) {
+			ptr = end;
+			return nullptr;
+		}
+		const unsigned char *	p = ptr;
+		ptr += bytes;
+		return p;
+	}
+
+	bool read( quint32 & v )
+	{
+		const unsigned char *	p = section( 1, 4 );
+		if ( !p )
+			return false;
+		v = FileBuffer::readUInt32Fast( p );
+		return true;
+	}
+
+	bool read( float & v )
+	{
+		quint32	n;
+		if ( !read( n ) )
+			return false;
+		v = std::bit_cast< float >( n );
+		return true;
+	}
+
+	//! Reads the number of indices followed by the indices, as triangles
+	bool readTriangles( QVector<Triangle> & triangles )
+	{
+		static_assert( sizeof( Triangle ) == 6 );
+
+		quint32	indicesSize;
+		if ( !read( indicesSize ) )
+			return false;
+		const unsigned char *	p = section( indicesSize, 2 );
+		if ( !p )
+			return false;
+		triangles.resize( qsizetype( indicesSize / 3 ) );
+		qFromLittleEndian< quint16 >( p, triangles.size() * 3, triangles.data() );
+		return true;
+	}
+
+private:
+	const unsigned char *	ptr;
+	const unsigned char *	end;
+};
+
 void MeshFile::update( const void * data, size_t size )
 {
 	clear();
 	if ( !( data && size > 0 ) )
 		return;
 
-	QBuffer	f;
-	f.setData( reinterpret_cast< const char * >( data ), qsizetype( size ) );
-	if ( !f.open(QIODevice::ReadOnly) )
-		return;
-
-	QDataStream	in;
-	in.setDevice(&f);
-	in.setByteOrder(QDataStream::LittleEndian);
-	in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+	MeshFileReader	in( data, size );
 
 	quint32 magic;
-	in >> magic;
-	if ( magic > 2U )
+	if ( !in.read( magic ) || magic > 2U )
 		return;
 
-	quint32 indicesSize;
-	in >> indicesSize;
-	triangles.resize( indicesSize / 3 );
+	if ( !in.readTriangles( triangles ) )
+		return;
 	haveData = true;
 
-	for ( quint32 i = 0; i < indicesSize / 3; i++ ) {
-		Triangle tri;
-		in >> tri;
-		triangles[i] = tri;
-	}
-
 	float scale;
-	in >> scale;
-	if ( scale <= 0.0f ) {
+	quint32 numWeightsPerVertex;
+	if ( !in.read( scale ) || !in.read( numWeightsPerVertex ) || scale <= 0.0f ) {
 		clear();
 		return; // From RE
 	}
-
-	quint32 numWeightsPerVertex;
-	in >> numWeightsPerVertex;
-	weightsPerVertex = numWeightsPerVertex;
+	weightsPerVertex = quint8( numWeightsPerVertex );
 
 	quint32 numPositions;
-	in >> numPositions;
-	if ( !numPositions ) {
+	const unsigned char * src;
+	if ( !in.read( numPositions ) || !numPositions || !( src = in.section( numPositions, 6 ) ) ) {
 		clear();
 		return;
 	}
 	positions.resize( numPositions );
-
-	for ( int i = 0; i < int(numPositions); i++ ) {
-		uint32_t	xy;
-		uint16_t	z;
-
-		in >> xy;
-		in >> z;
-		FloatVector4	xyz(FloatVector4::convertInt16((std::uint64_t(z) << 32) | xy));
+	{
+		Vector3 *	dst = positions.data();
+		// Read 8 bytes at a time except for the last vertex, the upper 16 bits are masked off
+		quint32	i = 0;
+		for ( ; ( i + 1 ) < numPositions; i++, src += 6 ) {
+			FloatVector4	xyz( FloatVector4::convertInt16( FileBuffer::readUInt64Fast( src ) & 0x0000FFFFFFFFFFFFULL ) );
+			xyz /= 32767.0f;
+			xyz *= scale;
+			dst[i].fromFloatVector4( xyz );
+		}
+		std::uint64_t	xyzLast = FileBuffer::readUInt32Fast( src ) | ( std::uint64_t( FileBuffer::readUInt16Fast( src + 4 ) ) << 32 );
+		FloatVector4	xyz( FloatVector4::convertInt16( xyzLast ) );
 		xyz /= 32767.0f;
 		xyz *= scale;
-
-		positions[i] = Vector3(xyz[0], xyz[1], xyz[2]);
+		dst[i].fromFloatVector4( xyz );
 	}
 
 	quint32 numCoord1;
-	in >> numCoord1;
+	if ( !in.read( numCoord1 ) || !( src = in.section( numCoord1, 4 ) ) ) {
+		clear();
+		return;
+	}
 	coords.resize( numCoord1 );
-
-	for ( int i = 0; i < int(numCoord1); i++ ) {
-		uint32_t uv;
-
-		in >> uv;
-
-		coords[i] = Vector4(FloatVector4::convertFloat16(uv));
+	{
+		Vector4 *	dst = coords.data();
+		// Two UVs per conversion
+		quint32	i = 0;
+		for ( ; ( i + 1 ) < numCoord1; i += 2, src += 8 ) {
+			FloatVector4	uv( FloatVector4::convertFloat16( FileBuffer::readUInt64Fast( src ) ) );
+			dst[i] = Vector4( FloatVector4( uv ).blendValues( FloatVector4( 0.0f ), 0x0C ) );
+			dst[i + 1] = Vector4( FloatVector4( uv ).shuffleValues( 0x0E ).blendValues( FloatVector4( 0.0f ), 0x0C ) );
+		}
+		if ( i < numCoord1 )
+			dst[i] = Vector4( FloatVector4::convertFloat16( FileBuffer::readUInt32Fast( src ) ) );
 	}
 
 	quint32 numCoord2;
-	in >> numCoord2;
+	if ( !in.read( numCoord2 ) || !( src = in.section( numCoord2, 4 ) ) ) {
+		clear();
+		return;
+	}
 	numCoord2 = std::min( numCoord2, numCoord1 );
 	haveTexCoord2 = bool( numCoord2 );
+	for ( quint32 i = 0; i < numCoord2; i++, src += 4 ) {
+		FloatVector4	uv( FloatVector4::convertFloat16( FileBuffer::readUInt32Fast( src ) ) );
 
-	for ( quint32 i = 0; i < numCoord2; i++ ) {
-		uint32_t uv;
-
-		in >> uv;
-		FloatVector4  uv_f(FloatVector4::convertFloat16(uv));
-
-		coords[i][2] = uv_f[0];
-		coords[i][3] = uv_f[1];
+		coords[i][2] = uv[0];
+		coords[i][3] = uv[1];
 	}
 
 	quint32 numColor;
-	in >> numColor;
+	if ( !in.read( numColor ) || !( src = in.section( numColor, 4 ) ) ) {
+		clear();
+		return;
+	}
 	if ( numColor > 0 ) {
 		colors.resize( numColor );
-	}
-	for ( quint32 i = 0; i < numColor; i++ ) {
-		uint32_t	bgra;
-		in >> bgra;
-		colors[i] = Color4( ( FloatVector4(bgra) / 255.0f ).shuffleValues( 0xC6 ) );	// 2, 1, 0, 3
+		Color4 *	dst = colors.data();
+		for ( quint32 i = 0; i < numColor; i++, src += 4 ) {
+			std::uint32_t	bgra = FileBuffer::readUInt32Fast( src );
+			dst[i] = Color4( ( FloatVector4( bgra ) / 255.0f ).shuffleValues( 0xC6 ) );	// 2, 1, 0, 3
+		}
 	}
 
 	quint32 numNormal;
-	in >> numNormal;
+	if ( !in.read( numNormal ) || !( src = in.section( numNormal, 4 ) ) ) {
+		clear();
+		return;
+	}
 	if ( numNormal > 0 ) {
 		normals.resize( numNormal );
-	}
-	for ( int i = 0; i < int(numNormal); i++ ) {
-		std::uint32_t	n;
-		in >> n;
-		normals[i] = Vector3( UDecVector4(n) );
+		Vector3 *	dst = normals.data();
+		for ( quint32 i = 0; i < numNormal; i++, src += 4 )
+			dst[i].fromFloatVector4( FloatVector4::convertX10Y10Z10W2( FileBuffer::readUInt32Fast( src ) ) );
 	}
 
 	quint32 numTangent;
-	in >> numTangent;
+	if ( !in.read( numTangent ) || !( src = in.section( numTangent, 4 ) ) ) {
+		clear();
+		return;
+	}
 	if ( numTangent > 0 ) {
 		tangents.resize( numTangent );
 		bitangentsBasis.resize( numTangent );
-	}
-	for ( int i = 0; i < int(numTangent); i++ ) {
-		std::uint32_t	n;
-		in >> n;
-		UDecVector4	v( n );
-		tangents[i] = Vector3( v );
-		bitangentsBasis[i] = v[3];
+		Vector3 *	dstT = tangents.data();
+		float *	dstB = bitangentsBasis.data();
+		for ( quint32 i = 0; i < numTangent; i++, src += 4 ) {
+			FloatVector4	v( FloatVector4::convertX10Y10Z10W2( FileBuffer::readUInt32Fast( src ) ) );
+			dstT[i].fromFloatVector4( v );
+			dstB[i] = v[3];
+		}
 	}
 
+	// Weights are (bone, weight) pairs of 16-bit integers, numWeightsPerVertex pairs per vertex
 	quint32 numWeights;
-	in >> numWeights;
-	if ( numWeights > 0 && numWeightsPerVertex > 0 ) {
-		weights.resize(numWeights / numWeightsPerVertex);
+	if ( !in.read( numWeights ) || !( src = in.section( numWeights, 4 ) ) ) {
+		clear();
+		return;
 	}
-	for ( int i = 0; i < weights.count(); i++ ) {
-		QVector<QPair<quint16, quint16>> weightsUNORM;
-		for ( quint32 j = 0; j < 8; j++ ) {
-			if ( j < numWeightsPerVertex ) {
-				quint16 b, w;
-				in >> b;
-				in >> w;
-				weightsUNORM.append({ b, w });
-			} else {
-				weightsUNORM.append({0, 0});
-			}
+	if ( numWeights > 0 && numWeightsPerVertex > 0 ) {
+		weights.resize( numWeights / numWeightsPerVertex );
+		int	n = int( std::min< quint32 >( numWeightsPerVertex, 8 ) );
+		for ( auto & w : weights ) {
+			w.setWeights( src, n );
+			src += size_t( numWeightsPerVertex ) * 4;
 		}
-		weights[i] = BoneWeightsUNorm(weightsUNORM, i);
 	}
 
 	if ( magic ) {
 		quint32 numLODs;
-		in >> numLODs;
-		lods.resize(numLODs);
+		if ( !in.read( numLODs ) ) {
+			clear();
+			return;
+		}
 		for ( quint32 i = 0; i < numLODs; i++ ) {
-			quint32 indicesSize2;
-			in >> indicesSize2;
-			lods[i].resize(indicesSize2 / 3);
-
-			for ( quint32 j = 0; j < indicesSize2 / 3; j++ ) {
-				Triangle tri;
-				in >> tri;
-				lods[i][j] = tri;
+			QVector<Triangle>	lod;
+			if ( !in.readTriangles( lod ) ) {
+				clear();
+				return;
 			}
+			lods.append( lod );
 		}
 	}
 }
@@ -0,0 +1,672 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "nifindex.h"
+
+#include "gamemanager.h"
+#include "model/nifmodel.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QReadWriteLock>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <set>
+#include <string>
+
+
+//! @file nifindex.cpp NifIndex
+
+//! Cache file header
+/*!
+ * Followed by the arrays, in this order:
+ *  - qint64 fileStamps[fileCount * 2]: size and modification time of each file
+ *  - quint32 filePaths[fileCount]: offsets of the file paths in the strings
+ *  - quint32 fileTermBegin[fileCount + 1], quint32 fileTerms[postingCount]: the sorted term IDs of each file
+ *  - quint32 termNames[termCount]: offsets of the term names in the strings, the names are in ascending order
+ *  - quint32 termPostingBegin[termCount + 1], quint32 postings[postingCount]: the sorted file IDs of each term
+ *  - char strings[stringsSize]: null terminated file paths and term names
+ */
+struct NifIndexHeader
+{
+	char magic[8];
+	quint32 fileCount;
+	quint32 termCount;
+	quint32 postingCount;
+	quint32 stringsSize;
+	char fieldsKey[20];
+	quint32 reserved;
+};
+
+static const char nifIndexMagic[8] = { 'N', 'S', 'N', 'I', 'D', 'X', '\0', '\1' };
+
+static const char * const termPrefixes[3] = { "block:", "path:", "value:" };
+
+NifIndex::NifIndex( const QString & source ) : sourcePath( source ), indexedFields( defaultFields() )
+{
+	if ( source.startsWith( "game:", Qt::CaseInsensitive ) )
+		archiveGame = int( Game::ModeForString( source.mid( 5 ) ) );
+}
+
+NifIndex::~NifIndex()
+{
+	if ( file.isOpen() )
+		file.close();
+}
+
+QStringList NifIndex::defaultFields()
+{
+	return { "Shader Flags 1", "Shader Flags 2", "Shader Type", "SF1", "SF2" };
+}
+
+QByteArray NifIndex::fieldsKey() const
+{
+	return QCryptographicHash::hash( indexedFields.join( '\n' ).toUtf8(), QCryptographicHash::Sha1 );
+}
+
+QString NifIndex::cachePath() const
+{
+	QString cacheDir = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+	if ( cacheDir.isEmpty() )
+		return QString();
+
+	QString key = ( archiveGame >= 0 ) ? sourcePath.toLower() : QFileInfo( sourcePath ).absoluteFilePath();
+	QByteArray hash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Sha1 );
+	return cacheDir + "/nifindex/" + QString::fromLatin1( hash.toHex() ) + ".idx";
+}
+
+QString NifIndex::toString( const std::string_view & s ) const
+{
+	// archive paths are stored as the bytes used by the archives
+	if ( archiveGame >= 0 )
+		return QString::fromLatin1( s.data(), qsizetype( s.length() ) );
+	return QString::fromUtf8( s.data(), qsizetype( s.length() ) );
+}
+
+QString NifIndex::filePath( const QString & fileName ) const
+{
+	if ( archiveGame >= 0 )
+		return fileName;
+	return QDir( sourcePath ).filePath( fileName );
+}
+
+bool NifIndex::setData( const uchar * data, qint64 size )
+{
+	if ( !data || size < qint64( sizeof( NifIndexHeader ) ) )
+		return false;
+
+	NifIndexHeader h;
+	std::memcpy( &h, data, sizeof( h ) );
+	if ( std::memcmp( h.magic, nifIndexMagic, sizeof( h.magic ) ) )
+		return false;
+
+	qint64 expectedSize = qint64( sizeof( h ) ) + qint64( h.fileCount ) * 20 + ( qint64( h.fileCount ) + 1 ) * 4
+							+ qint64( h.termCount ) * 4 + ( qint64( h.termCount ) + 1 ) * 4
+							+ qint64( h.postingCount ) * 8 + qint64( h.stringsSize );
+	if ( size != expectedSize || ( h.stringsSize > 0 && data[size - 1] != 0 ) )
+		return false;
+
+	const uchar * p = data + sizeof( h );
+	const qint64 * stamps = reinterpret_cast< const qint64 * >( p );
+	p = p + size_t( h.fileCount ) * 16;
+	const quint32 * paths = reinterpret_cast< const quint32 * >( p );
+	const quint32 * fBegin = paths + h.fileCount;
+	const quint32 * fTerms = fBegin + ( h.fileCount + 1 );
+	const quint32 * tNames = fTerms + h.postingCount;
+	const quint32 * tBegin = tNames + h.termCount;
+	const quint32 * tPostings = tBegin + ( h.termCount + 1 );
+	const char * s = reinterpret_cast< const char * >( tPostings + h.postingCount );
+
+	// Validate the offsets and IDs once, so that the accessors do not need to
+	if ( fBegin[0] != 0 || fBegin[h.fileCount] != h.postingCount || tBegin[0] != 0 || tBegin[h.termCount] != h.postingCount )
+		return false;
+	for ( quint32 i = 0; i < h.fileCount; i++ ) {
+		if ( fBegin[i + 1] < fBegin[i] || paths[i] >= h.stringsSize )
+			return false;
+	}
+	for ( quint32 i = 0; i < h.termCount; i++ ) {
+		if ( tBegin[i + 1] < tBegin[i] || tNames[i] >= h.stringsSize )
+			return false;
+	}
+	for ( quint32 i = 0; i < h.postingCount; i++ ) {
+		if ( fTerms[i] >= h.termCount || tPostings[i] >= h.fileCount )
+			return false;
+	}
+
+	numFiles = h.fileCount;
+	numTerms = h.termCount;
+	fileStamps = stamps;
+	filePaths = paths;
+	fileTermBegin = fBegin;
+	fileTerms = fTerms;
+	termNames = tNames;
+	termPostingBegin = tBegin;
+	postings = tPostings;
+	strings = s;
+	dataFieldsKey = QByteArray( h.fieldsKey, qsizetype( sizeof( h.fieldsKey ) ) );
+	return true;
+}
+
+bool NifIndex::load()
+{
+	QString path = cachePath();
+	if ( path.isEmpty() )
+		return false;
+
+	if ( file.isOpen() )
+		file.close();
+	buffer.clear();
+	numFiles = numTerms = 0;
+
+	file.setFileName( path );
+	if ( !file.open( QIODevice::ReadOnly ) )
+		return false;
+
+	qint64 size = file.size();
+	const uchar * data = file.map( 0, size );
+	if ( !data ) {
+		buffer = file.readAll();
+		file.close();
+		data = reinterpret_cast< const uchar * >( buffer.constData() );
+	}
+
+	if ( !setData( data, size ) ) {
+		numFiles = numTerms = 0;
+		if ( file.isOpen() )
+			file.close();
+		buffer.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ *  Update
+ */
+
+namespace
+{
+
+struct SourceFile
+{
+	std::string path;
+	qint64 size;
+	qint64 mtime;
+};
+
+void addValueTerms( const NifModel & nif, const QString & field, const QString & type, const NifValue & value, const NifItem * item,
+					std::vector<std::string> & terms )
+{
+	std::string prefix = "value:" + field.toStdString() + "=";
+
+	NifValue::EnumType enumType = NifValue::enumType( type );
+	if ( enumType != NifValue::eNone ) {
+		const NifValue::EnumOptions & options = NifValue::enumOptionData( type );
+		quint32 v = quint32( value.toCount( nullptr, nullptr ) );
+		if ( enumType == NifValue::eFlags ) {
+			for ( auto i = options.o.constBegin(); i != options.o.constEnd(); i++ ) {
+				if ( i.key() < 32 && ( v & ( 1U << i.key() ) ) )
+					terms.push_back( prefix + i.value().first.toStdString() );
+			}
+		} else {
+			auto i = options.o.constFind( v );
+			terms.push_back( prefix + ( i != options.o.constEnd() ? i.value().first : QString::number( v ) ).toStdString() );
+		}
+		return;
+	}
+
+	QString s;
+	if ( item && ( value.isString() || value.type() == NifValue::tStringIndex ) )
+		s = nif.resolveString( item );
+	else
+		s = value.toString();
+	if ( !s.isEmpty() )
+		terms.push_back( prefix + s.toStdString() );
+}
+
+void collectItemTerms( const NifModel & nif, const NifItem * parent, const QStringList & fields, std::vector<std::string> & terms )
+{
+	if ( parent->isPacked() ) {
+		// large arrays of plain values, which are only read if they are selected
+		if ( fields.contains( parent->name() ) ) {
+			for ( const NifValue & v : parent->packedValues() )
+				addValueTerms( nif, parent->name(), parent->strType(), v, nullptr, terms );
+		}
+		return;
+	}
+
+	for ( int i = 0; i < parent->childCount(); i++ ) {
+		const NifItem * item = parent->child( i );
+		if ( !item || !nif.evalCondition( item ) )
+			continue;
+		if ( item->childCount() > 0 ) {
+			collectItemTerms( nif, item, fields, terms );
+			continue;
+		}
+		if ( item->isArray() )
+			continue;
+
+		std::string path = Game::GameManager::get_resource_path( &nif, item );
+		if ( !path.empty() )
+			terms.push_back( "path:" + path );
+		if ( fields.contains( item->name() ) )
+			addValueTerms( nif, item->name(), item->strType(), item->value(), item, terms );
+	}
+}
+
+//! The sorted terms of a loaded file
+void collectTerms( const NifModel & nif, const QStringList & fields, std::vector<std::string> & terms )
+{
+	for ( int b = 0; b < nif.getBlockCount(); b++ ) {
+		const NifItem * block = nif.getBlockItem( qint32( b ) );
+		if ( !block )
+			continue;
+		terms.push_back( "block:" + block->name().toStdString() );
+		collectItemTerms( nif, block, fields, terms );
+	}
+
+	std::sort( terms.begin(), terms.end() );
+	terms.erase( std::unique( terms.begin(), terms.end() ), terms.end() );
+}
+
+bool archiveNifFilter( [[maybe_unused]] void * p, const std::string_view & fileName )
+{
+	return fileName.ends_with( ".nif" );
+}
+
+//! Stamp of the archives of a game, used as the modification time of all files of an archive source
+qint64 archiveStamp( Game::GameMode game )
+{
+	QCryptographicHash hash( QCryptographicHash::Sha1 );
+	for ( const QString & dataPath : Game::GameManager::folders( game ) ) {
+		QFileInfo fi( dataPath );
+		QFileInfoList archives;
+		if ( fi.isDir() ) {
+			for ( const QString & name : Game::GameManager::get_archive_list( dataPath ) )
+				archives.append( QFileInfo( QDir( dataPath ).filePath( name ) ) );
+		} else {
+			archives.append( fi );
+		}
+		for ( const QFileInfo & a : archives ) {
+			hash.addData( a.absoluteFilePath().toUtf8() );
+			qint64 v[2] = { a.size(), a.lastModified().toMSecsSinceEpoch() };
+			hash.addData( QByteArrayView( reinterpret_cast< const char * >( v ), qsizetype( sizeof( v ) ) ) );
+		}
+	}
+
+	qint64 stamp;
+	std::memcpy( &stamp, hash.result().constData(), sizeof( stamp ) );
+	return stamp;
+}
+
+} // namespace
+
+bool NifIndex::update( int threadCount, const std::function<bool ( int, int )> & progress )
+{
+	QElapsedTimer timer;
+	timer.start();
+	updateStats = UpdateStatistics();
+
+	// list the files of the source, sorted by path
+	std::vector<SourceFile> files;
+	Game::GameMode game = Game::GameMode( archiveGame );
+	if ( archiveGame >= 0 ) {
+		if ( !Game::GameManager::status( game ) )
+			return false;
+		qint64 stamp = archiveStamp( game );
+		std::set<std::string_view> fileSet;
+		Game::GameManager::list_files( fileSet, game, &archiveNifFilter, nullptr );
+		for ( const std::string_view & f : fileSet )
+			files.push_back( SourceFile{ std::string( f ), 0, stamp } );
+	} else {
+		QDir dir( sourcePath );
+		if ( !dir.exists() )
+			return false;
+		QDirIterator it( dir.absolutePath(), QDir::Files, QDirIterator::Subdirectories );
+		while ( it.hasNext() ) {
+			QString filePath = it.next();
+			if ( !filePath.endsWith( ".nif", Qt::CaseInsensitive ) )
+				continue;
+			QFileInfo fi = it.fileInfo();
+			files.push_back( SourceFile{ dir.relativeFilePath( filePath ).toStdString(), fi.size(), fi.lastModified().toMSecsSinceEpoch() } );
+		}
+		std::sort( files.begin(), files.end(), []( const SourceFile & a, const SourceFile & b ) { return a.path < b.path; } );
+	}
+	updateStats.filesTotal = int( files.size() );
+
+	// the terms of unchanged files are taken from the current index, if it was created with the same fields
+	bool reuseTerms = ( numFiles > 0 && dataFieldsKey == fieldsKey() );
+	std::vector<std::vector<std::string_view>> fileTermNames( files.size() );
+	std::vector<size_t> changedFiles;
+	for ( size_t i = 0; i < files.size(); i++ ) {
+		const SourceFile & f = files[i];
+		if ( reuseTerms ) {
+			quint32 lo = 0, hi = numFiles;
+			while ( lo < hi ) {
+				quint32 mid = lo + ( hi - lo ) / 2;
+				if ( fileName( mid ) < f.path )
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			if ( lo < numFiles && fileName( lo ) == f.path && fileStamps[lo * 2] == f.size && fileStamps[lo * 2 + 1] == f.mtime ) {
+				for ( quint32 j = fileTermBegin[lo]; j < fileTermBegin[lo + 1]; j++ )
+					fileTermNames[i].push_back( termName( fileTerms[j] ) );
+				continue;
+			}
+		}
+		changedFiles.push_back( i );
+	}
+
+	// load the new and changed files on worker threads
+	std::vector<std::vector<std::string>> loadedTerms( changedFiles.size() );
+	int total = int( changedFiles.size() );
+	std::atomic<int> nextFile( 0 );
+	std::atomic<int> done( 0 );
+	std::atomic<int> failed( 0 );
+	std::atomic<qint64> bytesRead( 0 );
+	std::atomic<bool> cancelled( false );
+
+	auto worker = [&]() {
+		// The schema is shared read-only by all workers
+		QReadLocker lck( &NifModel::XMLlock );
+
+		NifModel nif;
+		for ( int n; !cancelled && ( n = nextFile++ ) < total; done++ ) {
+			const SourceFile & f = files[changedFiles[n]];
+			QByteArray data;
+			QString path;
+			bool dataRead = false;
+			if ( archiveGame >= 0 ) {
+				dataRead = Game::GameManager::get_file( data, game, f.path );
+			} else {
+				path = QDir( sourcePath ).filePath( QString::fromStdString( f.path ) );
+				QFile fileData( path );
+				if ( fileData.open( QIODevice::ReadOnly ) ) {
+					data = fileData.readAll();
+					dataRead = true;
+				}
+			}
+			bytesRead += data.size();
+
+			if ( dataRead && nif.loadFromData( data, path ) )
+				collectTerms( nif, indexedFields, loadedTerms[n] );
+			else
+				failed++;
+		}
+	};
+
+	int numThreads = ( threadCount > 0 ) ? threadCount : QThread::idealThreadCount();
+	numThreads = std::clamp( numThreads, 1, std::max( total, 1 ) );
+	QList<QThread *> threads;
+	for ( int i = 0; i < numThreads && total > 0; i++ ) {
+		QThread * thread = QThread::create( worker );
+		thread->start();
+		threads.append( thread );
+	}
+	for ( QThread * thread : threads ) {
+		while ( !thread->wait( QDeadlineTimer( 50 ) ) ) {
+			if ( progress && !cancelled && !progress( done, total ) )
+				cancelled = true;
+		}
+		delete thread;
+	}
+	if ( progress && !cancelled )
+		progress( total, total );
+
+	updateStats.filesLoaded = total;
+	updateStats.filesFailed = failed;
+	updateStats.bytesRead = bytesRead;
+	if ( cancelled ) {
+		updateStats.seconds = double( timer.nsecsElapsed() ) / 1.0e9;
+		return false;
+	}
+
+	for ( size_t n = 0; n < changedFiles.size(); n++ )
+		fileTermNames[changedFiles[n]].assign( loadedTerms[n].begin(), loadedTerms[n].end() );
+
+	// the term table, with IDs in ascending order of the names
+	std::vector<std::string_view> terms;
+	for ( const auto & t : fileTermNames )
+		terms.insert( terms.end(), t.begin(), t.end() );
+	std::sort( terms.begin(), terms.end() );
+	terms.erase( std::unique( terms.begin(), terms.end() ), terms.end() );
+
+	NifIndexHeader h;
+	std::memcpy( h.magic, nifIndexMagic, sizeof( h.magic ) );
+	h.fileCount = quint32( files.size() );
+	h.termCount = quint32( terms.size() );
+	h.postingCount = 0;
+	h.stringsSize = 0;
+	QByteArray key = fieldsKey();
+	std::memcpy( h.fieldsKey, key.constData(), sizeof( h.fieldsKey ) );
+	h.reserved = 0;
+
+	std::vector<qint64> stamps;
+	std::vector<quint32> paths, fBegin, fTerms, tNames, tBegin( terms.size() + 1, 0 ), tPostings;
+	QByteArray s;
+	stamps.reserve( files.size() * 2 );
+	fBegin.reserve( files.size() + 1 );
+	for ( size_t i = 0; i < files.size(); i++ ) {
+		stamps.push_back( files[i].size );
+		stamps.push_back( files[i].mtime );
+		paths.push_back( quint32( s.size() ) );
+		s.append( files[i].path.c_str(), qsizetype( files[i].path.length() + 1 ) );
+		fBegin.push_back( quint32( fTerms.size() ) );
+		for ( const std::string_view & t : fileTermNames[i] ) {
+			quint32 id = quint32( std::lower_bound( terms.begin(), terms.end(), t ) - terms.begin() );
+			fTerms.push_back( id );
+			tBegin[id + 1]++;
+		}
+	}
+	fBegin.push_back( quint32( fTerms.size() ) );
+	for ( size_t i = 0; i < terms.size(); i++ ) {
+		tNames.push_back( quint32( s.size() ) );
+		s.append( terms[i].data(), qsizetype( terms[i].length() ) );
+		s.append( '\0' );
+		tBegin[i + 1] += tBegin[i];
+	}
+	tPostings.resize( fTerms.size() );
+	{
+		// files are added in ascending order, so the postings of each term are sorted
+		std::vector<quint32> pos( tBegin.begin(), tBegin.end() - 1 );
+		for ( quint32 i = 0; i < h.fileCount; i++ ) {
+			for ( quint32 j = fBegin[i]; j < fBegin[i + 1]; j++ )
+				tPostings[pos[fTerms[j]]++] = i;
+		}
+	}
+	h.postingCount = quint32( fTerms.size() );
+	h.stringsSize = quint32( s.size() );
+
+	QByteArray buf;
+	auto append = [&buf]( const auto & v ) {
+		buf.append( reinterpret_cast< const char * >( v.data() ), qsizetype( v.size() * sizeof( v[0] ) ) );
+	};
+	buf.reserve( qsizetype( sizeof( h ) + stamps.size() * 8 + ( paths.size() + fBegin.size() + fTerms.size() * 2
+														+ tNames.size() + tBegin.size() ) * 4 ) + s.size() );
+	buf.append( reinterpret_cast< const char * >( &h ), qsizetype( sizeof( h ) ) );
+	append( stamps );
+	append( paths );
+	append( fBegin );
+	append( fTerms );
+	append( tNames );
+	append( tBegin );
+	append( tPostings );
+	buf.append( s );
+
+	// the terms of the current index are no longer needed
+	fileTermNames.clear();
+	terms.clear();
+	if ( file.isOpen() )
+		file.close();
+	buffer = buf;
+	setData( reinterpret_cast< const uchar * >( buffer.constData() ), buffer.size() );
+
+	QString path = cachePath();
+	if ( !path.isEmpty() && QDir().mkpath( QFileInfo( path ).absolutePath() ) ) {
+		QSaveFile f( path );
+		if ( f.open( QIODevice::WriteOnly ) && f.write( buffer ) == buffer.size() )
+			f.commit();
+	}
+
+	updateStats.seconds = double( timer.nsecsElapsed() ) / 1.0e9;
+	return true;
+}
+
+/*
+ *  Queries
+ */
+
+QStringList NifIndex::parseQuery( const QString & query )
+{
+	QStringList terms;
+	QString term;
+	bool quoted = false;
+	for ( QChar c : query ) {
+		if ( c == '"' ) {
+			quoted = !quoted;
+		} else if ( c.isSpace() && !quoted ) {
+			if ( !term.isEmpty() )
+				terms.append( term );
+			term.clear();
+		} else {
+			term.append( c );
+		}
+	}
+	if ( !term.isEmpty() )
+		terms.append( term );
+	return terms;
+}
+
+void NifIndex::addPostings( quint32 i, std::vector<quint32> & files ) const
+{
+	files.insert( files.end(), postings + termPostingBegin[i], postings + termPostingBegin[i + 1] );
+}
+
+std::vector<quint32> NifIndex::match( const QString & queryTerm ) const
+{
+	QString term = queryTerm;
+	if ( !( term.startsWith( termPrefixes[0] ) || term.startsWith( termPrefixes[1] ) || term.startsWith( termPrefixes[2] ) ) )
+		term.prepend( termPrefixes[1] );
+	if ( term.startsWith( termPrefixes[1] ) )
+		term = term.toLower().replace( '\\', '/' );
+
+	// the range of terms that begin with the part of the term before the first wildcard
+	qsizetype wildcard = term.indexOf( '*' );
+	std::string prefix = ( archiveGame >= 0 ? term.left( wildcard ).toLatin1() : term.left( wildcard ).toUtf8() ).toStdString();
+	quint32 lo = 0, hi = numTerms;
+	{
+		quint32 a = 0, b = numTerms;
+		while ( a < b ) {
+			quint32 mid = a + ( b - a ) / 2;
+			if ( termName( mid ) < prefix )
+				a = mid + 1;
+			else
+				b = mid;
+		}
+		lo = a;
+		for ( hi = lo; hi < numTerms && termName( hi ).starts_with( prefix ); ) {
+			if ( wildcard < 0 ) {
+				// exact match
+				if ( termName( hi ).length() == prefix.length() )
+					hi++;
+				break;
+			}
+			hi++;
+		}
+	}
+
+	std::vector<quint32> files;
+	if ( term.startsWith( termPrefixes[0] ) && wildcard < 0 ) {
+		// the block type and the types that inherit from it
+		QString type = term.mid( 6 );
+		NifModel nif;
+		size_t prefixLength = std::strlen( termPrefixes[0] );
+		quint32 a = lo;
+		for ( ; a > 0 && termName( a - 1 ).starts_with( termPrefixes[0] ); a-- ) {
+		}
+		for ( quint32 i = a; i < numTerms && termName( i ).starts_with( termPrefixes[0] ); i++ ) {
+			if ( nif.inherits( toString( termName( i ).substr( prefixLength ) ), type ) )
+				addPostings( i, files );
+		}
+	} else if ( wildcard < 0 || wildcard == ( term.length() - 1 ) ) {
+		for ( quint32 i = lo; i < hi; i++ )
+			addPostings( i, files );
+	} else {
+		QStringList parts = term.split( '*' );
+		for ( QString & p : parts )
+			p = QRegularExpression::escape( p );
+		QRegularExpression re( QRegularExpression::anchoredPattern( parts.join( ".*" ) ),
+							   QRegularExpression::DotMatchesEverythingOption );
+		for ( quint32 i = lo; i < hi; i++ ) {
+			if ( re.match( toString( termName( i ) ) ).hasMatch() )
+				addPostings( i, files );
+		}
+	}
+
+	std::sort( files.begin(), files.end() );
+	files.erase( std::unique( files.begin(), files.end() ), files.end() );
+	return files;
+}
+
+QStringList NifIndex::query( const QStringList & terms ) const
+{
+	QStringList results;
+	if ( terms.isEmpty() || !numFiles )
+		return results;
+
+	std::vector<quint32> files = match( terms.first() );
+	for ( qsizetype i = 1; i < terms.size() && !files.empty(); i++ ) {
+		std::vector<quint32> m = match( terms.at( i ) );
+		std::vector<quint32> tmp;
+		std::set_intersection( files.begin(), files.end(), m.begin(), m.end(), std::back_inserter( tmp ) );
+		files.swap( tmp );
+	}
+
+	results.reserve( qsizetype( files.size() ) );
+	for ( quint32 i : files )
+		results.append( toString( fileName( i ) ) );
+	return results;
+}
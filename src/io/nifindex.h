@@ -0,0 +1,158 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef NIFINDEX_H
+#define NIFINDEX_H
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+
+//! @file nifindex.h NifIndex
+
+//! Inverted index of the block types, resource paths and selected field values of a set of NIF files, cached on disk
+/*!
+ * The source is a folder of loose files, or "game:<name>" for the resource archives of a game as listed by
+ * GameManager. update() loads the new and changed files on worker threads and writes the index to the cache,
+ * the files that did not change since the last update keep their terms. A cached index is memory mapped,
+ * and queries are binary searches in its sorted term table.
+ *
+ * The terms of a file are:
+ *  - block:<type> for every block type in the file
+ *  - path:<path> for texture, material and mesh paths, in the normalized form of GameManager::get_full_path
+ *  - value:<field>=<value> for the fields listed by fields(), with one term per set flag of bit flag enums
+ */
+class NifIndex final
+{
+	Q_DECLARE_TR_FUNCTIONS( NifIndex )
+
+public:
+	//! Statistics of the last update
+	struct UpdateStatistics
+	{
+		int filesTotal = 0;
+		//! Files that were new or changed, and were loaded
+		int filesLoaded = 0;
+		int filesFailed = 0;
+		qint64 bytesRead = 0;
+		double seconds = 0.0;
+	};
+
+	//! The index of \a source, a folder or "game:<name>"
+	explicit NifIndex( const QString & source );
+	~NifIndex();
+
+	NifIndex( const NifIndex & ) = delete;
+	NifIndex & operator=( const NifIndex & ) = delete;
+
+	//! The fields whose values are indexed by default
+	static QStringList defaultFields();
+	//! The fields whose values are indexed, changing them invalidates the terms of all files on the next update
+	const QStringList & fields() const { return indexedFields; }
+	void setFields( const QStringList & fields ) { indexedFields = fields; }
+
+	//! Loads the index from the cache, returns false if there is no cached index for the source
+	bool load();
+	//! Brings the index up to date and writes it to the cache, returns false if the source does not exist
+	/*!
+	 * @param threadCount	The number of worker threads, 0 for one per core
+	 * @param progress		Called on the calling thread with the number of files loaded and to load, can return false to cancel
+	 */
+	bool update( int threadCount = 0, const std::function<bool ( int, int )> & progress = {} );
+	const UpdateStatistics & statistics() const { return updateStats; }
+
+	//! Splits a query into terms at spaces outside of quotes
+	static QStringList parseQuery( const QString & query );
+	//! Returns the files that match all \a terms, sorted by path
+	/*!
+	 * A term without a "block:", "path:" or "value:" prefix is searched as a path. "*" in a term matches any
+	 * characters, and a block type also matches the types that inherit from it.
+	 */
+	QStringList query( const QStringList & terms ) const;
+
+	//! The source the index was created for
+	const QString & source() const { return sourcePath; }
+	//! The absolute path of \a file for a folder source, or \a file for an archive source
+	QString filePath( const QString & file ) const;
+
+	quint32 fileCount() const { return numFiles; }
+	quint32 termCount() const { return numTerms; }
+
+private:
+	bool setData( const uchar * data, qint64 size );
+	QString cachePath() const;
+	QByteArray fieldsKey() const;
+
+	std::string_view string( quint32 offset ) const { return std::string_view( strings + offset ); }
+	QString toString( const std::string_view & s ) const;
+	std::string_view fileName( quint32 i ) const { return string( filePaths[i] ); }
+	std::string_view termName( quint32 i ) const { return string( termNames[i] ); }
+	//! Adds the files of term \a i to \a files
+	void addPostings( quint32 i, std::vector<quint32> & files ) const;
+	//! Returns the sorted files that match a single query term
+	std::vector<quint32> match( const QString & term ) const;
+
+	QString sourcePath;
+	//! The GameMode of an archive source, or -1 for a folder
+	int archiveGame = -1;
+	QStringList indexedFields;
+	UpdateStatistics updateStats;
+
+	//! The mapped cache file, or the data of an index that was just created
+	QFile file;
+	QByteArray buffer;
+	//! fieldsKey() of the fields the loaded index was created with
+	QByteArray dataFieldsKey;
+
+	quint32 numFiles = 0;
+	quint32 numTerms = 0;
+	//! size and modification time of each file
+	const qint64 * fileStamps = nullptr;
+	const quint32 * filePaths = nullptr;
+	//! numFiles + 1 offsets into fileTerms
+	const quint32 * fileTermBegin = nullptr;
+	const quint32 * fileTerms = nullptr;
+	const quint32 * termNames = nullptr;
+	//! numTerms + 1 offsets into postings
+	const quint32 * termPostingBegin = nullptr;
+	const quint32 * postings = nullptr;
+	const char * strings = nullptr;
+};
+
+#endif
@@ -41,6 +41,9 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QDataStream>
 #include <QIODevice>
 #include <QFloat16>
+#include <QSysInfo>
+
+#include <cstring>
 
 
 //! @file nifstream.cpp NIF file I/O
@@ -169,7 +172,7 @@ bool NifIStream::read( NifValue & val )
 			yf = (double( y ) / 255.0) * 2.0 - 1.0;
 			zf = (double( z ) / 255.0) * 2.0 - 1.0;
 
-			Vector3 * v = static_cast<Vector3 *>(val.val.data);
+			Vector3 * v = static_cast<Vector3 *>(val.dataPtr());
 			v->xyz[0] = xf; v->xyz[1] = yf; v->xyz[2] = zf;
 
 			return (dataStream->status() == QDataStream::Ok);
@@ -185,7 +188,7 @@ bool NifIStream::read( NifValue & val )
 			FloatVector4 xyzw( FloatVector4::convertInt16( ( std::uint64_t(z) << 32 ) | xy ) );
 			xyzw /= 32767.0f;
 
-			Vector3 * v = static_cast<Vector3 *>(val.val.data);
+			Vector3 * v = static_cast<Vector3 *>(val.dataPtr());
 			xyzw.convertToVector3( &(v->xyz[0]) );
 
 			return (dataStream->status() == QDataStream::Ok);
@@ -203,14 +206,14 @@ bool NifIStream::read( NifValue & val )
 			yf = (float) y;
 			zf = (float) z;
 
-			Vector3 * v = static_cast<Vector3 *>(val.val.data);
+			Vector3 * v = static_cast<Vector3 *>(val.dataPtr());
 			v->xyz[0] = xf; v->xyz[1] = yf; v->xyz[2] = zf;
 
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tHalfVector3:
 		{
-			Vector3 *	v = static_cast<Vector3 *>(val.val.data);
+			Vector3 *	v = static_cast<Vector3 *>(val.dataPtr());
 #if ENABLE_X86_64_SIMD >= 3
 			uint32_t	xy;
 			uint16_t	z;
@@ -232,7 +235,7 @@ bool NifIStream::read( NifValue & val )
 		}
 	case NifValue::tHalfVector2:
 		{
-			Vector2 *	v = static_cast<Vector2 *>(val.val.data);
+			Vector2 *	v = static_cast<Vector2 *>(val.dataPtr());
 #if ENABLE_X86_64_SIMD >= 3
 			uint32_t	xy;
 
@@ -253,13 +256,13 @@ bool NifIStream::read( NifValue & val )
 		}
 	case NifValue::tVector3:
 		{
-			Vector3 * v = static_cast<Vector3 *>(val.val.data);
+			Vector3 * v = static_cast<Vector3 *>(val.dataPtr());
 			*dataStream >> *v;
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tVector4:
 		{
-			Vector4 * v = static_cast<Vector4 *>(val.val.data);
+			Vector4 * v = static_cast<Vector4 *>(val.dataPtr());
 			*dataStream >> *v;
 			return (dataStream->status() == QDataStream::Ok);
 		}
@@ -267,31 +270,31 @@ bool NifIStream::read( NifValue & val )
 		{
 			std::uint32_t	v;
 			*dataStream >> v;
-			(void) new( static_cast<ByteVector4 *>(val.val.data) ) ByteVector4( v );
+			(void) new( static_cast<ByteVector4 *>(val.dataPtr()) ) ByteVector4( v );
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tUDecVector4:
 		{
 			std::uint32_t	v;
 			*dataStream >> v;
-			(void) new( static_cast<UDecVector4 *>(val.val.data) ) UDecVector4( v );
+			(void) new( static_cast<UDecVector4 *>(val.dataPtr()) ) UDecVector4( v );
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tTriangle:
 		{
-			Triangle * t = static_cast<Triangle *>(val.val.data);
+			Triangle * t = static_cast<Triangle *>(val.dataPtr());
 			*dataStream >> *t;
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tQuat:
 		{
-			Quat * q = static_cast<Quat *>(val.val.data);
+			Quat * q = static_cast<Quat *>(val.dataPtr());
 			*dataStream >> *q;
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tQuatXYZW:
 		{
-			Quat * q = static_cast<Quat *>(val.val.data);
+			Quat * q = static_cast<Quat *>(val.dataPtr());
 			return device->read( (char *)&q->wxyz[1], 12 ) == 12 && device->read( (char *)q->wxyz, 4 ) == 4;
 		}
 	case NifValue::tMatrix:
@@ -300,29 +303,29 @@ bool NifIStream::read( NifValue & val )
 		return device->read( (char *)static_cast<Matrix4 *>(val.val.data)->m, 64 ) == 64;
 	case NifValue::tVector2:
 		{
-			Vector2 * v = static_cast<Vector2 *>(val.val.data);
+			Vector2 * v = static_cast<Vector2 *>(val.dataPtr());
 			*dataStream >> *v;
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tColor3:
-		return device->read( (char *)static_cast<Color3 *>(val.val.data)->rgb, 12 ) == 12;
+		return device->read( (char *)static_cast<Color3 *>(val.dataPtr())->rgb, 12 ) == 12;
 	case NifValue::tByteColor4:
 		{
 			std::uint32_t	rgba;
 			*dataStream >> rgba;
-			(void) new( static_cast<ByteColor4 *>(val.val.data) ) ByteColor4( rgba );
+			(void) new( static_cast<ByteColor4 *>(val.dataPtr()) ) ByteColor4( rgba );
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tByteColor4BGRA:
 		{
 			std::uint32_t	bgra;
 			*dataStream >> bgra;
-			(void) new( static_cast<ByteColor4BGRA *>(val.val.data) ) ByteColor4BGRA( bgra );
+			(void) new( static_cast<ByteColor4BGRA *>(val.dataPtr()) ) ByteColor4BGRA( bgra );
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tColor4:
 		{
-			Color4 * c = static_cast<Color4 *>(val.val.data);
+			Color4 * c = static_cast<Color4 *>(val.dataPtr());
 			*dataStream >> *c;
 			return (dataStream->status() == QDataStream::Ok);
 		}
@@ -558,7 +561,7 @@ bool NifIStream::read( NifValue & val )
 		}
 	case NifValue::tBSVertexDesc:
 		{
-			*dataStream >> *static_cast<BSVertexDesc *>(val.val.data);
+			*dataStream >> *static_cast<BSVertexDesc *>(val.dataPtr());
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tBlob:
@@ -577,6 +580,221 @@ bool NifIStream::read( NifValue & val )
 	return false;
 }
 
+int NifIStream::fixedSize( const NifValue & val ) const
+{
+	// Raw copies below assume that the file and the host are both little-endian
+	if ( bigEndian || QSysInfo::ByteOrder != QSysInfo::LittleEndian )
+		return 0;
+
+	switch ( val.type() ) {
+	case NifValue::tBool:
+		return ( bool32bit ? 4 : 1 );
+	case NifValue::tByte:
+	case NifValue::tNormbyte:
+		return 1;
+	case NifValue::tWord:
+	case NifValue::tShort:
+	case NifValue::tFlags:
+	case NifValue::tHfloat:
+		return 2;
+	case NifValue::tByteVector3:
+		return 3;
+	case NifValue::tStringOffset:
+	case NifValue::tInt:
+	case NifValue::tUInt:
+	case NifValue::tULittle32:
+	case NifValue::tStringIndex:
+	case NifValue::tLink:
+	case NifValue::tUpLink:
+	case NifValue::tFloat:
+	case NifValue::tHalfVector2:
+	case NifValue::tByteVector4:
+	case NifValue::tUDecVector4:
+	case NifValue::tByteColor4:
+	case NifValue::tByteColor4BGRA:
+		return 4;
+	case NifValue::tShortVector3:
+	case NifValue::tUshortVector3:
+	case NifValue::tHalfVector3:
+	case NifValue::tTriangle:
+		return 6;
+	case NifValue::tInt64:
+	case NifValue::tUInt64:
+	case NifValue::tVector2:
+		return 8;
+	case NifValue::tVector3:
+	case NifValue::tColor3:
+		return 12;
+	case NifValue::tVector4:
+	case NifValue::tQuat:
+	case NifValue::tQuatXYZW:
+	case NifValue::tColor4:
+		return 16;
+	case NifValue::tMatrix:
+		return 36;
+	case NifValue::tMatrix4:
+		return 64;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+bool NifIStream::readBytes( QByteArray & buf, qint64 size )
+{
+	buf.resize( qsizetype( size ) );
+	return ( device->read( buf.data(), size ) == size );
+}
+
+void NifIStream::decode( NifValue & val, const char * data ) const
+{
+	// Must give the same results as read()
+	switch ( val.type() ) {
+	case NifValue::tBool:
+		val.val.u64 = 0;
+		if ( bool32bit )
+			val.val.u32 = FileBuffer::readUInt32Fast( data );
+		else
+			val.val.u08 = std::uint8_t( data[0] );
+		break;
+	case NifValue::tByte:
+		val.val.u64 = 0;
+		val.val.u08 = std::uint8_t( data[0] );
+		break;
+	case NifValue::tWord:
+	case NifValue::tShort:
+	case NifValue::tFlags:
+		val.val.u64 = 0;
+		val.val.u16 = FileBuffer::readUInt16Fast( data );
+		break;
+	case NifValue::tStringOffset:
+	case NifValue::tInt:
+	case NifValue::tUInt:
+	case NifValue::tULittle32:
+	case NifValue::tStringIndex:
+		val.val.u64 = 0;
+		val.val.u32 = FileBuffer::readUInt32Fast( data );
+		break;
+	case NifValue::tLink:
+	case NifValue::tUpLink:
+		val.val.u64 = 0;
+		val.val.i32 = std::int32_t( FileBuffer::readUInt32Fast( data ) );
+		if ( linkAdjust )
+			val.val.i32--;
+		break;
+	case NifValue::tInt64:
+	case NifValue::tUInt64:
+		val.val.u64 = FileBuffer::readUInt64Fast( data );
+		break;
+	case NifValue::tFloat:
+		val.val.u64 = 0;
+		val.val.f32 = std::bit_cast< float >( FileBuffer::readUInt32Fast( data ) );
+		break;
+	case NifValue::tHfloat:
+		val.val.u64 = 0;
+		val.val.f32 = float( std::bit_cast< qfloat16 >( FileBuffer::readUInt16Fast( data ) ) );
+		break;
+	case NifValue::tNormbyte:
+		val.val.u64 = 0;
+		val.val.f32 = float( ( double( std::uint8_t( data[0] ) ) / 255.0 ) * 2.0 - 1.0 );
+		break;
+	case NifValue::tByteVector3:
+		{
+			Vector3 * v = static_cast<Vector3 *>(val.dataPtr());
+			for ( int i = 0; i < 3; i++ )
+				v->xyz[i] = float( ( double( std::uint8_t( data[i] ) ) / 255.0 ) * 2.0 - 1.0 );
+		}
+		break;
+	case NifValue::tShortVector3:
+		{
+			FloatVector4 xyzw( FloatVector4::convertInt16( ( std::uint64_t( FileBuffer::readUInt16Fast( data + 4 ) ) << 32 ) | FileBuffer::readUInt32Fast( data ) ) );
+			xyzw /= 32767.0f;
+			xyzw.convertToVector3( &(static_cast<Vector3 *>(val.dataPtr())->xyz[0]) );
+		}
+		break;
+	case NifValue::tUshortVector3:
+		{
+			Vector3 * v = static_cast<Vector3 *>(val.dataPtr());
+			for ( int i = 0; i < 3; i++ )
+				v->xyz[i] = float( FileBuffer::readUInt16Fast( data + i * 2 ) );
+		}
+		break;
+	case NifValue::tHalfVector3:
+		{
+			Vector3 * v = static_cast<Vector3 *>(val.dataPtr());
+#if ENABLE_X86_64_SIMD >= 3
+			FloatVector4::convertFloat16( ( std::uint64_t( FileBuffer::readUInt16Fast( data + 4 ) ) << 32 ) | FileBuffer::readUInt32Fast( data ) ).convertToVector3( &(v->xyz[0]) );
+#else
+			for ( int i = 0; i < 3; i++ )
+				v->xyz[i] = float( std::bit_cast< qfloat16 >( FileBuffer::readUInt16Fast( data + i * 2 ) ) );
+#endif
+		}
+		break;
+	case NifValue::tHalfVector2:
+		{
+			Vector2 * v = static_cast<Vector2 *>(val.dataPtr());
+#if ENABLE_X86_64_SIMD >= 3
+			FloatVector4 xy_f( FloatVector4::convertFloat16( FileBuffer::readUInt32Fast( data ) ) );
+			v->xy[0] = xy_f[0];
+			v->xy[1] = xy_f[1];
+#else
+			for ( int i = 0; i < 2; i++ )
+				v->xy[i] = float( std::bit_cast< qfloat16 >( FileBuffer::readUInt16Fast( data + i * 2 ) ) );
+#endif
+		}
+		break;
+	case NifValue::tByteVector4:
+		(void) new( static_cast<ByteVector4 *>(val.dataPtr()) ) ByteVector4( FileBuffer::readUInt32Fast( data ) );
+		break;
+	case NifValue::tUDecVector4:
+		(void) new( static_cast<UDecVector4 *>(val.dataPtr()) ) UDecVector4( FileBuffer::readUInt32Fast( data ) );
+		break;
+	case NifValue::tByteColor4:
+		(void) new( static_cast<ByteColor4 *>(val.dataPtr()) ) ByteColor4( FileBuffer::readUInt32Fast( data ) );
+		break;
+	case NifValue::tByteColor4BGRA:
+		(void) new( static_cast<ByteColor4BGRA *>(val.dataPtr()) ) ByteColor4BGRA( FileBuffer::readUInt32Fast( data ) );
+		break;
+	case NifValue::tTriangle:
+		std::memcpy( static_cast<Triangle *>(val.dataPtr())->v, data, 6 );
+		break;
+	case NifValue::tVector2:
+		std::memcpy( static_cast<Vector2 *>(val.dataPtr())->xy, data, 8 );
+		break;
+	case NifValue::tVector3:
+		std::memcpy( static_cast<Vector3 *>(val.dataPtr())->xyz, data, 12 );
+		break;
+	case NifValue::tColor3:
+		std::memcpy( static_cast<Color3 *>(val.dataPtr())->rgb, data, 12 );
+		break;
+	case NifValue::tVector4:
+		std::memcpy( static_cast<Vector4 *>(val.dataPtr())->xyzw, data, 16 );
+		break;
+	case NifValue::tQuat:
+		std::memcpy( static_cast<Quat *>(val.dataPtr())->wxyz, data, 16 );
+		break;
+	case NifValue::tQuatXYZW:
+		{
+			Quat * q = static_cast<Quat *>(val.dataPtr());
+			std::memcpy( &q->wxyz[1], data, 12 );
+			std::memcpy( q->wxyz, data + 12, 4 );
+		}
+		break;
+	case NifValue::tColor4:
+		std::memcpy( static_cast<Color4 *>(val.dataPtr())->rgba, data, 16 );
+		break;
+	case NifValue::tMatrix:
+		std::memcpy( static_cast<Matrix *>(val.val.data)->m, data, 36 );
+		break;
+	case NifValue::tMatrix4:
+		std::memcpy( static_cast<Matrix4 *>(val.val.data)->m, data, 64 );
+		break;
+	default:
+		break;
+	}
+}
+
 void NifIStream::reset()
 {
 	dataStream->device()->reset();
@@ -592,6 +810,47 @@ void NifOStream::init()
 	bool32bit = (model->inherits( "NifModel" ) && model->getVersionNumber() <= 0x04000002);
 	linkAdjust = (model->inherits( "NifModel" ) && model->getVersionNumber() <  0x0303000D);
 	stringAdjust = (model->inherits( "NifModel" ) && model->getVersionNumber() >= 0x14010003);
+
+	if ( device )
+		buffer.reserve( flushSize + 0x10000 );
+}
+
+qint64 NifOStream::writeBytes( const char * data, qint64 len )
+{
+	if ( device && len >= qint64( flushSize ) ) {
+		// Large blocks of data are written directly after the buffered data
+		if ( !flush() || device->write( data, len ) != len ) {
+			failed = true;
+			return -1;
+		}
+		flushedSize += len;
+		return len;
+	}
+
+	if ( len > 0 )
+		buffer.insert( buffer.end(), data, data + len );
+	if ( device && buffer.size() >= flushSize && !flush() )
+		return -1;
+	return len;
+}
+
+qint64 NifOStream::writeBytes( const QByteArray & data )
+{
+	return writeBytes( data.constData(), data.size() );
+}
+
+bool NifOStream::flush()
+{
+	if ( !device || buffer.empty() )
+		return !failed;
+
+	qint64 n = qint64( buffer.size() );
+	if ( device->write( buffer.data(), n ) != n )
+		failed = true;
+	flushedSize += n;
+	buffer.clear();
+
+	return !failed;
 }
 
 bool NifOStream::write( const NifValue & val )
@@ -600,26 +859,26 @@ bool NifOStream::write( const NifValue & val )
 	case NifValue::tBool:
 
 		if ( bool32bit )
-			return device->write( (char *)&val.val.u32, 4 ) == 4;
+			return writeBytes( (char *)&val.val.u32, 4 ) == 4;
 		else
-			return device->write( (char *)&val.val.u08, 1 ) == 1;
+			return writeBytes( (char *)&val.val.u08, 1 ) == 1;
 
 	case NifValue::tByte:
-		return device->write( (char *)&val.val.u08, 1 ) == 1;
+		return writeBytes( (char *)&val.val.u08, 1 ) == 1;
 	case NifValue::tWord:
 	case NifValue::tShort:
 	case NifValue::tFlags:
 	case NifValue::tBlockTypeIndex:
-		return device->write( (char *)&val.val.u16, 2 ) == 2;
+		return writeBytes( (char *)&val.val.u16, 2 ) == 2;
 	case NifValue::tStringOffset:
 	case NifValue::tInt:
 	case NifValue::tUInt:
 	case NifValue::tULittle32:
 	case NifValue::tStringIndex:
-		return device->write( (char *)&val.val.u32, 4 ) == 4;
+		return writeBytes( (char *)&val.val.u32, 4 ) == 4;
 	case NifValue::tInt64:
 	case NifValue::tUInt64:
-		return device->write( (char *)&val.val.u64, 8 ) == 8;
+		return writeBytes( (char *)&val.val.u64, 8 ) == 8;
 	case NifValue::tFileVersion:
 		{
 			if ( NifModel * mdl = static_cast<NifModel *>(const_cast<BaseModel *>(model)) ) {
@@ -633,39 +892,39 @@ bool NifOStream::write( const NifValue & val )
 					version = val.val.u32;
 				}
 
-				return device->write( (char *)&version, 4 ) == 4;
+				return writeBytes( (char *)&version, 4 ) == 4;
 			} else {
-				return device->write( (char *)&val.val.u32, 4 ) == 4;
+				return writeBytes( (char *)&val.val.u32, 4 ) == 4;
 			}
 		}
 	case NifValue::tLink:
 	case NifValue::tUpLink:
 
 		if ( !linkAdjust ) {
-			return device->write( (char *)&val.val.i32, 4 ) == 4;
+			return writeBytes( (char *)&val.val.i32, 4 ) == 4;
 		} else {
 			qint32 l = val.val.i32 + 1;
-			return device->write( (char *)&l, 4 ) == 4;
+			return writeBytes( (char *)&l, 4 ) == 4;
 		}
 
 	case NifValue::tFloat:
-		return device->write( (char *)&val.val.f32, 4 ) == 4;
+		return writeBytes( (char *)&val.val.f32, 4 ) == 4;
 	case NifValue::tHfloat:
 		{
 			std::uint16_t	half = std::bit_cast< std::uint16_t >( qfloat16( val.val.f32 ) );
 			char	v[2];
 			FileBuffer::writeUInt16Fast( v, half );
-			return device->write( v, 2 ) == 2;
+			return writeBytes( v, 2 ) == 2;
 		}
 	case NifValue::tNormbyte:
 		{
 			uint8_t v = round( ((val.val.f32 + 1.0) / 2.0) * 255.0 );
 
-			return device->write( (char*)&v, 1 ) == 1;
+			return writeBytes( (char*)&v, 1 ) == 1;
 		}
 	case NifValue::tByteVector3:
 		{
-			Vector3 * vec = static_cast<Vector3 *>(val.val.data);
+			Vector3 * vec = static_cast<Vector3 *>(val.dataPtr());
 			if ( !vec )
 				return false;
 
@@ -674,11 +933,11 @@ bool NifOStream::write( const NifValue & val )
 			v[1] = round( ((vec->xyz[1] + 1.0) / 2.0) * 255.0 );
 			v[2] = round( ((vec->xyz[2] + 1.0) / 2.0) * 255.0 );
 
-			return device->write( (char*)v, 3 ) == 3;
+			return writeBytes( (char*)v, 3 ) == 3;
 		}
 	case NifValue::tShortVector3:
 		{
-			Vector3 * vec = static_cast<Vector3 *>(val.val.data);
+			Vector3 * vec = static_cast<Vector3 *>(val.dataPtr());
 			if ( !vec )
 				return false;
 
@@ -690,11 +949,11 @@ bool NifOStream::write( const NifValue & val )
 			FileBuffer::writeUInt16Fast( &(v[2]), std::uint16_t( std::int16_t(xyz[1]) ) );
 			FileBuffer::writeUInt16Fast( &(v[4]), std::uint16_t( std::int16_t(xyz[2]) ) );
 
-			return device->write( v, 6 ) == 6;
+			return writeBytes( v, 6 ) == 6;
 		}
 	case NifValue::tUshortVector3:
 		{
-			Vector3 * vec = static_cast<Vector3 *>(val.val.data);
+			Vector3 * vec = static_cast<Vector3 *>(val.dataPtr());
 			if ( !vec )
 				return false;
 
@@ -703,11 +962,11 @@ bool NifOStream::write( const NifValue & val )
 			v[1] = (uint16_t) round(vec->xyz[1]);
 			v[2] = (uint16_t) round(vec->xyz[2]);
 
-			return device->write( (char*)v, 6 ) == 6;
+			return writeBytes( (char*)v, 6 ) == 6;
 		}
 	case NifValue::tHalfVector3:
 		{
-			Vector3 * vec = static_cast<Vector3 *>(val.val.data);
+			Vector3 * vec = static_cast<Vector3 *>(val.dataPtr());
 			if ( !vec )
 				return false;
 
@@ -720,11 +979,11 @@ bool NifOStream::write( const NifValue & val )
 			FileBuffer::writeUInt16Fast( &(v[2]), std::bit_cast< std::uint16_t >( qfloat16( vec->xyz[1] ) ) );
 			FileBuffer::writeUInt16Fast( &(v[4]), std::bit_cast< std::uint16_t >( qfloat16( vec->xyz[2] ) ) );
 #endif
-			return device->write( v, 6 ) == 6;
+			return writeBytes( v, 6 ) == 6;
 		}
 	case NifValue::tHalfVector2:
 		{
-			Vector2 * vec = static_cast<Vector2 *>(val.val.data);
+			Vector2 * vec = static_cast<Vector2 *>(val.dataPtr());
 			if ( !vec )
 				return false;
 
@@ -736,67 +995,67 @@ bool NifOStream::write( const NifValue & val )
 			FileBuffer::writeUInt16Fast( &(v[0]), std::bit_cast< std::uint16_t >( qfloat16( vec->xy[0] ) ) );
 			FileBuffer::writeUInt16Fast( &(v[2]), std::bit_cast< std::uint16_t >( qfloat16( vec->xy[1] ) ) );
 #endif
-			return device->write( v, 4 ) == 4;
+			return writeBytes( v, 4 ) == 4;
 		}
 	case NifValue::tVector3:
-		return device->write( (char *)static_cast<Vector3 *>(val.val.data)->xyz, 12 ) == 12;
+		return writeBytes( (char *)static_cast<Vector3 *>(val.dataPtr())->xyz, 12 ) == 12;
 	case NifValue::tVector4:
-		return device->write( (char *)static_cast<Vector4 *>(val.val.data)->xyzw, 16 ) == 16;
+		return writeBytes( (char *)static_cast<Vector4 *>(val.dataPtr())->xyzw, 16 ) == 16;
 	case NifValue::tByteVector4:
 		{
-			ByteVector4 * vec = static_cast<ByteVector4 *>(val.val.data);
+			ByteVector4 * vec = static_cast<ByteVector4 *>(val.dataPtr());
 			if ( !vec )
 				return false;
 			char	v[4];
 			FileBuffer::writeUInt32Fast( v, std::uint32_t( *vec ) );
-			return device->write( v, 4 ) == 4;
+			return writeBytes( v, 4 ) == 4;
 		}
 	case NifValue::tUDecVector4:
 		{
-			UDecVector4 * vec = static_cast<UDecVector4 *>(val.val.data);
+			UDecVector4 * vec = static_cast<UDecVector4 *>(val.dataPtr());
 			if ( !vec )
 				return false;
 			char	v[4];
 			FileBuffer::writeUInt32Fast( v, std::uint32_t( *vec ) );
-			return device->write( v, 4 ) == 4;
+			return writeBytes( v, 4 ) == 4;
 		}
 	case NifValue::tTriangle:
-		return device->write( (char *)static_cast<Triangle *>(val.val.data)->v, 6 ) == 6;
+		return writeBytes( (char *)static_cast<Triangle *>(val.dataPtr())->v, 6 ) == 6;
 	case NifValue::tQuat:
-		return device->write( (char *)static_cast<Quat *>(val.val.data)->wxyz, 16 ) == 16;
+		return writeBytes( (char *)static_cast<Quat *>(val.dataPtr())->wxyz, 16 ) == 16;
 	case NifValue::tQuatXYZW:
 		{
-			Quat * q = static_cast<Quat *>(val.val.data);
-			return device->write( (char *)&q->wxyz[1], 12 ) == 12 && device->write( (char *)q->wxyz, 4 ) == 4;
+			Quat * q = static_cast<Quat *>(val.dataPtr());
+			return writeBytes( (char *)&q->wxyz[1], 12 ) == 12 && writeBytes( (char *)q->wxyz, 4 ) == 4;
 		}
 	case NifValue::tMatrix:
-		return device->write( (char *)static_cast<Matrix *>(val.val.data)->m, 36 ) == 36;
+		return writeBytes( (char *)static_cast<Matrix *>(val.val.data)->m, 36 ) == 36;
 	case NifValue::tMatrix4:
-		return device->write( (char *)static_cast<Matrix4 *>(val.val.data)->m, 64 ) == 64;
+		return writeBytes( (char *)static_cast<Matrix4 *>(val.val.data)->m, 64 ) == 64;
 	case NifValue::tVector2:
-		return device->write( (char *)static_cast<Vector2 *>(val.val.data)->xy, 8 ) == 8;
+		return writeBytes( (char *)static_cast<Vector2 *>(val.dataPtr())->xy, 8 ) == 8;
 	case NifValue::tColor3:
-		return device->write( (char *)static_cast<Color3 *>(val.val.data)->rgb, 12 ) == 12;
+		return writeBytes( (char *)static_cast<Color3 *>(val.dataPtr())->rgb, 12 ) == 12;
 	case NifValue::tByteColor4:
 		{
-			ByteColor4 * color = static_cast<ByteColor4 *>(val.val.data);
+			ByteColor4 * color = static_cast<ByteColor4 *>(val.dataPtr());
 			if ( !color )
 				return false;
 			char	c[4];
 			FileBuffer::writeUInt32Fast( c, std::uint32_t(*color) );
-			return device->write( c, 4 ) == 4;
+			return writeBytes( c, 4 ) == 4;
 		}
 	case NifValue::tByteColor4BGRA:
 		{
-			ByteColor4BGRA * color = static_cast<ByteColor4BGRA *>(val.val.data);
+			ByteColor4BGRA * color = static_cast<ByteColor4BGRA *>(val.dataPtr());
 			if ( !color )
 				return false;
 			char	c[4];
 			FileBuffer::writeUInt32Fast( c, std::uint32_t(*color) );
-			return device->write( c, 4 ) == 4;
+			return writeBytes( c, 4 ) == 4;
 		}
 	case NifValue::tColor4:
-		return device->write( (char *)static_cast<Color4 *>(val.val.data)->rgba, 16 ) == 16;
+		return writeBytes( (char *)static_cast<Color4 *>(val.dataPtr())->rgba, 16 ) == 16;
 	case NifValue::tSizedString:
 	case NifValue::tSizedString16:
 		{
@@ -807,10 +1066,10 @@ bool NifOStream::write( const NifValue & val )
 			FileBuffer::writeUInt32Fast( len, std::uint32_t(string.size()) );
 			int	lenSize = ( val.type() == NifValue::tSizedString16 ? 2 : 4 );
 
-			if ( device->write( len, lenSize ) != lenSize )
+			if ( writeBytes( len, lenSize ) != lenSize )
 				return false;
 
-			return device->write( string.constData(), string.size() ) == string.size();
+			return writeBytes( string.constData(), string.size() ) == string.size();
 		}
 	case NifValue::tShortString:
 		{
@@ -823,41 +1082,41 @@ bool NifOStream::write( const NifValue & val )
 
 			unsigned char len = string.size() + 1;
 
-			if ( device->write( (char *)&len, 1 ) != 1 )
+			if ( writeBytes( (char *)&len, 1 ) != 1 )
 				return false;
 
-			return device->write( string.constData(), len ) == len;
+			return writeBytes( string.constData(), len ) == len;
 		}
 	case NifValue::tText:
 		{
 			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
 			int len = string.size();
 
-			if ( device->write( (char *)&len, 4 ) != 4 )
+			if ( writeBytes( (char *)&len, 4 ) != 4 )
 				return false;
 
-			return device->write( (const char *)string.constData(), string.size() ) == string.size();
+			return writeBytes( (const char *)string.constData(), string.size() ) == string.size();
 		}
 	case NifValue::tHeaderString:
 	case NifValue::tLineString:
 		{
 			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
 
-			if ( device->write( string.constData(), string.length() ) != string.length() )
+			if ( writeBytes( string.constData(), string.length() ) != string.length() )
 				return false;
 
-			return (device->write( "\n", 1 ) == 1);
+			return (writeBytes( "\n", 1 ) == 1);
 		}
 	case NifValue::tChar8String:
 		{
 			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
 			quint32 n = std::min<quint32>( 8, string.length() );
 
-			if ( device->write( string.constData(), n ) != n )
+			if ( writeBytes( string.constData(), n ) != n )
 				return false;
 
 			for ( quint32 i = n; i < 8; ++i ) {
-				if ( device->write( "\0", 1 ) != 1 )
+				if ( writeBytes( "\0", 1 ) != 1 )
 					return false;
 			}
 
@@ -871,10 +1130,10 @@ bool NifOStream::write( const NifValue & val )
 			char lenBuf[4];
 			FileBuffer::writeUInt32Fast( lenBuf, std::uint32_t( len ) );
 
-			if ( device->write( lenBuf, 4 ) != 4 )
+			if ( writeBytes( lenBuf, 4 ) != 4 )
 				return false;
 
-			return device->write( *array ) == len;
+			return writeBytes( *array ) == len;
 		}
 	case NifValue::tStringPalette:
 		{
@@ -883,39 +1142,39 @@ bool NifOStream::write( const NifValue & val )
 			char lenBuf[4];
 			FileBuffer::writeUInt32Fast( lenBuf, std::uint32_t( len ) );
 
-			if ( device->write( lenBuf, 4 ) != 4 )
+			if ( writeBytes( lenBuf, 4 ) != 4 )
 				return false;
 
-			if ( device->write( *array ) != len )
+			if ( writeBytes( *array ) != len )
 				return false;
 
-			return device->write( lenBuf, 4 ) == 4;
+			return writeBytes( lenBuf, 4 ) == 4;
 		}
 	case NifValue::tByteMatrix:
 		{
 			ByteMatrix * array = static_cast<ByteMatrix *>(val.val.data);
 			int len = array->count( 0 );
 
-			if ( device->write( (char *)&len, 4 ) != 4 )
+			if ( writeBytes( (char *)&len, 4 ) != 4 )
 				return false;
 
 			len = array->count( 1 );
 
-			if ( device->write( (char *)&len, 4 ) != 4 )
+			if ( writeBytes( (char *)&len, 4 ) != 4 )
 				return false;
 
 			len = array->count();
-			return device->write( array->data(), len ) == len;
+			return writeBytes( array->data(), len ) == len;
 		}
 	case NifValue::tString:
 	case NifValue::tFilePath:
 		{
 			if ( stringAdjust ) {
 				if ( val.val.u32 < 0x00010000 ) {
-					return device->write( (char *)&val.val.u32, 4 ) == 4;
+					return writeBytes( (char *)&val.val.u32, 4 ) == 4;
 				} else {
 					int value = 0;
-					return device->write( (char *)&value, 4 ) == 4;
+					return writeBytes( (char *)&value, 4 ) == 4;
 				}
 			} else {
 				QByteArray string;
@@ -928,25 +1187,25 @@ bool NifOStream::write( const NifValue & val )
 				//string.replace( "\\n", "\n" );
 				int len = string.size();
 
-				if ( device->write( (char *)&len, 4 ) != 4 )
+				if ( writeBytes( (char *)&len, 4 ) != 4 )
 					return false;
 
-				return device->write( string.constData(), string.size() ) == string.size();
+				return writeBytes( string.constData(), string.size() ) == string.size();
 			}
 		}
 	case NifValue::tBSVertexDesc:
 		{
-			auto d = static_cast<BSVertexDesc *>(val.val.data);
+			auto d = static_cast<BSVertexDesc *>(val.dataPtr());
 			if ( !d )
 				return false;
 
-			return device->write( (char*)&d->desc, 8 ) == 8;
+			return writeBytes( (char*)&d->desc, 8 ) == 8;
 		}
 	case NifValue::tBlob:
 
 		if ( val.val.data ) {
 			QByteArray * array = static_cast<QByteArray *>(val.val.data);
-			return device->write( array->data(), array->size() ) == array->size();
+			return writeBytes( array->data(), array->size() ) == array->size();
 		}
 
 		return true;
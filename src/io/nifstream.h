@@ -36,12 +36,14 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QCoreApplication>
 
 #include <memory>
+#include <vector>
 
 
 //! @file nifstream.h NifIStream, NifOStream, NifSStream
 
 class NifValue;
 class BaseModel;
+class QByteArray;
 class QDataStream;
 class QIODevice;
 
@@ -63,6 +65,13 @@ public:
 	//! Reads a NifValue from the underlying device. Returns true if successful.
 	bool read( NifValue & );
 
+	//! Size in bytes of a value that decode() can handle, or 0 if it has to be read with read().
+	int fixedSize( const NifValue & ) const;
+	//! Reads \a size raw bytes from the underlying device with a single read. Returns true if successful.
+	bool readBytes( QByteArray & buf, qint64 size );
+	//! Decodes a value of fixedSize() bytes from memory filled by readBytes().
+	void decode( NifValue &, const char * data ) const;
+
 	void reset();
 
 private:
@@ -96,10 +105,24 @@ class NifOStream final
 	Q_DECLARE_TR_FUNCTIONS( NifOStream )
 
 public:
+	//! Constructor, the data is kept in memory until flush() if \a d is null
 	NifOStream( const BaseModel * n, QIODevice * d ) : model( n ), device( d ) { init(); }
+	//! Destructor, writes the remaining buffered data to the device
+	~NifOStream() { flush(); }
 
 	//! Writes a NifValue to the underlying device. Returns true if successful.
 	bool write( const NifValue & );
+	//! Writes \a len raw bytes. Returns \a len, or -1 if writing buffered data to the device failed.
+	qint64 writeBytes( const char * data, qint64 len );
+	qint64 writeBytes( const QByteArray & data );
+
+	//! Writes the buffered data to the device. Returns false if this or an earlier write to the device failed.
+	bool flush();
+
+	//! Number of bytes written to the stream, including the buffered data
+	qint64 pos() const { return flushedSize + qint64( buffer.size() ); }
+	//! The data not yet written to the device
+	const char * bufferedData() const { return buffer.data(); }
 
 private:
 	//! The model that data is being read from.
@@ -107,6 +130,15 @@ private:
 	//! The underlying device that data is being written to.
 	QIODevice * device;
 
+	//! Data is written to the device in blocks of at least this size
+	static constexpr size_t flushSize = 1 << 20;
+	//! Buffered data
+	std::vector<char> buffer;
+	//! Number of bytes written to the device
+	qint64 flushedSize = 0;
+	//! Whether writing to the device failed
+	bool failed = false;
+
 	//! Initialises the stream.
 	void init();
 
@@ -0,0 +1,249 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "resourceindex.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+
+//! @file resourceindex.cpp ResourceIndex
+
+//! Cache file header, followed by count + 1 name offsets and the names
+struct ResourceIndexHeader
+{
+	char magic[8];
+	quint32 filterId;
+	quint32 count;
+	quint32 namesSize;
+	char stamp[20];
+};
+
+static const char resourceIndexMagic[8] = { 'N', 'S', 'R', 'I', 'D', 'X', '\0', '\1' };
+
+ResourceIndex::~ResourceIndex()
+{
+	if ( file.isOpen() )
+		file.close();
+}
+
+QByteArray ResourceIndex::stamp( const QString & dataPath )
+{
+	QFileInfo fi( dataPath );
+	if ( !fi.exists() )
+		return QByteArray();
+
+	QCryptographicHash hash( QCryptographicHash::Sha1 );
+	auto addFile = [&hash]( const QString & name, const QFileInfo & f ) {
+		hash.addData( name.toUtf8() );
+		qint64 v[2] = { f.size(), f.lastModified().toMSecsSinceEpoch() };
+		hash.addData( QByteArrayView( reinterpret_cast< const char * >( v ), qsizetype( sizeof( v ) ) ) );
+	};
+
+	if ( !fi.isDir() ) {
+		addFile( QString(), fi );
+	} else {
+		// The archives and other files directly in the folder, in a stable order
+		QDir dir( dataPath );
+		const QFileInfoList topFiles = dir.entryInfoList( QDir::Files, QDir::Name );
+		for ( const auto & f : topFiles )
+			addFile( f.fileName(), f );
+
+		// The folder itself and its subfolders, but not the folders below them: walking the whole tree
+		// costs as much as building the index. The modification time of a folder changes when a file is
+		// added, removed or renamed in it, changes further down are picked up when the resources are
+		// closed (see GameManager::GameResources::close_archives)
+		auto addFolder = [&hash]( const QString & name, const QFileInfo & f ) {
+			hash.addData( name.toUtf8() );
+			qint64 t = f.lastModified().toMSecsSinceEpoch();
+			hash.addData( QByteArrayView( reinterpret_cast< const char * >( &t ), qsizetype( sizeof( t ) ) ) );
+		};
+		addFolder( QString(), fi );
+		const QFileInfoList folders = dir.entryInfoList( QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name );
+		for ( const auto & f : folders )
+			addFolder( f.fileName(), f );
+	}
+
+	return hash.result();
+}
+
+QString ResourceIndex::cachePath( const QString & dataPath )
+{
+	QString cacheDir = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+	if ( cacheDir.isEmpty() )
+		return QString();
+
+	QByteArray key = QCryptographicHash::hash( QFileInfo( dataPath ).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1 );
+	return cacheDir + "/resourceindex/" + QString::fromLatin1( key.toHex() ) + ".idx";
+}
+
+bool ResourceIndex::setData( const uchar * data, qint64 size, int filterId, const QByteArray & stamp )
+{
+	if ( !data || size < qint64( sizeof( ResourceIndexHeader ) ) || stamp.size() != 20 )
+		return false;
+
+	ResourceIndexHeader h;
+	std::memcpy( &h, data, sizeof( h ) );
+	if ( std::memcmp( h.magic, resourceIndexMagic, sizeof( h.magic ) ) || h.filterId != quint32( filterId )
+		 || std::memcmp( h.stamp, stamp.constData(), sizeof( h.stamp ) ) )
+		return false;
+
+	qint64 offsetsSize = ( qint64( h.count ) + 1 ) * 4;
+	if ( qint64( sizeof( h ) ) + offsetsSize + qint64( h.namesSize ) != size )
+		return false;
+
+	// Validate the offsets once, so that name() does not need to
+	const quint32 * o = reinterpret_cast< const quint32 * >( data + sizeof( h ) );
+	const char * n = reinterpret_cast< const char * >( data + sizeof( h ) + offsetsSize );
+	if ( o[0] != 0 || o[h.count] != h.namesSize )
+		return false;
+	for ( quint32 i = 0; i < h.count; i++ ) {
+		if ( o[i + 1] <= o[i] || n[o[i + 1] - 1] != '\0' )
+			return false;
+	}
+
+	count = h.count;
+	offsets = o;
+	names = n;
+	return true;
+}
+
+std::shared_ptr<const ResourceIndex> ResourceIndex::load( const QString & dataPath, int filterId, const QByteArray & stamp )
+{
+	QString path = cachePath( dataPath );
+	if ( path.isEmpty() || stamp.isEmpty() )
+		return nullptr;
+
+	std::shared_ptr<ResourceIndex> index( new ResourceIndex() );
+	index->file.setFileName( path );
+	if ( !index->file.open( QIODevice::ReadOnly ) )
+		return nullptr;
+
+	qint64 size = index->file.size();
+	const uchar * data = index->file.map( 0, size );
+	if ( !data ) {
+		index->buffer = index->file.readAll();
+		index->file.close();
+		data = reinterpret_cast< const uchar * >( index->buffer.constData() );
+	}
+
+	if ( !index->setData( data, size, filterId, stamp ) )
+		return nullptr;
+
+	return index;
+}
+
+std::shared_ptr<const ResourceIndex> ResourceIndex::create( const QString & dataPath, int filterId, const QByteArray & stamp,
+															 std::vector<std::string_view> & names )
+{
+	std::sort( names.begin(), names.end() );
+	names.erase( std::unique( names.begin(), names.end() ), names.end() );
+
+	ResourceIndexHeader h;
+	std::memcpy( h.magic, resourceIndexMagic, sizeof( h.magic ) );
+	h.filterId = quint32( filterId );
+	h.count = quint32( names.size() );
+	h.namesSize = 0;
+	std::memset( h.stamp, 0, sizeof( h.stamp ) );
+	std::memcpy( h.stamp, stamp.constData(), size_t( std::min< qsizetype >( stamp.size(), qsizetype( sizeof( h.stamp ) ) ) ) );
+
+	std::vector<quint32> offsets;
+	offsets.reserve( names.size() + 1 );
+	for ( const auto & n : names ) {
+		offsets.push_back( h.namesSize );
+		h.namesSize += quint32( n.length() + 1 );
+	}
+	offsets.push_back( h.namesSize );
+
+	std::shared_ptr<ResourceIndex> index( new ResourceIndex() );
+	QByteArray & buf = index->buffer;
+	buf.reserve( qsizetype( sizeof( h ) + offsets.size() * 4 + h.namesSize ) );
+	buf.append( reinterpret_cast< const char * >( &h ), qsizetype( sizeof( h ) ) );
+	buf.append( reinterpret_cast< const char * >( offsets.data() ), qsizetype( offsets.size() * 4 ) );
+	for ( const auto & n : names ) {
+		buf.append( n.data(), qsizetype( n.length() ) );
+		buf.append( '\0' );
+	}
+
+	// A path that does not exist has no stamp and is not cached
+	QString path = cachePath( dataPath );
+	if ( !path.isEmpty() && stamp.size() == 20 && QDir().mkpath( QFileInfo( path ).absolutePath() ) ) {
+		QSaveFile f( path );
+		if ( f.open( QIODevice::WriteOnly ) && f.write( buf ) == buf.size() )
+			f.commit();
+	}
+
+	index->setData( reinterpret_cast< const uchar * >( buf.constData() ), buf.size(), filterId,
+					( stamp.size() == 20 ) ? stamp : QByteArray( h.stamp, qsizetype( sizeof( h.stamp ) ) ) );
+	return index;
+}
+
+bool ResourceIndex::contains( const std::string_view & name ) const
+{
+	quint32 lo = 0, hi = count;
+	while ( lo < hi ) {
+		quint32 mid = lo + ( hi - lo ) / 2;
+		int c = this->name( mid ).compare( name );
+		if ( c == 0 )
+			return true;
+		if ( c < 0 )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return false;
+}
+
+ResourceIndex::Statistics & ResourceIndex::statistics()
+{
+	static Statistics s;
+	return s;
+}
+
+QString ResourceIndex::statisticsReport()
+{
+	const Statistics & s = statistics();
+	qint64 indexes = s.cacheHits + s.cacheMisses;
+	qint64 lookups = s.lookups;
+	return QString( "Resource index: %1 of %2 paths from the cache (%3%), %4 ms building, %5 of %6 lookups found (%7%)" )
+		.arg( s.cacheHits.load() ).arg( indexes ).arg( indexes ? 100.0 * double( s.cacheHits ) / double( indexes ) : 0.0, 0, 'f', 1 )
+		.arg( s.buildMsecs.load() )
+		.arg( s.lookupHits.load() ).arg( lookups ).arg( lookups ? 100.0 * double( s.lookupHits ) / double( lookups ) : 0.0, 0, 'f', 1 );
+}
@@ -0,0 +1,107 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef RESOURCEINDEX_H
+#define RESOURCEINDEX_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+
+//! @file resourceindex.h ResourceIndex
+
+//! Sorted file names of a resource data path (an archive or a folder), cached on disk
+/*!
+ * The cache is keyed by the absolute data path, a stamp and the archive filter in use. The stamp
+ * covers the size and modification time of the archive, or of the files directly in the folder
+ * (the archives), and the modification times of the folder and its direct subfolders. A cached
+ * index is memory mapped, lookups are binary searches in the mapped name table.
+ */
+class ResourceIndex final
+{
+public:
+	~ResourceIndex();
+
+	//! Returns the stamp of \a dataPath, empty if it does not exist
+	static QByteArray stamp( const QString & dataPath );
+	//! Loads the index of \a dataPath from the cache, returns nullptr if it is missing or out of date
+	static std::shared_ptr<const ResourceIndex> load( const QString & dataPath, int filterId, const QByteArray & stamp );
+	//! Creates the index of \a dataPath from its file names and writes it to the cache
+	static std::shared_ptr<const ResourceIndex> create( const QString & dataPath, int filterId, const QByteArray & stamp,
+														std::vector<std::string_view> & names );
+
+	//! Is \a name one of the files?
+	bool contains( const std::string_view & name ) const;
+	//! Number of files
+	quint32 size() const { return count; }
+	//! Name of file \a i, in ascending order
+	std::string_view name( quint32 i ) const
+	{
+		return std::string_view( names + offsets[i], size_t( offsets[i + 1] - offsets[i] - 1 ) );
+	}
+
+	//! Load statistics of all indexes
+	struct Statistics
+	{
+		std::atomic<qint64> cacheHits = 0;
+		std::atomic<qint64> cacheMisses = 0;
+		std::atomic<qint64> buildMsecs = 0;
+		std::atomic<qint64> lookups = 0;
+		std::atomic<qint64> lookupHits = 0;
+	};
+	static Statistics & statistics();
+	//! Summary of the statistics for the log
+	static QString statisticsReport();
+
+private:
+	ResourceIndex() {}
+	bool setData( const uchar * data, qint64 size, int filterId, const QByteArray & stamp );
+
+	static QString cachePath( const QString & dataPath );
+
+	//! The mapped cache file, or the data of an index that was just created
+	QFile file;
+	QByteArray buffer;
+
+	quint32 count = 0;
+	//! count + 1 offsets of the null terminated names, relative to names
+	const quint32 * offsets = nullptr;
+	const char * names = nullptr;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include "gl/gltools.h"
 #include "gl/BSMesh.h"
 #include "io/MeshFile.h"
+#include "lib/importex/gltf.h"
 #include "model/nifmodel.h"
 #include "message.h"
 #include "qtcompat.h"
@@ -18,7 +19,10 @@
 #define TINYGLTF_NO_STB_IMAGE_WRITE	1
 #include <tiny_gltf.h>
 
+#include <atomic>
 #include <cctype>
+#include <functional>
+#include <sstream>
 
 #include <QApplication>
 #include <QBuffer>
@@ -28,8 +32,15 @@
 #include <QFileInfo>
 #include <QIODevice>
 #include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QSettings>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QThread>
 
 #define tr( x ) QApplication::tr( x )
 
@@ -52,7 +63,7 @@ struct GltfStore
 };
 
 
-static inline void exportFloats( QByteArray & bin, const float * data, size_t n )
+static inline void exportFloats( GltfBinaryStream & bin, const float * data, size_t n )
 {
 #if defined(__i386__) || defined(__x86_64__) || defined(__x86_64)
 	const char *	buf = reinterpret_cast< const char * >( data );
@@ -68,7 +79,7 @@ static inline void exportFloats( QByteArray & bin, const float * data, size_t n
 	bin.append( buf, nBytes );
 }
 
-void exportCreateInverseBoneMatrices(tinygltf::Model& model, QByteArray& bin, const BSMesh* bsmesh, int gltfSkinID, GltfStore& gltf)
+void exportCreateInverseBoneMatrices(tinygltf::Model& model, GltfBinaryStream& bin, const BSMesh* bsmesh, int gltfSkinID, GltfStore& gltf)
 {
 	(void) gltf;
 	auto bufferViewIndex = model.bufferViews.size();
@@ -100,7 +111,7 @@ static QString exportGetMaterialPath( const NifModel * nif, const QModelIndex &
 	return nif->get<QString>( iSPBlock, "Name" );
 }
 
-bool exportCreateNodes(const NifModel* nif, const Scene* scene, tinygltf::Model& model, QByteArray& bin, GltfStore& gltf)
+bool exportCreateNodes(const NifModel* nif, const Scene* scene, tinygltf::Model& model, GltfBinaryStream& bin, GltfStore& gltf)
 {
 	int gltfNodeID = 0;
 	int gltfSkinID = -1;
@@ -330,7 +341,7 @@ bool exportCreateNodes(const NifModel* nif, const Scene* scene, tinygltf::Model&
 	return true;
 }
 
-void exportCreatePrimitive(tinygltf::Model& model, QByteArray& bin, std::shared_ptr<MeshFile> mesh, tinygltf::Primitive& prim, std::string attr,
+void exportCreatePrimitive(tinygltf::Model& model, GltfBinaryStream& bin, std::shared_ptr<MeshFile> mesh, tinygltf::Primitive& prim, std::string attr,
 							int count, int componentType, int type, quint32& attributeIndex, GltfStore& gltf)
 {
 	(void) gltf;
@@ -379,13 +390,12 @@ void exportCreatePrimitive(tinygltf::Model& model, QByteArray& bin, std::shared_
 
 	auto pad = bin.size() % size;
 	for ( int i = 0; i < pad; i++ ) {
-		bin.append("\xFF");
+		bin.append("\xFF", 1);
 	}
 	view.byteOffset = bin.size();
 	view.byteLength = count * size * tinygltf::GetNumComponentsInType(acc.type);
 	view.target = TINYGLTF_TARGET_ARRAY_BUFFER;
 
-	bin.reserve(bin.size() + view.byteLength);
 	// TODO: Refactoring BSMesh to std::vector for aligned allocators
 	// would bring incompatibility with Shape superclass and take a larger refactor.
 	// So, do this for now.
@@ -458,7 +468,7 @@ void exportCreatePrimitive(tinygltf::Model& model, QByteArray& bin, std::shared_
 	model.bufferViews.push_back(view);
 }
 
-bool exportCreatePrimitives(tinygltf::Model& model, QByteArray& bin, const BSMesh* bsmesh, tinygltf::Mesh& gltfMesh,
+bool exportCreatePrimitives(tinygltf::Model& model, GltfBinaryStream& bin, const BSMesh* bsmesh, tinygltf::Mesh& gltfMesh,
 							quint32& attributeIndex, quint32 lodLevel, int materialID, GltfStore& gltf, qint32 meshLodLevel = -1)
 {
 	if ( int(lodLevel) >= bsmesh->meshes.size() )
@@ -522,7 +532,6 @@ bool exportCreatePrimitives(tinygltf::Model& model, QByteArray& bin, const BSMes
 	view.byteLength = acc.count * tinygltf::GetComponentSizeInBytes(acc.componentType) * tinygltf::GetNumComponentsInType(acc.type);
 	view.target = TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER;
 
-	bin.reserve(bin.size() + view.byteLength);
 	for ( const auto & v : tris ) {
 		char tmpTriangles[6];
 		FileBuffer::writeUInt16Fast( &(tmpTriangles[0]), v[0] );
@@ -538,7 +547,7 @@ bool exportCreatePrimitives(tinygltf::Model& model, QByteArray& bin, const BSMes
 	return true;
 }
 
-bool exportCreateMeshes(const NifModel* nif, const Scene* scene, tinygltf::Model& model, QByteArray& bin, GltfStore& gltf)
+bool exportCreateMeshes(const NifModel* nif, const Scene* scene, tinygltf::Model& model, GltfBinaryStream& bin, GltfStore& gltf)
 {
 	int meshIndex = 0;
 	quint32 attributeIndex = model.bufferViews.size();
@@ -592,13 +601,41 @@ bool exportCreateMeshes(const NifModel* nif, const Scene* scene, tinygltf::Model
 
 class ExportGltfMaterials {
 protected:
+	// a texture or pair of textures to be converted to PNG, shared by all materials with the same textureMapKey
+	struct TextureJob {
+		int	n;
+		std::string	txtPath1;
+		std::string	txtPath2;
+		unsigned char	texCoordMode;
+		// the results, written by the worker thread
+		QByteArray	imageBuf;
+		int	width = 1;
+		int	height = 1;
+		int	channels = 0;
+		// the message of the exception thrown while converting the texture, if any
+		QString	error;
+	};
+	// a texture slot of a material, set when the textures have been converted
+	struct TextureRef {
+		tinygltf::Material *	mat;
+		int	n;
+		size_t	job;
+		unsigned char	texCoordChannel;
+	};
 	tinygltf::Model &	model;
 	NifModel *	nif;
 	CE2MaterialDB *	materials;
 	int	mipLevel;
+	GltfBinaryStream &	bin;
+	// if not empty, images are written to external PNG files with this path and the image number as their name
+	QString	imageBaseName;
 	std::set< std::string >	materialSet;
-	std::map< std::string, int >	textureMap;
-	DDSTexture16 * loadTexture( const std::string_view & txtPath );
+	std::map< std::string, size_t >	textureMap;
+	std::vector< TextureJob >	textureJobs;
+	std::vector< TextureRef >	textureRefs;
+	// external images written by addTexture() to temporary files, and the names commitImages() renames them to
+	std::vector< std::pair< QString, QString > >	imageFiles;
+	DDSTexture16 * loadTexture( const std::string_view & txtPath ) const;
 	// n = 0: albedo
 	// n = 1: normal
 	// n = 2: PBR
@@ -606,16 +643,64 @@ protected:
 	// n = 4: emissive
 	void getTexture( tinygltf::Material & mat, int n, const std::string & txtPath1, const std::string & txtPath2,
 					const CE2Material::UVStream * uvStream );
+	// loads, combines and encodes the texture(s) of a job, can be called from any thread
+	void convertTexture( TextureJob & job ) const;
+	static void convertScanline( unsigned char * imgPtr, int y, int n, int channels, int width, int height,
+								const DDSTexture16 * t1, const DDSTexture16 * t2 );
+	// adds a converted texture to the glTF model, and returns the texture ID or -1
+	int addTexture( const TextureJob & job );
 	static std::string getTexturePath( const CE2Material::TextureSet * txtSet, int n, std::uint32_t defaultColor = 0 );
 public:
-	ExportGltfMaterials( NifModel * nifModel, tinygltf::Model & gltfModel, int textureMipLevel )
-		: model( gltfModel ), nif( nifModel ), materials( nif->getCE2Materials() ), mipLevel( textureMipLevel )
+	ExportGltfMaterials( NifModel * nifModel, tinygltf::Model & gltfModel, int textureMipLevel,
+						GltfBinaryStream & binStream, const QString & externalImageBaseName = QString() )
+		: model( gltfModel ), nif( nifModel ), materials( nif->getCE2Materials() ), mipLevel( textureMipLevel ),
+			bin( binStream ), imageBaseName( externalImageBaseName )
 	{
 	}
+	// removes the temporary image files if the export failed or was cancelled
+	~ExportGltfMaterials();
 	void exportMaterial( tinygltf::Material & mat, const std::string & matPath );
+	// converts the textures used by the exported materials on worker threads, and adds them to the model
+	// progress( done, total ) is called periodically on the calling thread, and can return false to cancel
+	// textures that could not be converted are reported in errors
+	// the return value is false if the conversion was cancelled
+	bool exportTextures( const std::function< bool ( int, int ) > & progress, QStringList & errors );
+	// returns the external image files that already exist and would be replaced by commitImages()
+	QStringList existingImageFiles() const;
+	// moves the external images to their final names after the glTF file has been written, returns false on error
+	bool commitImages();
 };
 
-DDSTexture16 * ExportGltfMaterials::loadTexture( const std::string_view & txtPath )
+ExportGltfMaterials::~ExportGltfMaterials()
+{
+	for ( const auto & i : imageFiles )
+		QFile::remove( i.first );
+}
+
+QStringList ExportGltfMaterials::existingImageFiles() const
+{
+	QStringList	names;
+	for ( const auto & i : imageFiles ) {
+		if ( QFile::exists( i.second ) )
+			names << QFileInfo( i.second ).fileName();
+	}
+	return names;
+}
+
+bool ExportGltfMaterials::commitImages()
+{
+	bool	ok = true;
+	for ( const auto & i : imageFiles ) {
+		if ( !( ( !QFile::exists( i.second ) || QFile::remove( i.second ) ) && QFile::rename( i.first, i.second ) ) ) {
+			QFile::remove( i.first );
+			ok = false;
+		}
+	}
+	imageFiles.clear();
+	return ok;
+}
+
+DDSTexture16 * ExportGltfMaterials::loadTexture( const std::string_view & txtPath ) const
 {
 	if ( txtPath.length() == 9 && txtPath[0] == '#' ) {
 		std::uint32_t	c = 0;
@@ -659,158 +744,247 @@ void ExportGltfMaterials::getTexture(
 		texCoordChannel = (unsigned char) ( uvStream->channel > 1 );
 	}
 
+	// the conversion itself is deferred to exportTextures(), so that the unique textures can be converted in parallel
 	auto	i = textureMap.find( textureMapKey );
 	if ( i == textureMap.end() ) {
-		// load texture(s) and convert to glTF compatible PNG format
-		QByteArray	imageBuf;
-		int	width = 1;
-		int	height = 1;
-		int	channels = 0;
-		DDSTexture16 *	t1 = nullptr;
-		DDSTexture16 *	t2 = nullptr;
-		try {
-			if ( !txtPath1.empty() && ( t1 = loadTexture( txtPath1 ) ) != nullptr ) {
-				width = t1->getWidth();
-				height = t1->getHeight();
-			}
-			if ( !txtPath2.empty() && ( t2 = loadTexture( txtPath2 ) ) != nullptr ) {
-				width = std::max< int >( width, t2->getWidth() );
-				height = std::max< int >( height, t2->getHeight() );
-			}
-			if ( t1 || t2 )
-				channels = ( n == 0 ? ( !t2 ? 3 : 4 ) : ( n == 3 ? 1 : 3 ) );
+		TextureJob &	job = textureJobs.emplace_back();
+		job.n = n;
+		job.txtPath1 = txtPath1;
+		job.txtPath2 = txtPath2;
+		job.texCoordMode = texCoordMode;
+		i = textureMap.emplace( textureMapKey, textureJobs.size() - 1 ).first;
+	}
+
+	textureRefs.push_back( TextureRef{ &mat, n, i->second, texCoordChannel } );
+}
+
+void ExportGltfMaterials::convertScanline(
+	unsigned char * imgPtr, int y, int n, int channels, int width, int height,
+	const DDSTexture16 * t1, const DDSTexture16 * t2 )
+{
+	float	xScale = 1.0f / float( width );
+	float	xOffset = xScale * 0.5f;
+	float	yf = float( y ) / float( height ) + ( 0.5f / float( height ) );
+	bool	f1 = ( t1 && ( t1->getWidth() != width || t1->getHeight() != height ) );
+	bool	f2 = ( t2 && ( t2->getWidth() != width || t2->getHeight() != height ) );
+	FloatVector4	a( 0.0f, 0.0f, 0.0f, 1.0f );
+	FloatVector4	b( 0.0f, 0.0f, 0.0f, 1.0f );
+	// the per-channel conversion of each texture type as a single multiply-add on all four channels
+	FloatVector4	scale( 255.0f );
+	FloatVector4	offset( 0.0f );
+	if ( n == 1 ) {
+		// normal map: convert to unsigned format and invert green channel
+		scale = FloatVector4( 127.5f, -127.5f, 127.5f, 127.5f );
+		offset = FloatVector4( 127.5f );
+	}
+	for ( int x = 0; x < width; x++, imgPtr = imgPtr + channels ) {
+		float	xf = float( x ) * xScale + xOffset;
+		if ( t1 )
+			a = ( !f1 ? FloatVector4::convertFloat16( t1->getPixelN(x, y, 0) ) : t1->getPixelB(xf, yf, 0) );
+		if ( t2 )
+			b = ( !f2 ? FloatVector4::convertFloat16( t2->getPixelN(x, y, 0) ) : t2->getPixelB(xf, yf, 0) );
+		FloatVector4	c( a );
+		switch ( n ) {
+		case 0:
+			// albedo: add alpha channel from opacity texture
+			c[3] = b[0];
+			break;
+		case 1:
+			// normal map: calculate Z (blue) channel
+			c[2] = float( std::sqrt( std::max( 1.0f - a.dotProduct2(a), 0.0f ) ) );
+			break;
+		case 2:
+			// PBR map: G = roughness, B = metalness
+			c = FloatVector4( 0.0f, a[0], b[0], 0.0f );
+			break;
+		}
+		std::uint32_t	p = std::uint32_t( c * scale + offset );
+		if ( channels == 3 ) {
+			FileBuffer::writeUInt16Fast( imgPtr, std::uint16_t( p ) );
+			imgPtr[2] = std::uint8_t( p >> 16 );
+		} else if ( channels == 4 ) {
+			FileBuffer::writeUInt32Fast( imgPtr, p );
+		} else {
+			*imgPtr = std::uint8_t( p );
+		}
+	}
+}
+
+void ExportGltfMaterials::convertTexture( TextureJob & job ) const
+{
+	// load texture(s) and convert to glTF compatible PNG format
+	int	n = job.n;
+	DDSTexture16 *	t1 = nullptr;
+	DDSTexture16 *	t2 = nullptr;
+	try {
+		if ( !job.txtPath1.empty() && ( t1 = loadTexture( job.txtPath1 ) ) != nullptr ) {
+			job.width = t1->getWidth();
+			job.height = t1->getHeight();
+		}
+		if ( !job.txtPath2.empty() && ( t2 = loadTexture( job.txtPath2 ) ) != nullptr ) {
+			job.width = std::max< int >( job.width, t2->getWidth() );
+			job.height = std::max< int >( job.height, t2->getHeight() );
+		}
+		if ( t1 || t2 )
+			job.channels = ( n == 0 ? ( !t2 ? 3 : 4 ) : ( n == 3 ? 1 : 3 ) );
+		if ( job.channels ) {
 			QImage::Format	fmt =
-				( channels <= 1 ? QImage::Format_Grayscale8
-									: ( channels == 3 ? QImage::Format_RGB888 : QImage::Format_RGBA8888 ) );
-			QImage	img( width, height, fmt );
+				( job.channels <= 1 ? QImage::Format_Grayscale8
+										: ( job.channels == 3 ? QImage::Format_RGB888 : QImage::Format_RGBA8888 ) );
+			QImage	img( job.width, job.height, fmt );
 			size_t	lineBytes = size_t( img.bytesPerLine() );
-			float	xScale = 1.0f / float( width );
-			float	xOffset = xScale * 0.5f;
-			float	yScale = 1.0f / float( height );
-			float	yOffset = yScale * 0.5f;
-			bool	f1 = ( t1 && ( t1->getWidth() != width || t1->getHeight() != height ) );
-			bool	f2 = ( t2 && ( t2->getWidth() != width || t2->getHeight() != height ) );
-			for ( int y = 0; channels > 0 && y < height; y++ ) {
+			for ( int y = 0; y < job.height; y++ ) {
 				unsigned char *	imgPtr = reinterpret_cast< unsigned char * >( img.bits() ) + ( size_t(y) * lineBytes );
-				for ( int x = 0; x < width; x++, imgPtr = imgPtr + channels ) {
-					FloatVector4	a( 0.0f, 0.0f, 0.0f, 1.0f );
-					FloatVector4	b( 0.0f, 0.0f, 0.0f, 1.0f );
-					float	xf = float( x ) * xScale + xOffset;
-					float	yf = float( y ) * yScale + yOffset;
-					if ( t1 )
-						a = ( !f1 ? FloatVector4::convertFloat16( t1->getPixelN(x, y, 0) ) : t1->getPixelB(xf, yf, 0) );
-					if ( t2 )
-						b = ( !f2 ? FloatVector4::convertFloat16( t2->getPixelN(x, y, 0) ) : t2->getPixelB(xf, yf, 0) );
-					switch ( n ) {
-					case 0:
-						// albedo: add alpha channel from opacity texture
-						a[3] = b[0];
-						break;
-					case 1:
-						// normal map: calculate Z (blue) channel and convert to unsigned format
-						a[2] = float( std::sqrt( std::max( 1.0f - a.dotProduct2(a), 0.0f ) ) );
-						a = a * FloatVector4( 0.5f, -0.5f, 0.5f, 0.5f ) + 0.5f;	// invert green channel
-						break;
-					case 2:
-						// PBR map: G = roughness, B = metalness
-						a = FloatVector4( 0.0f, a[0], b[0], 0.0f );
-						break;
-					}
-					std::uint32_t	c = std::uint32_t( a * 255.0f );
-					if ( channels == 3 ) {
-						FileBuffer::writeUInt16Fast( imgPtr, std::uint16_t( c ) );
-						imgPtr[2] = std::uint8_t( c >> 16 );
-					} else if ( channels == 4 ) {
-						FileBuffer::writeUInt32Fast( imgPtr, c );
-					} else {
-						*imgPtr = std::uint8_t( c );
-					}
-				}
+				convertScanline( imgPtr, y, n, job.channels, job.width, job.height, t1, t2 );
 			}
 			delete t1;
 			t1 = nullptr;
 			delete t2;
 			t2 = nullptr;
 
-			if ( channels ) {
-				QBuffer	tmpBuf( &imageBuf );
-				tmpBuf.open( QIODevice::WriteOnly );
-				img.save( &tmpBuf, "PNG", 89 );
-			}
-		} catch ( ... ) {
-			delete t1;
-			delete t2;
-			throw;
+			QBuffer	tmpBuf( &job.imageBuf );
+			tmpBuf.open( QIODevice::WriteOnly );
+			img.save( &tmpBuf, "PNG", 89 );
 		}
+	} catch ( std::exception & e ) {
+		job.imageBuf.clear();
+		job.error = QString( "ERROR: Texture %1 could not be converted: %2" )
+					.arg( QString::fromStdString( !job.txtPath1.empty() ? job.txtPath1 : job.txtPath2 ), e.what() );
+	}
+	delete t1;
+	delete t2;
+}
+
+int ExportGltfMaterials::addTexture( const TextureJob & job )
+{
+	if ( job.imageBuf.isEmpty() )
+		return -1;
 
-		// if a valid image has been created, add it as a glTF buffer view
-		int	bufView = -1;
-		if ( !imageBuf.isEmpty() && !model.buffers.empty() ) {
-			bufView = int( model.bufferViews.size() );
-			tinygltf::BufferView &	v = model.bufferViews.emplace_back();
-			v.buffer = int( model.buffers.size() - 1 );
-			std::vector< unsigned char > &	buf = model.buffers.back().data;
-			v.byteOffset = buf.size();
-			v.byteLength = size_t( imageBuf.size() );
-			buf.resize( v.byteOffset + v.byteLength );
-			std::memcpy( buf.data() + v.byteOffset, imageBuf.data(), v.byteLength );
+	// if a valid image has been created, add it as a glTF buffer view or an external file
+	int	bufView = -1;
+	std::string	uri;
+	if ( imageBaseName.isEmpty() ) {
+		bufView = int( model.bufferViews.size() );
+		tinygltf::BufferView &	v = model.bufferViews.emplace_back();
+		v.buffer = 0;
+		v.byteOffset = size_t( bin.size() );
+		v.byteLength = size_t( job.imageBuf.size() );
+		bin.append( job.imageBuf.constData(), job.imageBuf.size() );
+	} else {
+		// written under a temporary name, so that existing files are not replaced if the export fails
+		QString	imageName = QString( "%1_%2.png" ).arg( imageBaseName ).arg( model.images.size() );
+		QFile	f( imageName + ".tmp" );
+		if ( !f.open( QIODevice::WriteOnly ) )
+			return -1;
+		if ( f.write( job.imageBuf ) != job.imageBuf.size() ) {
+			f.remove();
+			return -1;
 		}
+		imageFiles.emplace_back( f.fileName(), imageName );
+		uri = QFileInfo( imageName ).fileName().toStdString();
+	}
 
-		int	textureID = -1;
-		if ( bufView >= 0 ) {
-			tinygltf::Image &	img = model.images.emplace_back();
-			img.width = width;
-			img.height = height;
-			img.component = channels;
-			img.bits = 8;
-			img.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
-			img.bufferView = bufView;
-			img.mimeType = "image/png";
-			textureID = int( model.textures.size() );
-			model.textures.emplace_back().source = int( model.images.size() - 1 );
-			if ( texCoordMode ) {
-				int	wrapMode = TINYGLTF_TEXTURE_WRAP_CLAMP_TO_EDGE;
-				if ( !( texCoordMode & 1 ) )
-					wrapMode = TINYGLTF_TEXTURE_WRAP_MIRRORED_REPEAT;
-				for ( const auto & j : model.samplers ) {
-					if ( j.wrapS == wrapMode ) {
-						model.textures.back().sampler = int( &j - model.samplers.data() );
-						break;
-					}
-				}
-				if ( model.textures.back().sampler < 0 ) {
-					model.samplers.emplace_back().wrapS = wrapMode;
-					model.samplers.back().wrapT = wrapMode;
-					model.textures.back().sampler = int( model.samplers.size() - 1 );
-				}
+	tinygltf::Image &	img = model.images.emplace_back();
+	img.width = job.width;
+	img.height = job.height;
+	img.component = job.channels;
+	img.bits = 8;
+	img.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+	img.bufferView = bufView;
+	img.uri = uri;
+	img.mimeType = "image/png";
+	int	textureID = int( model.textures.size() );
+	model.textures.emplace_back().source = int( model.images.size() - 1 );
+	if ( job.texCoordMode ) {
+		int	wrapMode = TINYGLTF_TEXTURE_WRAP_CLAMP_TO_EDGE;
+		if ( !( job.texCoordMode & 1 ) )
+			wrapMode = TINYGLTF_TEXTURE_WRAP_MIRRORED_REPEAT;
+		for ( const auto & j : model.samplers ) {
+			if ( j.wrapS == wrapMode ) {
+				model.textures.back().sampler = int( &j - model.samplers.data() );
+				break;
 			}
 		}
+		if ( model.textures.back().sampler < 0 ) {
+			model.samplers.emplace_back().wrapS = wrapMode;
+			model.samplers.back().wrapT = wrapMode;
+			model.textures.back().sampler = int( model.samplers.size() - 1 );
+		}
+	}
+
+	return textureID;
+}
+
+bool ExportGltfMaterials::exportTextures( const std::function< bool ( int, int ) > & progress, QStringList & errors )
+{
+	int	total = int( textureJobs.size() );
+	std::atomic< int >	next( 0 );
+	std::atomic< int >	done( 0 );
+	std::atomic< bool >	cancelled( false );
+	auto	worker = [&]() {
+		for ( int i; !cancelled && ( i = next.fetch_add( 1 ) ) < total; ) {
+			convertTexture( textureJobs[i] );
+			done++;
+		}
+	};
 
-		i = textureMap.emplace( textureMapKey, textureID ).first;
+	// reading from the archives is serialized by the resource lock, decoding and PNG encoding run in parallel
+	int	numThreads = std::min( std::max( QThread::idealThreadCount(), 1 ), total );
+	QList< QThread * >	threads;
+	for ( int i = 0; i < numThreads; i++ ) {
+		QThread *	thread = QThread::create( worker );
+		thread->start();
+		threads.append( thread );
 	}
+	for ( QThread * thread : threads ) {
+		while ( !thread->wait( QDeadlineTimer( 50 ) ) ) {
+			if ( progress && !cancelled && !progress( done, total ) )
+				cancelled = true;
+		}
+		delete thread;
+	}
+	if ( progress && !cancelled )
+		progress( total, total );
+	if ( cancelled )
+		return false;
 
-	switch ( n ) {
-	case 0:
-		mat.pbrMetallicRoughness.baseColorTexture.index = i->second;
-		mat.pbrMetallicRoughness.baseColorTexture.texCoord = texCoordChannel;
-		break;
-	case 1:
-		mat.normalTexture.index = i->second;
-		mat.normalTexture.texCoord = texCoordChannel;
-		break;
-	case 2:
-		mat.pbrMetallicRoughness.metallicRoughnessTexture.index = i->second;
-		mat.pbrMetallicRoughness.metallicRoughnessTexture.texCoord = texCoordChannel;
-		break;
-	case 3:
-		mat.occlusionTexture.index = i->second;
-		mat.occlusionTexture.texCoord = texCoordChannel;
-		break;
-	case 4:
-		mat.emissiveTexture.index = i->second;
-		mat.emissiveTexture.texCoord = texCoordChannel;
-		break;
+	// add the images in the order in which the materials first used them
+	std::vector< int >	textureIDs( textureJobs.size() );
+	for ( size_t i = 0; i < textureJobs.size(); i++ ) {
+		if ( !textureJobs[i].error.isEmpty() )
+			errors << textureJobs[i].error;
+		textureIDs[i] = addTexture( textureJobs[i] );
+		textureJobs[i].imageBuf.clear();
 	}
+
+	for ( const TextureRef & r : textureRefs ) {
+		tinygltf::Material &	mat = *( r.mat );
+		int	textureID = textureIDs[r.job];
+		switch ( r.n ) {
+		case 0:
+			mat.pbrMetallicRoughness.baseColorTexture.index = textureID;
+			mat.pbrMetallicRoughness.baseColorTexture.texCoord = r.texCoordChannel;
+			break;
+		case 1:
+			mat.normalTexture.index = textureID;
+			mat.normalTexture.texCoord = r.texCoordChannel;
+			break;
+		case 2:
+			mat.pbrMetallicRoughness.metallicRoughnessTexture.index = textureID;
+			mat.pbrMetallicRoughness.metallicRoughnessTexture.texCoord = r.texCoordChannel;
+			break;
+		case 3:
+			mat.occlusionTexture.index = textureID;
+			mat.occlusionTexture.texCoord = r.texCoordChannel;
+			break;
+		case 4:
+			mat.emissiveTexture.index = textureID;
+			mat.emissiveTexture.texCoord = r.texCoordChannel;
+			break;
+		}
+	}
+
+	return true;
 }
 
 std::string ExportGltfMaterials::getTexturePath(
@@ -881,6 +1055,135 @@ void ExportGltfMaterials::exportMaterial( tinygltf::Material & mat, const std::s
 	mat.emissiveFactor[2] = emissiveFactor[2];
 }
 
+GltfBinaryStream::GltfBinaryStream( const QString & folder )
+	: file( new QTemporaryFile( QDir( folder ).filePath( "nifskope_XXXXXX.tmp" ) ) ), buf( 1 << 20 )
+{
+	failed = !file->open();
+}
+
+GltfBinaryStream::~GltfBinaryStream()
+{
+}
+
+void GltfBinaryStream::append( const char * data, qint64 n )
+{
+	if ( n <= 0 )
+		return;
+	streamSize += n;
+	if ( ( bufUsed + size_t( n ) ) > buf.size() ) {
+		flush();
+		if ( size_t( n ) >= ( buf.size() >> 1 ) ) {
+			// write large blocks directly
+			if ( !failed && file->write( data, n ) != n )
+				failed = true;
+			return;
+		}
+	}
+	std::memcpy( buf.data() + bufUsed, data, size_t( n ) );
+	bufUsed += size_t( n );
+}
+
+bool GltfBinaryStream::flush()
+{
+	if ( bufUsed > 0 && !failed && file->write( buf.data(), qint64( bufUsed ) ) != qint64( bufUsed ) )
+		failed = true;
+	bufUsed = 0;
+	return !failed;
+}
+
+bool GltfBinaryStream::saveAs( const QString & fileName )
+{
+	if ( !flush() )
+		return false;
+	if ( QFile::exists( fileName ) && !QFile::remove( fileName ) )
+		return false;
+	if ( !file->rename( fileName ) )
+		return false;
+	file->setAutoRemove( false );
+	return true;
+}
+
+bool GltfBinaryStream::copyTo( QIODevice & out )
+{
+	if ( !( flush() && file->seek( 0 ) ) )
+		return false;
+	for ( qint64 n = streamSize; n > 0; ) {
+		qint64	bytesRead = file->read( buf.data(), std::min< qint64 >( n, qint64( buf.size() ) ) );
+		if ( bytesRead <= 0 || out.write( buf.data(), bytesRead ) != bytesRead )
+			return false;
+		n = n - bytesRead;
+	}
+	return true;
+}
+
+bool writeGltfStreamed( const tinygltf::Model & model, GltfBinaryStream & bin, const QString & fileName, bool writeBinary )
+{
+	if ( !bin.flush() )
+		return false;
+
+	tinygltf::TinyGLTF	writer;
+	std::ostringstream	s;
+	if ( !writer.WriteGltfSceneToStream( &model, s, !writeBinary, false ) )
+		return false;
+	std::string	json = s.str();
+	while ( !json.empty() && std::isspace( (unsigned char) json.back() ) )
+		json.pop_back();
+	if ( json.empty() || json.front() != '{' )
+		return false;
+
+	// the buffer is not part of the model, insert it with the size of the stream
+	QFileInfo	fileInfo( fileName );
+	QString	binName = fileInfo.completeBaseName() + ".bin";
+	if ( bin.size() > 0 ) {
+		QJsonObject	b;
+		b.insert( "byteLength", QJsonValue( bin.size() ) );
+		if ( !writeBinary ) {
+			b.insert( "name", binName );
+			b.insert( "uri", binName );
+		}
+		QByteArray	buffers = "\"buffers\":" + QJsonDocument( QJsonArray{ b } ).toJson( QJsonDocument::Compact );
+		buffers.append( ',' );
+		json.insert( 1, buffers.constData(), size_t( buffers.size() ) );
+	}
+
+	// an existing file is only replaced by commit(), and is kept if writing fails
+	QSaveFile	f( fileName );
+	if ( !f.open( QIODevice::WriteOnly ) )
+		return false;
+	if ( !writeBinary ) {
+		json += '\n';
+		// the .bin file is staged in the temporary file of the stream, and only replaced once the .gltf is in place
+		if ( f.write( json.c_str(), qint64( json.length() ) ) != qint64( json.length() ) || !f.commit() )
+			return false;
+		return ( bin.size() < 1 || bin.saveAs( fileInfo.dir().filePath( binName ) ) );
+	}
+
+	// GLB header, JSON chunk padded with spaces, and BIN chunk padded with zeros
+	json.resize( ( json.length() + 3 ) & ~size_t( 3 ), ' ' );
+	std::uint64_t	binLength = ( std::uint64_t( bin.size() ) + 3 ) & ~std::uint64_t( 3 );
+	std::uint64_t	totalLength = 20 + json.length() + ( binLength ? binLength + 8 : 0 );
+	if ( totalLength > 0xFFFFFFFFU )
+		return false;
+	char	header[20];
+	FileBuffer::writeUInt32Fast( &(header[0]), 0x46546C67U );	// "glTF"
+	FileBuffer::writeUInt32Fast( &(header[4]), 2 );
+	FileBuffer::writeUInt32Fast( &(header[8]), std::uint32_t( totalLength ) );
+	FileBuffer::writeUInt32Fast( &(header[12]), std::uint32_t( json.length() ) );
+	FileBuffer::writeUInt32Fast( &(header[16]), 0x4E4F534AU );	// "JSON"
+	if ( f.write( header, 20 ) != 20 || f.write( json.c_str(), qint64( json.length() ) ) != qint64( json.length() ) )
+		return false;
+	if ( binLength ) {
+		FileBuffer::writeUInt32Fast( &(header[0]), std::uint32_t( binLength ) );
+		FileBuffer::writeUInt32Fast( &(header[4]), 0x004E4942U );	// "BIN\0"
+		if ( f.write( header, 8 ) != 8 || !bin.copyTo( f ) )
+			return false;
+		qint64	padding = qint64( binLength ) - bin.size();
+		if ( padding > 0 && f.write( "\0\0\0", padding ) != padding )
+			return false;
+	}
+	return f.commit();
+}
+
 static QString getGltfFolder( const NifModel * nif )
 {
 	QString	dirName = nif->getFolder();
@@ -892,7 +1195,7 @@ static QString getGltfFolder( const NifModel * nif )
 
 void exportGltf( const NifModel* nif, const Scene* scene, [[maybe_unused]] const QModelIndex& index )
 {
-	QString filename = QFileDialog::getSaveFileName(qApp->activeWindow(), tr("Choose a .glTF file for export"), getGltfFolder(nif), "glTF (*.gltf)");
+	QString filename = QFileDialog::getSaveFileName(qApp->activeWindow(), tr("Choose a .glTF file for export"), getGltfFolder(nif), "glTF (*.gltf);;glTF Binary (*.glb)");
 	bool	useFullMatPaths;
 	int	textureMipLevel;
 	if ( filename.isEmpty() ) {
@@ -904,28 +1207,31 @@ void exportGltf( const NifModel* nif, const Scene* scene, [[maybe_unused]] const
 		textureMipLevel = settings.value( "Settings/Nif/Gl TF Export Mip Level", 1 ).toInt();
 		textureMipLevel = std::min< int >( std::max< int >( textureMipLevel, -1 ), 15 );
 	}
-	if ( !filename.endsWith( ".gltf", Qt::CaseInsensitive ) )
+	bool	writeBinary = filename.endsWith( ".glb", Qt::CaseInsensitive );
+	if ( !( writeBinary || filename.endsWith( ".gltf", Qt::CaseInsensitive ) ) )
 		filename.append( ".gltf" );
 
-	QString buffName = filename.left( filename.length() - 5 ) + ".bin";
+	// the geometry and embedded images are streamed to a temporary file, and .glb files reference external images
+	QFileInfo	fileInfo( filename );
+	GltfBinaryStream	buffer( fileInfo.absolutePath() );
+	if ( !buffer.isValid() ) {
+		Message::critical( nullptr, tr( "Could not create temporary file in %1" ).arg( fileInfo.absolutePath() ) );
+		return;
+	}
+	QString	imageBaseName;
+	if ( writeBinary )
+		imageBaseName = fileInfo.dir().filePath( fileInfo.completeBaseName() );
 
-	tinygltf::TinyGLTF writer;
 	tinygltf::Model model;
 	model.asset.generator = "NifSkope glTF 2.0 Exporter v1.2";
 
 	GltfStore gltf;
 	gltf.materials.emplace( std::string(), 0 );
-	QByteArray buffer;
 	bool success = exportCreateNodes(nif, scene, model, buffer, gltf);
 	if ( success )
 		success = exportCreateMeshes(nif, scene, model, buffer, gltf);
 	if ( success ) {
-		auto buff = tinygltf::Buffer();
-		buff.name = buffName.mid( QDir::fromNativeSeparators( buffName ).lastIndexOf( QChar('/') ) + 1 ).toStdString();
-		buff.data = std::vector<unsigned char>(buffer.cbegin(), buffer.cend());
-		model.buffers.push_back(buff);
-
-		ExportGltfMaterials	matExporter( const_cast< NifModel * >(nif), model, textureMipLevel );
+		ExportGltfMaterials	matExporter( const_cast< NifModel * >(nif), model, textureMipLevel, buffer, imageBaseName );
 		model.materials.resize( gltf.materials.size() );
 		for ( const auto& i : gltf.materials ) {
 			const std::string &	name = i.first;
@@ -953,7 +1259,31 @@ void exportGltf( const NifModel* nif, const Scene* scene, [[maybe_unused]] const
 			matExporter.exportMaterial( mat, name );
 		}
 
-		writer.WriteGltfSceneToFile(&model, filename.toStdString(), false, false, true, false);
+		QProgressDialog	progress( tr( "Converting textures..." ), tr( "Cancel" ), 0, 0, qApp->activeWindow() );
+		progress.setWindowModality( Qt::WindowModal );
+		progress.setMinimumDuration( 500 );
+		bool	exported = matExporter.exportTextures( [&progress]( int done, int total ) {
+			progress.setMaximum( total );
+			progress.setValue( done );
+			QApplication::processEvents();
+			return !progress.wasCanceled();
+		}, gltf.errors );
+		if ( !exported )
+			return;
+
+		QStringList	existingImages = matExporter.existingImageFiles();
+		if ( !existingImages.isEmpty() ) {
+			auto	answer = QMessageBox::question( qApp->activeWindow(), tr( "Export glTF" ),
+													tr( "The following image files already exist in %1 and will be replaced:\n\n%2\n\nContinue?" )
+													.arg( fileInfo.absolutePath(), existingImages.join( '\n' ) ) );
+			if ( answer != QMessageBox::Yes )
+				return;
+		}
+
+		if ( !writeGltfStreamed( model, buffer, filename, writeBinary ) )
+			gltf.errors << tr( "Error writing %1" ).arg( filename );
+		else if ( !matExporter.commitImages() )
+			gltf.errors << tr( "Error writing the images of %1" ).arg( filename );
 	}
 
 	if ( gltf.errors.size() == 1 ) {
@@ -987,13 +1317,18 @@ protected:
 	bool nodeHasMeshes( const tinygltf::Node & node, int d = 0 ) const;
 	static void normalizeFloats( float * p, size_t n, int dataType );
 	template< typename T > bool loadBuffer( std::vector< T > & outBuf, int accessor, int typeRequired );
+	// Replaces per-vertex attributes with those of the vertices used by a chunk of a split mesh
+	template< typename T > static void remapVertices( std::vector< T > & buf, size_t componentCnt, const TriangleChunk & chunk );
 	void loadSkin( const QPersistentModelIndex & index, const tinygltf::Skin & skin );
-	int loadTriangles( const QModelIndex & index, const tinygltf::Primitive & p );
-	void loadSkinnedLODMesh( const QPersistentModelIndex & index, const tinygltf::Primitive & p, int lod );
+	// Returns the triangles of the primitive split into parts that can be indexed with 16 bits
+	QVector< TriangleChunk > loadTriangleChunks( const tinygltf::Primitive & p );
+	int loadTriangles( const QModelIndex & index, const TriangleChunk & chunk );
+	void loadSkinnedLODMesh(
+		const QPersistentModelIndex & index, const tinygltf::Primitive & p, const TriangleChunk & chunk, int lod );
 	// Returns true if tangent space needs to be calculated
 	bool loadMesh(
 		const QPersistentModelIndex & index, std::string & materialPath, const tinygltf::Primitive & p,
-		int lod, int skin );
+		const TriangleChunk & chunk, int lod, int skin );
 	void loadNode( const QPersistentModelIndex & index, int nodeNum, bool isRoot );
 public:
 	ImportGltf( NifModel * nifModel, const tinygltf::Model & gltfModel, bool enableLOD )
@@ -1122,6 +1457,19 @@ template< typename T > bool ImportGltf::loadBuffer( std::vector< T > & outBuf, i
 	return true;
 }
 
+template< typename T > void ImportGltf::remapVertices( std::vector< T > & buf, size_t componentCnt, const TriangleChunk & chunk )
+{
+	if ( chunk.vertices.isEmpty() )
+		return;
+	std::vector< T >	tmpBuf( size_t( chunk.vertices.size() ) * componentCnt, T( 0 ) );
+	for ( qsizetype i = 0; i < chunk.vertices.size(); i++ ) {
+		size_t	j = size_t( chunk.vertices[i] ) * componentCnt;
+		if ( ( j + componentCnt ) <= buf.size() )
+			std::copy( buf.begin() + j, buf.begin() + ( j + componentCnt ), tmpBuf.begin() + ( size_t(i) * componentCnt ) );
+	}
+	buf = std::move( tmpBuf );
+}
+
 void ImportGltf::loadSkin( const QPersistentModelIndex & index, const tinygltf::Skin & skin )
 {
 	QPersistentModelIndex	iSkinBMP = nif->insertNiBlock( "SkinAttach" );
@@ -1214,31 +1562,31 @@ void ImportGltf::loadSkin( const QPersistentModelIndex & index, const tinygltf::
 	}
 }
 
-int ImportGltf::loadTriangles( const QModelIndex & index, const tinygltf::Primitive & p )
+QVector< TriangleChunk > ImportGltf::loadTriangleChunks( const tinygltf::Primitive & p )
 {
-	std::vector< std::uint16_t >	indices;
-	if ( !loadBuffer< std::uint16_t >( indices, p.indices, TINYGLTF_TYPE_SCALAR ) )
-		return -1;
+	std::vector< std::uint32_t >	indices;
+	if ( !loadBuffer< std::uint32_t >( indices, p.indices, TINYGLTF_TYPE_SCALAR ) )
+		return QVector< TriangleChunk >();
 
-	int	numTriangles = int( indices.size() / 3 );
-	nif->set<quint32>( index, "Indices Size", quint32(indices.size()) );
+	// the mesh format uses 16-bit indices, larger primitives are imported as multiple shapes
+	return splitTriangles( indices.data(), qsizetype( indices.size() / 3 ) );
+}
+
+int ImportGltf::loadTriangles( const QModelIndex & index, const TriangleChunk & chunk )
+{
+	int	numTriangles = int( chunk.triangles.size() );
+	nif->set<quint32>( index, "Indices Size", quint32(numTriangles) * 3U );
 	auto	iTriangles = nif->getIndex( index, "Triangles" );
 	if ( iTriangles.isValid() ) {
 		nif->updateArraySize( iTriangles );
-		QVector< Triangle >	triangles;
-		triangles.resize( numTriangles );
-		for ( qsizetype i = 0; i < numTriangles; i++ ) {
-			triangles[i][0] = indices[i * 3];
-			triangles[i][1] = indices[i * 3 + 1];
-			triangles[i][2] = indices[i * 3 + 2];
-		}
-		nif->setArray<Triangle>( iTriangles, triangles );
+		nif->setArray<Triangle>( iTriangles, chunk.triangles );
 	}
 
 	return numTriangles;
 }
 
-void ImportGltf::loadSkinnedLODMesh( const QPersistentModelIndex & index, const tinygltf::Primitive & p, int lod )
+void ImportGltf::loadSkinnedLODMesh(
+	const QPersistentModelIndex & index, const tinygltf::Primitive & p, const TriangleChunk & chunk, int lod )
 {
 	auto	iMeshes = nif->getIndex( index, "Meshes" );
 	if ( !iMeshes.isValid() )
@@ -1259,6 +1607,7 @@ void ImportGltf::loadSkinnedLODMesh( const QPersistentModelIndex & index, const
 		if ( i.first == "POSITION" || i.first == "NORMAL" ) {
 			if ( !loadBuffer< float >( attrBuf, i.second, TINYGLTF_TYPE_VEC3 ) )
 				continue;
+			remapVertices( attrBuf, 3, chunk );
 			if ( !attrBuf.empty() && attrBuf.size() != ( size_t(numVerts) * 3 ) ) {
 				invalidAttrSize = true;
 				break;
@@ -1266,6 +1615,7 @@ void ImportGltf::loadSkinnedLODMesh( const QPersistentModelIndex & index, const
 		} else if ( i.first == "TEXCOORD_0" || i.first == "TEXCOORD_1" ) {
 			if ( !loadBuffer< float >( attrBuf, i.second, TINYGLTF_TYPE_VEC2 ) )
 				continue;
+			remapVertices( attrBuf, 2, chunk );
 			if ( !attrBuf.empty() && attrBuf.size() != ( size_t(numVerts) << 1 ) ) {
 				invalidAttrSize = true;
 				break;
@@ -1273,6 +1623,7 @@ void ImportGltf::loadSkinnedLODMesh( const QPersistentModelIndex & index, const
 		} else if ( i.first == "TANGENT" || i.first == "COLOR_0" ) {
 			if ( !loadBuffer< float >( attrBuf, i.second, TINYGLTF_TYPE_VEC4 ) )
 				continue;
+			remapVertices( attrBuf, 4, chunk );
 			if ( !attrBuf.empty() && attrBuf.size() != ( size_t(numVerts) << 2 ) ) {
 				invalidAttrSize = true;
 				break;
@@ -1296,14 +1647,15 @@ void ImportGltf::loadSkinnedLODMesh( const QPersistentModelIndex & index, const
 	nif->updateArraySize( iLODMesh );
 	iLODMesh = QModelIndex_child( iLODMesh, lod - 1 );
 	if ( iLODMesh.isValid() )
-		(void) loadTriangles( iLODMesh, p );
+		(void) loadTriangles( iLODMesh, chunk );
 }
 
 bool ImportGltf::loadMesh(
-	const QPersistentModelIndex & index, std::string & materialPath, const tinygltf::Primitive & p, int lod, int skin )
+	const QPersistentModelIndex & index, std::string & materialPath, const tinygltf::Primitive & p,
+	const TriangleChunk & chunk, int lod, int skin )
 {
 	if ( lod > 0 && skin >= 0 && size_t(skin) < model.skins.size() ) {
-		loadSkinnedLODMesh( index, p, lod );
+		loadSkinnedLODMesh( index, p, chunk, lod );
 		return false;
 	}
 
@@ -1338,9 +1690,7 @@ bool ImportGltf::loadMesh(
 	nif->set<quint32>( iMesh, "Flags", 64 );
 	nif->set<quint32>( iMeshData, "Version", 2 );
 
-	int	numTriangles = loadTriangles( iMeshData, p );
-	if ( numTriangles < 0 )
-		return false;
+	int	numTriangles = loadTriangles( iMeshData, chunk );
 	nif->set<quint32>( iMesh, "Indices Size", quint32(numTriangles) * 3U );
 
 	if ( skin >= 0 && size_t(skin) < model.skins.size() )
@@ -1353,6 +1703,7 @@ bool ImportGltf::loadMesh(
 			std::vector< float >	positions;
 			if ( !loadBuffer< float >( positions, i.second, TINYGLTF_TYPE_VEC3 ) )
 				continue;
+			remapVertices( positions, 3, chunk );
 			std::uint32_t	numVerts = std::uint32_t( positions.size() / 3 );
 			if ( !numVerts )
 				continue;
@@ -1382,6 +1733,7 @@ bool ImportGltf::loadMesh(
 			std::vector< float >	uvs;
 			if ( !loadBuffer< float >( uvs, i.second, TINYGLTF_TYPE_VEC2 ) )
 				continue;
+			remapVertices( uvs, 2, chunk );
 			std::uint32_t	numUVs = std::uint32_t( uvs.size() >> 1 );
 			if ( !numUVs )
 				continue;
@@ -1402,6 +1754,7 @@ bool ImportGltf::loadMesh(
 			std::vector< float >	normals;
 			if ( !loadBuffer< float >( normals, i.second, TINYGLTF_TYPE_VEC3 ) )
 				continue;
+			remapVertices( normals, 3, chunk );
 			std::uint32_t	numNormals = std::uint32_t( normals.size() / 3 );
 			if ( !numNormals )
 				continue;
@@ -1428,6 +1781,7 @@ bool ImportGltf::loadMesh(
 			std::vector< float >	tangents;
 			if ( !loadBuffer< float >( tangents, i.second, TINYGLTF_TYPE_VEC4 ) )
 				continue;
+			remapVertices( tangents, 4, chunk );
 			std::uint32_t	numTangents = std::uint32_t( tangents.size() >> 2 );
 			if ( !numTangents )
 				continue;
@@ -1456,6 +1810,7 @@ bool ImportGltf::loadMesh(
 			if ( !haveAlpha && !loadBuffer< float >( colors, i.second, TINYGLTF_TYPE_VEC3 ) )
 				continue;
 			size_t	componentCnt = ( !haveAlpha ? 3 : 4 );
+			remapVertices( colors, componentCnt, chunk );
 			std::uint32_t	numColors = std::uint32_t( colors.size() / componentCnt );
 			if ( !numColors )
 				continue;
@@ -1481,6 +1836,7 @@ bool ImportGltf::loadMesh(
 			std::vector< float >	weights;
 			if ( !loadBuffer< float >( weights, i.second, TINYGLTF_TYPE_VEC4 ) )
 				continue;
+			remapVertices( weights, 4, chunk );
 			size_t	numWeights = weights.size() >> 2;
 			if ( numWeights > boneWeights.size() )
 				boneWeights.resize( numWeights );
@@ -1499,6 +1855,7 @@ bool ImportGltf::loadMesh(
 			std::vector< std::uint16_t >	joints;
 			if ( !loadBuffer< std::uint16_t >( joints, i.second, TINYGLTF_TYPE_VEC4 ) )
 				continue;
+			remapVertices( joints, 4, chunk );
 			size_t	numJoints = joints.size() >> 2;
 			if ( numJoints > boneWeights.size() )
 				boneWeights.resize( numJoints );
@@ -1571,16 +1928,30 @@ void ImportGltf::loadNode( const QPersistentModelIndex & index, int nodeNum, boo
 	if ( haveMesh )
 		primCnt = model.meshes[node.mesh].primitives.size();
 	size_t	p = 0;
+	// primitives that use more than 65536 vertices are split into one shape per chunk
+	QVector< TriangleChunk >	chunks;
+	qsizetype	c = 0;
 	do {
 		const tinygltf::Primitive *	meshPrim = nullptr;
 		if ( haveMesh ) {
 			if ( !primCnt )
 				break;
 			meshPrim = model.meshes[node.mesh].primitives.data() + p;
-			if ( meshPrim->mode != TINYGLTF_MODE_TRIANGLES || meshPrim->attributes.empty() )
-				continue;
-			if ( meshPrim->indices < 0 || size_t(meshPrim->indices) >= model.accessors.size() )
-				continue;
+			if ( c == 0 ) {
+				chunks.clear();
+				if ( meshPrim->mode != TINYGLTF_MODE_TRIANGLES || meshPrim->attributes.empty() )
+					continue;
+				if ( meshPrim->indices < 0 || size_t(meshPrim->indices) >= model.accessors.size() )
+					continue;
+				chunks = loadTriangleChunks( *meshPrim );
+				if ( chunks.isEmpty() )
+					continue;
+				if ( chunks.size() > 1 ) {
+					Message::append( "Warnings were generated during glTF import.",
+										QString( "Mesh '%1' uses more than 65536 vertices and was split into %2 shapes." )
+										.arg( QString::fromStdString( node.name ) ).arg( chunks.size() ) );
+				}
+			}
 		}
 
 		QPersistentModelIndex	iBlock = nif->insertNiBlock( !haveMesh ? "NiNode" : "BSGeometry" );
@@ -1655,13 +2026,13 @@ void ImportGltf::loadNode( const QPersistentModelIndex & index, int nodeNum, boo
 			if ( node.extras.Has( "Material Path" ) )
 				materialPath = node.extras.Get( "Material Path" ).Get< std::string >();
 
-			bool	tangentsNeeded = loadMesh( iBlock, materialPath, *meshPrim, 0, node.skin );
+			bool	tangentsNeeded = loadMesh( iBlock, materialPath, *meshPrim, chunks.at( c ), 0, node.skin );
 			for ( int l = 0; size_t(l) < node.lods.size() && l < 3 && gltfEnableLOD; l++ ) {
 				int	n = node.lods[l];
 				if ( n >= 0 && size_t(n) < model.nodes.size() ) {
 					int	m = model.nodes[n].mesh;
 					if ( m >= 0 && size_t(m) < model.meshes.size() )
-						tangentsNeeded |= loadMesh( iBlock, materialPath, *meshPrim, l + 1, node.skin );
+						tangentsNeeded |= loadMesh( iBlock, materialPath, *meshPrim, chunks.at( c ), l + 1, node.skin );
 				}
 			}
 
@@ -1685,7 +2056,7 @@ void ImportGltf::loadNode( const QPersistentModelIndex & index, int nodeNum, boo
 			for ( int i : node.children )
 				loadNode( iBlock, i, false );
 		}
-	} while ( ++p < primCnt );
+	} while ( ++c < chunks.size() || ( c = 0, ++p < primCnt ) );
 
 	nodeStack.pop_back();
 }
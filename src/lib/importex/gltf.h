@@ -0,0 +1,101 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef GLTF_H
+#define GLTF_H
+
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+
+//! @file gltf.h GltfBinaryStream, writeGltfStreamed()
+
+class QIODevice;
+class QTemporaryFile;
+
+namespace tinygltf
+{
+class Model;
+}
+
+//! The binary buffer of a glTF export, written to a temporary file as it grows
+/*!
+ * The accessors and buffer views of the exported meshes are appended to the stream while the model is being built,
+ * so that the geometry is never held in memory as a whole. writeGltfStreamed() moves the temporary file to the .bin
+ * file of a .gltf, or copies it into the BIN chunk of a .glb file. If the export is cancelled, the temporary file
+ * is removed when the stream is destroyed.
+ */
+class GltfBinaryStream final
+{
+public:
+	//! Creates a stream backed by a temporary file in \a folder
+	GltfBinaryStream( const QString & folder );
+	~GltfBinaryStream();
+
+	//! Returns false if the temporary file could not be created or written
+	bool isValid() const { return !failed; }
+	//! The number of bytes appended so far
+	qint64 size() const { return streamSize; }
+
+	//! Appends \a n bytes
+	void append( const char * data, qint64 n );
+	//! Writes the buffered data to the temporary file
+	bool flush();
+	//! Renames the temporary file to \a fileName, replacing an existing file
+	bool saveAs( const QString & fileName );
+	//! Copies the contents of the stream to \a out
+	bool copyTo( QIODevice & out );
+
+private:
+	std::unique_ptr<QTemporaryFile> file;
+	std::vector<char> buf;
+	size_t bufUsed = 0;
+	qint64 streamSize = 0;
+	bool failed = false;
+};
+
+//! Writes \a model to \a fileName with \a bin as its only buffer
+/*!
+ * @param model			The model without buffers, the buffer views refer to buffer 0
+ * @param bin			The binary data
+ * @param fileName		The output file, a .gltf with a separate .bin file, or a single .glb file
+ * @param writeBinary	Write a .glb file
+ * @return				False on a write error
+ *
+ * The main file is written through QSaveFile, an existing .gltf file is kept if writing it fails. The .bin file
+ * replaces an existing one only after the .gltf file has been committed.
+ */
+bool writeGltfStreamed( const tinygltf::Model & model, GltfBinaryStream & bin, const QString & fileName, bool writeBinary );
+
+#endif
@@ -44,11 +44,14 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QDebug>
 #include <QFile>
 #include <QFileDialog>
+#include <QHash>
 #include <QMessageBox>
 #include <QRegularExpression>
 #include <QSettings>
 #include <QTextStream>
 
+#include <vector>
+
 #define tr( x ) QApplication::tr( x )
 
 
@@ -513,6 +516,11 @@ struct ObjPoint
 	}
 };
 
+inline size_t qHash( const ObjPoint & p, size_t seed = 0 )
+{
+	return qHashMulti( seed, p.v, p.t, p.n );
+}
+
 struct ObjFace
 {
 	ObjPoint p[3];
@@ -588,6 +596,73 @@ static void readMtlLib( const QString & fname, QMap<QString, ObjMaterial> & omat
 		omaterials.insert( mtlid, mtl );
 }
 
+//! Vertex data and triangles of a shape to be created by the OBJ import
+struct ObjShape
+{
+	QString material;
+	QVector<Vector3> verts;
+	QVector<Vector3> norms;
+	QVector<Vector2> texco;
+	QVector<ByteColor4> colors;
+	QVector<Triangle> triangles;
+	bool haveVertexColors = false;
+};
+
+/*! Converts the faces using a material to one or more shapes
+ *
+ * Vertices are indexed with 32 bits first, and the mesh is split into multiple shapes
+ * only if it references more vertices than 16-bit triangles can address.
+ */
+static void buildObjShapes( QVector<ObjShape> & shapes, const QString & material, const QVector<ObjFace> & faces,
+							const QVector<Vector3> & overts, const QVector<Vector3> & onorms,
+							const QVector<Vector2> & otexco, const QVector<ByteColor4> & ocolors )
+{
+	if ( faces.isEmpty() )
+		return;
+
+	QHash<ObjPoint, quint32> pointIndex;
+	QVector<ObjPoint> points;
+	std::vector<quint32> indices;
+	pointIndex.reserve( faces.size() );
+	indices.reserve( size_t( faces.size() ) * 3 );
+	for ( const ObjFace & oface : faces ) {
+		for ( int t = 0; t < 3; t++ ) {
+			auto i = pointIndex.constFind( oface.p[t] );
+			if ( i == pointIndex.cend() ) {
+				i = pointIndex.insert( oface.p[t], quint32( points.size() ) );
+				points.append( oface.p[t] );
+			}
+			indices.push_back( i.value() );
+		}
+	}
+
+	QVector<TriangleChunk> chunks = splitTriangles( indices.data(), faces.size() );
+	if ( chunks.size() > 1 ) {
+		Message::append( tr( "Warnings were generated during OBJ import." ),
+			tr( "Material '%1' uses %2 vertices and was split into %3 shapes." ).arg( material ).arg( points.size() ).arg( chunks.size() ) );
+	}
+
+	for ( TriangleChunk & chunk : chunks ) {
+		ObjShape & shape = shapes.emplace_back();
+		shape.material = material;
+		qsizetype numVerts = ( chunk.vertices.isEmpty() ? points.size() : chunk.vertices.size() );
+		shape.verts.reserve( numVerts );
+		shape.norms.reserve( numVerts );
+		shape.texco.reserve( numVerts );
+		shape.colors.reserve( numVerts );
+		for ( qsizetype i = 0; i < numVerts; i++ ) {
+			const ObjPoint & p = points.at( chunk.vertices.isEmpty() ? i : qsizetype( chunk.vertices.at( i ) ) );
+			shape.verts.append( overts.value( p.v ) );
+			shape.norms.append( onorms.value( p.n ) );
+			shape.texco.append( otexco.value( p.t ) );
+			ByteColor4 c = ocolors.value( p.v );
+			shape.colors.append( c );
+			shape.haveVertexColors = shape.haveVertexColors || ( std::uint32_t( c ) != 0xFFFFFFFFU );
+		}
+		shape.triangles = std::move( chunk.triangles );
+	}
+}
+
 static void addLink( NifModel * nif, const QModelIndex & iBlock, const QString & name, qint32 link )
 {
 	QModelIndex iArray = nif->getIndex( iBlock, name );
@@ -800,52 +875,20 @@ void importObjMain( NifModel * nif, const QModelIndex & index, bool collision )
 	// create a NiTriShape or BSTriShape for each material in the object
 	int shapecount = 0;
 	bool first_tri_shape = true;
-	QMapIterator<QString, QVector<ObjFace> *> it( ofaces );
-
-	nif->holdUpdates( true );
-
-	while ( it.hasNext() ) {
-		it.next();
-
-		if ( !it.value()->count() )
-			continue;
 
-		QVector<Vector3> verts;
-		QVector<Vector3> norms;
-		QVector<Vector2> texco;
-		QVector<ByteColor4> colors;
-		QVector<Triangle> triangles;
-
-		QVector<ObjPoint> points;
-		bool	haveVertexColors = false;
+	QVector<ObjShape> oshapes;
+	for ( auto it = ofaces.cbegin(); it != ofaces.cend(); it++ )
+		buildObjShapes( oshapes, it.key(), *( it.value() ), overts, onorms, otexco, ocolors );
 
-		foreach ( ObjFace oface, *( it.value() ) ) {
-			Triangle tri;
-
-			for ( int t = 0; t < 3; t++ ) {
-				ObjPoint p = oface.p[t];
-				int ix;
-
-				for ( ix = 0; ix < points.count(); ix++ ) {
-					if ( points[ix] == p )
-						break;
-				}
-
-				if ( ix == points.count() ) {
-					points.append( p );
-					verts.append( overts.value( p.v ) );
-					norms.append( onorms.value( p.n ) );
-					texco.append( otexco.value( p.t ) );
-					ByteColor4	c = ocolors.value( p.v );
-					colors.append( c );
-					haveVertexColors = haveVertexColors || ( std::uint32_t( c ) != 0xFFFFFFFFU );
-				}
-
-				tri[t] = ix;
-			}
+	nif->holdUpdates( true );
 
-			triangles.append( tri );
-		}
+	for ( const ObjShape & oshape : oshapes ) {
+		const QVector<Vector3> & verts = oshape.verts;
+		const QVector<Vector3> & norms = oshape.norms;
+		const QVector<Vector2> & texco = oshape.texco;
+		const QVector<ByteColor4> & colors = oshape.colors;
+		const QVector<Triangle> & triangles = oshape.triangles;
+		bool	haveVertexColors = oshape.haveVertexColors;
 
 		if ( !collision ) {
 			//If we are on the first shape, and one was selected in the 3D view, use the existing one
@@ -866,12 +909,12 @@ void importObjMain( NifModel * nif, const QModelIndex & index, bool collision )
 				}
 			}
 
-			if ( !omaterials.contains( it.key() ) ) {
+			if ( !omaterials.contains( oshape.material ) ) {
 				Message::append( tr( "Warnings were generated during OBJ import." ),
-					tr( "Material '%1' not found in mtllib." ).arg( it.key() ) );
+					tr( "Material '%1' not found in mtllib." ).arg( oshape.material ) );
 			}
 
-			ObjMaterial mtl = omaterials.value( it.key() );
+			ObjMaterial mtl = omaterials.value( oshape.material );
 
 			QModelIndex shaderProp;
 			// add material property, for non-Skyrim versions
@@ -884,7 +927,7 @@ void importObjMain( NifModel * nif, const QModelIndex & index, bool collision )
 				}
 
 				if ( newiMaterial ) // don't affect a property  that is already there - that name is generated above on export and it has nothign to do with the stored name
-					nif->set<QString>( iMaterial, "Name", it.key() );
+					nif->set<QString>( iMaterial, "Name", oshape.material );
 
 				nif->set<Color3>( iMaterial, "Ambient Color", mtl.Ka );
 				nif->set<Color3>( iMaterial, "Diffuse Color", mtl.Kd );
@@ -1085,38 +1128,8 @@ void importObjMain( NifModel * nif, const QModelIndex & index, bool collision )
 			bounds.update( nif, iData );
 		} else if ( nif->getBSVersion() > 0 ) {
 			// create experimental havok collision mesh
-			QVector<Vector3> verts;
-			QVector<Vector3> norms;
-			QVector<Triangle> triangles;
-
-			QVector<ObjPoint> points;
-
 			shapecount++;
 
-			for ( const ObjFace & oface : *( it.value() ) ) {
-				Triangle tri;
-
-				for ( int t = 0; t < 3; t++ ) {
-					ObjPoint p = oface.p[t];
-					int ix;
-
-					for ( ix = 0; ix < points.count(); ix++ ) {
-						if ( points[ix] == p )
-							break;
-					}
-
-					if ( ix == points.count() ) {
-						points.append( p );
-						verts.append( overts.value( p.v ) );
-						norms.append( onorms.value( p.n ) );
-					}
-
-					tri[t] = ix;
-				}
-
-				triangles.append( tri );
-			}
-
 			QPersistentModelIndex iData = nif->insertNiBlock( "NiTriStripsData" );
 
 			nif->set<int>( iData, "Has Vertices", 1 );
@@ -0,0 +1,518 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "skinpartition.h"
+
+#include "lib/spatialhash.h"
+
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+
+
+//! @file skinpartition.cpp SkinPartitioner
+
+bool SkinPartitioner::setWeights( int numVertices, const QVector<VertexWeight> & weights )
+{
+	numVerts = std::max( numVertices, 0 );
+	numBones = 0;
+	vertexCounts.assign( size_t( numVerts ), 0 );
+	matched = false;
+
+	for ( const VertexWeight & w : weights ) {
+		if ( w.vertex < 0 || w.vertex >= numVerts || w.bone < 0 )
+			return false;
+
+		vertexCounts[w.vertex]++;
+		numBones = std::max( numBones, w.bone + 1 );
+	}
+
+	minBones = maxBones = ( numVerts > 0 ) ? vertexCounts[0] : 0;
+	for ( int c : vertexCounts ) {
+		minBones = std::min( minBones, c );
+		maxBones = std::max( maxBones, c );
+	}
+
+	// one row of maxBones influences per vertex, filled in bone order
+	stride = std::max( maxBones, 1 );
+	vertexBones.assign( size_t( numVerts ) * stride, 0 );
+	vertexWeights.assign( size_t( numVerts ) * stride, 0.0f );
+	std::fill( vertexCounts.begin(), vertexCounts.end(), 0 );
+
+	for ( const VertexWeight & w : weights ) {
+		size_t i = size_t( w.vertex ) * stride + size_t( vertexCounts[w.vertex]++ );
+		vertexBones[i] = w.bone;
+		vertexWeights[i] = w.weight;
+	}
+
+	return true;
+}
+
+void SkinPartitioner::setVertices( const QVector<Vector3> & verts )
+{
+	positions = verts;
+	matched = false;
+}
+
+void SkinPartitioner::setTriangles( const QVector<Triangle> & tris )
+{
+	triangles = tris;
+}
+
+void SkinPartitioner::setTrianglePartitions( const QVector<int> & partIndices )
+{
+	trianglePartitions = partIndices;
+}
+
+void SkinPartitioner::sortInfluences( int v )
+{
+	int * b = vertexBones.data() + size_t( v ) * stride;
+	float * w = vertexWeights.data() + size_t( v ) * stride;
+	int n = vertexCounts[v];
+
+	// insertion sort, there are only a few influences: descending weight, then ascending bone
+	for ( int i = 1; i < n; i++ ) {
+		int bone = b[i];
+		float weight = w[i];
+		int j = i;
+		for ( ; j > 0 && ( w[j - 1] < weight || ( w[j - 1] == weight && b[j - 1] > bone ) ); j-- ) {
+			b[j] = b[j - 1];
+			w[j] = w[j - 1];
+		}
+		b[j] = bone;
+		w[j] = weight;
+	}
+}
+
+bool SkinPartitioner::removeInfluence( int v, int bone, bool & removed )
+{
+	int * b = vertexBones.data() + size_t( v ) * stride;
+	float * w = vertexWeights.data() + size_t( v ) * stride;
+	int n = vertexCounts[v];
+
+	int k = 0;
+	for ( int i = 0; i < n; i++ ) {
+		if ( b[i] == bone ) {
+			removed = true;
+			continue;
+		}
+		b[k] = b[i];
+		w[k] = w[i];
+		k++;
+	}
+	vertexCounts[v] = k;
+
+	float totalWeight = 0.0f;
+	for ( int i = 0; i < k; i++ )
+		totalWeight += w[i];
+
+	if ( totalWeight == 0.0f )
+		return false;
+
+	for ( int i = 0; i < k; i++ )
+		w[i] /= totalWeight;
+
+	return true;
+}
+
+int SkinPartitioner::triangleBones( const Triangle & tri, int * bones ) const
+{
+	int n = 0;
+	for ( int c = 0; c < 3; c++ ) {
+		const int * b = vertexBones.data() + size_t( tri[c] ) * stride;
+		for ( int i = 0; i < vertexCounts[tri[c]]; i++ ) {
+			if ( std::find( bones, bones + n, b[i] ) == bones + n )
+				bones[n++] = b[i];
+		}
+	}
+
+	return n;
+}
+
+void SkinPartitioner::matchVertices()
+{
+	matched = true;
+	matchGroup.resize( size_t( numVerts ) );
+	for ( int v = 0; v < numVerts; v++ )
+		matchGroup[v] = v;
+
+	if ( positions.size() >= numVerts && numVerts > 0 ) {
+		auto equal = [this]( int a, int b ) {
+			int n = vertexCounts[a];
+			if ( n != vertexCounts[b] )
+				return false;
+
+			size_t ia = size_t( a ) * stride, ib = size_t( b ) * stride;
+			for ( int i = 0; i < n; i++ ) {
+				if ( vertexBones[ia + i] != vertexBones[ib + i] || vertexWeights[ia + i] != vertexWeights[ib + i] )
+					return false;
+			}
+			return true;
+		};
+
+		// the equality is transitive, so the last copy of a vertex represents all of them
+		std::vector<int> dup = findDuplicateVertices( &( positions.constFirst()[0] ), sizeof( Vector3 ) / sizeof( float ), size_t( numVerts ), equal );
+		for ( int v = 0; v < numVerts; v++ ) {
+			if ( dup[v] >= 0 )
+				matchGroup[v] = dup[v];
+		}
+	}
+
+	matchOffsets.assign( size_t( numVerts ) + 1, 0 );
+	for ( int v = 0; v < numVerts; v++ )
+		matchOffsets[matchGroup[v] + 1]++;
+	for ( int v = 0; v < numVerts; v++ )
+		matchOffsets[v + 1] += matchOffsets[v];
+
+	std::vector<int> fill( matchOffsets.begin(), matchOffsets.end() - 1 );
+	matchVerts.resize( size_t( numVerts ) );
+	for ( int v = 0; v < numVerts; v++ )
+		matchVerts[fill[matchGroup[v]]++] = v;
+}
+
+bool SkinPartitioner::fitTriangles( int maxBonesPerPartition )
+{
+	std::vector<int> tribones( size_t( stride ) * 3 );
+
+	for ( const Triangle & tri : triangles ) {
+		for ( ;; ) {
+			int n = triangleBones( tri, tribones.data() );
+			if ( n <= maxBonesPerPartition )
+				break;
+
+			// sum up the weights for each bone, bones with weight == 1 can't be removed
+			int minBone = -1;
+			float minWeight = 5.0f;
+
+			for ( int i = 0; i < n; i++ ) {
+				int bone = tribones[i];
+				float sum = 0.0f;
+				bool keep = false;
+
+				for ( int c = 0; c < 3; c++ ) {
+					const int * b = vertexBones.data() + size_t( tri[c] ) * stride;
+					const float * w = vertexWeights.data() + size_t( tri[c] ) * stride;
+					for ( int k = 0; k < vertexCounts[tri[c]]; k++ ) {
+						if ( b[k] == bone ) {
+							sum += w[k];
+							keep = keep || ( vertexCounts[tri[c]] == 1 );
+						}
+					}
+				}
+
+				if ( !keep && ( sum < minWeight || ( sum == minWeight && bone < minBone ) ) ) {
+					minWeight = sum;
+					minBone = bone;
+				}
+			}
+
+			if ( minBone < 0 ) { // this shouldn't never happen
+				errorText = "internal error 0x01";
+				return false;
+			}
+
+			if ( !matched )
+				matchVertices();
+
+			// now remove that bone from all vertices of this triangle and from all matching vertices too
+			for ( int c = 0; c < 3; c++ ) {
+				bool removed = false;
+				int group = matchGroup[tri[c]];
+
+				for ( int i = matchOffsets[group]; i < matchOffsets[group + 1]; i++ ) {
+					if ( !removeInfluence( matchVerts[i], minBone, removed ) ) {
+						errorText = "internal error 0x02";
+						return false;
+					}
+				}
+
+				if ( removed )
+					numRemoved++;
+			}
+		}
+	}
+
+	return true;
+}
+
+void SkinPartitioner::clusterTriangles( int maxBonesPerPartition, std::vector<char> & assigned )
+{
+	qsizetype numTris = triangles.size();
+
+	// the bones of each triangle
+	std::vector<int> triBoneOffsets( size_t( numTris ) + 1, 0 );
+	std::vector<int> triBoneList;
+	triBoneList.reserve( size_t( numTris ) * 3 );
+	{
+		std::vector<int> tribones( size_t( stride ) * 3 );
+		for ( qsizetype t = 0; t < numTris; t++ ) {
+			int n = triangleBones( triangles.at( t ), tribones.data() );
+			triBoneList.insert( triBoneList.end(), tribones.begin(), tribones.begin() + n );
+			triBoneOffsets[t + 1] = int( triBoneList.size() );
+		}
+	}
+
+	// the triangles of each vertex
+	std::vector<int> vertTriOffsets( size_t( numVerts ) + 1, 0 );
+	std::vector<int> vertTris( size_t( numTris ) * 3 );
+	for ( const Triangle & tri : triangles ) {
+		for ( int c = 0; c < 3; c++ )
+			vertTriOffsets[tri[c] + 1]++;
+	}
+	for ( int v = 0; v < numVerts; v++ )
+		vertTriOffsets[v + 1] += vertTriOffsets[v];
+	{
+		std::vector<int> fill( vertTriOffsets.begin(), vertTriOffsets.end() - 1 );
+		for ( qsizetype t = 0; t < numTris; t++ ) {
+			for ( int c = 0; c < 3; c++ )
+				vertTris[fill[triangles.at( t )[c]]++] = int( t );
+		}
+	}
+
+	// grow each partition from the first unassigned triangle over the triangles sharing a vertex with it,
+	// a triangle that does not fit is left for a later partition
+	std::vector<int> seenBy( size_t( numTris ), -1 );
+	std::vector<char> inPart( size_t( numBones ), 0 );
+	std::vector<int> queue;
+
+	for ( qsizetype seed = 0; seed < numTris; seed++ ) {
+		if ( assigned[seed] )
+			continue;
+
+		int p = int( parts.size() );
+		parts.append( Partition() );
+		Partition & part = parts.last();
+		std::vector<int> bones;
+
+		queue.clear();
+		queue.push_back( int( seed ) );
+		seenBy[seed] = p;
+
+		for ( size_t q = 0; q < queue.size(); q++ ) {
+			int t = queue[q];
+
+			int added = 0;
+			for ( int i = triBoneOffsets[t]; i < triBoneOffsets[t + 1]; i++ ) {
+				if ( !inPart[triBoneList[i]] )
+					added++;
+			}
+			if ( int( bones.size() ) + added > maxBonesPerPartition )
+				continue;
+
+			for ( int i = triBoneOffsets[t]; i < triBoneOffsets[t + 1]; i++ ) {
+				if ( !inPart[triBoneList[i]] ) {
+					inPart[triBoneList[i]] = 1;
+					bones.push_back( triBoneList[i] );
+				}
+			}
+			part.triangles.append( triangles.at( t ) );
+			assigned[t] = 1;
+
+			const Triangle & tri = triangles.at( t );
+			for ( int c = 0; c < 3; c++ ) {
+				for ( int i = vertTriOffsets[tri[c]]; i < vertTriOffsets[tri[c] + 1]; i++ ) {
+					int u = vertTris[i];
+					if ( !assigned[u] && seenBy[u] != p ) {
+						seenBy[u] = p;
+						queue.push_back( u );
+					}
+				}
+			}
+		}
+
+		for ( int b : bones )
+			inPart[b] = 0;
+
+		std::sort( bones.begin(), bones.end() );
+		part.bones = QList<int>( bones.begin(), bones.end() );
+	}
+}
+
+void SkinPartitioner::assignTriangles( std::vector<char> & assigned )
+{
+	std::vector<std::vector<int>> partBones;
+	std::vector<int> tribones( size_t( stride ) * 3 );
+
+	for ( qsizetype t = 0; t < triangles.size(); t++ ) {
+		int p = trianglePartitions.value( t, -1 );
+		if ( p < 0 )
+			continue;
+
+		while ( p >= parts.size() ) {
+			parts.append( Partition() );
+			partBones.emplace_back();
+		}
+
+		int n = triangleBones( triangles.at( t ), tribones.data() );
+		partBones[p].insert( partBones[p].end(), tribones.begin(), tribones.begin() + n );
+		parts[p].triangles.append( triangles.at( t ) );
+		assigned[t] = 1;
+	}
+
+	for ( qsizetype p = 0; p < parts.size(); p++ ) {
+		std::vector<int> & bones = partBones[p];
+		std::sort( bones.begin(), bones.end() );
+		bones.erase( std::unique( bones.begin(), bones.end() ), bones.end() );
+		parts[p].bones = QList<int>( bones.begin(), bones.end() );
+	}
+}
+
+//! The number of distinct bones in two sorted bone lists
+static qsizetype unionCount( const QList<int> & a, const QList<int> & b )
+{
+	qsizetype n = 0;
+	auto i = a.cbegin(), j = b.cbegin();
+	while ( i != a.cend() && j != b.cend() ) {
+		if ( *i < *j )
+			i++;
+		else if ( *j < *i )
+			j++;
+		else
+			i++, j++;
+		n++;
+	}
+
+	return n + ( a.cend() - i ) + ( b.cend() - j );
+}
+
+void SkinPartitioner::mergePartitions( int maxBonesPerPartition )
+{
+	// Merging only ever grows the first partition, so a pair that does not fit once never fits later,
+	// and a single pass gives the same result as restarting after every merge.
+	// A full partition can still take in the partitions whose bones it already has.
+	std::vector<char> removed( size_t( parts.size() ), 0 );
+
+	for ( qsizetype p1 = 0; p1 < parts.size(); p1++ ) {
+		if ( removed[p1] )
+			continue;
+
+		for ( qsizetype p2 = p1 + 1; p2 < parts.size(); p2++ ) {
+			if ( removed[p2] || unionCount( parts[p1].bones, parts[p2].bones ) > maxBonesPerPartition )
+				continue;
+
+			QList<int> merged;
+			merged.reserve( maxBonesPerPartition );
+			std::set_union( parts[p1].bones.cbegin(), parts[p1].bones.cend(), parts[p2].bones.cbegin(), parts[p2].bones.cend(),
+							std::back_inserter( merged ) );
+			parts[p1].bones = merged;
+			parts[p1].triangles << parts[p2].triangles;
+			parts[p2] = Partition();
+			removed[p2] = 1;
+		}
+	}
+
+	QVector<Partition> kept;
+	for ( qsizetype p = 0; p < parts.size(); p++ ) {
+		if ( !removed[p] )
+			kept.append( std::move( parts[p] ) );
+	}
+	parts = std::move( kept );
+}
+
+bool SkinPartitioner::run( int maxBonesPerPartition, int maxBonesPerVertex )
+{
+	parts.clear();
+	errorText.clear();
+	numReduced = numRemoved = 0;
+
+	for ( const Triangle & tri : triangles ) {
+		if ( tri[0] >= numVerts || tri[1] >= numVerts || tri[2] >= numVerts ) {
+			errorText = "bad triangle - vertex index out of range";
+			return false;
+		}
+	}
+
+	// reduce vertex influences if necessary
+	if ( maxBones > maxBonesPerVertex ) {
+		for ( int v = 0; v < numVerts; v++ ) {
+			sortInfluences( v );
+			if ( vertexCounts[v] > maxBonesPerVertex ) {
+				vertexCounts[v] = maxBonesPerVertex;
+				numReduced++;
+			}
+
+			float * w = vertexWeights.data() + size_t( v ) * stride;
+			float totalWeight = 0.0f;
+			for ( int i = 0; i < vertexCounts[v]; i++ )
+				totalWeight += w[i];
+			for ( int i = 0; i < vertexCounts[v]; i++ )
+				w[i] /= totalWeight;
+		}
+		matched = false;
+	}
+
+	// reduce bone weights so that the triangles fit into the partitions
+	if ( !fitTriangles( maxBonesPerPartition ) )
+		return false;
+
+	// split the triangles into partitions, an explicit mapping does not allow merging
+	std::vector<char> assigned( size_t( triangles.size() ), 0 );
+	if ( !trianglePartitions.isEmpty() ) {
+		assignTriangles( assigned );
+		clusterTriangles( maxBonesPerPartition, assigned );
+	} else {
+		clusterTriangles( maxBonesPerPartition, assigned );
+		mergePartitions( maxBonesPerPartition );
+	}
+
+	for ( int v = 0; v < numVerts; v++ )
+		sortInfluences( v );
+
+	return true;
+}
+
+void SkinPartitioner::run( const QVector<SkinPartitioner *> & partitioners, int maxBonesPerPartition, int maxBonesPerVertex )
+{
+	std::atomic<qsizetype> next( 0 );
+	auto worker = [&]() {
+		for ( qsizetype i; ( i = next.fetch_add( 1 ) ) < partitioners.size(); )
+			partitioners.at( i )->run( maxBonesPerPartition, maxBonesPerVertex );
+	};
+
+	qsizetype numThreads = std::min( qsizetype( std::max( QThread::idealThreadCount(), 1 ) ), partitioners.size() );
+
+	QList<QThread *> threads;
+	for ( qsizetype i = 1; i < numThreads; i++ ) {
+		QThread * thread = QThread::create( worker );
+		thread->start();
+		threads.append( thread );
+	}
+
+	worker();
+
+	for ( QThread * thread : threads ) {
+		thread->wait();
+		delete thread;
+	}
+}
@@ -0,0 +1,159 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef SKINPARTITION_H
+#define SKINPARTITION_H
+
+#include "data/niftypes.h"
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include <vector>
+
+
+//! @file skinpartition.h SkinPartitioner
+
+//! Splits a skinned triangle mesh into partitions that each use a limited number of bones
+/*!
+ * This is the model independent part of "Make Skin Partition", so that several shapes can be partitioned
+ * on worker threads. The influences are kept in flat per-vertex arrays, vertices with the same position
+ * and weights are matched through a hash of their positions, and the triangles are clustered by growing
+ * each partition over the triangles adjacent to it, which is linear in the number of triangles.
+ */
+class SkinPartitioner final
+{
+public:
+	//! One bone influence, as read from the `Vertex Weights` of NiSkinData
+	struct VertexWeight
+	{
+		int vertex;
+		int bone;
+		float weight;
+	};
+
+	//! A set of triangles and the bones they use
+	struct Partition
+	{
+		//! The bones in ascending order
+		QList<int> bones;
+		//! The triangles with the vertex numbers of the shape
+		QVector<Triangle> triangles;
+	};
+
+	/*! Sets the influences of every vertex
+	 *
+	 * @param numVertices	The number of vertices of the shape
+	 * @param weights		The influences, in bone order
+	 * @return False if an influence refers to a vertex that does not exist
+	 */
+	bool setWeights( int numVertices, const QVector<VertexWeight> & weights );
+	//! Sets the vertex positions used to find the copies of a vertex along seams
+	void setVertices( const QVector<Vector3> & verts );
+	//! Sets the triangles to partition
+	void setTriangles( const QVector<Triangle> & tris );
+	/*! Assigns every triangle to a fixed partition instead of clustering them
+	 *
+	 * @param parts	The partition of each triangle, in the order of setTriangles()
+	 */
+	void setTrianglePartitions( const QVector<int> & parts );
+
+	//! The smallest number of influences of any vertex
+	int minBonesPerVertex() const { return minBones; }
+	//! The largest number of influences of any vertex
+	int maxBonesPerVertex() const { return maxBones; }
+
+	/*! Runs the partitioning
+	 *
+	 * @return False on an error, see error()
+	 */
+	bool run( int maxBonesPerPartition, int maxBonesPerVertex );
+	//! Runs several independent partitioners on all cores
+	static void run( const QVector<SkinPartitioner *> & partitioners, int maxBonesPerPartition, int maxBonesPerVertex );
+
+	QString error() const { return errorText; }
+
+	//! The number of vertices that had too many influences
+	int reducedVertices() const { return numReduced; }
+	//! The number of influences removed so that every triangle fits into a partition
+	int removedInfluences() const { return numRemoved; }
+
+	const QVector<Partition> & partitions() const { return parts; }
+
+	//! The number of influences of vertex \a v after run(), sorted by descending weight
+	int influenceCount( int v ) const { return vertexCounts[v]; }
+	int influenceBone( int v, int i ) const { return vertexBones[size_t( v ) * stride + i]; }
+	float influenceWeight( int v, int i ) const { return vertexWeights[size_t( v ) * stride + i]; }
+
+private:
+	//! Sorts the influences of vertex \a v in the order used by the NiSkinPartition
+	void sortInfluences( int v );
+	//! Removes \a bone from vertex \a v and normalizes its weights
+	bool removeInfluence( int v, int bone, bool & removed );
+	//! Collects the distinct bones of triangle \a tri in order of appearance
+	int triangleBones( const Triangle & tri, int * bones ) const;
+	//! Removes the weakest bones from the triangles that use more than \a maxBonesPerPartition bones
+	bool fitTriangles( int maxBonesPerPartition );
+	//! Groups the vertices with identical positions and weights
+	void matchVertices();
+	//! Grows partitions over adjacent triangles that are not \a assigned yet
+	void clusterTriangles( int maxBonesPerPartition, std::vector<char> & assigned );
+	//! Adds the triangles to the partitions set by setTrianglePartitions()
+	void assignTriangles( std::vector<char> & assigned );
+	//! Merges partitions while the merged bones fit
+	void mergePartitions( int maxBonesPerPartition );
+
+	int numVerts = 0;
+	int numBones = 0;
+	int stride = 0;
+	int minBones = 0, maxBones = 0;
+
+	std::vector<int> vertexBones;
+	std::vector<float> vertexWeights;
+	std::vector<int> vertexCounts;
+
+	QVector<Vector3> positions;
+	QVector<Triangle> triangles;
+	QVector<int> trianglePartitions;
+
+	//! The vertices of each match group, and the group of each vertex
+	std::vector<int> matchOffsets, matchVerts, matchGroup;
+	bool matched = false;
+
+	QVector<Partition> parts;
+	QString errorText;
+	int numReduced = 0;
+	int numRemoved = 0;
+};
+
+#endif
@@ -0,0 +1,235 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "spatialhash.h"
+
+#include "libfo76utils/src/fp32vec4.hpp"
+
+#include <QList>
+#include <QThread>
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+
+//! @file spatialhash.cpp SpatialHash, smoothVertexNormals, findDuplicateVertices
+
+SpatialHash::SpatialHash( const float * verts, size_t stride, size_t numVerts, double cellSize )
+	: cells( numVerts )
+{
+	// Clamping far away cells together only adds candidates, which are tested by the caller
+	constexpr double maxCell = 1.0e15;
+	bool uniform = !( cellSize > 0.0 && std::isfinite( cellSize ) );
+	double invSize = uniform ? 0.0 : 1.0 / cellSize;
+
+	entries.reserve( numVerts );
+	const float * p = verts;
+	for ( size_t i = 0; i < numVerts; i++, p += stride ) {
+		if ( !( std::isfinite( p[0] ) && std::isfinite( p[1] ) && std::isfinite( p[2] ) ) )
+			continue;
+
+		Cell & c = cells[i];
+		if ( !uniform ) {
+			c.x = std::int64_t( std::clamp( std::floor( double( p[0] ) * invSize ), -maxCell, maxCell ) );
+			c.y = std::int64_t( std::clamp( std::floor( double( p[1] ) * invSize ), -maxCell, maxCell ) );
+			c.z = std::int64_t( std::clamp( std::floor( double( p[2] ) * invSize ), -maxCell, maxCell ) );
+		}
+		c.valid = true;
+		entries.push_back( { c.x, c.y, c.z, std::uint32_t( i ) } );
+	}
+
+	std::sort( entries.begin(), entries.end() );
+}
+
+void SpatialHash::parallelFor( size_t n, const std::function<void ( size_t, size_t )> & func )
+{
+	constexpr size_t chunkSize = 1024;
+
+	size_t numThreads = std::min( size_t( std::max( QThread::idealThreadCount(), 1 ) ), ( n + chunkSize - 1 ) / chunkSize );
+	if ( numThreads <= 1 ) {
+		func( 0, n );
+		return;
+	}
+
+	std::atomic<size_t> next( 0 );
+	auto worker = [n, &func, &next]() {
+		for ( size_t begin; ( begin = next.fetch_add( chunkSize ) ) < n; )
+			func( begin, std::min( begin + chunkSize, n ) );
+	};
+
+	QList<QThread *> threads;
+	for ( size_t i = 1; i < numThreads; i++ ) {
+		QThread * thread = QThread::create( worker );
+		thread->start();
+		threads.append( thread );
+	}
+
+	worker();
+
+	for ( QThread * thread : threads ) {
+		thread->wait();
+		delete thread;
+	}
+}
+
+void smoothVertexNormals( float * snorms, size_t snormSize, float * norms, const float * verts, size_t numVerts, float maxa, float maxd )
+{
+	constexpr size_t normStride = 3;
+	size_t	snormStride = snormSize / sizeof( float );
+
+	float *	np = norms;
+	float *	sp = snorms;
+	for ( size_t i = 0; i < numVerts; i++, np += normStride, sp += snormStride ) {
+		FloatVector4	n( np );
+		float	r2 = n.dotProduct3( n );
+		if ( !( r2 > 0.999999f && r2 < 1.000001f ) ) {
+			// make sure that input data is normalized
+			if ( r2 > 0.0f )
+				n /= float( std::sqrt( r2 ) );
+			else
+				n = FloatVector4( 0.0f, 0.0f, 1.0f, 0.0f );
+			n.convertToVector3( np );
+		}
+		n.convertToVector3( sp );
+	}
+
+	// A pair closer than sqrt( maxd ) is always in neighbouring cells, the margin covers rounding errors
+	bool	havePairs = ( maxd > 0.0f );
+	SpatialHash	grid( verts, normStride, havePairs ? numVerts : 0, std::sqrt( double( maxd ) ) * 1.001 );
+
+	SpatialHash::parallelFor( numVerts, [=, &grid]( size_t begin, size_t end ) {
+		std::vector<size_t>	near;
+		for ( size_t i = begin; i < end; i++ ) {
+			near.clear();
+			if ( havePairs ) {
+				grid.forEachNear( i, [=, &near]( size_t j ) {
+					if ( j == i )
+						return;
+					// Test the pair in the same order as the pairwise search, so that the results are identical
+					size_t	lo = std::min( i, j );
+					size_t	hi = std::max( i, j );
+					FloatVector4	b( verts + hi * normStride );
+					b -= FloatVector4( verts + lo * normStride );
+					if ( !( b.dotProduct3( b ) < maxd ) ) [[likely]]
+						return;
+					if ( FloatVector4( norms + lo * normStride ).dotProduct3( FloatVector4( norms + hi * normStride ) ) > maxa )
+						near.push_back( j );
+				} );
+				std::sort( near.begin(), near.end() );
+			}
+
+			FloatVector4	sn( norms + i * normStride );
+			for ( size_t j : near )
+				sn += FloatVector4( norms + j * normStride );
+
+			float	r2 = sn.dotProduct3( sn );
+			if ( r2 > 0.0f )
+				sn /= float( std::sqrt( r2 ) );
+			else
+				sn = FloatVector4( 0.0f, 0.0f, 1.0f, 0.0f );
+			sn.convertToVector3( snorms + i * snormStride );
+		}
+	} );
+}
+
+std::vector<int> findDuplicateVertices( const float * verts, size_t stride, size_t numVerts, const std::function<bool ( int, int )> & equal )
+{
+	std::vector<int> result( numVerts, -1 );
+
+	// Positions compare equal if their bits are identical once -0.0 is replaced with 0.0, NaN is never equal
+	struct Key
+	{
+		std::uint32_t x, y, z;
+		int index;
+
+		bool samePosition( const Key & k ) const { return x == k.x && y == k.y && z == k.z; }
+		bool operator<( const Key & k ) const
+		{
+			if ( x != k.x )
+				return x < k.x;
+			if ( y != k.y )
+				return y < k.y;
+			if ( z != k.z )
+				return z < k.z;
+			return index < k.index;
+		}
+	};
+
+	auto bits = []( float f ) {
+		std::uint32_t n;
+		f = ( f == 0.0f ) ? 0.0f : f;
+		std::memcpy( &n, &f, sizeof( n ) );
+		return n;
+	};
+
+	std::vector<Key> keys;
+	keys.reserve( numVerts );
+	const float * p = verts;
+	for ( size_t i = 0; i < numVerts; i++, p += stride ) {
+		if ( std::isnan( p[0] ) || std::isnan( p[1] ) || std::isnan( p[2] ) )
+			continue;
+		keys.push_back( { bits( p[0] ), bits( p[1] ), bits( p[2] ), int( i ) } );
+	}
+	std::sort( keys.begin(), keys.end() );
+
+	// Start of each group of more than one vertex at the same position, the indices are ascending within a group
+	std::vector<size_t> groups;
+	for ( size_t i = 0; i + 1 < keys.size(); ) {
+		size_t j = i + 1;
+		while ( j < keys.size() && keys[j].samePosition( keys[i] ) )
+			j++;
+		if ( j - i > 1 )
+			groups.push_back( i );
+		i = j;
+	}
+
+	SpatialHash::parallelFor( groups.size(), [&]( size_t begin, size_t end ) {
+		for ( size_t g = begin; g < end; g++ ) {
+			size_t first = groups[g];
+			size_t last = first + 1;
+			while ( last < keys.size() && keys[last].samePosition( keys[first] ) )
+				last++;
+
+			for ( size_t b = first; b + 1 < last; b++ ) {
+				for ( size_t a = last - 1; a > b; a-- ) {
+					if ( equal( keys[a].index, keys[b].index ) ) {
+						result[size_t( keys[b].index )] = keys[a].index;
+						break;
+					}
+				}
+			}
+		}
+	} );
+
+	return result;
+}
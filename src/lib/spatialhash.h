@@ -0,0 +1,128 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+//! @file spatialhash.h SpatialHash, smoothVertexNormals, findDuplicateVertices
+
+//! Vertices sorted by the cells of a uniform grid, for finding the vertices within a distance of each other
+class SpatialHash final
+{
+public:
+	/*! Builds the grid
+	 *
+	 * @param verts		Positions, three floats at every \a stride floats
+	 * @param numVerts	Number of positions
+	 * @param cellSize	Size of the cells, at least the search distance; if it is not finite, all vertices share one cell
+	 *
+	 * Vertices with a position that is not finite are left out, they are never within a distance of another vertex.
+	 */
+	SpatialHash( const float * verts, size_t stride, size_t numVerts, double cellSize );
+
+	//! Calls \a func( j ) for every vertex j in the 27 cells around vertex \a i, including \a i itself
+	template <typename Func> void forEachNear( size_t i, Func func ) const
+	{
+		const Cell & c = cells[i];
+		if ( !c.valid )
+			return;
+
+		for ( int dx = -1; dx <= 1; dx++ ) {
+			for ( int dy = -1; dy <= 1; dy++ ) {
+				// The three cells along z are adjacent in the sort order
+				Entry lo{ c.x + dx, c.y + dy, c.z - 1, 0 };
+				auto it = std::lower_bound( entries.begin(), entries.end(), lo );
+				for ( ; it != entries.end() && it->x == lo.x && it->y == lo.y && it->z <= c.z + 1; it++ )
+					func( size_t( it->index ) );
+			}
+		}
+	}
+
+	//! Runs \a func( begin, end ) over ranges of [0, \a n) on all cores, or inline if \a n is small
+	static void parallelFor( size_t n, const std::function<void ( size_t, size_t )> & func );
+
+private:
+	struct Cell
+	{
+		std::int64_t x = 0, y = 0, z = 0;
+		bool valid = false;
+	};
+
+	struct Entry
+	{
+		std::int64_t x, y, z;
+		std::uint32_t index;
+
+		bool operator<( const Entry & e ) const
+		{
+			if ( x != e.x )
+				return x < e.x;
+			if ( y != e.y )
+				return y < e.y;
+			if ( z != e.z )
+				return z < e.z;
+			return index < e.index;
+		}
+	};
+
+	std::vector<Cell> cells;
+	std::vector<Entry> entries;
+};
+
+/*! Averages the normals of the vertices that are closer than sqrt( \a maxd ) and whose normals differ by less than acos( \a maxa )
+ *
+ * @param snorms	Output normals, every \a snormSize bytes; only the first three floats are written
+ * @param norms		Input normals with a stride of three floats, normalized in place
+ * @param verts		Positions with a stride of three floats
+ *
+ * Both \a norms and \a verts must have one more element than \a numVerts, because four floats are read at a time.
+ * The normal of each vertex is its own normal plus the normals of its neighbours in ascending order, normalized.
+ */
+void smoothVertexNormals( float * snorms, size_t snormSize, float * norms, const float * verts, size_t numVerts, float maxa, float maxd );
+
+/*! Finds the vertices that have a later duplicate
+ *
+ * @param verts		Positions
+ * @param equal		Compares the other attributes of two vertices with the same position
+ * @return For each vertex b, the last vertex a > b with an identical position and equal( a, b ), or -1
+ */
+std::vector<int> findDuplicateVertices( const float * verts, size_t stride, size_t numVerts, const std::function<bool ( int, int )> & equal );
+
+#endif
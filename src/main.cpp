@@ -30,20 +30,23 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 ***** END LICENCE BLOCK *****/
 
+#include "batchprocessor.h"
 #include "nifskope.h"
+#include "spellbook.h"
 #include "version.h"
 #include "data/nifvalue.h"
+#include "io/nifindex.h"
 #include "model/nifmodel.h"
 #include "model/kfmmodel.h"
 
 #include <QApplication>
 #include <QCommandLineParser>
-#include <QDesktopServices>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QSettings>
 #include <QStack>
-#include <QUdpSocket>
-#include <QUrl>
+#include <QTextStream>
 
 
 QCoreApplication * createApplication( int &argc, char *argv[] )
@@ -55,7 +58,11 @@ QCoreApplication * createApplication( int &argc, char *argv[] )
 	// Iterate over args
 	for ( int i = 1; i < argc; ++i ) {
 		// -no-gui: start as core app without all the GUI overhead
-		if ( !qstrcmp( argv[i], "-no-gui" ) ) {
+		// --batch, --index, --query: command line tools, imply -no-gui
+		if ( !qstrcmp( argv[i], "-no-gui" )
+			|| !qstrcmp( argv[i], "--batch" ) || !qstrcmp( argv[i], "-batch" )
+			|| !qstrcmp( argv[i], "--index" ) || !qstrcmp( argv[i], "-index" )
+			|| !qstrcmp( argv[i], "--query" ) || !qstrcmp( argv[i], "-query" ) ) {
 			return new QCoreApplication( argc, argv );
 		}
 	}
@@ -63,6 +70,129 @@ QCoreApplication * createApplication( int &argc, char *argv[] )
 }
 
 
+/*
+ *  Command line batch mode
+ */
+
+//! Casts a spell on every NIF file under a folder: nifskope --batch <spell> <root>
+//! or updates and searches the file index of a folder or game: nifskope --index --query <terms> <root>
+static int runBatch( QCoreApplication * a )
+{
+	// Same names as the GUI so that the game paths and NIF settings are shared
+	a->setOrganizationName( "NifTools" );
+	a->setOrganizationDomain( "niftools.org" );
+	a->setApplicationName( "NifSkope " + NifSkopeVersion::rawToMajMin( NIFSKOPE_VERSION ) );
+	a->setApplicationVersion( NIFSKOPE_VERSION );
+
+	QCommandLineParser parser;
+	parser.setSingleDashWordOptionMode( QCommandLineParser::ParseAsLongOptions );
+	parser.setApplicationDescription( "Casts a spell on every NIF file under a folder, without opening any windows." );
+	parser.addHelpOption();
+	parser.addVersionOption();
+
+	QCommandLineOption noGuiOption( "no-gui", "Start without the GUI" );
+	parser.addOption( noGuiOption );
+	QCommandLineOption batchOption( "batch", "Spell to cast, as \"Page/Name\" for spells on a sub-menu", "spell" );
+	parser.addOption( batchOption );
+	QCommandLineOption logOption( "log", "Log file, defaults to batch_log_<date>.txt in the root folder", "file" );
+	parser.addOption( logOption );
+	QCommandLineOption threadsOption( "threads", "Number of worker threads, defaults to one per core", "count" );
+	parser.addOption( threadsOption );
+	QCommandLineOption indexOption( "index", "Create or update the file index of the root folder, or of the archives of a game if root is \"game:<name>\"" );
+	parser.addOption( indexOption );
+	QCommandLineOption queryOption( "query", "Print the indexed files that match all terms, as block:<type>, path:<path> or value:<field>=<value>", "terms" );
+	parser.addOption( queryOption );
+	parser.addPositionalArgument( "root", "Folder to process, including subfolders, or \"game:<name>\" for the index" );
+
+	parser.process( *a );
+
+	// Nothing to do without a spell or index
+	if ( !parser.isSet( batchOption ) && !parser.isSet( indexOption ) && !parser.isSet( queryOption ) )
+		return 0;
+
+	if ( parser.positionalArguments().size() != 1 )
+		parser.showHelp( 1 );
+
+	QTextStream out( stdout );
+	QTextStream err( stderr );
+
+	if ( !NifModel::loadXML() )
+		return 1;
+
+	// Init game manager
+	(void) Game::GameManager::get();
+
+	QString rootFolder = parser.positionalArguments().at( 0 );
+	if ( !rootFolder.startsWith( "game:", Qt::CaseInsensitive ) )
+		rootFolder = QDir::current().absoluteFilePath( rootFolder );
+
+	if ( parser.isSet( indexOption ) || parser.isSet( queryOption ) ) {
+		NifIndex index( rootFolder );
+		bool indexLoaded = index.load();
+		if ( parser.isSet( indexOption ) ) {
+			int threadCount = parser.isSet( threadsOption ) ? parser.value( threadsOption ).toInt() : 0;
+			if ( !index.update( threadCount ) ) {
+				err << "Source does not exist: " << rootFolder << "\n";
+				return 1;
+			}
+			const NifIndex::UpdateStatistics & stats = index.statistics();
+			err << QString( "Indexed %1 files, %2 loaded, %3 failed, %4 terms in %5 s\n" )
+					.arg( stats.filesTotal ).arg( stats.filesLoaded ).arg( stats.filesFailed )
+					.arg( index.termCount() ).arg( stats.seconds, 0, 'f', 3 );
+		} else if ( !indexLoaded ) {
+			err << "No index for " << rootFolder << ", create it with --index\n";
+			return 1;
+		}
+
+		if ( parser.isSet( queryOption ) ) {
+			QElapsedTimer timer;
+			timer.start();
+			QStringList files = index.query( NifIndex::parseQuery( parser.value( queryOption ) ) );
+			qint64 t = timer.nsecsElapsed();
+			for ( const QString & f : files )
+				out << f << "\n";
+			out.flush();
+			err << QString( "%1 of %2 files match, %3 ms\n" ).arg( files.size() ).arg( index.fileCount() ).arg( double( t ) / 1.0e6, 0, 'f', 3 );
+		}
+		return 0;
+	}
+
+	SpellPtr spell = SpellBook::lookup( parser.value( batchOption ) );
+	if ( !spell ) {
+		err << "Unknown spell: " << parser.value( batchOption ) << "\n" << "Available spells:\n";
+		for ( SpellPtr s : SpellBook::spells() ) {
+			if ( s->page().isEmpty() )
+				err << "  " << s->name() << "\n";
+			else
+				err << "  " << s->page() << "/" << s->name() << "\n";
+		}
+		return 1;
+	}
+
+	BatchProcessor batch( spell.get(), rootFolder );
+	if ( parser.isSet( threadsOption ) )
+		batch.setThreadCount( parser.value( threadsOption ).toInt() );
+	if ( !batch.run() ) {
+		err << "Folder does not exist: " << rootFolder << "\n";
+		return 1;
+	}
+
+	QString logFileName = parser.value( logOption );
+	if ( logFileName.isEmpty() ) {
+		logFileName = QDir( rootFolder ).filePath(
+			QString( "batch_log_%1.txt" ).arg( QDateTime::currentDateTime().toString( "yyyy-MM-dd_hh-mm-ss" ) )
+		);
+	}
+
+	if ( !batch.writeLog( logFileName ) )
+		err << "Failed to create log file: " << logFileName << "\n";
+
+	out << batch.summary() << "\n";
+
+	return ( batch.filesFailed() > 0 ) ? 1 : 0;
+}
+
+
 /*
  *  main
  */
@@ -73,6 +203,9 @@ int main( int argc, char * argv[] )
 	QScopedPointer<QCoreApplication> app( createApplication( argc, argv ) );
 
 	if ( auto a = qobject_cast<QApplication *>(app.data()) ) {
+		QElapsedTimer startupTimer;
+		startupTimer.start();
+
 		a->setOrganizationName( "NifTools" );
 		a->setOrganizationDomain( "niftools.org" );
 		a->setApplicationName( "NifSkope " + NifSkopeVersion::rawToMajMin( NIFSKOPE_VERSION ) );
@@ -103,11 +236,15 @@ int main( int argc, char * argv[] )
 		cfg.endGroup();
 
 		// Load XML files
+		qint64 tStart = startupTimer.nsecsElapsed();
 		NifModel::loadXML();
+		qint64 tNifXml = startupTimer.nsecsElapsed();
 		KfmModel::loadXML();
+		qint64 tKfmXml = startupTimer.nsecsElapsed();
 
 		// Init game manager
 		(void) Game::GameManager::get();
+		qint64 tGames = startupTimer.nsecsElapsed();
 
 		int port = NIFSKOPE_IPC_PORT;
 
@@ -121,6 +258,8 @@ int main( int argc, char * argv[] )
 		// Add port option
 		QCommandLineOption portOption( {"p", "port"}, "Port NifSkope listens on", "port" );
 		parser.addOption( portOption );
+		QCommandLineOption timingOption( "startup-timing", "Print the time spent on each startup step" );
+		parser.addOption( timingOption );
 
 		// Process options
 		parser.process( *a );
@@ -151,6 +290,15 @@ int main( int argc, char * argv[] )
 				IPCsocket::sendCommand( QString( "NifSkope::open %1" ).arg( fnames.pop() ), port );
 			}
 
+			if ( parser.isSet( timingOption ) ) {
+				qint64 tWindow = startupTimer.nsecsElapsed();
+				auto ms = []( qint64 t ) { return QString::number( double( t ) / 1.0e6, 'f', 1 ); };
+				qInfo().noquote() << QString( "Startup: %1 ms total, settings %2 ms, nif.xml %3 ms (%4), kfm.xml %5 ms, games %6 ms, window %7 ms" )
+					.arg( ms( tWindow ), ms( tStart ), ms( tNifXml - tStart ) )
+					.arg( NifModel::lastXmlLoadFromCache() ? "cached" : "parsed" )
+					.arg( ms( tKfmXml - tNifXml ), ms( tGames - tKfmXml ), ms( tWindow - tGames ) );
+			}
+
 			return a->exec();
 		} else {
 			//qDebug() << "IPCSocket send";
@@ -160,81 +308,8 @@ int main( int argc, char * argv[] )
 			return 0;
 		}
 	} else {
-		// Future command line batch tools here
+		return runBatch( app.data() );
 	}
 
 	return 0;
 }
-
-
-
-/*
-*  IPC socket
-*/
-
-IPCsocket * IPCsocket::create( int port )
-{
-	QUdpSocket * udp = new QUdpSocket();
-
-	if ( udp->bind( QHostAddress( QHostAddress::LocalHost ), port, QUdpSocket::DontShareAddress ) ) {
-		IPCsocket * ipc = new IPCsocket( udp );
-		QDesktopServices::setUrlHandler( "nif", ipc, "openNif" );
-		return ipc;
-	}
-
-	return nullptr;
-}
-
-void IPCsocket::sendCommand( const QString & cmd, int port )
-{
-	QUdpSocket udp;
-	udp.writeDatagram( (const char *)cmd.data(), cmd.length() * sizeof( QChar ), QHostAddress( QHostAddress::LocalHost ), port );
-}
-
-IPCsocket::IPCsocket( QUdpSocket * s ) : QObject(), socket( s )
-{
-	QObject::connect( socket, &QUdpSocket::readyRead, this, &IPCsocket::processDatagram );
-}
-
-IPCsocket::~IPCsocket()
-{
-	delete socket;
-}
-
-void IPCsocket::processDatagram()
-{
-	while ( socket->hasPendingDatagrams() ) {
-		QByteArray data;
-		data.resize( socket->pendingDatagramSize() );
-		QHostAddress host;
-		quint16 port = 0;
-
-		socket->readDatagram( data.data(), data.size(), &host, &port );
-
-		if ( host == QHostAddress( QHostAddress::LocalHost ) && (data.size() % sizeof( QChar )) == 0 ) {
-			QString cmd;
-			cmd.setUnicode( (QChar *)data.data(), data.size() / sizeof( QChar ) );
-			execCommand( cmd );
-		}
-	}
-}
-
-void IPCsocket::execCommand( const QString & cmd )
-{
-	if ( cmd.startsWith( "NifSkope::open" ) ) {
-		openNif( cmd.right( cmd.length() - 15 ) );
-	}
-}
-
-void IPCsocket::openNif( const QUrl & url )
-{
-	auto file = url.toString();
-	file.remove( 0, 4 );
-
-	openNif( file );
-}
-
-void IPCsocket::openNif( const QString & url )
-{
-	NifSkope::createWindow( url );
-}
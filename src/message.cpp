@@ -4,7 +4,9 @@
 #include <QAbstractButton>
 #include <QMap>
 #include <QCloseEvent>
+#include <QDebug>
 #include <QScreen>
+#include <QThread>
 
 
 Q_LOGGING_CATEGORY( ns, "nifskope" )
@@ -24,9 +26,40 @@ Message::~Message()
 
 }
 
+//! The innermost MessageSink of the current thread
+static thread_local MessageSink * currentSink = nullptr;
+
+MessageSink::MessageSink( QStringList & l ) : lines( l ), previous( currentSink )
+{
+	currentSink = this;
+}
+
+MessageSink::~MessageSink()
+{
+	currentSink = previous;
+}
+
+//! Message boxes need the GUI thread of a QApplication; otherwise the text goes to the MessageSink or is printed
+static bool printWithoutGui( const QString & str, const QString & err = QString() )
+{
+	auto app = qobject_cast<QApplication *>( QCoreApplication::instance() );
+	if ( app && QThread::currentThread() == app->thread() )
+		return false;
+
+	QString line = err.isEmpty() ? str : ( str + " " + err );
+	if ( currentSink )
+		currentSink->append( line );
+	else
+		qWarning().noquote() << line;
+	return true;
+}
+
 //! Static helper for message box without detail text
-QMessageBox* Message::message( QWidget * parent, const QString & str, QMessageBox::Icon icon )
+void Message::message( QWidget * parent, const QString & str, QMessageBox::Icon icon )
 {
+	if ( printWithoutGui( str ) )
+		return;
+
 	auto msgBox = new QMessageBox( parent );
 	msgBox->setWindowFlags( msgBox->windowFlags() | Qt::Tool );
 	msgBox->setAttribute( Qt::WA_DeleteOnClose );
@@ -38,13 +71,14 @@ QMessageBox* Message::message( QWidget * parent, const QString & str, QMessageBo
 	msgBox->show();
 
 	msgBox->activateWindow();
-
-	return msgBox;
 }
 
 //! Static helper for message box with detail text
-QMessageBox* Message::message( QWidget * parent, const QString & str, const QString & err, QMessageBox::Icon icon )
+void Message::message( QWidget * parent, const QString & str, const QString & err, QMessageBox::Icon icon )
 {
+	if ( printWithoutGui( str, err ) )
+		return;
+
 	if ( !parent )
 		parent = qApp->activeWindow();
 
@@ -60,8 +94,6 @@ QMessageBox* Message::message( QWidget * parent, const QString & str, const QStr
 	msgBox->show();
 
 	msgBox->activateWindow();
-
-	return msgBox;
 }
 
 //! Static helper for installed message handler
@@ -166,6 +198,9 @@ void unregisterMessageBox( DetailsMessageBox * msgBox )
 
 void Message::append( QWidget * parent, const QString & str, const QString & err, QMessageBox::Icon icon )
 {
+	if ( printWithoutGui( str, err ) )
+		return;
+
 	if ( !parent )
 		parent = qApp->activeWindow();
 
@@ -5,6 +5,7 @@
 #include <QMessageBox>
 #include <QMetaType>
 #include <QString>
+#include <QStringList>
 
 Q_DECLARE_LOGGING_CATEGORY( ns )
 Q_DECLARE_LOGGING_CATEGORY( nsGl )
@@ -22,8 +23,8 @@ class Message : QObject
 	~Message();
 
 public:
-	static QMessageBox* message( QWidget *, const QString &, QMessageBox::Icon );
-	static QMessageBox* message( QWidget *, const QString &, const QString &, QMessageBox::Icon );
+	static void message( QWidget *, const QString &, QMessageBox::Icon );
+	static void message( QWidget *, const QString &, const QString &, QMessageBox::Icon );
 	static void message( QWidget *, const QString &, const QMessageLogContext *, QMessageBox::Icon );
 
 	static void append( const QString &, const QString &, QMessageBox::Icon = QMessageBox::Warning );
@@ -39,6 +40,29 @@ public:
 	static void info( QWidget *, const QString &, const QString & );
 };
 
+//! Collects the messages of the current thread while it has no GUI, instead of printing them
+/*!
+ * Message boxes can only be shown on the GUI thread of a QApplication. Without one
+ * (command line mode, batch worker threads) messages are appended to the innermost
+ * MessageSink of the thread, or printed if there is none.
+ */
+class MessageSink final
+{
+public:
+	explicit MessageSink( QStringList & lines );
+	~MessageSink();
+
+	MessageSink( const MessageSink & ) = delete;
+	MessageSink & operator=( const MessageSink & ) = delete;
+
+	//! Appends a message to the collected lines
+	void append( const QString & line ) { lines.append( line ); }
+
+private:
+	QStringList & lines;
+	MessageSink * previous;
+};
+
 class TestMessage
 {
 public:
@@ -40,6 +40,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QBuffer>
 #include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
 #include <QTime>
 
 
@@ -561,15 +562,38 @@ bool BaseModel::loadFromFile( const QString & file )
 	return false;
 }
 
-bool BaseModel::saveToFile( const QString & str ) const
+bool BaseModel::loadFromData( const QByteArray & data, const QString & file )
 {
-	QFile f( str );
 	QBuffer buf;
-	bool success = false;
-	if ( buf.open( QIODevice::WriteOnly ) && save( buf ) )
-		success = f.open( QIODevice::WriteOnly ) && f.write( buf.data() ) > 0;
+	buf.setData( data );
+
+	setState( Loading );
 
-	return success;
+	std::string	fileName( file.toStdString() );
+	if ( buf.open( QIODevice::ReadOnly ) && load( buf, fileName.c_str() ) ) {
+		if ( !file.isEmpty() )
+			refreshFileInfo( file );
+		resetState();
+		return true;
+	}
+
+	resetState();
+	return false;
+}
+
+bool BaseModel::saveToFile( const QString & str ) const
+{
+	// The file is only replaced if everything could be written
+	QSaveFile f( str );
+	if ( !f.open( QIODevice::WriteOnly ) )
+		return false;
+
+	if ( !save( f ) || f.size() <= 0 ) {
+		f.cancelWriting();
+		return false;
+	}
+
+	return f.commit();
 }
 
 void BaseModel::refreshFileInfo( const QString & f )
@@ -583,11 +607,48 @@ void BaseModel::refreshFileInfo( const QString & f )
  *  searching
  */
 
-const NifItem * BaseModel::getItemInternal( const NifItem * parent, const QString & name, bool reportErrors ) const
+const NifItem * BaseModel::getItemInternal( const NifItem * parent, NifFieldId id ) const
 {
+	// The field table gives the candidate rows directly, as long as the children are still the fields of the type
+	const NifFieldTable * fields = parent->fieldTable().get();
+	if ( fields && !parent->isArray() && parent->childCount() == fields->count() ) {
+		const QVector<int> * rows = fields->rows( id );
+		if ( !rows )
+			return nullptr;
+
+		bool valid = true;
+		for ( int row : *rows ) {
+			const NifItem * item = parent->child( row );
+			if ( !item || !item->hasName(id) ) {
+				valid = false;
+				break;
+			}
+			if ( evalCondition(item) )
+				return item;
+		}
+		if ( valid )
+			return nullptr;
+	}
+
 	for ( auto item : parent->childIter() )
-		if ( item->hasName(name) && evalCondition(item) )
+		if ( item->hasName(id) && evalCondition(item) )
+			return item;
+
+	return nullptr;
+}
+
+const NifItem * BaseModel::getItemInternal( const NifItem * parent, const QString & name, bool reportErrors ) const
+{
+	NifFieldId id = NifFieldId::find( name );
+	if ( id.isValid() ) {
+		const NifItem * item = getItemInternal( parent, id );
+		if ( item )
 			return item;
+	} else if ( name.isEmpty() ) {
+		for ( auto item : parent->childIter() )
+			if ( item->hasName(name) && evalCondition(item) )
+				return item;
+	}
 
 	if ( reportErrors )
 		reportError( parent, tr( "Could not find \"%1\" subitem." ).arg( name ) );
@@ -596,9 +657,16 @@ const NifItem * BaseModel::getItemInternal( const NifItem * parent, const QStrin
 
 const NifItem * BaseModel::getItemInternal( const NifItem * parent, const QLatin1String & name, bool reportErrors ) const
 {
-	for ( auto item : parent->childIter() )
-		if ( item->hasName(name) && evalCondition(item) )
+	NifFieldId id = NifFieldId::find( name );
+	if ( id.isValid() ) {
+		const NifItem * item = getItemInternal( parent, id );
+		if ( item )
 			return item;
+	} else if ( name.isEmpty() ) {
+		for ( auto item : parent->childIter() )
+			if ( item->hasName(name) && evalCondition(item) )
+				return item;
+	}
 
 	if ( reportErrors )
 		reportError( parent, tr( "Could not find \"%1\" subitem." ).arg( QString(name) ) );
@@ -644,6 +712,17 @@ const NifItem * BaseModel::getItem( const NifItem * parent, const QLatin1String
 	return getItemInternal( parent, name, reportErrors );
 }
 
+const NifItem * BaseModel::getItem( const NifItem * parent, NifFieldId id, bool reportErrors ) const
+{
+	if ( !parent )
+		return nullptr;
+
+	const NifItem * item = getItemInternal( parent, id );
+	if ( !item && reportErrors )
+		reportError( parent, tr( "Could not find \"%1\" subitem." ).arg( id.name() ) );
+	return item;
+}
+
 const NifItem * BaseModel::getItem( const NifItem * parent, int childIndex, bool reportErrors ) const
 {
 	if ( !parent )
@@ -868,7 +947,11 @@ void BaseModel::onItemValueChange( NifItem * item )
 void BaseModel::onArrayValuesChange( NifItem * arrayRootItem )
 {
 	int x = arrayRootItem->childCount() - 1;
-	if ( x >= 0 ) {
+	if ( arrayRootItem->isPacked() ) {
+		// The element items do not exist yet, nothing can show them
+		QModelIndex idx = itemToIndex( arrayRootItem, ValueCol );
+		emit dataChanged( idx, idx );
+	} else if ( x >= 0 ) {
 		emit dataChanged(
 			createIndex( 0, ValueCol, arrayRootItem->children().at(0) ),
 			createIndex( x, ValueCol, arrayRootItem->children().at(x) )
@@ -927,43 +1010,85 @@ QVariant BaseModelEval::operator()( const QVariant & v ) const
 		if ( numeric )
 			return QVariant( val );
 
-		// resolve reference to sibling
-		const NifItem * sibling = model->getItem( exprItem->parent(), left );
-		if ( sibling ) {
-			if ( sibling->isCount() || sibling->isFloat() ) {
-				return QVariant( sibling->getCountValue() );
-			} else if ( sibling->isFileVersion() ) {
-				return QVariant( sibling->getFileVersionValue() );
-			// this is tricky to understand
-			// we check whether the reference is an array
-			// if so, we get the current item's row number (exprItem->row())
-			// and get the sibling's child at that row number
-			// this is used for instance to describe array sizes of strips
-			} else if ( sibling->childCount() > 0 ) {
-				const NifItem * i2 = sibling->child( exprItem->row() );
-
-				if ( i2 && i2->isCount() )
-					return QVariant( i2->getCountValue() );
-			} else if ( sibling->valueType() == NifValue::tBSVertexDesc ) {
-				return QVariant( sibling->get<BSVertexDesc>().GetFlags() << 4 );
-			} else {
-				model->reportError( item, QString( "BaseModelEval could not convert %1 to a count." ).arg( sibling->repr() ) );
-			}
-		}
+		return QVariant( nameValue( exprItem, left, model->getItem( exprItem->parent(), left ) ) );
+	}
 
-		// resolve reference to block type
-		// is the condition string a type?
-		if ( model->isAncestorOrNiBlock( left ) ) {
-			// get the type of the current block
-			auto itemBlock = model->getTopItem( exprItem );
-			if ( itemBlock )
-				return QVariant( model->inherits( itemBlock->name(), left ) );
+	return v;
+}
+
+quint64 BaseModelEval::symbol( const NifExpr::Symbol & s ) const
+{
+	return nameValue( item, s.name, findSibling( s ) );
+}
+
+quint64 BaseModelEval::arg() const
+{
+	const NifItem * exprItem = item;
+	do {
+		exprItem = exprItem->parent();
+		if ( !exprItem )
+			return 0;
+	} while ( exprItem->arg() == XMLARG );
+
+	// ARG is an expression
+	const NifExpr & argexpr = exprItem->argexpr();
+	if ( !argexpr.noop() )
+		return quint64( qint64( argexpr.evaluateUInt64( BaseModelEval( model, exprItem ) ) ) );
+
+	const QString & left = exprItem->arg();
+	bool numeric;
+	int val = left.toInt( &numeric, 10 );
+	if ( numeric )
+		return quint64( qint64( val ) );
+
+	return nameValue( exprItem, left, model->getItem( exprItem->parent(), left ) );
+}
+
+const NifItem * BaseModelEval::findSibling( const NifExpr::Symbol & s ) const
+{
+	const NifItem * parent = item->parent();
+	if ( !parent || s.isPath )
+		return model->getItem( parent, s.name );
+
+	// The field ID was interned when the expression was compiled, so this is a table lookup
+	return model->getItemInternal( parent, NifFieldId::fromValue( s.fieldId ) );
+}
+
+quint64 BaseModelEval::nameValue( const NifItem * exprItem, const QString & name, const NifItem * sibling ) const
+{
+	// resolve reference to sibling
+	if ( sibling ) {
+		if ( sibling->isCount() || sibling->isFloat() ) {
+			return sibling->getCountValue();
+		} else if ( sibling->isFileVersion() ) {
+			return sibling->getFileVersionValue();
+		// this is tricky to understand
+		// we check whether the reference is an array
+		// if so, we get the current item's row number (exprItem->row())
+		// and get the sibling's child at that row number
+		// this is used for instance to describe array sizes of strips
+		} else if ( sibling->childCount() > 0 ) {
+			const NifItem * i2 = sibling->child( exprItem->row() );
+
+			if ( i2 && i2->isCount() )
+				return i2->getCountValue();
+		} else if ( sibling->valueType() == NifValue::tBSVertexDesc ) {
+			return sibling->get<BSVertexDesc>().GetFlags() << 4;
+		} else {
+			model->reportError( item, QString( "BaseModelEval could not convert %1 to a count." ).arg( sibling->repr() ) );
 		}
+	}
 
-		return QVariant( 0 );
+	// resolve reference to block type
+	// is the condition string a type?
+	if ( model->isAncestorOrNiBlock( name ) ) {
+		// get the type of the current block
+		auto itemBlock = model->getTopItem( exprItem );
+		if ( itemBlock )
+			return model->inherits( itemBlock->name(), name );
 	}
 
-	return v;
+	return 0;
 }
 
 unsigned DJB1Hash( const char * key, unsigned tableSize )
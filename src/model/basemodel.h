@@ -96,6 +96,8 @@ public:
 
 	//! Load from file.
 	bool loadFromFile( const QString & filename );
+	//! Load from the contents of a file that have already been read, \a filename is empty for files in archives
+	bool loadFromData( const QByteArray & data, const QString & filename = QString() );
 	//! Save to file.
 	bool saveToFile( const QString & str ) const;
 
@@ -330,6 +332,7 @@ protected:
 protected:
 	const NifItem * getItemInternal( const NifItem * parent, const QString & name, bool reportErrors ) const;
 	const NifItem * getItemInternal( const NifItem * parent, const QLatin1String & name, bool reportErrors ) const;
+	const NifItem * getItemInternal( const NifItem * parent, NifFieldId id ) const;
 
 public:
 	//! Get a child NifItem from its parent and name.
@@ -344,6 +347,10 @@ public:
 	const NifItem * getItem( const NifItem * parent, const char * name, bool reportErrors = false ) const;
 	//! Get a child NifItem from its parent and name.
 	NifItem * getItem( const NifItem * parent, const char * name, bool reportErrors = false );
+	//! Get a child NifItem from its parent and interned name.
+	const NifItem * getItem( const NifItem * parent, NifFieldId id, bool reportErrors = false ) const;
+	//! Get a child NifItem from its parent and interned name.
+	NifItem * getItem( const NifItem * parent, NifFieldId id, bool reportErrors = false );
 	//! Get a child NifItem from its parent and numerical index.
 	const NifItem * getItem( const NifItem * parent, int childIndex, bool reportErrors = true ) const;
 	//! Get a child NifItem from its parent and numerical index.
@@ -364,6 +371,10 @@ public:
 	const NifItem * getItem( const QModelIndex & parent, const char * name, bool reportErrors = false ) const;
 	//! Get a child NifItem from its parent and name.
 	NifItem * getItem( const QModelIndex & parent, const char * name, bool reportErrors = false );
+	//! Get a child NifItem from its parent and interned name.
+	const NifItem * getItem( const QModelIndex & parent, NifFieldId id, bool reportErrors = false ) const;
+	//! Get a child NifItem from its parent and interned name.
+	NifItem * getItem( const QModelIndex & parent, NifFieldId id, bool reportErrors = false );
 	//! Get a child NifItem from its parent and numerical index.
 	const NifItem * getItem( const QModelIndex & parent, int childIndex, bool reportErrors = true ) const;
 	//! Get a child NifItem from its parent and numerical index.
@@ -389,11 +400,15 @@ public:
 	//! Get the model index of a child item.
 	QModelIndex getIndex( const NifItem * itemParent, const char * itemName, int column = 0 ) const;
 	//! Get the model index of a child item.
+	QModelIndex getIndex( const NifItem * itemParent, NifFieldId itemId, int column = 0 ) const;
+	//! Get the model index of a child item.
 	QModelIndex getIndex( const QModelIndex & itemParent, const QString & itemName, int column = 0 ) const;
 	//! Get the model index of a child item.
 	QModelIndex getIndex( const QModelIndex & itemParent, const QLatin1String & itemName, int column = 0 ) const;
 	//! Get the model index of a child item.
 	QModelIndex getIndex( const QModelIndex & itemParent, const char * itemName, int column = 0 ) const;
+	//! Get the model index of a child item.
+	QModelIndex getIndex( const QModelIndex & itemParent, NifFieldId itemId, int column = 0 ) const;
 
 	// Item value getters
 public:
@@ -407,6 +422,8 @@ public:
 	template <typename T> T get( const NifItem * itemParent, const QLatin1String & itemName ) const;
 	//! Get the value of a child item.
 	template <typename T> T get( const NifItem * itemParent, const char * itemName ) const;
+	//! Get the value of a child item.
+	template <typename T> T get( const NifItem * itemParent, NifFieldId itemId ) const;
 	//! Get the value of a model index.
 	template <typename T> T get( const QModelIndex & index ) const;
 	//! Get the value of a child item.
@@ -417,6 +434,8 @@ public:
 	template <typename T> T get( const QModelIndex & itemParent, const QLatin1String & itemName ) const;
 	//! Get the value of a child item.
 	template <typename T> T get( const QModelIndex & itemParent, const char * itemName ) const;
+	//! Get the value of a child item.
+	template <typename T> T get( const QModelIndex & itemParent, NifFieldId itemId ) const;
 
 	// Item value setters
 public:
@@ -430,6 +449,8 @@ public:
 	template <typename T> bool set( const NifItem * itemParent, const QLatin1String & itemName, const T & val );
 	//! Set the value of a child item.
 	template <typename T> bool set( const NifItem * itemParent, const char * itemName, const T & val );
+	//! Set the value of a child item.
+	template <typename T> bool set( const NifItem * itemParent, NifFieldId itemId, const T & val );
 	//! Set the value of a model index.
 	template <typename T> bool set( const QModelIndex & index, const T & val );
 	//! Set the value of a child item.
@@ -440,6 +461,8 @@ public:
 	template <typename T> bool set( const QModelIndex & itemParent, const QLatin1String & itemName, const T & val );
 	//! Set the value of a child item.
 	template <typename T> bool set( const QModelIndex & itemParent, const char * itemName, const T & val );
+	//! Set the value of a child item.
+	template <typename T> bool set( const QModelIndex & itemParent, NifFieldId itemId, const T & val );
 
 	// Array size management
 protected:	
@@ -480,6 +503,8 @@ public:
 	template <typename T> QVector<T> getArray( const NifItem * arrayParent, const QLatin1String & arrayName ) const;
 	//! Get a child array as a QVector.
 	template <typename T> QVector<T> getArray( const NifItem * arrayParent, const char * arrayName ) const;
+	//! Get a child array as a QVector.
+	template <typename T> QVector<T> getArray( const NifItem * arrayParent, NifFieldId arrayId ) const;
 	//! Get a model index array as a QVector.
 	template <typename T> QVector<T> getArray( const QModelIndex & iArray ) const;
 	//! Get a child array as a QVector.
@@ -490,6 +515,8 @@ public:
 	template <typename T> QVector<T> getArray( const QModelIndex & arrayParent, const QLatin1String & arrayName ) const;
 	//! Get a child array as a QVector.
 	template <typename T> QVector<T> getArray( const QModelIndex & arrayParent, const char * arrayName ) const;
+	//! Get a child array as a QVector.
+	template <typename T> QVector<T> getArray( const QModelIndex & arrayParent, NifFieldId arrayId ) const;
 
 	// Array setters
 public:
@@ -603,7 +630,17 @@ public:
 	//! Evaluation function
 	QVariant operator()( const QVariant & v ) const;
 
+	//! Value of a name in a compiled expression (see NifExpr::run)
+	quint64 symbol( const NifExpr::Symbol & s ) const;
+	//! Value of #ARG# in a compiled expression
+	quint64 arg() const;
+
 private:
+	//! Find the sibling of the item which a symbol refers to, like BaseModel::getItem does
+	const NifItem * findSibling( const NifExpr::Symbol & s ) const;
+	//! Value of a name which refers to \a sibling of \a exprItem (or to a block type if \a sibling is null)
+	quint64 nameValue( const NifItem * exprItem, const QString & name, const NifItem * sibling ) const;
+
 	const BaseModel * model;
 	const NifItem * item;
 };
@@ -684,6 +721,10 @@ inline NifItem * BaseModel::getItem( const NifItem * parent, const char * name,
 {
 	return _BASEMODEL_NONCONST_GETITEM_3( parent, QLatin1String(name), reportErrors );
 }
+inline NifItem * BaseModel::getItem( const NifItem * parent, NifFieldId id, bool reportErrors )
+{
+	return _BASEMODEL_NONCONST_GETITEM_3( parent, id, reportErrors );
+}
 inline NifItem * BaseModel::getItem( const NifItem * parent, int childIndex, bool reportErrors )
 {
 	return _BASEMODEL_NONCONST_GETITEM_3( parent, childIndex, reportErrors );
@@ -716,6 +757,14 @@ inline NifItem * BaseModel::getItem( const QModelIndex & parent, const char * na
 {
 	return _BASEMODEL_NONCONST_GETITEM_3( getItem(parent), QLatin1String(name), reportErrors );
 }
+inline const NifItem * BaseModel::getItem( const QModelIndex & parent, NifFieldId id, bool reportErrors ) const
+{
+	return getItem( getItem(parent), id, reportErrors );
+}
+inline NifItem * BaseModel::getItem( const QModelIndex & parent, NifFieldId id, bool reportErrors )
+{
+	return _BASEMODEL_NONCONST_GETITEM_3( getItem(parent), id, reportErrors );
+}
 inline const NifItem * BaseModel::getItem( const QModelIndex & parent, int childIndex, bool reportErrors ) const
 {
 	return getItem( getItem(parent), childIndex, reportErrors );
@@ -750,6 +799,10 @@ inline QModelIndex BaseModel::getIndex( const NifItem * itemParent, const char *
 {
 	return itemToIndex( getItem(itemParent, QLatin1String(itemName)), column );
 }
+inline QModelIndex BaseModel::getIndex( const NifItem * itemParent, NifFieldId itemId, int column ) const
+{
+	return itemToIndex( getItem(itemParent, itemId), column );
+}
 inline QModelIndex BaseModel::getIndex( const QModelIndex & itemParent, const QString & itemName, int column ) const
 {
 	return itemToIndex( getItem(itemParent, itemName), column );
@@ -762,6 +815,10 @@ inline QModelIndex BaseModel::getIndex( const QModelIndex & itemParent, const ch
 {
 	return itemToIndex( getItem(itemParent, QLatin1String(itemName)), column );
 }
+inline QModelIndex BaseModel::getIndex( const QModelIndex & itemParent, NifFieldId itemId, int column ) const
+{
+	return itemToIndex( getItem(itemParent, itemId), column );
+}
 
 
 // Item value getters
@@ -786,6 +843,10 @@ template <typename T> inline T BaseModel::get( const NifItem * itemParent, const
 {
 	return NifItem::get<T>( getItem(itemParent, QLatin1String(itemName)) );
 }
+template <typename T> inline T BaseModel::get( const NifItem * itemParent, NifFieldId itemId ) const
+{
+	return NifItem::get<T>( getItem(itemParent, itemId) );
+}
 template <typename T> inline T BaseModel::get( const QModelIndex & index ) const
 {
 	return NifItem::get<T>( getItem(index) );
@@ -806,6 +867,10 @@ template <typename T> inline T BaseModel::get( const QModelIndex & itemParent, c
 {
 	return NifItem::get<T>( getItem(itemParent, QLatin1String(itemName)) );
 }
+template <typename T> inline T BaseModel::get( const QModelIndex & itemParent, NifFieldId itemId ) const
+{
+	return NifItem::get<T>( getItem(itemParent, itemId) );
+}
 
 
 // Item value setters
@@ -835,6 +900,10 @@ template <typename T> inline bool BaseModel::set( const NifItem * itemParent, co
 {
 	return set( getItem(itemParent, QLatin1String(itemName), true), val );
 }
+template <typename T> inline bool BaseModel::set( const NifItem * itemParent, NifFieldId itemId, const T & val )
+{
+	return set( getItem(itemParent, itemId, true), val );
+}
 template <typename T> inline bool BaseModel::set( const QModelIndex & index, const T & val )
 {
 	return set( getItem(index), val );
@@ -855,6 +924,10 @@ template <typename T> inline bool BaseModel::set( const QModelIndex & itemParent
 {
 	return set( getItem(itemParent, QLatin1String(itemName), true), val );
 }
+template <typename T> inline bool BaseModel::set( const QModelIndex & itemParent, NifFieldId itemId, const T & val )
+{
+	return set( getItem(itemParent, itemId, true), val );
+}
 
 
 // Array size management
@@ -923,6 +996,10 @@ template <typename T> inline QVector<T> BaseModel::getArray( const NifItem * arr
 {
 	return NifItem::getArray<T>( getItem(arrayParent, QLatin1String(arrayName)) );
 }
+template <typename T> inline QVector<T> BaseModel::getArray( const NifItem * arrayParent, NifFieldId arrayId ) const
+{
+	return NifItem::getArray<T>( getItem(arrayParent, arrayId) );
+}
 template <typename T> inline QVector<T> BaseModel::getArray( const QModelIndex & iArray ) const
 {
 	return NifItem::getArray<T>( getItem(iArray) );
@@ -943,6 +1020,10 @@ template <typename T> inline QVector<T> BaseModel::getArray( const QModelIndex &
 {
 	return NifItem::getArray<T>( getItem(arrayParent, QLatin1String(arrayName)) );
 }
+template <typename T> inline QVector<T> BaseModel::getArray( const QModelIndex & arrayParent, NifFieldId arrayId ) const
+{
+	return NifItem::getArray<T>( getItem(arrayParent, arrayId) );
+}
 
 
 // Array setters
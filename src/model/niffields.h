@@ -0,0 +1,213 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef NIFFIELDS_H
+#define NIFFIELDS_H
+
+#include "data/nifitem.h"
+
+
+//! @file niffields.h Interned IDs of the fields looked up while rendering and animating
+
+/*! The names are interned once at startup, lookups by ID use the field table of the parent item
+ * instead of comparing names (see BaseModel::getItem( const NifItem *, NifFieldId )).
+ */
+
+inline const NifFieldId fieldAccess( "Access" );
+inline const NifFieldId fieldAge( "Age" );
+inline const NifFieldId fieldBackward( "Backward" );
+inline const NifFieldId fieldBasisData( "Basis Data" );
+inline const NifFieldId fieldBinaryData( "Binary Data" );
+inline const NifFieldId fieldBirthRate( "Birth Rate" );
+inline const NifFieldId fieldBitangents( "Bitangents" );
+inline const NifFieldId fieldBitangentX( "Bitangent X" );
+inline const NifFieldId fieldBitangentY( "Bitangent Y" );
+inline const NifFieldId fieldBitangentZ( "Bitangent Z" );
+inline const NifFieldId fieldBoneIndices( "Bone Indices" );
+inline const NifFieldId fieldBoneList( "Bone List" );
+inline const NifFieldId fieldBones( "Bones" );
+inline const NifFieldId fieldBoneWeights( "Bone Weights" );
+inline const NifFieldId fieldBoundingSphere( "Bounding Sphere" );
+inline const NifFieldId fieldCenter( "Center" );
+inline const NifFieldId fieldCode( "Code" );
+inline const NifFieldId fieldCombined( "Combined" );
+inline const NifFieldId fieldCompactControlPoints( "Compact Control Points" );
+inline const NifFieldId fieldComponentFormats( "Component Formats" );
+inline const NifFieldId fieldComponentSemantics( "Component Semantics" );
+inline const NifFieldId fieldControlledBlocks( "Controlled Blocks" );
+inline const NifFieldId fieldControlledColor( "Controlled Color" );
+inline const NifFieldId fieldControlledVariable( "Controlled Variable" );
+inline const NifFieldId fieldController( "Controller" );
+inline const NifFieldId fieldControllerID( "Controller ID" );
+inline const NifFieldId fieldControllerIDOffset( "Controller ID Offset" );
+inline const NifFieldId fieldControllerSequences( "Controller Sequences" );
+inline const NifFieldId fieldControllerType( "Controller Type" );
+inline const NifFieldId fieldControllerTypeOffset( "Controller Type Offset" );
+inline const NifFieldId fieldData( "Data" );
+inline const NifFieldId fieldDataSize( "Data Size" );
+inline const NifFieldId fieldDatastreams( "Datastreams" );
+inline const NifFieldId fieldDeclination( "Declination" );
+inline const NifFieldId fieldDeclinationVariation( "Declination Variation" );
+inline const NifFieldId fieldDelta( "Delta" );
+inline const NifFieldId fieldDirection( "Direction" );
+inline const NifFieldId fieldEmitStartTime( "Emit Start Time" );
+inline const NifFieldId fieldEmitStopTime( "Emit Stop Time" );
+inline const NifFieldId fieldEmitter( "Emitter" );
+inline const NifFieldId fieldEmitterDimensions( "Emitter Dimensions" );
+inline const NifFieldId fieldExtraDataList( "Extra Data List" );
+inline const NifFieldId fieldExtraTargets( "Extra Targets" );
+inline const NifFieldId fieldFade( "Fade" );
+inline const NifFieldId fieldFlags( "Flags" );
+inline const NifFieldId fieldForce( "Force" );
+inline const NifFieldId fieldForward( "Forward" );
+inline const NifFieldId fieldFrequency( "Frequency" );
+inline const NifFieldId fieldGrow( "Grow" );
+inline const NifFieldId fieldHasVertexWeights( "Has Vertex Weights" );
+inline const NifFieldId fieldImages( "Images" );
+inline const NifFieldId fieldIndex( "Index" );
+inline const NifFieldId fieldInitialSize( "Initial Size" );
+inline const NifFieldId fieldInterpolation( "Interpolation" );
+inline const NifFieldId fieldInterpolator( "Interpolator" );
+inline const NifFieldId fieldInterpolatorID( "Interpolator ID" );
+inline const NifFieldId fieldInterpolatorIDOffset( "Interpolator ID Offset" );
+inline const NifFieldId fieldInterpolators( "Interpolators" );
+inline const NifFieldId fieldInterpolatorWeights( "Interpolator Weights" );
+inline const NifFieldId fieldKeys( "Keys" );
+inline const NifFieldId fieldLastUpdate( "Last Update" );
+inline const NifFieldId fieldLifeSpan( "Life Span" );
+inline const NifFieldId fieldLifetime( "Lifetime" );
+inline const NifFieldId fieldLifetimeVariation( "Lifetime Variation" );
+inline const NifFieldId fieldLOD0Size( "LOD0 Size" );
+inline const NifFieldId fieldLOD1Size( "LOD1 Size" );
+inline const NifFieldId fieldLOD2Size( "LOD2 Size" );
+inline const NifFieldId fieldMesh( "Mesh" );
+inline const NifFieldId fieldMeshData( "Mesh Data" );
+inline const NifFieldId fieldMeshes( "Meshes" );
+inline const NifFieldId fieldMeshlets( "Meshlets" );
+inline const NifFieldId fieldMorphs( "Morphs" );
+inline const NifFieldId fieldName( "Name" );
+inline const NifFieldId fieldNextController( "Next Controller" );
+inline const NifFieldId fieldNextModifier( "Next Modifier" );
+inline const NifFieldId fieldNodeName( "Node Name" );
+inline const NifFieldId fieldNodeNameOffset( "Node Name Offset" );
+inline const NifFieldId fieldNormal( "Normal" );
+inline const NifFieldId fieldNormals( "Normals" );
+inline const NifFieldId fieldNumBones( "Num Bones" );
+inline const NifFieldId fieldNumComponents( "Num Components" );
+inline const NifFieldId fieldNumControlPoints( "Num Control Points" );
+inline const NifFieldId fieldNumIndices( "Num Indices" );
+inline const NifFieldId fieldNumParticles( "Num Particles" );
+inline const NifFieldId fieldNumRegions( "Num Regions" );
+inline const NifFieldId fieldNumSubmeshes( "Num Submeshes" );
+inline const NifFieldId fieldNumValid( "Num Valid" );
+inline const NifFieldId fieldNumVertices( "Num Vertices" );
+inline const NifFieldId fieldNumWeightsPerVertex( "Num Weights Per Vertex" );
+inline const NifFieldId fieldObjectData( "Object Data" );
+inline const NifFieldId fieldOperation( "Operation" );
+inline const NifFieldId fieldParticleModifier( "Particle Modifier" );
+inline const NifFieldId fieldParticles( "Particles" );
+inline const NifFieldId fieldPartitions( "Partitions" );
+inline const NifFieldId fieldPhase( "Phase" );
+inline const NifFieldId fieldPlanarAngle( "Planar Angle" );
+inline const NifFieldId fieldPlanarAngleVariation( "Planar Angle Variation" );
+inline const NifFieldId fieldPoints( "Points" );
+inline const NifFieldId fieldPosition( "Position" );
+inline const NifFieldId fieldPrimitiveType( "Primitive Type" );
+inline const NifFieldId fieldPropertyType( "Property Type" );
+inline const NifFieldId fieldPropertyTypeOffset( "Property Type Offset" );
+inline const NifFieldId fieldQuaternionKeys( "Quaternion Keys" );
+inline const NifFieldId fieldRadius( "Radius" );
+inline const NifFieldId fieldRegions( "Regions" );
+inline const NifFieldId fieldRotation( "Rotation" );
+inline const NifFieldId fieldRotationHalfRange( "Rotation Half Range" );
+inline const NifFieldId fieldRotationHandle( "Rotation Handle" );
+inline const NifFieldId fieldRotationOffset( "Rotation Offset" );
+inline const NifFieldId fieldRotationType( "Rotation Type" );
+inline const NifFieldId fieldScale( "Scale" );
+inline const NifFieldId fieldScaleHalfRange( "Scale Half Range" );
+inline const NifFieldId fieldScaleHandle( "Scale Handle" );
+inline const NifFieldId fieldScaleOffset( "Scale Offset" );
+inline const NifFieldId fieldScales( "Scales" );
+inline const NifFieldId fieldSkeletonRoot( "Skeleton Root" );
+inline const NifFieldId fieldSkin( "Skin" );
+inline const NifFieldId fieldSkinPartition( "Skin Partition" );
+inline const NifFieldId fieldSkinTransform( "Skin Transform" );
+inline const NifFieldId fieldSources( "Sources" );
+inline const NifFieldId fieldSpeed( "Speed" );
+inline const NifFieldId fieldSpeedVariation( "Speed Variation" );
+inline const NifFieldId fieldSplineData( "Spline Data" );
+inline const NifFieldId fieldStartIndex( "Start Index" );
+inline const NifFieldId fieldStartTime( "Start Time" );
+inline const NifFieldId fieldStopTime( "Stop Time" );
+inline const NifFieldId fieldStream( "Stream" );
+inline const NifFieldId fieldStrips( "Strips" );
+inline const NifFieldId fieldSubmeshToRegionMap( "Submesh To Region Map" );
+inline const NifFieldId fieldTangent( "Tangent" );
+inline const NifFieldId fieldTangents( "Tangents" );
+inline const NifFieldId fieldTargetColor( "Target Color" );
+inline const NifFieldId fieldTargetName( "Target Name" );
+inline const NifFieldId fieldTextKeys( "Text Keys" );
+inline const NifFieldId fieldTextureSlot( "Texture Slot" );
+inline const NifFieldId fieldTime( "Time" );
+inline const NifFieldId fieldTransform( "Transform" );
+inline const NifFieldId fieldTranslation( "Translation" );
+inline const NifFieldId fieldTranslationHalfRange( "Translation Half Range" );
+inline const NifFieldId fieldTranslationHandle( "Translation Handle" );
+inline const NifFieldId fieldTranslationOffset( "Translation Offset" );
+inline const NifFieldId fieldTranslations( "Translations" );
+inline const NifFieldId fieldTriangleCount( "Triangle Count" );
+inline const NifFieldId fieldTriangles( "Triangles" );
+inline const NifFieldId fieldType( "Type" );
+inline const NifFieldId fieldUsage( "Usage" );
+inline const NifFieldId fieldUseBirthRate( "Use Birth Rate" );
+inline const NifFieldId fieldUV( "UV" );
+inline const NifFieldId fieldUVGroups( "UV Groups" );
+inline const NifFieldId fieldUVs( "UVs" );
+inline const NifFieldId fieldUVs2( "UVs 2" );
+inline const NifFieldId fieldUVSets( "UV Sets" );
+inline const NifFieldId fieldValue( "Value" );
+inline const NifFieldId fieldVectors( "Vectors" );
+inline const NifFieldId fieldVelocity( "Velocity" );
+inline const NifFieldId fieldVertex( "Vertex" );
+inline const NifFieldId fieldVertexColors( "Vertex Colors" );
+inline const NifFieldId fieldVertexData( "Vertex Data" );
+inline const NifFieldId fieldVertexDesc( "Vertex Desc" );
+inline const NifFieldId fieldVertexMap( "Vertex Map" );
+inline const NifFieldId fieldVertexSize( "Vertex Size" );
+inline const NifFieldId fieldVertexWeights( "Vertex Weights" );
+inline const NifFieldId fieldVertices( "Vertices" );
+inline const NifFieldId fieldWeight( "Weight" );
+inline const NifFieldId fieldWeights( "Weights" );
+inline const NifFieldId fieldWeightsPerVertex( "Weights Per Vertex" );
+inline const NifFieldId fieldXYZRotations( "XYZ Rotations" );
+
+#endif
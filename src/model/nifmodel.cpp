@@ -44,9 +44,12 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QSet>
 #include <QSettings>
 #include <QStringBuilder>
 
+#include <algorithm>
+
 //! @file nifmodel.cpp The NIF data model.
 
 const QString EMPTY_QSTRING;
@@ -265,7 +268,7 @@ void setupArrayPseudonyms()
 
 NifModel::NifModel( QObject * parent ) : BaseModel( parent )
 {
-	gameResources = &( Game::GameManager::getNIFResources( nullptr ) );
+	gameResources = Game::GameManager::get_resources( Game::OTHER );
 
 	setupArrayPseudonyms();
 	updateSettings();
@@ -427,7 +430,7 @@ void NifModel::clear()
 	needUpdates = utNone;
 
 	Game::GameManager::removeNIFResourcePath( this );
-	gameResources = &( Game::GameManager::getNIFResources( this ) );
+	gameResources = Game::GameManager::get_resources( Game::GameManager::get_game( this ) );
 }
 
 
@@ -468,7 +471,7 @@ const NifItem * NifModel::getHeaderItem() const
 	return root->child( 0 );
 }
 
-void NifModel::updateHeader()
+void NifModel::updateHeader( bool updateBlockSizes )
 {
 	emit beginUpdateHeader();
 
@@ -507,7 +510,7 @@ void NifModel::updateHeader()
 			}
 			blockTypeIndices.append( iBlockType );
 
-			if ( itemBlockSizes ) {
+			if ( itemBlockSizes && updateBlockSizes ) {
 				updateChildArraySizes( itemBlock );
 				blockSizes.append( blockSize( itemBlock ) );
 			}
@@ -522,7 +525,7 @@ void NifModel::updateHeader()
 			updateArraySize(itemBlockTypes);
 			itemBlockTypes->setArray<QString>( blockTypes );
 		}
-		if ( itemBlockSizes ) {
+		if ( itemBlockSizes && updateBlockSizes ) {
 			updateArraySize(itemBlockSizes);
 			itemBlockSizes->setArray<int>( blockSizes );
 		}
@@ -591,6 +594,29 @@ void NifModel::updateFooter()
  *  array functions
  */
 
+//! Arrays of values with fewer elements than this are always loaded as child items
+static constexpr int MinPackedArraySize = 64;
+
+//! Data of the elements of an array
+static NifData arrayElementData( const NifItem * array )
+{
+	NifData data( array->name(),
+				  array->strType(),
+				  array->templ(),
+				  NifValue( NifValue::type( array->strType() ) ),
+				  addConditionParentPrefix( array->arg() ),
+				  addConditionParentPrefix( array->arr2() ) // arr1 in children is parent arr2
+	);
+
+	// Fill data flags
+	data.setIsConditionless( true );
+	data.setIsCompound( array->isCompound() );
+	data.setIsArray( array->isMultiArray() );
+	data.setFieldTable( array->fieldTable() );
+
+	return data;
+}
+
 bool NifModel::updateArraySizeImpl( NifItem * array )
 {
 	if ( !isArray( array ) ) {
@@ -621,19 +647,19 @@ bool NifModel::updateArraySizeImpl( NifItem * array )
 
 	bool bOldHasChildLinks = array->hasChildLinks();
 
-	if ( nNewSize > nOldSize ) { // Add missing items
-		NifData data( array->name(),
-					  array->strType(),
-					  array->templ(),
-					  NifValue( NifValue::type( array->strType() ) ),
-					  addConditionParentPrefix( array->arg() ),
-					  addConditionParentPrefix( array->arr2() ) // arr1 in children is parent arr2
-		);
+	if ( array->isPacked() ) {
+		if ( nNewSize > nOldSize )
+			beginInsertRows( itemToIndex(array), nOldSize, nNewSize - 1 );
+		else
+			beginRemoveRows( itemToIndex(array), nNewSize, nOldSize - 1 );
+		array->resizePackedChildren( nNewSize );
+		if ( nNewSize > nOldSize )
+			endInsertRows();
+		else
+			endRemoveRows();
 
-		// Fill data flags
-		data.setIsConditionless( true );
-		data.setIsCompound( array->isCompound() );
-		data.setIsArray( array->isMultiArray() );
+	} else if ( nNewSize > nOldSize ) { // Add missing items
+		NifData data = arrayElementData( array );
 
 		beginInsertRows( itemToIndex(array), nOldSize, nNewSize - 1 );
 		array->prepareInsert( nNewSize - nOldSize );
@@ -651,7 +677,7 @@ bool NifModel::updateArraySizeImpl( NifItem * array )
 		&& ( bOldHasChildLinks || array->hasChildLinks() ) // had or has any links inside
 		&& !array->isDescendantOf( getFooterItem() )
 	) {
-		updateLinks();
+		updateItemLinks( array );
 		updateFooter();
 		emit linksChanged();
 	}
@@ -730,7 +756,7 @@ bool NifModel::updateChildArraySizes( NifItem * parent )
 				if ( !updateArraySize(child) )
 					return false;
 			}
-			if ( child->childCount() > 0 ) {
+			if ( child->childCount() > 0 && !child->isPacked() ) {
 				if ( !updateChildArraySizes(child) )
 					return false;
 			}
@@ -764,6 +790,7 @@ QModelIndex NifModel::insertNiBlock( const QString & identifier, int at )
 
 		NifData d = NifData( identifier, "NiBlock", block->text );
 		d.setIsConditionless( true );
+		d.setFieldTable( block->fields );
 		NifItem * branch = insertBranch( root, d, at );
 		endInsertRows();
 
@@ -777,7 +804,9 @@ QModelIndex NifModel::insertNiBlock( const QString & identifier, int at )
 
 		if ( state != Loading ) {
 			updateHeader();
-			updateLinks();
+			int newBlock = at - 1;
+			remapLinks( getBlockCount() - 1, [newBlock]( int l ) { return ( l >= newBlock ) ? l + 1 : l; } );
+			updateLinks( newBlock );
 			updateFooter();
 			emit linksChanged();
 		}
@@ -800,7 +829,7 @@ void NifModel::removeNiBlock( int blocknum )
 	beginRemoveRows( QModelIndex(), blocknum + 1, blocknum + 1 );
 	root->removeChild( blocknum + 1 );
 	endRemoveRows();
-	updateLinks();
+	remapLinks( getBlockCount() + 1, [blocknum]( int l ) { return ( l == blocknum ) ? -1 : ( l > blocknum ) ? l - 1 : l; } );
 	updateFooter();
 	emit linksChanged();
 }
@@ -836,7 +865,7 @@ void NifModel::moveNiBlock( int src, int dst )
 
 	mapLinks( root, map );
 
-	updateLinks();
+	remapLinks( getBlockCount(), [&map]( int l ) { return map.value( l, l ); } );
 	updateHeader();
 	updateFooter();
 	emit linksChanged();
@@ -852,6 +881,10 @@ void NifModel::updateStrings( NifModel * src, NifModel * tgt, NifItem * item )
 		tgt->assignString( tgt->createIndex( 0, 0, item ), str, false );
 	}
 
+	// Packed arrays hold no strings
+	if ( item->isPacked() )
+		return;
+
 	for ( auto child : item->children() ) {
 		updateStrings( src, tgt, child );
 	}
@@ -1148,7 +1181,14 @@ void NifModel::insertType( NifItem * parent, const NifData & data, int at )
 		NifBlockPtr compound = compounds.value( data.type() );
 		if ( !compound )
 			return;
-		NifItem * branch = insertBranch( parent, data, at );
+		NifItem * branch;
+		if ( data.fieldTable() ) {
+			branch = insertBranch( parent, data, at );
+		} else {
+			NifData d( data );
+			d.setFieldTable( compound->fields );
+			branch = insertBranch( parent, d, at );
+		}
 		branch->prepareInsert( compound->types.count() );
 		for ( const NifData & d : compound->types ) {
 			insertType( branch, d );
@@ -1674,7 +1714,7 @@ bool NifModel::removeRows( int iStart, int count, const QModelIndex & parent )
 		endRemoveRows();
 
 		if ( hasLinks ) {
-			updateLinks();
+			updateItemLinks( item );
 			updateFooter();
 			emit linksChanged();
 		}
@@ -2071,16 +2111,20 @@ bool NifModel::save( QIODevice & device ) const
 
 	setState( Saving );
 
-	// Force update header and footer prior to save
-	if ( NifModel * mdl = const_cast<NifModel *>(this) ) {
-		mdl->updateHeader();
-		mdl->updateFooter();
-	}
+	// Force update header and footer prior to save. The block sizes are recorded while the blocks are written
+	// and patched into the header afterwards, unless the device cannot seek back: then they are calculated here.
+	NifModel * mdl = const_cast<NifModel *>(this);
+	bool patchBlockSizes = ( version >= 0x14020000 && !device.isSequential() );
+	mdl->updateHeader( !patchBlockSizes );
+	mdl->updateFooter();
 
-	emit sigProgress( 0, rowCount( QModelIndex() ) );
+	NifItem * itemBlockSizes = patchBlockSizes ? mdl->getItem( mdl->getHeaderItem(), "Block Size" ) : nullptr;
 
-	for ( int c = 0; c < rowCount( QModelIndex() ); c++ ) {
-		emit sigProgress( c + 1, rowCount( QModelIndex() ) );
+	int rows = rowCount( QModelIndex() );
+	emit sigProgress( 0, rows );
+
+	auto saveRow = [this, rows]( int c, NifOStream & out ) {
+		emit sigProgress( c + 1, rows );
 
 		//qDebug() << "saving block " << c << ": " << itemName( index( c, 0 ) );
 
@@ -2088,45 +2132,94 @@ bool NifModel::save( QIODevice & device ) const
 			if ( version > 0x0a000000 ) {
 				if ( version < 0x0a020000 ) {
 					int null = 0;
-					device.write( (char *)&null, 4 );
+					out.writeBytes( (char *)&null, 4 );
 				}
 			} else {
 				if ( version < 0x0303000d ) {
 					if ( rootLinks.contains( c - 1 ) ) {
 						QString string = "Top Level Object";
 						int len = string.length();
-						device.write( (char *)&len, 4 );
-						device.write( string.toLatin1().constData(), len );
+						out.writeBytes( (char *)&len, 4 );
+						out.writeBytes( string.toLatin1().constData(), len );
 					}
 				}
 
 				QString string = itemName( index( c, 0 ) );
 				int len = string.length();
-				device.write( (char *)&len, 4 );
-				device.write( string.toLatin1().constData(), len );
+				out.writeBytes( (char *)&len, 4 );
+				out.writeBytes( string.toLatin1().constData(), len );
 
 				if ( version < 0x0303000d ) {
-					device.write( (char *)&c, 4 );
+					out.writeBytes( (char *)&c, 4 );
 				}
 			}
 		}
 
-		if ( !saveItem( root->child( c ), stream ) ) {
+		if ( !saveItem( root->child( c ), out ) ) {
 			Message::critical( nullptr, tr( "Failed to write block %1 (%2)." ).arg( itemName( index( c, 0 ) ) ).arg( c - 1 ) );
-			resetState();
 			return false;
 		}
+		return true;
+	};
+
+	bool ok = true;
+	if ( itemBlockSizes ) {
+		// The header is written with one placeholder size per block, so that it has its final length
+		setState( Processing );
+		mdl->updateArraySize( itemBlockSizes );
+		restoreState();
+		qint64 blockSizesPos = device.pos() + fileOffset( itemToIndex( itemBlockSizes ) );
+		int nBlocks = itemBlockSizes->childCount();
+		ok = ( blockSizesPos >= device.pos() );
+
+		for ( int c = 0; c < firstBlockRow() && ok; c++ )
+			ok = saveRow( c, stream );
+
+		// Each block goes to the device as soon as it is written, its size is taken from the stream position
+		QVector<int> blockSizes;
+		blockSizes.reserve( nBlocks );
+		for ( int c = firstBlockRow(); c <= lastBlockRow() && ok; c++ ) {
+			mdl->updateChildArraySizes( root->child( c ) );
+			qint64 start = stream.pos();
+			ok = saveRow( c, stream ) && stream.flush();
+			blockSizes.append( int( stream.pos() - start ) );
+		}
+
+		for ( int c = lastBlockRow() + 1; c < rows && ok; c++ )
+			ok = saveRow( c, stream );
+		ok = stream.flush() && ok;
+
+		// Back-patch the Block Size array in the header
+		if ( ok ) {
+			setState( Processing );
+			bool sizesOk = ( blockSizes.count() == nBlocks && itemBlockSizes->setArray<int>( blockSizes ) );
+			restoreState();
+
+			qint64 end = device.pos();
+			NifOStream patch( this, &device );
+			ok = sizesOk && device.seek( blockSizesPos ) && saveItem( itemBlockSizes, patch ) && patch.flush()
+				 && patch.pos() == qint64( nBlocks ) * 4 && device.seek( end );
+			if ( !ok )
+				Message::critical( nullptr, tr( "Failed to write the block sizes." ) );
+		}
+
+		resetState();
+		return ok;
 	}
 
-	if ( version < 0x0303000d ) {
+	for ( int c = 0; c < rows && ok; c++ )
+		ok = saveRow( c, stream );
+
+	if ( ok && version < 0x0303000d ) {
 		QString string = "End Of File";
 		int len = string.length();
-		device.write( (char *)&len, 4 );
-		device.write( string.toLatin1().constData(), len );
+		stream.writeBytes( (char *)&len, 4 );
+		stream.writeBytes( string.toLatin1().constData(), len );
 	}
 
+	ok = stream.flush() && ok;
 	resetState();
-	return true;
+	return ok;
 }
 
 bool NifModel::loadIndex( QIODevice & device, const QModelIndex & index )
@@ -2173,7 +2266,14 @@ bool NifModel::loadHeaderOnly( const QString & fname )
 		return false;
 	}
 
-	NifIStream stream( this, &f );
+	return loadHeaderOnly( f );
+}
+
+bool NifModel::loadHeaderOnly( QIODevice & device )
+{
+	clear();
+
+	NifIStream stream( this, &device );
 
 	// read header
 	NifItem * header = getHeaderItem();
@@ -2195,20 +2295,26 @@ bool NifModel::earlyRejection( const QString & filepath, const QString & blockId
 		return false;
 	}
 
+	return nif.headerMatches( blockId, v );
+}
+
+bool NifModel::headerMatches( const QString & blockId, quint32 v ) const
+{
 	bool ver_match = false;
 
 	if ( v == 0 ) {
 		ver_match = true;
-	} else if ( v != 0 && nif.getVersionNumber() == v ) {
+	} else if ( v != 0 && version == v ) {
 		ver_match = true;
 	}
 
 	bool blk_match = false;
 
-	if ( blockId.isEmpty() == true || v < 0x0A000100 ) {
+	// files before 10.1.0.0 have no block type list in the header
+	if ( blockId.isEmpty() == true || version < 0x0A000100 ) {
 		blk_match = true;
 	} else {
-		const auto & types = nif.getArray<QString>( nif.getHeaderItem(), "Block Types" );
+		const auto & types = getArray<QString>( getHeaderItem(), "Block Types" );
 		for ( const QString& s : types ) {
 			if ( inherits( s, blockId ) ) {
 				blk_match = true;
@@ -2225,7 +2331,7 @@ bool NifModel::saveIndex( QIODevice & device, const QModelIndex & index ) const
 	const NifItem * item = getItem( index );
 	if ( item ) {
 		NifOStream stream( this, &device );
-		return saveItem( item, stream );
+		return saveItem( item, stream ) && stream.flush();
 	}
 	return false;
 }
@@ -2299,7 +2405,12 @@ int NifModel::blockSize( const NifItem * item, NifSStream & stream ) const
 					}
 				}
 
-				size += blockSize( child, stream );
+				if ( child->isPacked() ) {
+					for ( const NifValue & v : child->packedValues() )
+						size += stream.size( v );
+				} else {
+					size += blockSize( child, stream );
+				}
 			} else {
 				size += stream.size( child->value() );
 			}
@@ -2326,10 +2437,16 @@ bool NifModel::loadItem( NifItem * parent, NifIStream & stream )
 
 		if ( evalCondition( child ) ) {
 			if ( child->isArray() ) {
-				if ( !updateArraySize( child ) )
-					return false;
-				if ( !loadItem( child, stream ) )
-					return false;
+				int size = packedElementSize( child, stream );
+				if ( size > 0 ) {
+					if ( !loadPackedArray( child, size, stream ) )
+						return false;
+				} else {
+					if ( !updateArraySize( child ) )
+						return false;
+					if ( !loadArray( child, stream ) )
+						return false;
+				}
 			} else if ( child->childCount() > 0 ) {
 				if ( !loadItem( child, stream ) )
 					return false;
@@ -2343,6 +2460,189 @@ bool NifModel::loadItem( NifItem * parent, NifIStream & stream )
 	return true;
 }
 
+bool NifModel::loadArray( NifItem * array, NifIStream & stream )
+{
+	int n = array->childCount();
+	if ( !bulkLoading || n < 2 || array->isBinary() )
+		return loadItem( array, stream );
+
+	NifItem * first = array->child( 0 );
+	if ( !first || first->isArray() )
+		return loadItem( array, stream );
+
+	QByteArray buf;
+
+	if ( first->childCount() == 0 ) {
+		// Array of values (Triangles, Vertices, UV Sets etc.), all of the same type
+		int size = stream.fixedSize( first->value() );
+		if ( size <= 0 )
+			return loadItem( array, stream );
+
+		if ( !stream.readBytes( buf, qint64( size ) * n ) )
+			return false;
+
+		const char * data = buf.constData();
+		for ( auto child : array->childIter() ) {
+			stream.decode( child->value(), data );
+			data += size;
+		}
+
+		return true;
+	}
+
+	if ( !isFixedCompound( first->strType() ) )
+		return loadItem( array, stream );
+
+	// Array of fixed compounds (Vertex Data): the first structure is loaded normally,
+	// it caches the conditions for all the others (see getConditionCacheItem)
+	first->invalidateCondition();
+	if ( !evalCondition( first ) )
+		return loadItem( array, stream );
+	if ( !loadItem( first, stream ) )
+		return false;
+
+	int size = fixedCompoundSize( first, stream );
+	if ( size <= 0 ) {
+		for ( int i = 1; i < n; i++ ) {
+			NifItem * child = array->child( i );
+			child->invalidateCondition();
+			if ( evalCondition( child ) && !loadItem( child, stream ) )
+				return false;
+		}
+
+		return true;
+	}
+
+	if ( !stream.readBytes( buf, qint64( size ) * ( n - 1 ) ) )
+		return false;
+
+	const char * data = buf.constData();
+	for ( int i = 1; i < n; i++ ) {
+		if ( !decodeFixedCompound( first, array->child( i ), stream, data ) )
+			return false;
+	}
+
+	return true;
+}
+
+int NifModel::packedElementSize( const NifItem * array, const NifIStream & stream ) const
+{
+	// Only arrays of simple values are packed. The renderer and the spells read compound
+	// elements (Vertex Data) field by field through model indices, which would unpack them
+	// on the first frame, and their layout depends on conditions (Vertex Desc) which can be edited.
+	if ( !bulkLoading || array->isBinary() || array->isCompound() || array->isMultiArray() )
+		return 0;
+
+	// Arrays which already have child items (loadIndex etc.) are loaded the usual way
+	if ( array->childCount() > 0 && !array->isPacked() )
+		return 0;
+
+	// Links and strings need their items for the link caches and string lookups
+	NifValue v( NifValue::type( array->strType() ) );
+	if ( v.isLink() || v.isString() || v.type() == NifValue::tStringIndex )
+		return 0;
+
+	int size = stream.fixedSize( v );
+	if ( size <= 0 )
+		return 0;
+
+	int n = evalArraySize( array );
+	if ( n < MinPackedArraySize || n > 1024 * 1024 * 8 )
+		return 0;
+
+	return size;
+}
+
+bool NifModel::loadPackedArray( NifItem * array, int size, NifIStream & stream )
+{
+	if ( array->isPacked() ) {
+		if ( !updateArraySize( array ) )
+			return false;
+	} else {
+		int n = evalArraySize( array );
+		beginInsertRows( itemToIndex(array), 0, n - 1 );
+		array->setPackedChildren( arrayElementData( array ), n );
+		endInsertRows();
+	}
+
+	QVector<NifValue> & values = array->packedValues();
+
+	QByteArray buf;
+	if ( !stream.readBytes( buf, qint64( size ) * values.count() ) )
+		return false;
+
+	const char * data = buf.constData();
+	for ( NifValue & v : values ) {
+		stream.decode( v, data );
+		data += size;
+	}
+
+	return true;
+}
+
+int NifModel::fixedCompoundSize( const NifItem * ref, const NifIStream & stream ) const
+{
+	int size = 0;
+
+	for ( auto child : ref->childIter() ) {
+		if ( child->isAbstract() || !evalCondition( child ) )
+			continue;
+
+		if ( child->isArray() ) {
+			// Nested arrays must have a constant length ("Bone Weights" etc.)
+			bool ok = false;
+			child->arr1().toInt( &ok );
+			if ( !ok || child->isBinary() )
+				return 0;
+		}
+
+		if ( child->isArray() || child->childCount() > 0 ) {
+			if ( child->childCount() > 0 ) {
+				int s = fixedCompoundSize( child, stream );
+				if ( s <= 0 )
+					return 0;
+				size += s;
+			}
+		} else {
+			int s = stream.fixedSize( child->value() );
+			if ( s <= 0 )
+				return 0;
+			size += s;
+		}
+	}
+
+	return size;
+}
+
+bool NifModel::decodeFixedCompound( const NifItem * ref, NifItem * target, const NifIStream & stream, const char *& data )
+{
+	int n = ref->childCount();
+	if ( target->childCount() != n )
+		return false;
+
+	for ( int i = 0; i < n; i++ ) {
+		const NifItem * r = ref->child( i );
+		if ( r->isAbstract() || !evalCondition( r ) )
+			continue;
+
+		NifItem * t = target->child( i );
+		if ( t->isArray() ) {
+			if ( !updateArraySize( t ) || t->childCount() != r->childCount() )
+				return false;
+		}
+
+		if ( t->isArray() || t->childCount() > 0 ) {
+			if ( !decodeFixedCompound( r, t, stream, data ) )
+				return false;
+		} else {
+			stream.decode( t->value(), data );
+			data += stream.fixedSize( t->value() );
+		}
+	}
+
+	return true;
+}
+
 bool NifModel::loadHeader( NifItem * header, NifIStream & stream )
 {
 	// Load header separately and invalidate conditions before reading
@@ -2413,8 +2713,14 @@ bool NifModel::saveItem( const NifItem * parent, NifOStream & stream ) const
 
 				}
 
-				if ( !saveItem( child, stream ) )
+				if ( child->isPacked() ) {
+					for ( const NifValue & v : child->packedValues() ) {
+						if ( !stream.write( v ) )
+							return false;
+					}
+				} else if ( !saveItem( child, stream ) ) {
 					return false;
+				}
 			} else {
 				if ( !stream.write( child->value() ) )
 					return false;
@@ -2437,7 +2743,10 @@ bool NifModel::fileOffset( const NifItem * parent, const NifItem * target, NifSS
 			return true;
 
 		if ( evalCondition( child ) ) {
-			if ( child->isArray() || child->childCount() > 0 ) {
+			if ( child->isPacked() ) {
+				for ( const NifValue & v : child->packedValues() )
+					ofs += stream.size( v );
+			} else if ( child->isArray() || child->childCount() > 0 ) {
 				if ( fileOffset( child, target, stream, ofs ) )
 					return true;
 			} else {
@@ -2553,48 +2862,198 @@ void NifModel::updateLinks( int block )
 		return;
 	}
 
-	if ( block >= 0 ) {
-		childLinks[ block ].clear();
-		parentLinks[ block ].clear();
+	int n = getBlockCount();
+	if ( block >= 0 && childLinks.count() == n ) {
+		if ( block >= n )
+			return;
+
+		removeTextureSetLinks();
+
+		for ( const auto c : std::as_const( childLinks[block] ) ) {
+			if ( c < n )
+				childRefs[c].removeOne( block );
+		}
+		childLinks[block].clear();
+		parentLinks[block].clear();
 		updateLinks( block, getBlockItem( block ) );
-	} else {
-		rootLinks.clear();
-		childLinks.clear();
-		parentLinks.clear();
 
-		// Run updateLinks() for each block
-		for ( int c = 0; c < getBlockCount(); c++ )
-			updateLinks( c );
+		// Only the links of this block can have closed a cycle, which is found among the descendants of their targets
+		QList<int> & links = childLinks[block];
+		for ( int i = 0; i < links.count(); ) {
+			int c = links.at( i );
+			if ( c < n && linkReaches( c, block ) ) {
+				logWarning(tr("Infinite recursive link detected (%1 -> %2 -> %1)").arg(block).arg(c));
+				links.removeAt( i );
+				continue;
+			}
+			if ( c < n )
+				childRefs[c].append( block );
+			i++;
+		}
+
+		updateRootLinks();
+		return;
+	}
 
-		// Run checkLinks() for each block
-		for ( int c = 0; c < getBlockCount(); c++ ) {
-			QStack<int> stack;
-			checkLinks( c, stack );
+	// Rebuild the whole graph
+	childLinks = QVector<QList<int> >( n );
+	parentLinks = QVector<QList<int> >( n );
+	childRefs = QVector<QList<int> >( n );
+	textureSetLinks.clear();
+
+	for ( int c = 0; c < n; c++ )
+		updateLinks( c, getBlockItem( c ) );
+
+	removeLinkCycles();
+
+	for ( int c = 0; c < n; c++ ) {
+		for ( const auto d : std::as_const( childLinks[c] ) ) {
+			if ( d < n )
+				childRefs[d].append( c );
 		}
+	}
 
+	updateRootLinks();
+}
 
-		int n = getBlockCount();
-		QByteArray hasrefs( n, 0 );
+void NifModel::updateItemLinks( const NifItem * item )
+{
+	int block = getBlockNumber( item );
+	updateLinks( block >= 0 ? block : -1 );
+}
 
-		for ( int c = 0; c < n; c++ ) {
-			for ( const auto d : childLinks.value( c ) ) {
-				if ( d >= 0 && d < n )
-					hasrefs[d] = 1;
+void NifModel::removeLinkCycles()
+{
+	int n = childLinks.count();
+	// 0: not visited yet, 1: on the current path, 2: done
+	QVector<quint8> visited( n, 0 );
+	QVector<QPair<int, int> > path;
+
+	for ( int c = 0; c < n; c++ ) {
+		if ( visited[c] )
+			continue;
+
+		visited[c] = 1;
+		path.append( { c, 0 } );
+		while ( !path.isEmpty() ) {
+			int b = path.last().first;
+			int i = path.last().second;
+			QList<int> & links = childLinks[b];
+			if ( i >= links.count() ) {
+				visited[b] = 2;
+				path.removeLast();
+				continue;
+			}
+
+			int child = links.at( i );
+			if ( child < n && visited[child] == 1 ) {
+				logWarning(tr("Infinite recursive link detected (%1 -> %2 -> %1)").arg(b).arg(child));
+				links.removeAt( i );
+				continue;
+			}
+
+			path.last().second = i + 1;
+			if ( child < n && visited[child] == 0 ) {
+				visited[child] = 1;
+				path.append( { child, 0 } );
 			}
 		}
+	}
+}
 
-		for ( int c = 0; c < n; c++ ) {
-			if ( !hasrefs[c] ) {
-				const NifItem *	b;
-				if ( bsVersion >= 151 && ( b = getBlockItem( qint32(c) ) ) != nullptr && b->name() == "BSShaderTextureSet" ) {
-					if ( c > 0 && ( b = getBlockItem( qint32(c - 1) ) ) != nullptr && b->name() == "BSLightingShaderProperty" )
-						childLinks[c - 1] += c;
-				} else {
-					rootLinks.append( c );
-				}
+bool NifModel::linkReaches( int block, int target ) const
+{
+	if ( block == target )
+		return true;
+
+	int n = childLinks.count();
+	QVector<int> stack = { block };
+	QSet<int> visited = { block };
+	while ( !stack.isEmpty() ) {
+		int b = stack.takeLast();
+		for ( const auto c : childLinks.at( b ) ) {
+			if ( c == target )
+				return true;
+			if ( c < n && !visited.contains( c ) ) {
+				visited.insert( c );
+				stack.append( c );
 			}
 		}
 	}
+
+	return false;
+}
+
+void NifModel::remapLinks( int oldBlockCount, const std::function<int( int )> & map )
+{
+	if ( lockUpdates || childLinks.count() != oldBlockCount ) {
+		updateLinks();
+		return;
+	}
+
+	removeTextureSetLinks();
+
+	int n = getBlockCount();
+	QVector<QList<int> > newChildLinks( n );
+	QVector<QList<int> > newParentLinks( n );
+	auto mapList = [&map]( const QList<int> & links, QList<int> & newLinks ) {
+		for ( const auto l : links ) {
+			int m = map( l );
+			if ( m >= 0 )
+				newLinks.append( m );
+		}
+	};
+
+	for ( int b = 0; b < oldBlockCount; b++ ) {
+		int m = map( b );
+		if ( m < 0 || m >= n )
+			continue;
+		mapList( childLinks.at( b ), newChildLinks[m] );
+		mapList( parentLinks.at( b ), newParentLinks[m] );
+	}
+
+	childLinks.swap( newChildLinks );
+	parentLinks.swap( newParentLinks );
+
+	childRefs = QVector<QList<int> >( n );
+	for ( int b = 0; b < n; b++ ) {
+		for ( const auto c : std::as_const( childLinks[b] ) ) {
+			if ( c < n )
+				childRefs[c].append( b );
+		}
+	}
+
+	updateRootLinks();
+}
+
+void NifModel::updateRootLinks()
+{
+	rootLinks.clear();
+
+	int n = childRefs.count();
+	for ( int c = 0; c < n; c++ ) {
+		if ( !childRefs.at( c ).isEmpty() )
+			continue;
+
+		const NifItem *	b;
+		if ( bsVersion >= 151 && ( b = getBlockItem( qint32(c) ) ) != nullptr && b->name() == "BSShaderTextureSet" ) {
+			if ( c > 0 && ( b = getBlockItem( qint32(c - 1) ) ) != nullptr && b->name() == "BSLightingShaderProperty" ) {
+				childLinks[c - 1] += c;
+				textureSetLinks.append( c );
+			}
+		} else {
+			rootLinks.append( c );
+		}
+	}
+}
+
+void NifModel::removeTextureSetLinks()
+{
+	for ( const auto c : std::as_const( textureSetLinks ) ) {
+		if ( c > 0 && c <= childLinks.count() )
+			childLinks[c - 1].removeOne( c );
+	}
+	textureSetLinks.clear();
 }
 
 void NifModel::updateLinks( int block, NifItem * parent )
@@ -2633,24 +3092,9 @@ void NifModel::updateLinks( int block, NifItem * parent )
 	}
 }
 
-void NifModel::checkLinks( int block, QStack<int> & parents )
-{
-	parents.push( block );
-	foreach ( const auto child, childLinks.value( block ) ) {
-		if ( parents.contains( child ) ) {
-			logWarning(tr("Infinite recursive link detected (%1 -> %2 -> %1)").arg(block).arg(child));
-
-			childLinks[block].removeAll( child );
-		} else {
-			checkLinks( child, parents );
-		}
-	}
-	parents.pop();
-}
-
 void NifModel::adjustLinks( NifItem * parent, int block, int delta )
 {
-	if ( !parent )
+	if ( !parent || parent->isPacked() ) // Packed arrays hold no links
 		return;
 
 	if ( parent->childCount() > 0 ) {
@@ -2670,7 +3114,7 @@ void NifModel::adjustLinks( NifItem * parent, int block, int delta )
 
 void NifModel::mapLinks( NifItem * parent, const QMap<qint32, qint32> & map )
 {
-	if ( !parent )
+	if ( !parent || parent->isPacked() ) // Packed arrays hold no links
 		return;
 
 	if ( parent->childCount() > 0 ) {
@@ -2744,7 +3188,7 @@ bool NifModel::setLinkArray( NifItem * arrayRootItem, const QVector<qint32> & li
 	onArrayValuesChange( arrayRootItem );
 
 	if ( !arrayRootItem->isDescendantOf( getFooterItem() ) ) {
-		updateLinks();
+		updateItemLinks( arrayRootItem );
 		updateFooter();
 		emit linksChanged();
 	}
@@ -2754,16 +3198,17 @@ bool NifModel::setLinkArray( NifItem * arrayRootItem, const QVector<qint32> & li
 
 int NifModel::getParent( int block ) const
 {
-	int parent = -1;
+	if ( block < 0 || block >= childRefs.count() )
+		return -1;
 
-	for ( int b = 0; b < getBlockCount(); b++ ) {
-		if ( childLinks.value( b ).contains( block ) ) {
-			parent = b;
-			break;
-		}
-	}
+	const QList<int> & refs = childRefs.at( block );
+	if ( !refs.isEmpty() )
+		return *std::min_element( refs.cbegin(), refs.cend() );
+
+	if ( textureSetLinks.contains( block ) )
+		return block - 1;
 
-	return parent;
+	return -1;
 }
 
 int NifModel::getParent( const QModelIndex & index ) const
@@ -2929,6 +3374,7 @@ void NifModel::convertNiBlock( const QString & identifier, const QModelIndex & i
 
 	if ( srcBlock && dstBlock ) {
 		branch->setName( identifier );
+		branch->setFieldTable( dstBlock->fields );
 
 		if ( inherits( oldType, identifier ) ) {
 			// Remove any level between the two types
@@ -2982,7 +3428,7 @@ void NifModel::convertNiBlock( const QString & identifier, const QModelIndex & i
 
 		if ( state != Loading ) {
 			updateHeader();
-			updateLinks();
+			updateItemLinks( branch );
 			updateFooter();
 			emit linksChanged();
 		}
@@ -3041,7 +3487,7 @@ void NifModel::onItemValueChange( NifItem * item )
 	BaseModel::onItemValueChange( item );
 
 	if ( item->isLink() && !item->isDescendantOf( getFooterItem() ) ) {
-		updateLinks();
+		updateItemLinks( item );
 		updateFooter();
 		emit linksChanged();
 	}
@@ -3077,6 +3523,20 @@ QVariant NifModelEval::operator()( const QVariant & v ) const
 	return v;
 }
 
+quint64 NifModelEval::symbol( const NifExpr::Symbol & s ) const
+{
+	const NifItem * itemLeft = model->getItem( item, s.name, false );
+
+	if ( itemLeft ) {
+		if ( itemLeft->isCount() )
+			return itemLeft->getCountValue();
+		else if ( itemLeft->isFileVersion() )
+			return itemLeft->getFileVersionValue();
+	}
+
+	return 0;
+}
+
 /*
  * GameManager interface
  */
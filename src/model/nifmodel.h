@@ -41,6 +41,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QStack>
 #include <QStringList>
 
+#include <functional>
 #include <memory>
 
 class SpellBook;
@@ -79,7 +80,15 @@ public:
 	static const NifModel * fromValidIndex( const QModelIndex & index );
 
 	//! Find and parse the XML file
-	static bool loadXML();
+	/*!
+	 * The parsed schema is stored in a binary cache, which is loaded instead of parsing the XML file
+	 * again as long as the contents of the file and the build of NifSkope do not change.
+	 */
+	static bool loadXML( bool useSchemaCache = true );
+	//! The time spent by the last loadXML() in milliseconds
+	static double lastXmlLoadTime() { return xmlLoadTime; }
+	//! Whether the last loadXML() read the schema from the binary cache
+	static bool lastXmlLoadFromCache() { return xmlLoadedFromCache; }
 
 	//! When creating NifModels from outside the main thread protect them with a QReadLocker
 	static QReadWriteLock XMLlock;
@@ -121,6 +130,11 @@ public:
 	bool loadAndMapLinks( QIODevice & device, const QModelIndex &, const QMap<qint32, qint32> & map );
 	//! Loads the header from a filename
 	bool loadHeaderOnly( const QString & fname );
+	//! Loads the header from a QIODevice
+	bool loadHeaderOnly( QIODevice & device );
+
+	//! Read arrays of fixed size values with one device read per array and keep large ones packed (default), or one value at a time
+	void setBulkLoading( bool enable ) { bulkLoading = enable; }
 
 	//! Returns the the estimated file offset of the model index
 	int fileOffset( const QModelIndex & ) const;
@@ -140,6 +154,15 @@ public:
 	 */
 	bool earlyRejection( const QString & filepath, const QString & blockId, quint32 version );
 
+	/*! Checks if the loaded header lists a block type that inherits the specified block ID, and is of the specified version
+	 *
+	 * This is the test of earlyRejection() on a header that has already been loaded, e.g. with loadHeaderOnly().
+	 *
+	 * @param blockId	The block to check for, or empty to accept any block types
+	 * @param version	The version to check for, or 0 to accept any version
+	 */
+	bool headerMatches( const QString & blockId, quint32 version ) const;
+
 	const NifItem * getHeaderItem() const;
 	NifItem * getHeaderItem();
 	//! Returns the model index of the NiHeader
@@ -147,7 +170,11 @@ public:
 	QModelIndex getHeaderIndex() const;
 
 	//! Updates the header infos ( num blocks etc. )
-	void updateHeader();
+	/*!
+	 * @param updateBlockSizes	False skips the calculation of the Block Size array, save() fills it in
+	 *							from the sizes of the written blocks instead
+	 */
+	void updateHeader( bool updateBlockSizes = true );
 	//! Extracts the 0x01 separated args from NiDataStream. NiDataStream is the only known block to use RTTI args.
 	QString extractRTTIArgs( const QString & RTTIName, NiMesh::DataStreamMetadata & metadata ) const;
 	//! Creates the 0x01 separated args for NiDataStream. NiDataStream is the only known block to use RTTI args.
@@ -452,6 +479,8 @@ public:
 	template <typename T> T get( const NifItem * itemParent, const QLatin1String & itemName ) const;
 	//! Get the value of a child item.
 	template <typename T> T get( const NifItem * itemParent, const char * itemName ) const;
+	//! Get the value of a child item by interned name.
+	template <typename T> T get( const NifItem * itemParent, NifFieldId itemId ) const;
 	//! Get the value of a model index.
 	template <typename T> T get( const QModelIndex & index ) const;
 	//! Get the value of a child item.
@@ -462,6 +491,8 @@ public:
 	template <typename T> T get( const QModelIndex & itemParent, const QLatin1String & itemName ) const;
 	//! Get the value of a child item.
 	template <typename T> T get( const QModelIndex & itemParent, const char * itemName ) const;
+	//! Get the value of a child item by interned name.
+	template <typename T> T get( const QModelIndex & itemParent, NifFieldId itemId ) const;
 
 	// Item value setters
 public:
@@ -560,6 +591,8 @@ public:
 	qint32 getLink( const NifItem * itemParent, const QLatin1String & itemName ) const;
 	//! Return the link value (block number) of a child item if it's a valid link, otherwise -1.
 	qint32 getLink( const NifItem * itemParent, const char * itemName ) const;
+	//! Return the link value (block number) of a child item if it's a valid link, otherwise -1.
+	qint32 getLink( const NifItem * itemParent, NifFieldId itemId ) const;
 	//! Return the link value (block number) of a model index if it's a valid link, otherwise -1.
 	qint32 getLink( const QModelIndex & index ) const;
 	//! Return the link value (block number) of a child item if it's a valid link, otherwise -1.
@@ -570,6 +603,8 @@ public:
 	qint32 getLink( const QModelIndex & itemParent, const QLatin1String & itemName ) const;
 	//! Return the link value (block number) of a child item if it's a valid link, otherwise -1.
 	qint32 getLink( const QModelIndex & itemParent, const char * itemName ) const;
+	//! Return the link value (block number) of a child item if it's a valid link, otherwise -1.
+	qint32 getLink( const QModelIndex & itemParent, NifFieldId itemId ) const;
 
 	// Link setters
 public:
@@ -606,6 +641,8 @@ public:
 	QVector<qint32> getLinkArray( const NifItem * arrayParent, const QLatin1String & arrayName ) const;
 	//! Return a QVector of link values (block numbers) of a child item if it's a valid link array.
 	QVector<qint32> getLinkArray( const NifItem * arrayParent, const char * arrayName ) const;
+	//! Return a QVector of link values (block numbers) of a child item if it's a valid link array.
+	QVector<qint32> getLinkArray( const NifItem * arrayParent, NifFieldId arrayId ) const;
 	//! Return a QVector of link values (block numbers) of a model index if it's a valid link array.
 	QVector<qint32> getLinkArray( const QModelIndex & iArray ) const;
 	//! Return a QVector of link values (block numbers) of a child item if it's a valid link array.
@@ -616,6 +653,8 @@ public:
 	QVector<qint32> getLinkArray( const QModelIndex & arrayParent, const QLatin1String & arrayName ) const;
 	//! Return a QVector of link values (block numbers) of a child item if it's a valid link array.
 	QVector<qint32> getLinkArray( const QModelIndex & arrayParent, const char * arrayName ) const;
+	//! Return a QVector of link values (block numbers) of a child item if it's a valid link array.
+	QVector<qint32> getLinkArray( const QModelIndex & arrayParent, NifFieldId arrayId ) const;
 
 	// Link array setters
 public:
@@ -681,6 +720,16 @@ protected:
 	// end BaseModel
 
 	bool loadItem( NifItem * parent, NifIStream & stream );
+	//! Loads the elements of an array, reading arrays of fixed size values and fixed compounds in bulk
+	bool loadArray( NifItem * array, NifIStream & stream );
+	//! Size in bytes of an element if the array should be loaded as packed values, otherwise 0
+	int packedElementSize( const NifItem * array, const NifIStream & stream ) const;
+	//! Loads an array of fixed size values into packed storage (see NifItem::isPacked)
+	bool loadPackedArray( NifItem * array, int size, NifIStream & stream );
+	//! Size in bytes of the active fields of a loaded fixed compound, or 0 if any of them has a variable size
+	int fixedCompoundSize( const NifItem * ref, const NifIStream & stream ) const;
+	//! Decodes a fixed compound from memory, using the already loaded \a ref for conditions and array sizes
+	bool decodeFixedCompound( const NifItem * ref, NifItem * target, const NifIStream & stream, const char *& data );
 	bool loadHeader( NifItem * parent, NifIStream & stream );
 	bool saveItem( const NifItem * parent, NifOStream & stream ) const;
 	bool fileOffset( const NifItem * parent, const NifItem * target, NifSStream & stream, int & ofs ) const;
@@ -690,9 +739,25 @@ protected:
 	void insertType( NifItem * parent, const NifData & data, int row = -1 );
 	NifItem * insertBranch( NifItem * parent, const NifData & data, int row = -1 );
 
+	//! Rebuilds the link graph, or updates the links of a single block if \a block is not -1
 	void updateLinks( int block = -1 );
 	void updateLinks( int block, NifItem * parent );
-	void checkLinks( int block, QStack<int> & parents );
+	//! Updates the links of the block containing \a item, or all links if it is not in a block
+	void updateItemLinks( const NifItem * item );
+	//! Removes the child links that close a cycle, with a single depth-first search over all blocks
+	void removeLinkCycles();
+	//! Returns true if \a target is \a block or one of its descendants through child links
+	bool linkReaches( int block, int target ) const;
+	//! Renumbers the blocks and links of the link graph after blocks were inserted, removed or moved
+	/*!
+	 * @param oldBlockCount	The number of blocks before the change, the graph is rebuilt if it does not match
+	 * @param map			Returns the new number of a block or link, or -1 if it was removed
+	 */
+	void remapLinks( int oldBlockCount, const std::function<int( int )> & map );
+	//! Recalculates rootLinks from the blocks that have no child link to them
+	void updateRootLinks();
+	//! Removes the child links added by updateRootLinks()
+	void removeTextureSetLinks();
 	void adjustLinks( NifItem * parent, int block, int delta );
 	void mapLinks( NifItem * parent, const QMap<qint32, qint32> & map );
 
@@ -701,9 +766,14 @@ protected:
 	//! NIF file version
 	quint32 version;
 
-	QHash<int, QList<int> > childLinks;
-	QHash<int, QList<int> > parentLinks;
+	//! Child links and uplinks of each block, indexed by block number
+	QVector<QList<int> > childLinks;
+	QVector<QList<int> > parentLinks;
+	//! Blocks that have a child link to each block, the reverse edges of childLinks
+	QVector<QList<int> > childRefs;
 	QList<int> rootLinks;
+	//! Unreferenced BSShaderTextureSet blocks linked from the previous BSLightingShaderProperty in childLinks
+	QList<int> textureSetLinks;
 
 	bool lockUpdates;
 
@@ -722,6 +792,8 @@ protected:
 	quint32 bsVersion;
 	void cacheBSVersion( const NifItem * headerItem );
 
+	bool bulkLoading = true;
+
 	QString topItemRepr( const NifItem * item ) const override final;
 	void onItemValueChange( NifItem * item ) override final;
 
@@ -769,8 +841,14 @@ public:
 		void * fileListFilterFuncData = nullptr ) const;
 
 protected:
-	//! Parse the XML file using a NifXmlHandler
-	static QString parseXmlDescription( const QString & filename );
+	//! Parse the XML file using a NifXmlHandler, or load the schema from the cache
+	static QString parseXmlDescription( const QString & filename, bool useCache = true );
+	//! Load the cached schema if it was created with \a key, see parseXmlDescription
+	static bool readSchemaCache( const QByteArray & key );
+	//! Write the parsed schema to the cache
+	static void writeSchemaCache( const QByteArray & key );
+	//! Build the field tables of the compounds and blocks (see NifFieldTable)
+	static void buildFieldTables();
 
 	// XML structures
 	static QList<quint32> supportedVersions;
@@ -779,6 +857,9 @@ protected:
 	static QHash<QString, NifBlockPtr> blocks;
 	static QMap<quint32, NifBlockPtr> blockHashes;
 
+	static double xmlLoadTime;
+	static bool xmlLoadedFromCache;
+
 private:
 	struct Settings
 	{
@@ -796,6 +877,11 @@ public:
 	NifModelEval( const NifModel * model, const NifItem * item );
 
 	QVariant operator()( const QVariant & v ) const;
+
+	//! Value of a header field in a compiled expression (see NifExpr::run)
+	quint64 symbol( const NifExpr::Symbol & s ) const;
+	//! Version conditions have no #ARG#
+	quint64 arg() const { return 0; }
 private:
 	const NifModel * model;
 	const NifItem * item;
@@ -1268,6 +1354,10 @@ template <typename T> inline T NifModel::get( const NifItem * itemParent, const
 {
 	return get<T>( getItem(itemParent, QLatin1String(itemName)) );
 }
+template <typename T> inline T NifModel::get( const NifItem * itemParent, NifFieldId itemId ) const
+{
+	return get<T>( getItem(itemParent, itemId) );
+}
 template <typename T> inline T NifModel::get( const QModelIndex & index ) const
 {
 	return get<T>( getItem(index) );
@@ -1288,6 +1378,10 @@ template <typename T> inline T NifModel::get( const QModelIndex & itemParent, co
 {
 	return get<T>( getItem(itemParent, QLatin1String(itemName)) );
 }
+template <typename T> inline T NifModel::get( const QModelIndex & itemParent, NifFieldId itemId ) const
+{
+	return get<T>( getItem(itemParent, itemId) );
+}
 
 
 // Item value setters
@@ -1453,6 +1547,10 @@ inline qint32 NifModel::getLink( const NifItem * itemParent, const char * itemNa
 {
 	return getLink( getItem(itemParent, QLatin1String(itemName)) );
 }
+inline qint32 NifModel::getLink( const NifItem * itemParent, NifFieldId itemId ) const
+{
+	return getLink( getItem(itemParent, itemId) );
+}
 inline qint32 NifModel::getLink( const QModelIndex & index ) const
 {
 	return getLink( getItem(index) );
@@ -1473,6 +1571,10 @@ inline qint32 NifModel::getLink( const QModelIndex & itemParent, const char * it
 {
 	return getLink( getItem(itemParent, QLatin1String(itemName)) );
 }
+inline qint32 NifModel::getLink( const QModelIndex & itemParent, NifFieldId itemId ) const
+{
+	return getLink( getItem(itemParent, itemId) );
+}
 
 
 // Link setters
@@ -1533,6 +1635,10 @@ inline QVector<qint32> NifModel::getLinkArray( const NifItem * arrayParent, cons
 {
 	return getLinkArray( getItem(arrayParent, QLatin1String(arrayName)) );
 }
+inline QVector<qint32> NifModel::getLinkArray( const NifItem * arrayParent, NifFieldId arrayId ) const
+{
+	return getLinkArray( getItem(arrayParent, arrayId) );
+}
 inline QVector<qint32> NifModel::getLinkArray( const QModelIndex & iArray ) const
 {
 	return getLinkArray( getItem(iArray) );
@@ -1553,6 +1659,10 @@ inline QVector<qint32> NifModel::getLinkArray( const QModelIndex & arrayParent,
 {
 	return getLinkArray( getItem(arrayParent, QLatin1String(arrayName)) );
 }
+inline QVector<qint32> NifModel::getLinkArray( const QModelIndex & arrayParent, NifFieldId arrayId ) const
+{
+	return getLinkArray( getItem(arrayParent, arrayId) );
+}
 
 
 // Link array setters
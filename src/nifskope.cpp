@@ -64,6 +64,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QSettings>
 #include <QTimer>
 #include <QTranslator>
+#include <QUdpSocket>
 #include <QUrl>
 #include <QCryptographicHash>
 
@@ -290,7 +291,24 @@ NifSkope::NifSkope()
 	connect( bsaView, &QTreeView::doubleClicked, this, &NifSkope::openArchiveFile );
 
 	bsaModel = new BSAModel( this );
-	bsaProxyModel = new BSAProxyModel( this );
+
+	// Filter
+	bsaFilterTimer = new QTimer( this );
+	bsaFilterTimer->setSingleShot( true );
+
+	connect( ui->bsaFilter, &QLineEdit::textChanged, [this]() { bsaFilterTimer->start( 300 ); } );
+	connect( bsaFilterTimer, &QTimer::timeout, [this]() {
+		auto text = ui->bsaFilter->text();
+
+		bsaModel->setFilter( text );
+
+		// Expanding everything is only useful for a limited number of matches
+		if ( !text.isEmpty() && bsaModel->shownFileCount() <= 2000 )
+			bsaView->expandAll();
+	} );
+
+	connect( ui->bsaFilenameOnly, &QCheckBox::toggled, bsaModel, &BSAModel::setFilterByNameOnly );
+	connect( ui->bsaFilenameOnly, &QCheckBox::toggled, [this]() { bsaFilterTimer->start( 0 ); } );
 
 	// Empty Model for swapping out before model fill
 	emptyModel = new QStandardItemModel( this );
@@ -753,6 +771,7 @@ void NifSkope::clearCurrentArchive()
 
 	currentArchivePath.clear();
 	currentArchiveNames.clear();
+	bsaModel->clear();
 	delete currentArchive;
 	currentArchive = nullptr;
 }
@@ -887,10 +906,8 @@ bool NifSkope::loadArchivesFromFolder( QString archive )
 void NifSkope::openArchive( const QString & archive )
 {
 	// Clear memory from previously opened archives
-	bsaModel->clear();
-	bsaProxyModel->invalidate();
-	bsaProxyModel->setSourceModel( emptyModel );
 	bsaView->setModel( emptyModel );
+	bsaModel->clear();
 	bsaView->setSortingEnabled( false );
 
 	if ( currentArchive ) {
@@ -922,34 +939,22 @@ void NifSkope::openArchive( const QString & archive )
 	{
 		setCurrentArchive( isArchiveFolder );
 
-		// Models
-		bsaModel->init();
-
 		// Populate model from BSA
-		bsaModel->fillModel( currentArchive, "meshes" );
-
-		if ( bsaModel->rowCount() == 0 ) {
+		if ( !bsaModel->fillModel( currentArchive, "meshes" ) ) {
 			qCWarning( nsIo ) << "The BSA does not contain any meshes.";
 			clearCurrentArchive();
 			return;
 		}
 
-		// Set proxy and view only after filling source model
-		bsaProxyModel->setSourceModel( bsaModel );
-		bsaView->setModel( bsaProxyModel );
+		// Set view only after filling the model
+		bsaView->setModel( bsaModel );
 		bsaView->setSortingEnabled( true );
 
 		bsaView->hideColumn( 1 );
 		bsaView->setColumnWidth( 0, 300 );
 		bsaView->setColumnWidth( 2, 50 );
 
-		// Sort proxy after model/view is populated
-		bsaProxyModel->sort( 0, Qt::AscendingOrder );
-#if 0
-		// this is not needed because archives are already filtered on load
-		bsaProxyModel->setFiletypes( { ".nif", ".bto", ".btr" } );
-#endif
-		bsaProxyModel->resetFilter();
+		bsaView->sortByColumn( 0, Qt::AscendingOrder );
 
 		// Set filename label
 		ui->bsaName->setText( currentArchiveNames.back() );
@@ -960,30 +965,8 @@ void NifSkope::openArchive( const QString & archive )
 		// Bring tab to front
 		dBrowser->raise();
 
-		// Filter
-		auto filterTimer = new QTimer( this );
-		filterTimer->setSingleShot( true );
-
-		connect( ui->bsaFilter, &QLineEdit::textChanged, [filterTimer]() { filterTimer->start( 300 ); } );
-		connect( filterTimer, &QTimer::timeout, [this]() {
-			auto text = ui->bsaFilter->text();
-
-			bsaProxyModel->setFilterRegularExpression(
-				QRegularExpression::fromWildcard(
-					text, Qt::CaseInsensitive, QRegularExpression::UnanchoredWildcardConversion ) );
-			bsaView->expandAll();
-
-			if ( text.isEmpty() ) {
-				bsaView->collapseAll();
-				bsaProxyModel->resetFilter();
-			}
-
-		} );
-
-		connect( ui->bsaFilenameOnly, &QCheckBox::toggled, bsaProxyModel, &BSAProxyModel::setFilterByNameOnly );
-
 		// Update filter when switching open archives
-		filterTimer->start( 0 );
+		bsaFilterTimer->start( 0 );
 	}
 }
 
@@ -1436,3 +1419,74 @@ void NifSkope::migrateSettings() const
 	}
 #endif
 }
+
+/*
+*  IPC socket
+*/
+
+IPCsocket * IPCsocket::create( int port )
+{
+	QUdpSocket * udp = new QUdpSocket();
+
+	if ( udp->bind( QHostAddress( QHostAddress::LocalHost ), port, QUdpSocket::DontShareAddress ) ) {
+		IPCsocket * ipc = new IPCsocket( udp );
+		QDesktopServices::setUrlHandler( "nif", ipc, "openNif" );
+		return ipc;
+	}
+
+	return nullptr;
+}
+
+void IPCsocket::sendCommand( const QString & cmd, int port )
+{
+	QUdpSocket udp;
+	udp.writeDatagram( (const char *)cmd.data(), cmd.length() * sizeof( QChar ), QHostAddress( QHostAddress::LocalHost ), port );
+}
+
+IPCsocket::IPCsocket( QUdpSocket * s ) : QObject(), socket( s )
+{
+	QObject::connect( socket, &QUdpSocket::readyRead, this, &IPCsocket::processDatagram );
+}
+
+IPCsocket::~IPCsocket()
+{
+	delete socket;
+}
+
+void IPCsocket::processDatagram()
+{
+	while ( socket->hasPendingDatagrams() ) {
+		QByteArray data;
+		data.resize( socket->pendingDatagramSize() );
+		QHostAddress host;
+		quint16 port = 0;
+
+		socket->readDatagram( data.data(), data.size(), &host, &port );
+
+		if ( host == QHostAddress( QHostAddress::LocalHost ) && (data.size() % sizeof( QChar )) == 0 ) {
+			QString cmd;
+			cmd.setUnicode( (QChar *)data.data(), data.size() / sizeof( QChar ) );
+			execCommand( cmd );
+		}
+	}
+}
+
+void IPCsocket::execCommand( const QString & cmd )
+{
+	if ( cmd.startsWith( "NifSkope::open" ) ) {
+		openNif( cmd.right( cmd.length() - 15 ) );
+	}
+}
+
+void IPCsocket::openNif( const QUrl & url )
+{
+	auto file = url.toString();
+	file.remove( 0, 4 );
+
+	openNif( file );
+}
+
+void IPCsocket::openNif( const QString & url )
+{
+	NifSkope::createWindow( url );
+}
@@ -69,7 +69,6 @@ class SettingsDialog;
 class SpellBook;
 class BA2File;
 class BSAModel;
-class BSAProxyModel;
 class QStandardItemModel;
 class QAction;
 class QActionGroup;
@@ -202,6 +201,9 @@ public slots:
 	//! A slot for starting the XML checker.
 	void on_aShredder_triggered();
 
+	//! A slot for opening the file index window.
+	void on_aNifIndex_triggered();
+
 	//! Reset "block details"
 	void on_aHeader_triggered();
 
@@ -434,8 +436,8 @@ private:
 	//QAction * idxBackAction;
 
 	BSAModel * bsaModel;
-	BSAProxyModel * bsaProxyModel;
 	QStandardItemModel * emptyModel;
+	QTimer * bsaFilterTimer;
 
 	QMenu * mRecentArchiveFiles;
 };
@@ -48,6 +48,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ui/widgets/nifview.h"
 #include "ui/widgets/refrbrowser.h"
 #include "ui/widgets/inspect.h"
+#include "ui/widgets/nifindexwidget.h"
 #include "ui/widgets/xmlcheck.h"
 #include "ui/about_dialog.h"
 #include "ui/settingsdialog.h"
@@ -1429,6 +1430,11 @@ void NifSkope::on_aShredder_triggered()
 	TestShredder::create();
 }
 
+void NifSkope::on_aNifIndex_triggered()
+{
+	NifIndexWidget::create();
+}
+
 void NifSkope::on_aHeader_triggered()
 {
 	if ( tree )
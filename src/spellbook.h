@@ -45,6 +45,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QMap>
 #include <QPersistentModelIndex>
 #include <QString>
+#include <QStringList>
 
 #include <memory>
 
@@ -99,6 +100,43 @@ public:
 			cast( nif, index );
 	}
 
+	//! Cast the spell on a file that was loaded without a window (command line batch mode)
+	/*!
+	 * The default casts the spell on the whole file if it is applicable to an
+	 * invalid index, otherwise on each root block it is applicable to.
+	 * Spells that prompt for input or walk a folder themselves should reimplement
+	 * this to process the single file in \a nif. Lines appended to \a log are
+	 * written to the batch log under the name of the file.
+	 *
+	 * @return True if the file was modified and should be saved
+	 */
+	virtual bool castBatch( NifModel * nif, QStringList & log )
+	{
+		Q_UNUSED( log );
+		if ( isApplicable( nif, QModelIndex() ) ) {
+			cast( nif, QModelIndex() );
+			return !constant();
+		}
+
+		// Casting may insert or remove blocks
+		QList<QPersistentModelIndex> roots;
+		for ( const auto b : nif->getRootLinks() )
+			roots.append( nif->getBlockIndex( b ) );
+
+		bool casted = false;
+		for ( const auto & root : std::as_const( roots ) ) {
+			if ( root.isValid() && isApplicable( nif, root ) ) {
+				cast( nif, root );
+				casted = true;
+			}
+		}
+
+		return casted && !constant();
+	}
+
+	//! Whether castBatch may run on several files at the same time, each in its own model
+	virtual bool reentrant() const { return false; }
+
 	//! i18n wrapper for various strings
 	/*!
 	 * Note that we don't use QObject::tr() because that doesn't provide
@@ -46,26 +46,9 @@ public:
 
 	static bool is_Applicable( const NifModel * nif, const NifItem * item )
 	{
-		NifValue::Type	vt = item->valueType();
-		if ( vt != NifValue::tStringIndex && vt != NifValue::tSizedString && vt != NifValue::tSizedString16 ) {
-			if ( !( nif->checkVersion( 0x14010003, 0 ) && ( vt == NifValue::tString || vt == NifValue::tFilePath ) ) )
-				return false;
-		}
-		do {
-			if ( item->parent() && nif && nif->getBSVersion() >= 130 ) {
-				if ( item->name() == "Name" && ( item->parent()->name() == "BSLightingShaderProperty" || item->parent()->name() == "BSEffectShaderProperty" ) )
-					break;		// Fallout 4, 76 or Starfield material
-			}
-			if ( item->parent() && item->parent()->name() == "Textures" )
-				break;
-			if ( item->name() == "Path" || item->name() == "Mesh Path" || item->name().startsWith( "Texture " ) )
-				break;
-			return false;
-		} while ( false );
-		return !( nif->resolveString( item ).isEmpty() );
+		return !Game::GameManager::get_resource_path( nif, item ).empty();
 	}
 
-	static std::string getNifItemFilePath( NifModel * nif, const NifItem * item );
 	static std::string getOutputDirectory();
 	static void writeFileWithPath( const std::string & fileName, const char * buf, qsizetype bufSize );
 
@@ -78,34 +61,6 @@ public:
 	QModelIndex cast( NifModel * nif, const QModelIndex & index ) override final;
 };
 
-std::string spResourceFileExtract::getNifItemFilePath( NifModel * nif, const NifItem * item )
-{
-	const char *	archiveFolder = nullptr;
-	const char *	extension = nullptr;
-
-	quint32	bsVersion = nif->getBSVersion();
-	if ( item->parent() && bsVersion >= 130 && item->name() == "Name" ) {
-		if ( item->parent()->name() == "BSLightingShaderProperty" ) {
-			archiveFolder = "materials/";
-			extension = ( bsVersion < 170 ? ".bgsm" : ".mat" );
-		} else if ( item->parent()->name() == "BSEffectShaderProperty" ) {
-			archiveFolder = "materials/";
-			extension = ( bsVersion < 170 ? ".bgem" : ".mat" );
-		}
-	} else if ( ( item->parent() && item->parent()->name() == "Textures" ) || item->name().contains( "Texture" ) || ( bsVersion >= 170 && item->name() == "Path" ) ) {
-		archiveFolder = "textures/";
-		extension = ".dds";
-	} else if ( bsVersion >= 170 && item->name() == "Mesh Path" ) {
-		archiveFolder = "geometries/";
-		extension = ".mesh";
-	}
-
-	QString	filePath( nif->resolveString( item ) );
-	if ( filePath.isEmpty() )
-		return std::string();
-	return Game::GameManager::get_full_path( filePath, archiveFolder, extension );
-}
-
 std::string spResourceFileExtract::getOutputDirectory()
 {
 	QSettings	settings;
@@ -175,7 +130,7 @@ QModelIndex spResourceFileExtract::cast( NifModel * nif, const QModelIndex & ind
 	if ( !item )
 		return index;
 
-	std::string	filePath( getNifItemFilePath( nif, item ) );
+	std::string	filePath( Game::GameManager::get_resource_path( nif, item ) );
 	if ( filePath.empty() )
 		return index;
 
@@ -238,11 +193,9 @@ public:
 
 void spExtractAllResources::findPaths( std::set< std::string > & fileSet, NifModel * nif, const NifItem * item )
 {
-	if ( spResourceFileExtract::is_Applicable( nif, item ) ) {
-		std::string	filePath( spResourceFileExtract::getNifItemFilePath( nif, item ) );
-		if ( !filePath.empty() )
-			fileSet.insert( filePath );
-	}
+	std::string	filePath( Game::GameManager::get_resource_path( nif, item ) );
+	if ( !filePath.empty() )
+		fileSet.insert( filePath );
 
 	for ( int i = 0; i < item->childCount(); i++ ) {
 		if ( item->child( i ) )
@@ -10,6 +10,7 @@
 
 #include "libfo76utils/src/fp32vec4.hpp"
 #include "io/MeshFile.h"
+#include "lib/spatialhash.h"
 #include "meshoptimizer/meshoptimizer.h"
 #include "meshlet.h"
 
@@ -894,33 +895,33 @@ public:
 
 			// detect the duplicates
 
-			QMap<quint16, quint16> map;
-
-			for ( int a = 0; a < numVerts; a++ ) {
-				Vector3 v = verts[a];
+			// vertices are only compared with the others at the same position, each vertex maps to its last duplicate
+			const QVector<Vector3> & cnorms = norms;
+			const QVector<Color4> & ccolors = colors;
+			const QList<QVector<Vector2> > & ctexco = texco;
+			auto equalAttributes = [&cnorms, &ccolors, &ctexco]( int a, int b ) {
+				if ( cnorms.count() && !( cnorms[a] == cnorms[b] ) )
+					return false;
 
-				for ( int b = 0; b < a; b++ ) {
-					if ( !( v == verts[b] ) )
-						continue;
+				if ( ccolors.count() && !( ccolors[a] == ccolors[b] ) )
+					return false;
 
-					if ( norms.count() && !( norms[a] == norms[b] ) )
-						continue;
+				for ( const auto & uv : ctexco ) {
+					if ( !( uv[a] == uv[b] ) )
+						return false;
+				}
 
-					if ( colors.count() && !( colors[a] == colors[b] ) )
-						continue;
+				return true;
+			};
 
-					int t = 0;
+			std::vector<int> duplicates = findDuplicateVertices( &( verts.constFirst()[0] ), sizeof( Vector3 ) / sizeof( float ),
+																 size_t( numVerts ), equalAttributes );
 
-					for ( t = 0; t < texco.count(); t++ ) {
-						if ( !( texco[t][a] == texco[t][b] ) )
-							break;
-					}
-
-					if ( t < texco.count() )
-						continue;
+			QMap<quint16, quint16> map;
 
-					map.insert( b, a );
-				}
+			for ( int b = 0; b < numVerts; b++ ) {
+				if ( duplicates[b] >= 0 )
+					map.insert( b, duplicates[b] );
 			}
 
 			//qDebug() << QString( Spell::tr("detected % duplicates") ).arg( map.count() );
@@ -1,16 +1,15 @@
-#include "nifskope.h"
+#include "batchprocessor.h"
 #include "spellbook.h"
 
 #include <QDateTime>
 #include <QDir>
-#include <QDirIterator>
 #include <QFile>
 #include <QFileDialog>
 #include <QHash>
 #include <QMessageBox>
+#include <QMutex>
 #include <QTextStream>
 #include <string>
-//TODO: Handle load and save comletion events properly
 //TODO: Move mesh map path into starfield settings
 
 
@@ -42,6 +41,8 @@ public:
     }
 
     QModelIndex cast( NifModel * nif, const QModelIndex & index ) override final;
+    bool castBatch( NifModel * nif, QStringList & log ) override final;
+    bool reentrant() const override final { return true; }
     //End Spell Implementation
 
     //Represents a replacement made (or not) by script
@@ -57,9 +58,20 @@ public:
     QList<spBulkMeshUpdate::ReplacementLog> processNif(NifModel * nif, const QHash<QString, QString> &pathMap);
     //Recurse the nif structure looking for all Mesh Paths
 	void replacePaths(NifModel *nif, NifItem *item, const QHash<QString, QString> &pathMap, QList<ReplacementLog> &replacementLogs);
+    //Path of the map file, next to the executable
+    static QString mapFilePath();
 
+private:
+    //Map used by castBatch, loaded on first use (or by cast) and shared by all files
+    QHash<QString, QString> meshMap;
+    QMutex meshMapLock;
 };
 
+QString spBulkMeshUpdate::mapFilePath()
+{
+    return QDir(QCoreApplication::applicationDirPath()).filePath("sf_mesh_map_1_11_33.v2.txt");
+}
+
 QHash<QString, QString> spBulkMeshUpdate::loadMapFile(const QString &filename)
 {
     QHash<QString, QString> pathMap;
@@ -134,24 +146,48 @@ QList<spBulkMeshUpdate::ReplacementLog> spBulkMeshUpdate::processNif(NifModel *
 }
 
 
-QModelIndex spBulkMeshUpdate::cast ( NifModel * nif, const QModelIndex & index )
+bool spBulkMeshUpdate::castBatch( NifModel * nif, QStringList & log )
 {
     if ( !nif )
-        return index;
-    QDateTime startTime(QDateTime::currentDateTime());
+        return false;
+
+    QHash<QString, QString> pathMap;
+    {
+        QMutexLocker lock(&meshMapLock);
+        if (meshMap.isEmpty())
+            meshMap = loadMapFile(mapFilePath());
+        pathMap = meshMap;
+    }
 
-    //Reference to NifSkope required for successful saving
-    NifSkope* nifSkope = qobject_cast<NifSkope*>(nif->getWindow());
+    if (pathMap.isEmpty()) {
+        log << "ERROR: Problem loading map file " + mapFilePath();
+        return false;
+    }
 
-    QString executableDir = QCoreApplication::applicationDirPath();
+    QList<ReplacementLog> logs = processNif(nif, pathMap);
+    for (const auto &l : logs)
+        log << "\"" + l.objectName + "\" " + l.oldPath + " -> " + l.newPath;
 
-    QString filePath = QDir(executableDir).filePath("sf_mesh_map_1_11_33.v2.txt");
+    if (logs.isEmpty())
+        qWarning() << "No changes made to the file: " << nif->getFileInfo().filePath();
 
-    QHash<QString, QString> meshMap = loadMapFile(filePath);
+    return !logs.isEmpty();
+}
 
-    if (meshMap.isEmpty()) {
-        QMessageBox::critical(nullptr, "Error", "Problem loading map file\nPlease ensure the file sf_mesh_map_1_11_33.v2.txt is in the same folder as NifSkope.");
+
+QModelIndex spBulkMeshUpdate::cast ( NifModel * nif, const QModelIndex & index )
+{
+    if ( !nif )
         return index;
+
+    {
+        //Reload in case the map was edited since the last run
+        QMutexLocker lock(&meshMapLock);
+        meshMap = loadMapFile(mapFilePath());
+        if (meshMap.isEmpty()) {
+            QMessageBox::critical(nullptr, "Error", "Problem loading map file\nPlease ensure the file sf_mesh_map_1_11_33.v2.txt is in the same folder as NifSkope.");
+            return index;
+        }
     }
 
     QString rootFolder = QFileDialog::getExistingDirectory(nullptr, "Select root folder to process");
@@ -167,73 +203,31 @@ QModelIndex spBulkMeshUpdate::cast ( NifModel * nif, const QModelIndex & index )
         return index;
     }
 
+    //Files are processed in bare models, the open window is left untouched
+    BatchProcessor batch(this, rootFolder);
+    batch.run();
 
     QString logFileName = QString("sf_mesh_map_1_11_33_log_%1.txt").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss"));
-
-
-    QString logFilePath = rootDir.filePath(logFileName);
-    QFile logFile(logFilePath);
-    if (!logFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    if (!batch.writeLog(rootDir.filePath(logFileName))) {
         QMessageBox::critical(nullptr, "Error", "Failed to create log file.");
-        return index;
     }
 
-    QTextStream logStream(&logFile);
-    logStream << "Spell Name: " << name() << "\n";
-    logStream << "Date and Time: " << startTime.toString("yyyy-MM-dd hh:mm:ss") << "\n";
-
-    int filesProcessed = 0;
     int updatesPerformed = 0;
     int unmappedItemsEncountered = 0;
-    int readOnlyCount = 0;
-
-    QDirIterator it(rootFolder, QDir::Files, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        if (filePath.endsWith(".nif", Qt::CaseInsensitive)) {
-            QFile file(filePath);
-            //Nifskope doesn't report an error when trying to save to a readonly file fails
-            if (!(file.permissions() & QFile::WriteUser)) {
-                qWarning() << "Skipping read-only file:" << filePath;
-                readOnlyCount++;
-                continue;
-            }
-
-            nifSkope->openFile(filePath);
-            //Temporary solution
-            //Correct solution must await a signal and check if load succeeded
-            //This probaly will need to be moved into NifSkope.h/cpp
-            //Without the processEvents, changes are not applied to saved files.
-            QCoreApplication::processEvents();
-            QList<ReplacementLog> logs = processNif(nif, meshMap);
-            
-            if (!logs.isEmpty()) {
-                QCoreApplication::processEvents(); //Belt... (not clickbait)
-
-                //NifSkope class had no public save method - temporary until moving logic into NifSkope class (for events)
-                nifSkope->publicSave();
-                QCoreApplication::processEvents(); //... And suspenders :P
-            } else {
-                qWarning() << "No changes made to the file: " << filePath;
-            }
-            //Use path relative to the root folder in the report
-            QString relativePath = rootDir.relativeFilePath(filePath);
-            logStream << "File: " << relativePath << "\n";
-            for (const auto &log : logs) {
-                logStream << "\"" << log.objectName << "\" " << log.oldPath << " -> " << log.newPath << "\n";
-                if (log.newPath == "ERROR_NOT_MAPPED")
-                    unmappedItemsEncountered++;
-                else
-                    updatesPerformed++;
-            }
-            filesProcessed++;
+    for (const auto &r : batch.results()) {
+        for (const auto &line : r.log) {
+            if (line.endsWith(" -> ERROR_NOT_MAPPED"))
+                unmappedItemsEncountered++;
+            else if (!line.startsWith("ERROR:"))
+                updatesPerformed++;
         }
     }
+
     // Show summary
-    QString summaryMsg = QString("Files processed: %1\nRead-only files skipped: %2\nUpdates performed: %3\nUnmapped items encountered: %4")
-        .arg(filesProcessed).arg(readOnlyCount).arg(updatesPerformed).arg(unmappedItemsEncountered);
+    QString summaryMsg = QString("Files processed: %1\nRead-only files skipped: %2\nUpdates performed: %3\nUnmapped items encountered: %4\n\n%5")
+        .arg(batch.filesProcessed()).arg(batch.filesReadOnly()).arg(updatesPerformed).arg(unmappedItemsEncountered)
+        .arg(batch.summary());
     QMessageBox::information(nullptr, "Summary", summaryMsg);
-    logFile.close();
 
     return index;
 }
@@ -2,6 +2,7 @@
 #include "qtcompat.h"
 
 #include "lib/nvtristripwrapper.h"
+#include "lib/spatialhash.h"
 
 #include <QDialog>
 #include <QDoubleSpinBox>
@@ -422,59 +423,7 @@ void spSmoothNormals::calculateSmoothNormals( float * snorms, size_t snormSize,
 												float * norms, const float * verts, size_t numVerts,
 												float maxa, float maxd )
 {
-	size_t	normStride = sizeof( Vector3 ) / sizeof( float );
-	size_t	snormStride = snormSize / sizeof( float );
-
-	float *	np = norms;
-	float *	sp = snorms;
-	for ( size_t i = 0; i < numVerts; i++, np += normStride, sp += snormStride ) {
-		FloatVector4	n( np );
-		float	r2 = n.dotProduct3( n );
-		if ( !( r2 > 0.999999f && r2 < 1.000001f ) ) {
-			// make sure that input data is normalized
-			if ( r2 > 0.0f )
-				n /= float( std::sqrt( r2 ) );
-			else
-				n = FloatVector4( 0.0f, 0.0f, 1.0f, 0.0f );
-			n.convertToVector3( np );
-		}
-		n.convertToVector3( sp );
-	}
-
-	const float *	vp = verts;
-	np = norms;
-	sp = snorms;
-	for ( size_t i = 0; i < numVerts; i++, vp += normStride, np += normStride, sp += snormStride ) {
-		FloatVector4	a( vp );
-		FloatVector4	an( np );
-		FloatVector4	sn( sp );
-
-		const float *	vp2 = vp;
-		for ( size_t j = i + 1; j < numVerts; j++ ) {
-			vp2 += normStride;
-			FloatVector4	b( vp2 );
-			b -= a;
-			if ( !( b.dotProduct3( b ) < maxd ) ) [[likely]]
-				continue;
-
-			FloatVector4	bn( np + size_t( vp2 - vp ) );
-
-			if ( an.dotProduct3( bn ) > maxa ) {
-				sn += bn;
-				float *	sp2 = snorms + ( j * snormStride );
-				FloatVector4	tmp( sp2 );
-				tmp += an;
-				tmp.convertToVector3( sp2 );
-			}
-		}
-
-		float	r2 = sn.dotProduct3( sn );
-		if ( r2 > 0.0f )
-			sn /= float( std::sqrt( r2 ) );
-		else
-			sn = FloatVector4( 0.0f, 0.0f, 1.0f, 0.0f );
-		sn.convertToVector3( sp );
-	}
+	smoothVertexNormals( snorms, snormSize, norms, verts, numVerts, maxa, maxd );
 }
 
 void spSmoothNormals::smoothNormals( NifModel * nif, const QModelIndex & index, float maxa, float maxd )
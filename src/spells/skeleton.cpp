@@ -5,6 +5,7 @@
 #include "qtcompat.h"
 
 #include "lib/nvtristripwrapper.h"
+#include "lib/skinpartition.h"
 
 #include <QCheckBox>
 #include <QFile>
@@ -15,6 +16,7 @@
 #include <QSpinBox>
 
 #include <algorithm> // std::sort
+#include <memory>
 
 #define SKEL_DAT ":/res/skel.dat"
 
@@ -266,725 +268,422 @@ public:
 		return false;
 	}
 
-	typedef QPair<int, float> boneweight;
-
-	//! Helper for sorting a boneweight list
-	struct boneweight_equivalence
+	//! A shape read from the model and the partitioner working on it
+	struct SkinShape
 	{
-		bool operator()( const boneweight & lhs, const boneweight & rhs )
-		{
-			if ( lhs.second == 0.0 ) {
-				if ( rhs.second == 0.0 ) {
-					return rhs.first < lhs.first;
-				} else {
-					return true;
-				}
-
-				return false;
-			} else if ( rhs.second == lhs.second ) {
-				return lhs.first < rhs.first;
-			} else {
-				return rhs.second < lhs.second;
-			}
-		}
+		QPersistentModelIndex iShape, iData, iSkinInst, iSkinData, iSkinPart;
+		SkinPartitioner partitioner;
 	};
 
-	//! A bone and Triangle set
-	typedef struct
-	{
-		QList<int> bones;
-		QVector<Triangle> triangles;
-	} Partition;
-
 	QModelIndex cast( NifModel * nif, const QModelIndex & iBlock ) override final
 	{
 		int mbpp = 0, mbpv = 0;
-		bool make_strips = false;
-		return cast( nif, iBlock, mbpp, mbpv, make_strips );
+		bool make_strips = false, pad = false;
+		return cast( nif, iBlock, mbpp, mbpv, make_strips, pad );
 	}
 
 	//! Cast with extra parameters
-	QModelIndex cast( NifModel * nif, const QModelIndex & iBlock, int & maxBonesPerPartition, int & maxBonesPerVertex, bool make_strips, bool pad = false )
+	QModelIndex cast( NifModel * nif, const QModelIndex & iBlock, int & maxBonesPerPartition, int & maxBonesPerVertex, bool & make_strips, bool & pad )
 	{
-		QPersistentModelIndex iShape = iBlock;
-		QString iShapeType = "";
-
-		if ( nif->isNiBlock( iShape, "NiTriShape" ) ) {
-			iShapeType = "NiTriShape";
-		} else if ( nif->isNiBlock( iShape, "NiTriStrips" ) ) {
-			iShapeType = "NiTriStrips";
-		}
-
 		try
 		{
-			QPersistentModelIndex iData;
+			SkinShape shape;
+			shape.iShape = iBlock;
+			read( nif, shape );
 
-			if ( iShapeType == "NiTriShape" ) {
-				iData = nif->getBlockIndex( nif->getLink( iShape, "Data" ), "NiTriShapeData" );
-			} else if ( iShapeType == "NiTriStrips" ) {
-				iData = nif->getBlockIndex( nif->getLink( iShape, "Data" ), "NiTriStripsData" );
+			if ( maxBonesPerPartition <= 0 || maxBonesPerVertex <= 0 ) {
+				if ( !queryOptions( shape.partitioner.maxBonesPerVertex(), maxBonesPerPartition, maxBonesPerVertex, make_strips, pad ) )
+					return iBlock;
 			}
 
-			QPersistentModelIndex iSkinInst = nif->getBlockIndex( nif->getLink( iShape, "Skin Instance" ), "NiSkinInstance" );
-			QPersistentModelIndex iSkinData = nif->getBlockIndex( nif->getLink( iSkinInst, "Data" ), "NiSkinData" );
-			QModelIndex iSkinPart = nif->getBlockIndex( nif->getLink( iSkinInst, "Skin Partition" ), "NiSkinPartition" );
-
-			if ( !iSkinPart.isValid() )
-				iSkinPart = nif->getBlockIndex( nif->getLink( iSkinData, "Skin Partition" ), "NiSkinPartition" );
-
-			// read in the weights from NiSkinData
-
-			int numVerts = nif->get<int>( iData, "Num Vertices" );
-			QVector<QList<boneweight> > weights( numVerts );
+			if ( !shape.partitioner.run( maxBonesPerPartition, maxBonesPerVertex ) )
+				throw shape.partitioner.error();
 
-			QModelIndex iBoneList = nif->getIndex( iSkinData, "Bone List" );
-			int numBones = nif->rowCount( iBoneList );
-
-			for ( int bone = 0; bone < numBones; bone++ ) {
-				QModelIndex iVertexWeights = nif->getIndex( QModelIndex_child( iBoneList, bone ), "Vertex Weights" );
-
-				for ( int r = 0; r < nif->rowCount( iVertexWeights ); r++ ) {
-					int vertex = nif->get<int>( QModelIndex_child( iVertexWeights, r ), "Index" );
-					float weight = nif->get<float>( QModelIndex_child( iVertexWeights, r ), "Weight" );
-
-					if ( vertex >= weights.count() )
-						throw QString( Spell::tr( "bad NiSkinData - vertex count does not match" ) );
-
-					weights[vertex].append( boneweight( bone, weight ) );
-				}
-			}
-
-			// count min and max bones per vertex
+			reportChanges( shape, maxBonesPerVertex );
+			write( nif, shape, maxBonesPerPartition, maxBonesPerVertex, make_strips, pad );
+		}
+		catch ( QString & err )
+		{
+			if ( !err.isEmpty() )
+				QMessageBox::warning( nullptr, "NifSkope", err );
+		}
 
-			int minBones, maxBones;
-			minBones = maxBones = weights.value( 0 ).count();
-			for ( const QList<boneweight> & list : weights ) {
-				if ( list.count() < minBones )
-					minBones = list.count();
+		return iBlock;
+	}
 
-				if ( list.count() > maxBones )
-					maxBones = list.count();
-			}
+	//! Asks for the partition settings, returns false if the dialog was cancelled
+	static bool queryOptions( int maxBones, int & maxBonesPerPartition, int & maxBonesPerVertex, bool & make_strips, bool & pad )
+	{
+		SkinPartitionDialog dlg( maxBones );
 
-			if ( minBones <= 0 )
-				throw QString( Spell::tr( "bad NiSkinData - some vertices have no weights at all" ) );
+		if ( dlg.exec() != QDialog::Accepted )
+			return false;
 
-			// query max bones per vertex/partition
+		maxBonesPerPartition = dlg.maxBonesPerPartition();
+		maxBonesPerVertex = dlg.maxBonesPerVertex();
+		make_strips = dlg.makeStrips();
+		pad = dlg.padPartitions();
 
-			if ( maxBonesPerPartition <= 0 || maxBonesPerVertex <= 0 ) {
-				SkinPartitionDialog dlg( maxBones );
+		return true;
+	}
 
-				if ( dlg.exec() != QDialog::Accepted )
-					return iBlock;
+	//! Reads the weights, vertices and triangles of a shape into its partitioner, throws a QString on bad data
+	static void read( const NifModel * nif, SkinShape & shape )
+	{
+		QString iShapeType = "";
 
-				maxBonesPerPartition = dlg.maxBonesPerPartition();
-				maxBonesPerVertex = dlg.maxBonesPerVertex();
-				make_strips = dlg.makeStrips();
-				pad = dlg.padPartitions();
-			}
+		if ( nif->isNiBlock( shape.iShape, "NiTriShape" ) ) {
+			iShapeType = "NiTriShape";
+		} else if ( nif->isNiBlock( shape.iShape, "NiTriStrips" ) ) {
+			iShapeType = "NiTriStrips";
+		}
 
-			// reduce vertex influences if necessary
+		if ( iShapeType == "NiTriShape" ) {
+			shape.iData = nif->getBlockIndex( nif->getLink( shape.iShape, "Data" ), "NiTriShapeData" );
+		} else if ( iShapeType == "NiTriStrips" ) {
+			shape.iData = nif->getBlockIndex( nif->getLink( shape.iShape, "Data" ), "NiTriStripsData" );
+		}
 
-			if ( maxBones > maxBonesPerVertex ) {
-				QMutableVectorIterator<QList<boneweight> > it( weights );
-				int c = 0;
+		shape.iSkinInst = nif->getBlockIndex( nif->getLink( shape.iShape, "Skin Instance" ), "NiSkinInstance" );
+		shape.iSkinData = nif->getBlockIndex( nif->getLink( shape.iSkinInst, "Data" ), "NiSkinData" );
+		shape.iSkinPart = nif->getBlockIndex( nif->getLink( shape.iSkinInst, "Skin Partition" ), "NiSkinPartition" );
 
-				while ( it.hasNext() ) {
-					QList<boneweight> & lst = it.next();
-					std::sort( lst.begin(), lst.end(), boneweight_equivalence() );
+		if ( !shape.iSkinPart.isValid() )
+			shape.iSkinPart = nif->getBlockIndex( nif->getLink( shape.iSkinData, "Skin Partition" ), "NiSkinPartition" );
 
-					if ( lst.count() > maxBonesPerVertex )
-						c++;
+		// read in the weights from NiSkinData
 
-					while ( lst.count() > maxBonesPerVertex ) {
-						lst.removeLast();
-					}
+		int numVerts = nif->get<int>( shape.iData, "Num Vertices" );
+		QVector<SkinPartitioner::VertexWeight> weights;
 
-					float totalWeight = 0;
-					for ( const auto & bw : lst ) {
-						totalWeight += bw.second;
-					}
+		QModelIndex iBoneList = nif->getIndex( shape.iSkinData, "Bone List" );
+		int numBones = nif->rowCount( iBoneList );
 
-					for ( int b = 0; b < lst.count(); b++ ) {
-						// normalize
-						lst[b].second /= totalWeight;
-					}
-				}
+		for ( int bone = 0; bone < numBones; bone++ ) {
+			QModelIndex iVertexWeights = nif->getIndex( QModelIndex_child( iBoneList, bone ), "Vertex Weights" );
 
-				qCWarning( nsSpell ) << Spell::tr( "Reduced %1 vertices to %2 bone influences (maximum number of bones per vertex was %3)" )
-					.arg( c )
-					.arg( maxBonesPerVertex )
-					.arg( maxBones );
+			for ( int r = 0; r < nif->rowCount( iVertexWeights ); r++ ) {
+				int vertex = nif->get<int>( QModelIndex_child( iVertexWeights, r ), "Index" );
+				float weight = nif->get<float>( QModelIndex_child( iVertexWeights, r ), "Weight" );
+				weights.append( { vertex, bone, weight } );
 			}
+		}
 
-			maxBones = maxBonesPerVertex;
-
-			// reduces bone weights so that the triangles fit into the partitions
-
-			QList<Triangle> triangles;
+		SkinPartitioner & sp = shape.partitioner;
+		if ( !sp.setWeights( numVerts, weights ) )
+			throw QString( Spell::tr( "bad NiSkinData - vertex count does not match" ) );
 
-			if ( iShapeType == "NiTriShape" ) {
-				triangles = nif->getArray<Triangle>( iData, "Triangles" ).toList();
-			} else if ( iShapeType == "NiTriStrips" ) {
-				// triangulate first (code copied from strippify.cpp)
-				QVector<QVector<quint16> > strips;
-				QModelIndex iPoints = nif->getIndex( iData, "Points" );
+		if ( sp.minBonesPerVertex() <= 0 )
+			throw QString( Spell::tr( "bad NiSkinData - some vertices have no weights at all" ) );
 
-				for ( int s = 0; s < nif->rowCount( iPoints ); s++ ) {
-					QVector<quint16> strip;
-					QModelIndex iStrip = QModelIndex_child( iPoints, s );
+		sp.setVertices( nif->getArray<Vector3>( shape.iData, "Vertices" ) );
 
-					for ( int p = 0; p < nif->rowCount( iStrip ); p++ ) {
-						strip.append( nif->get<int>( QModelIndex_child( iStrip, p ) ) );
-					}
+		QVector<Triangle> triangles;
 
-					strips.append( strip );
-				}
+		if ( iShapeType == "NiTriShape" ) {
+			triangles = nif->getArray<Triangle>( shape.iData, "Triangles" );
+		} else if ( iShapeType == "NiTriStrips" ) {
+			// triangulate first (code copied from strippify.cpp)
+			triangles = triangulate( readStrips( nif, nif->getIndex( shape.iData, "Points" ) ) );
+		}
 
-				triangles = triangulate( strips ).toList();
-			}
+		sp.setTriangles( triangles );
 
-			QMap<Triangle, quint32> trimap;
+		if ( nif->blockInherits( shape.iSkinInst, "BSDismemberSkinInstance" ) ) {
+			QHash<quint64, quint32> trimap;
 			quint32 defaultPart = 0;
 
-			if ( nif->blockInherits( iSkinInst, "BSDismemberSkinInstance" ) ) {
-				// First find a partition to dump dangling faces.  Torso is prefered if available.
-				quint32 nparts = nif->get<uint>( iSkinInst, "Num Partitions" );
-				QModelIndex iPartData = nif->getIndex( iSkinInst, "Partitions" );
+			// First find a partition to dump dangling faces.  Torso is prefered if available.
+			quint32 nparts = nif->get<uint>( shape.iSkinInst, "Num Partitions" );
+			QModelIndex iPartData = nif->getIndex( shape.iSkinInst, "Partitions" );
 
-				for ( quint32 i = 0; i < nparts; ++i ) {
-					QModelIndex iPart = QModelIndex_child( iPartData, i );
+			for ( quint32 i = 0; i < nparts; ++i ) {
+				QModelIndex iPart = QModelIndex_child( iPartData, i );
 
-					if ( !iPart.isValid() )
-						continue;
+				if ( !iPart.isValid() )
+					continue;
 
-					if ( nif->get<uint>( iPart, "Body Part" ) == 0 /* Torso */ ) {
-						defaultPart = i;
-						break;
-					}
+				if ( nif->get<uint>( iPart, "Body Part" ) == 0 /* Torso */ ) {
+					defaultPart = i;
+					break;
 				}
+			}
 
-				defaultPart = qMin( nparts - 1, defaultPart );
-
-				// enumerate existing partitions and select faces into same partition
-				quint32 nskinparts = nif->get<int>( iSkinPart, "Num Partitions" );
-				iPartData = nif->getIndex( iSkinPart, "Partitions" );
-
-				for ( quint32 i = 0; i < nskinparts; ++i ) {
-					QModelIndex iPart = QModelIndex_child( iPartData, i );
-
-					if ( !iPart.isValid() )
-						continue;
-
-					quint32 finalPart = qMin( nparts - 1, i );
-
-					QVector<int> vertmap = nif->getArray<int>( iPart, "Vertex Map" );
-
-					quint8 hasFaces  = nif->get<quint8>( iPart, "Has Faces" );
-					quint8 numStrips = nif->get<quint8>( iPart, "Num Strips" );
-					QVector<Triangle> partTriangles;
+			defaultPart = qMin( nparts - 1, defaultPart );
 
-					if ( hasFaces && numStrips == 0 ) {
-						partTriangles = nif->getArray<Triangle>( iPart, "Triangles" );
-					} else if ( numStrips != 0 ) {
-						// triangulate first (code copied from strippify.cpp)
-						QVector<QVector<quint16> > strips;
-						QModelIndex iPoints = nif->getIndex( iPart, "Strips" );
+			// enumerate existing partitions and select faces into same partition
+			quint32 nskinparts = nif->get<int>( shape.iSkinPart, "Num Partitions" );
+			iPartData = nif->getIndex( shape.iSkinPart, "Partitions" );
 
-						for ( int s = 0; s < nif->rowCount( iPoints ); s++ ) {
-							QVector<quint16> strip;
-							QModelIndex iStrip = QModelIndex_child( iPoints, s );
+			for ( quint32 i = 0; i < nskinparts; ++i ) {
+				QModelIndex iPart = QModelIndex_child( iPartData, i );
 
-							for ( int p = 0; p < nif->rowCount( iStrip ); p++ ) {
-								strip.append( nif->get<int>( QModelIndex_child( iStrip, p ) ) );
-							}
+				if ( !iPart.isValid() )
+					continue;
 
-							strips.append( strip );
-						}
+				quint32 finalPart = qMin( nparts - 1, i );
 
-						partTriangles = triangulate( strips );
-					}
+				QVector<int> vertmap = nif->getArray<int>( iPart, "Vertex Map" );
 
-					for ( int j = 0; j < partTriangles.count(); ++j ) {
-						Triangle t = partTriangles[j];
-						Triangle tri = t;
+				quint8 hasFaces  = nif->get<quint8>( iPart, "Has Faces" );
+				quint8 numStrips = nif->get<quint8>( iPart, "Num Strips" );
+				QVector<Triangle> partTriangles;
 
-						if ( !vertmap.isEmpty() ) {
-							tri[0] = vertmap[tri[0]];
-							tri[1] = vertmap[tri[1]];
-							tri[2] = vertmap[tri[2]];
-						}
-
-						qRotate( tri );
-						trimap.insert( tri, finalPart );
-					}
+				if ( hasFaces && numStrips == 0 ) {
+					partTriangles = nif->getArray<Triangle>( iPart, "Triangles" );
+				} else if ( numStrips != 0 ) {
+					// triangulate first (code copied from strippify.cpp)
+					partTriangles = triangulate( readStrips( nif, nif->getIndex( iPart, "Strips" ) ) );
 				}
-			}
-
-			QMultiMap<int, int> match;
-			bool doMatch = true;
-
-			QList<int> tribones;
 
-			int cnt = 0;
+				for ( const Triangle & t : partTriangles ) {
+					Triangle tri = t;
 
-			for ( const Triangle& tri : triangles )
-			{
-				do {
-					tribones.clear();
-
-					for ( int c = 0; c < 3; c++ ) {
-						for ( const auto & bw : weights[tri[c]] ) {
-							if ( !tribones.contains( bw.first ) )
-								tribones.append( bw.first );
-						}
+					if ( !vertmap.isEmpty() ) {
+						tri[0] = vertmap.value( tri[0] );
+						tri[1] = vertmap.value( tri[1] );
+						tri[2] = vertmap.value( tri[2] );
 					}
 
-					if ( tribones.count() > maxBonesPerPartition ) {
-						// sum up the weights for each bone
-						// bones with weight == 1 can't be removed
-
-						QMap<int, float> sum;
-						QList<int> nono;
-
-						for ( int t = 0; t < 3; t++ ) {
-							if ( weights[tri[t]].count() == 1 )
-								nono.append( weights[tri[t]].first().first );
-
-							for ( const auto & bw : weights[tri[t]] ) {
-								sum[ bw.first ] += bw.second;
-							}
-						}
-
-						// select the bone to remove
-
-						float minWeight = 5.0;
-						int minBone = -1;
-
-						for ( const auto b : sum.keys() ) {
-							if ( !nono.contains( b ) && sum[b] < minWeight ) {
-								minWeight = sum[b];
-								minBone = b;
-							}
-						}
-
-						if ( minBone < 0 )  // this shouldn't never happen
-							throw QString( "internal error 0x01" );
-
-						// do a vertex match detect
-
-						if ( doMatch ) {
-							QVector<Vector3> verts = nif->getArray<Vector3>( iData, "Vertices" );
-
-							for ( int a = 0; a < verts.count(); a++ ) {
-								match.insert( a, a );
-
-								for ( int b = a + 1; b < verts.count(); b++ ) {
-									if ( verts[a] == verts[b] && weights[a] == weights[b] ) {
-										match.insert( a, b );
-										match.insert( b, a );
-									}
-								}
-							}
-						}
-
-						// now remove that bone from all vertices of this triangle and from all matching vertices too
-
-						for ( int t = 0; t < 3; t++ ) {
-							bool rem = false;
-							for ( const auto v : match.values( tri[t] ) )
-							{
-								QList<boneweight> & bws = weights[ v ];
-								QMutableListIterator<boneweight> it( bws );
-
-								while ( it.hasNext() ) {
-									boneweight & bw = it.next();
-
-									if ( bw.first == minBone ) {
-										it.remove();
-										rem = true;
-									}
-								}
-
-								float totalWeight = 0;
-								for ( const auto & bw : bws ) {
-									totalWeight += bw.second;
-								}
-
-								if ( totalWeight == 0 )
-									throw QString( "internal error 0x02" );
-
-								for ( int b = 0; b < bws.count(); b++ ) {
-									// normalize
-									bws[b].second /= totalWeight;
-								}
-							}
-
-							if ( rem )
-								cnt++;
-						}
-					}
-				} while ( tribones.count() > maxBonesPerPartition );
+					trimap.insert( triangleKey( tri ), finalPart );
+				}
 			}
 
-			if ( cnt > 0 )
-				qCWarning( nsSpell ) << Spell::tr( "Removed %1 bone influences" ).arg( cnt );
-
-			// split the triangles into partitions
-
-			bool merged = true;
-
-			QList<Partition> parts;
-
 			if ( !trimap.isEmpty() ) {
-				QMutableListIterator<Triangle> it( triangles );
-
-				while ( it.hasNext() ) {
-					Triangle tri = it.next();
-					qRotate( tri );
-					QMap<Triangle, quint32>::iterator partItr = trimap.find( tri );
-					int partIdx = ( partItr != trimap.end() ) ? partItr.value() : defaultPart;
-
-					if ( partIdx >= 0 ) {
-						//Triangle & tri = *it;
-
-						// Ensure enough partitions
-						while ( partIdx >= int( parts.size() ) )
-							parts.push_back( Partition() );
+				QVector<int> parts( triangles.size() );
+				for ( qsizetype t = 0; t < triangles.size(); t++ )
+					parts[t] = int( trimap.value( triangleKey( triangles.at( t ) ), defaultPart ) );
 
-						Partition & part = parts[partIdx];
-
-						QList<int> tribones;
-
-						for ( int c = 0; c < 3; c++ ) {
-							for ( const auto & bw : weights[tri[c]] ) {
-								if ( !tribones.contains( bw.first ) )
-									tribones.append( bw.first );
-							}
-						}
-
-						part.bones = mergeBones( part.bones, tribones );
-						part.triangles.append( tri );
-						it.remove();
-					}
-				}
-
-				merged = false; // when explicit mapping enabled, no merging is allowed
+				sp.setTrianglePartitions( parts );
 			}
+		}
+	}
 
-			while ( !triangles.isEmpty() ) {
-				Partition part;
+	//! Reads the strips of a NiTriStripsData or a partition
+	static QVector<QVector<quint16>> readStrips( const NifModel * nif, const QModelIndex & iPoints )
+	{
+		QVector<QVector<quint16>> strips;
 
-				QHash<int, bool> usedVerts;
+		for ( int s = 0; s < nif->rowCount( iPoints ); s++ )
+			strips.append( nif->getArray<quint16>( QModelIndex_child( iPoints, s ) ) );
 
-				bool addtriangles;
+		return strips;
+	}
 
-				do {
-					QMutableListIterator<Triangle> it( triangles );
+	//! A key for a Triangle that does not depend on which vertex comes first
+	static quint64 triangleKey( Triangle tri )
+	{
+		qRotate( tri );
+		return quint64( tri[0] ) | ( quint64( tri[1] ) << 16 ) | ( quint64( tri[2] ) << 32 );
+	}
 
-					while ( it.hasNext() ) {
-						Triangle & tri = it.next();
+	//! Logs the influences that were dropped by the partitioner
+	static void reportChanges( const SkinShape & shape, int maxBonesPerVertex )
+	{
+		const SkinPartitioner & sp = shape.partitioner;
 
-						QList<int> tribones;
+		if ( sp.maxBonesPerVertex() > maxBonesPerVertex ) {
+			qCWarning( nsSpell ) << Spell::tr( "Reduced %1 vertices to %2 bone influences (maximum number of bones per vertex was %3)" )
+				.arg( sp.reducedVertices() )
+				.arg( maxBonesPerVertex )
+				.arg( sp.maxBonesPerVertex() );
+		}
 
-						for ( int c = 0; c < 3; c++ ) {
-							for ( const auto & bw : weights[tri[c]] ) {
-								if ( !tribones.contains( bw.first ) )
-									tribones.append( bw.first );
-							}
-						}
+		if ( sp.removedInfluences() > 0 )
+			qCWarning( nsSpell ) << Spell::tr( "Removed %1 bone influences" ).arg( sp.removedInfluences() );
+	}
 
-						if ( part.bones.isEmpty() || containsBones( part.bones, tribones ) ) {
-							part.bones = mergeBones( part.bones, tribones );
-							part.triangles.append( tri );
-							usedVerts[ tri[0] ] = true;
-							usedVerts[ tri[1] ] = true;
-							usedVerts[ tri[2] ] = true;
-							it.remove();
-						}
-					}
+	//! Writes the partitions of a shape into its NiSkinPartition, which is created if it does not exist yet
+	static void write( NifModel * nif, SkinShape & shape, int maxBonesPerPartition, int maxBones, bool make_strips, bool pad )
+	{
+		const SkinPartitioner & sp = shape.partitioner;
+		const QVector<SkinPartitioner::Partition> & parts = sp.partitions();
+		int numVerts = nif->get<int>( shape.iData, "Num Vertices" );
 
-					addtriangles = false;
-
-					if ( part.bones.count() < maxBonesPerPartition ) {
-						// if we have room left in the partition then add an adjacent triangle
-						it.toFront();
-
-						while ( it.hasNext() ) {
-							Triangle & tri = it.next();
-
-							if ( usedVerts.contains( tri[0] ) || usedVerts.contains( tri[1] ) || usedVerts.contains( tri[2] ) ) {
-								QList<int> tribones;
-
-								for ( int c = 0; c < 3; c++ ) {
-									for ( const auto & bw : weights[tri[c]] ) {
-										if ( !tribones.contains( bw.first ) )
-											tribones.append( bw.first );
-									}
-								}
-
-								tribones = mergeBones( part.bones, tribones );
-
-								if ( tribones.count() <= maxBonesPerPartition ) {
-									part.bones = tribones;
-									part.triangles.append( tri );
-									usedVerts[ tri[0] ] = true;
-									usedVerts[ tri[1] ] = true;
-									usedVerts[ tri[2] ] = true;
-									it.remove();
-									addtriangles = true;
-									//break;
-								}
-							}
-						}
-					}
-				} while ( addtriangles );
+		// create the NiSkinPartition if it doesn't exist yet
 
-				parts.append( part );
-			}
+		if ( !shape.iSkinPart.isValid() ) {
+			shape.iSkinPart = nif->insertNiBlock( "NiSkinPartition", nif->getBlockNumber( shape.iSkinData ) + 1 );
+			nif->setLink( shape.iSkinInst, "Skin Partition", nif->getBlockNumber( shape.iSkinPart ) );
+			nif->setLink( shape.iSkinData, "Skin Partition", nif->getBlockNumber( shape.iSkinPart ) );
+		}
 
-			//qDebug() << parts.count() << "small partitions";
+		QModelIndex iSkinPart = shape.iSkinPart;
 
-			// merge partitions
+		// start writing NiSkinPartition
 
-			while ( merged ) {
-				merged = false;
+		nif->set<int>( iSkinPart, "Num Partitions", parts.count() );
+		nif->updateArraySize( iSkinPart, "Partitions" );
 
-				for ( int p1 = 0; p1 < parts.count() && !merged; p1++ ) {
-					if ( parts[p1].bones.count() < maxBonesPerPartition ) {
-						for ( int p2 = p1 + 1; p2 < parts.count() && !merged; p2++ ) {
-							QList<int> mergedBones = mergeBones( parts[p1].bones, parts[p2].bones );
+		QModelIndex iBSSkinInstPartData;
 
-							if ( mergedBones.count() <= maxBonesPerPartition ) {
-								parts[p1].bones = mergedBones;
-								parts[p1].triangles << parts[p2].triangles;
-								parts.removeAt( p2 );
-								merged = true;
-							}
-						}
-					}
-				}
-			}
-
-			//qDebug() << parts.count() << "partitions";
-
-			// create the NiSkinPartition if it doesn't exist yet
+		if ( nif->blockInherits( shape.iSkinInst, "BSDismemberSkinInstance" ) ) {
+			quint32 nparts = nif->get<uint>( shape.iSkinInst, "Num Partitions" );
+			iBSSkinInstPartData = nif->getIndex( shape.iSkinInst, "Partitions" );
 
-			if ( !iSkinPart.isValid() ) {
-				iSkinPart = nif->insertNiBlock( "NiSkinPartition", nif->getBlockNumber( iSkinData ) + 1 );
-				nif->setLink( iSkinInst, "Skin Partition", nif->getBlockNumber( iSkinPart ) );
-				nif->setLink( iSkinData, "Skin Partition", nif->getBlockNumber( iSkinPart ) );
+			// why is QList.count() signed? cast to squash warning
+			if ( nparts != (quint32)parts.count() ) {
+				qCWarning( nsSpell ) << "BSDismemberSkinInstance partition count does not match Skin Partition count.  Adjusting to fit.";
+				nif->set<uint>( shape.iSkinInst, "Num Partitions", parts.count() );
+				nif->updateArraySize( shape.iSkinInst, "Partitions" );
 			}
+		}
 
-			// start writing NiSkinPartition
-
-			nif->set<int>( iSkinPart, "Num Partitions", parts.count() );
-			nif->updateArraySize( iSkinPart, "Partitions" );
+		QList<int> prevPartBones;
+		QVector<int> vidx( numVerts, -1 );
 
-			QModelIndex iBSSkinInstPartData;
+		for ( int p = 0; p < parts.count(); p++ ) {
+			QModelIndex iPart = QModelIndex_child( nif->getIndex( iSkinPart, "Partitions" ), p );
 
-			if ( nif->blockInherits( iSkinInst, "BSDismemberSkinInstance" ) ) {
-				quint32 nparts = nif->get<uint>( iSkinInst, "Num Partitions" );
-				iBSSkinInstPartData = nif->getIndex( iSkinInst, "Partitions" );
+			QList<int> bones = parts[p].bones;
 
-				// why is QList.count() signed? cast to squash warning
-				if ( nparts != (quint32)parts.count() ) {
-					qCWarning( nsSpell ) << "BSDismemberSkinInstance partition count does not match Skin Partition count.  Adjusting to fit.";
-					nif->set<uint>( iSkinInst, "Num Partitions", parts.count() );
-					nif->updateArraySize( iSkinInst, "Partitions" );
+			// set partition flags for bs skin instance if present
+			if ( iBSSkinInstPartData.isValid() ) {
+				if ( bones != prevPartBones ) {
+					prevPartBones = bones;
+					nif->set<uint>( QModelIndex_child( iBSSkinInstPartData, p ), "Part Flag", 257 );
 				}
 			}
 
-			QList<int> prevPartBones;
-
-			for ( int p = 0; p < parts.count(); p++ ) {
-				QModelIndex iPart = QModelIndex_child( nif->getIndex( iSkinPart, "Partitions" ), p );
-
-				QList<int> bones = parts[p].bones;
-				std::sort( bones.begin(), bones.end() /*, std::less<int>()*/ );
-
-				// set partition flags for bs skin instance if present
-				if ( iBSSkinInstPartData.isValid() ) {
-					if ( bones != prevPartBones ) {
-						prevPartBones = bones;
-						nif->set<uint>( QModelIndex_child( iBSSkinInstPartData, p ), "Part Flag", 257 );
-					}
-				}
-
-				QVector<Triangle> triangles = parts[p].triangles;
+			QVector<Triangle> triangles = parts[p].triangles;
 
-				// Create the vertex map
+			// Create the vertex map, in order of first use
 
-				int idx = 0;
-				QVector<int> vidx( numVerts, -1 );
-				for ( const Triangle& tri : triangles ) {
-					for ( int t = 0; t < 3; t++ ) {
-						int v = tri[t];
+			QVector<int> vertices;
+			for ( const Triangle& tri : triangles ) {
+				for ( int t = 0; t < 3; t++ ) {
+					int v = tri[t];
 
-						if ( vidx[v] < 0 )
-							vidx[v] = idx++;
+					if ( vidx[v] < 0 ) {
+						vidx[v] = vertices.count();
+						vertices.append( v );
 					}
 				}
-				QVector<int> vertices( idx, -1 );
+			}
 
-				for ( int i = 0; i < numVerts; ++i ) {
-					int v = vidx[i];
+			// map the vertices
 
-					if ( v >= 0 ) {
-						vertices[v] = i;
-					}
-				}
-
-				// map the vertices
+			for ( Triangle & tri : triangles ) {
+				for ( int t = 0; t < 3; t++ )
+					tri[t] = vidx[tri[t]];
+			}
 
-				for ( int tri = 0; tri < triangles.count(); tri++ ) {
-					for ( int t = 0; t < 3; t++ ) {
-						triangles[tri][t] = vertices.indexOf( triangles[tri][t] );
-					}
-				}
+			for ( int v : vertices )
+				vidx[v] = -1;
 
-				// stripify the triangles
-				QVector<QVector<quint16> > strips;
-				int numTriangles = 0;
+			// stripify the triangles
+			QVector<QVector<quint16> > strips;
+			int numTriangles = 0;
 
-				if ( make_strips == true ) {
-					strips = stripify( triangles );
+			if ( make_strips == true ) {
+				strips = stripify( triangles );
 
-					for ( const QVector<quint16>& strip : strips ) {
-						numTriangles += strip.count() - 2;
-					}
-				} else {
-					numTriangles = triangles.count();
+				for ( const QVector<quint16>& strip : strips ) {
+					numTriangles += strip.count() - 2;
 				}
+			} else {
+				numTriangles = triangles.count();
+			}
 
-				// fill in counts
-				if ( pad ) {
-					while ( bones.size() < maxBonesPerPartition ) {
-						bones.append( 0 );
-					}
+			// fill in counts
+			if ( pad ) {
+				while ( bones.size() < maxBonesPerPartition ) {
+					bones.append( 0 );
 				}
+			}
 
-				// resort the bone weights in bone order
-				QMutableVectorIterator<QList<boneweight> > it( weights );
-
-				while ( it.hasNext() ) {
-					QList<boneweight> & bw = it.next();
-					std::sort( bw.begin(), bw.end(), boneweight_equivalence() );
-				}
+			nif->set<int>( iPart, "Num Vertices", vertices.count() );
+			nif->set<int>( iPart, "Num Triangles", numTriangles );
+			nif->set<int>( iPart, "Num Bones", bones.count() );
+			nif->set<int>( iPart, "Num Strips", strips.count() );
+			nif->set<int>( iPart, "Num Weights Per Vertex", maxBones );
 
-				nif->set<int>( iPart, "Num Vertices", vertices.count() );
-				nif->set<int>( iPart, "Num Triangles", numTriangles );
-				nif->set<int>( iPart, "Num Bones", bones.count() );
-				nif->set<int>( iPart, "Num Strips", strips.count() );
-				nif->set<int>( iPart, "Num Weights Per Vertex", maxBones );
+			// fill in bone map
 
-				// fill in bone map
+			QModelIndex iBoneMap = nif->getIndex( iPart, "Bones" );
+			nif->updateArraySize( iBoneMap );
+			nif->setArray<int>( iBoneMap, bones.toVector() );
 
-				QModelIndex iBoneMap = nif->getIndex( iPart, "Bones" );
-				nif->updateArraySize( iBoneMap );
-				nif->setArray<int>( iBoneMap, bones.toVector() );
+			// fill in vertex map
 
-				// fill in vertex map
+			nif->set<int>( iPart, "Has Vertex Map", 1 );
+			QModelIndex iVertexMap = nif->getIndex( iPart, "Vertex Map" );
+			nif->updateArraySize( iVertexMap );
+			nif->setArray<int>( iVertexMap, vertices );
 
-				nif->set<int>( iPart, "Has Vertex Map", 1 );
-				QModelIndex iVertexMap = nif->getIndex( iPart, "Vertex Map" );
-				nif->updateArraySize( iVertexMap );
-				nif->setArray<int>( iVertexMap, vertices );
+			// fill in vertex weights
 
-				// fill in vertex weights
+			nif->set<int>( iPart, "Has Vertex Weights", 1 );
+			QModelIndex iVWeights = nif->getIndex( iPart, "Vertex Weights" );
+			nif->updateArraySize( iVWeights );
 
-				nif->set<int>( iPart, "Has Vertex Weights", 1 );
-				QModelIndex iVWeights = nif->getIndex( iPart, "Vertex Weights" );
-				nif->updateArraySize( iVWeights );
+			QVector<float> vweights( maxBones );
+			for ( int v = 0; v < nif->rowCount( iVWeights ); v++ ) {
+				QModelIndex iVertex = QModelIndex_child( iVWeights, v );
+				nif->updateArraySize( iVertex );
 
-				for ( int v = 0; v < nif->rowCount( iVWeights ); v++ ) {
-					QModelIndex iVertex = QModelIndex_child( iVWeights, v );
-					nif->updateArraySize( iVertex );
-					QList<boneweight> list = weights.value( vertices[v] );
+				int vert = vertices[v];
+				for ( int b = 0; b < maxBones; b++ )
+					vweights[b] = ( sp.influenceCount( vert ) > b ) ? sp.influenceWeight( vert, b ) : 0.0f;
 
-					for ( int b = 0; b < maxBones; b++ )
-						nif->set<float>( QModelIndex_child( iVertex, b ), list.count() > b ? list[ b ].second : 0.0 );
-				}
+				nif->setArray<float>( iVertex, vweights );
+			}
 
-				nif->set<int>( iPart, "Has Faces", 1 );
+			nif->set<int>( iPart, "Has Faces", 1 );
 
-				if ( make_strips == true ) {
-					//Clear out any existing triangle data that might be left over from an existing Skin Partition
-					QModelIndex iTriangles = nif->getIndex( iPart, "Triangles" );
-					nif->updateArraySize( iTriangles );
+			if ( make_strips == true ) {
+				//Clear out any existing triangle data that might be left over from an existing Skin Partition
+				QModelIndex iTriangles = nif->getIndex( iPart, "Triangles" );
+				nif->updateArraySize( iTriangles );
 
-					// write the strips
-					QModelIndex iStripLengths = nif->getIndex( iPart, "Strip Lengths" );
-					nif->updateArraySize( iStripLengths );
+				// write the strips
+				QModelIndex iStripLengths = nif->getIndex( iPart, "Strip Lengths" );
+				nif->updateArraySize( iStripLengths );
 
-					for ( int s = 0; s < nif->rowCount( iStripLengths ); s++ )
-						nif->set<int>( QModelIndex_child( iStripLengths, s ), strips.value( s ).count() );
+				for ( int s = 0; s < nif->rowCount( iStripLengths ); s++ )
+					nif->set<int>( QModelIndex_child( iStripLengths, s ), strips.value( s ).count() );
 
-					QModelIndex iStrips = nif->getIndex( iPart, "Strips" );
-					nif->updateArraySize( iStrips );
+				QModelIndex iStrips = nif->getIndex( iPart, "Strips" );
+				nif->updateArraySize( iStrips );
 
-					for ( int s = 0; s < nif->rowCount( iStrips ); s++ ) {
-						nif->updateArraySize( QModelIndex_child( iStrips, s ) );
-						nif->setArray<quint16>( QModelIndex_child( iStrips, s ), strips.value( s ) );
-					}
-				} else {
-					//Clear out any existing strip data that might be left over from an existing Skin Partition
-					QModelIndex iStripLengths = nif->getIndex( iPart, "Strip Lengths" );
-					nif->updateArraySize( iStripLengths );
-					QModelIndex iStrips = nif->getIndex( iPart, "Strips" );
-					nif->updateArraySize( iStrips );
-
-					QModelIndex iTriangles = nif->getIndex( iPart, "Triangles" );
-					nif->updateArraySize( iTriangles );
-					nif->setArray<Triangle>( iTriangles, triangles );
+				for ( int s = 0; s < nif->rowCount( iStrips ); s++ ) {
+					nif->updateArraySize( QModelIndex_child( iStrips, s ) );
+					nif->setArray<quint16>( QModelIndex_child( iStrips, s ), strips.value( s ) );
 				}
+			} else {
+				//Clear out any existing strip data that might be left over from an existing Skin Partition
+				QModelIndex iStripLengths = nif->getIndex( iPart, "Strip Lengths" );
+				nif->updateArraySize( iStripLengths );
+				QModelIndex iStrips = nif->getIndex( iPart, "Strips" );
+				nif->updateArraySize( iStrips );
+
+				QModelIndex iTriangles = nif->getIndex( iPart, "Triangles" );
+				nif->updateArraySize( iTriangles );
+				nif->setArray<Triangle>( iTriangles, triangles );
+			}
 
-				// fill in vertex bones
-
-				nif->set<int>( iPart, "Has Bone Indices", 1 );
-				QModelIndex iVBones = nif->getIndex( iPart, "Bone Indices" );
-				nif->updateArraySize( iVBones );
-
-				for ( int v = 0; v < nif->rowCount( iVBones ); v++ ) {
-					QModelIndex iVertex = QModelIndex_child( iVBones, v );
-					nif->updateArraySize( iVertex );
-					QList<boneweight> list = weights.value( vertices[v] );
+			// fill in vertex bones, as indices into the bone map
 
-					for ( int b = 0; b < maxBones; b++ )
-						nif->set<int>( QModelIndex_child( iVertex, b ), list.count() > b ? bones.indexOf( list[ b ].first ) : 0 );
-				}
-			}
+			QHash<int, int> boneIndex;
+			for ( int b = bones.count() - 1; b >= 0; b-- )
+				boneIndex.insert( bones[b], b );
 
-			// done
+			nif->set<int>( iPart, "Has Bone Indices", 1 );
+			QModelIndex iVBones = nif->getIndex( iPart, "Bone Indices" );
+			nif->updateArraySize( iVBones );
 
-			return iShape;
-		}
-		catch ( QString & err )
-		{
-			if ( !err.isEmpty() )
-				QMessageBox::warning( nullptr, "NifSkope", err );
+			QVector<int> vbones( maxBones );
+			for ( int v = 0; v < nif->rowCount( iVBones ); v++ ) {
+				QModelIndex iVertex = QModelIndex_child( iVBones, v );
+				nif->updateArraySize( iVertex );
 
-			return iShape;
-		}
-	}
+				int vert = vertices[v];
+				for ( int b = 0; b < maxBones; b++ )
+					vbones[b] = ( sp.influenceCount( vert ) > b ) ? boneIndex.value( sp.influenceBone( vert, b ), -1 ) : 0;
 
-	static QList<int> mergeBones( QList<int> a, QList<int> b )
-	{
-		for ( const auto c : b ) {
-			if ( !a.contains( c ) ) {
-				a.append( c );
+				nif->setArray<int>( iVertex, vbones );
 			}
 		}
-		return a;
-	}
-
-	static bool containsBones( QList<int> a, QList<int> b )
-	{
-		for ( const auto c : b ) {
-			if ( !a.contains( c ) )
-				return false;
-		}
-		return true;
 	}
 };
 
@@ -1005,25 +704,66 @@ public:
 	QModelIndex cast( NifModel * nif, const QModelIndex & index ) override final
 	{
 		Q_UNUSED( index );
-		QList<QPersistentModelIndex> indices;
+		std::vector<std::unique_ptr<spSkinPartition::SkinShape>> shapes;
 
 		spSkinPartition Partitioner;
+		int maxBones = 0;
+
+		// read every shape first, the partitioning itself does not touch the model and runs on all cores
 
 		for ( int n = 0; n < nif->getBlockCount(); n++ ) {
 			QModelIndex idx = nif->getBlockIndex( n );
 
-			if ( Partitioner.isApplicable( nif, idx ) )
-				indices.append( idx );
+			if ( !Partitioner.isApplicable( nif, idx ) )
+				continue;
+
+			auto shape = std::make_unique<spSkinPartition::SkinShape>();
+			shape->iShape = idx;
+
+			try
+			{
+				spSkinPartition::read( nif, *shape );
+			}
+			catch ( QString & err )
+			{
+				if ( !err.isEmpty() )
+					QMessageBox::warning( nullptr, "NifSkope", err );
+				continue;
+			}
+
+			maxBones = std::max( maxBones, shape->partitioner.maxBonesPerVertex() );
+			shapes.push_back( std::move( shape ) );
 		}
 
+		if ( shapes.empty() )
+			return QModelIndex();
+
 		int mbpp = 0, mbpv = 0;
-		bool make_strips = false;
+		bool make_strips = false, pad = false;
+
+		if ( !spSkinPartition::queryOptions( maxBones, mbpp, mbpv, make_strips, pad ) )
+			return QModelIndex();
+
+		QVector<SkinPartitioner *> partitioners;
+		for ( const auto & shape : shapes )
+			partitioners.append( &shape->partitioner );
+
+		SkinPartitioner::run( partitioners, mbpp, mbpv );
+
+		int done = 0;
+		for ( const auto & shape : shapes ) {
+			const SkinPartitioner & sp = shape->partitioner;
+			if ( !sp.error().isEmpty() ) {
+				QMessageBox::warning( nullptr, "NifSkope", sp.error() );
+				continue;
+			}
 
-		for ( const QPersistentModelIndex& idx : indices ) {
-			Partitioner.cast( nif, idx, mbpp, mbpv, make_strips );
+			spSkinPartition::reportChanges( *shape, mbpv );
+			spSkinPartition::write( nif, *shape, mbpp, mbpv, make_strips, pad );
+			done++;
 		}
 
-		qCWarning( nsSpell ) << Spell::tr( "did %1 partitions" ).arg( indices.count() );
+		qCWarning( nsSpell ) << Spell::tr( "did %1 partitions" ).arg( done );
 
 		return QModelIndex();
 	}
@@ -0,0 +1,281 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "nifindexwidget.h"
+
+#include "gamemanager.h"
+#include "nifskope.h"
+#include "io/nifindex.h"
+#include "ui/widgets/fileselect.h"
+
+#include <QCloseEvent>
+#include <QComboBox>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSettings>
+#include <QSpinBox>
+#include <QThread>
+#include <QVBoxLayout>
+
+#include <algorithm>
+
+
+//! @file nifindexwidget.cpp NifIndexWidget
+
+NifIndexWidget * NifIndexWidget::create()
+{
+	NifIndexWidget * w = new NifIndexWidget();
+	w->setAttribute( Qt::WA_DeleteOnClose );
+	w->show();
+	return w;
+}
+
+NifIndexWidget::NifIndexWidget()
+	: QWidget()
+{
+	setWindowTitle( tr( "File Index" ) );
+
+	QSettings settings;
+	settings.beginGroup( "File Index" );
+
+	source = new QComboBox( this );
+	source->addItem( tr( "Folder" ), -1 );
+	for ( int g = Game::OTHER + 1; g < Game::NUM_GAMES; g++ ) {
+		if ( Game::GameManager::status( Game::GameMode( g ) ) )
+			source->addItem( tr( "%1 archives" ).arg( Game::StringForMode( Game::GameMode( g ) ) ), g );
+	}
+	source->setCurrentIndex( std::max( source->findText( settings.value( "Source" ).toString() ), 0 ) );
+	source->setToolTip( tr( "Index the loose files in a folder, or the files in the resource archives of a game" ) );
+	connect( source, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &NifIndexWidget::sourceChanged );
+
+	directory = new FileSelector( FileSelector::Folder, "Dir", QBoxLayout::RightToLeft );
+	directory->setText( settings.value( "Directory" ).toString() );
+	connect( directory, &FileSelector::sigActivated, this, &NifIndexWidget::sourceChanged );
+
+	fields = new QLineEdit( this );
+	fields->setText( settings.value( "Fields", NifIndex::defaultFields().join( ", " ) ).toString() );
+	fields->setToolTip( tr( "Comma separated names of the fields whose values are indexed" ) );
+
+	threads = new QSpinBox( this );
+	threads->setRange( 1, 1024 );
+	threads->setValue( settings.value( "Threads", std::max( QThread::idealThreadCount(), 1 ) ).toInt() );
+
+	query = new QLineEdit( this );
+	query->setPlaceholderText( tr( "block:<type> path:<path> value:<field>=<value>" ) );
+	query->setToolTip( tr( "Files matching all terms are listed, terms without a prefix are paths, and * matches any characters" ) );
+	connect( query, &QLineEdit::returnPressed, this, &NifIndexWidget::search );
+
+	results = new QListWidget( this );
+	connect( results, &QListWidget::itemActivated, this, &NifIndexWidget::openFile );
+
+	progress = new QProgressBar( this );
+	progress->setHidden( true );
+
+	label = new QLabel( this );
+
+	btUpdate = new QPushButton( tr( "Update" ), this );
+	btUpdate->setToolTip( tr( "Load the new and changed files, and save the index" ) );
+	connect( btUpdate, &QPushButton::clicked, this, &NifIndexWidget::update );
+
+	QPushButton * btSearch = new QPushButton( tr( "Search" ), this );
+	connect( btSearch, &QPushButton::clicked, this, &NifIndexWidget::search );
+
+	QPushButton * btClose = new QPushButton( tr( "Close" ), this );
+	connect( btClose, &QPushButton::clicked, this, &NifIndexWidget::close );
+
+	QVBoxLayout * lay = new QVBoxLayout();
+	setLayout( lay );
+
+	QHBoxLayout * hbox = new QHBoxLayout();
+	lay->addLayout( hbox );
+	hbox->addWidget( source );
+	hbox->addWidget( directory );
+
+	lay->addLayout( hbox = new QHBoxLayout() );
+	hbox->addWidget( new QLabel( tr( "Fields:" ) ) );
+	hbox->addWidget( fields );
+	hbox->addWidget( new QLabel( tr( "Threads:" ) ) );
+	hbox->addWidget( threads );
+
+	lay->addLayout( hbox = new QHBoxLayout() );
+	hbox->addWidget( new QLabel( tr( "Query:" ) ) );
+	hbox->addWidget( query );
+	hbox->addWidget( btSearch );
+
+	lay->addWidget( results );
+
+	lay->addLayout( hbox = new QHBoxLayout() );
+	hbox->addWidget( progress );
+	hbox->addWidget( label );
+
+	lay->addLayout( hbox = new QHBoxLayout() );
+	hbox->addWidget( btUpdate );
+	hbox->addWidget( btClose );
+
+	settings.endGroup();
+
+	sourceChanged();
+}
+
+NifIndexWidget::~NifIndexWidget()
+{
+	QSettings settings;
+	settings.beginGroup( "File Index" );
+
+	settings.setValue( "Source", source->currentText() );
+	settings.setValue( "Directory", directory->text() );
+	settings.setValue( "Fields", fields->text() );
+	settings.setValue( "Threads", threads->value() );
+}
+
+QString NifIndexWidget::sourceName() const
+{
+	int game = source->currentData().toInt();
+	if ( game < 0 )
+		return directory->text();
+	return "game:" + Game::StringForMode( Game::GameMode( game ) );
+}
+
+void NifIndexWidget::sourceChanged()
+{
+	if ( updating )
+		return;
+
+	directory->setEnabled( source->currentData().toInt() < 0 );
+	results->clear();
+
+	QString name = sourceName();
+	index.reset( name.isEmpty() ? nullptr : new NifIndex( name ) );
+	if ( !index ) {
+		label->setText( QString() );
+		return;
+	}
+
+	if ( index->load() )
+		label->setText( tr( "%1 files, %2 terms" ).arg( index->fileCount() ).arg( index->termCount() ) );
+	else
+		label->setText( tr( "Not indexed" ) );
+}
+
+void NifIndexWidget::update()
+{
+	if ( updating ) {
+		cancelled = true;
+		return;
+	}
+
+	QString name = sourceName();
+	if ( name.isEmpty() )
+		return;
+	if ( !index || index->source() != name ) {
+		index.reset( new NifIndex( name ) );
+		index->load();
+	}
+
+	QStringList fieldList;
+	for ( const QString & f : fields->text().split( ',' ) ) {
+		if ( !f.trimmed().isEmpty() )
+			fieldList.append( f.trimmed() );
+	}
+	index->setFields( fieldList );
+
+	updating = true;
+	cancelled = false;
+	btUpdate->setText( tr( "Cancel" ) );
+	source->setEnabled( false );
+	directory->setEnabled( false );
+	progress->setValue( 0 );
+	progress->setHidden( false );
+
+	bool updated = index->update( threads->value(), [this]( int n, int total ) {
+		progress->setMaximum( std::max( total, 1 ) );
+		progress->setValue( n );
+		QCoreApplication::processEvents();
+		return !cancelled;
+	} );
+
+	const NifIndex::UpdateStatistics & stats = index->statistics();
+	if ( updated ) {
+		label->setText( tr( "%1 files, %2 terms, %3 loaded (%4 failed) in %5 s" )
+						.arg( index->fileCount() ).arg( index->termCount() )
+						.arg( stats.filesLoaded ).arg( stats.filesFailed ).arg( stats.seconds, 0, 'f', 1 ) );
+	} else if ( cancelled ) {
+		label->setText( tr( "Cancelled" ) );
+	} else {
+		label->setText( tr( "Source does not exist" ) );
+	}
+
+	progress->setHidden( true );
+	source->setEnabled( true );
+	directory->setEnabled( source->currentData().toInt() < 0 );
+	btUpdate->setText( tr( "Update" ) );
+	updating = false;
+}
+
+void NifIndexWidget::search()
+{
+	results->clear();
+	if ( !index || updating )
+		return;
+
+	QElapsedTimer timer;
+	timer.start();
+	QStringList files = index->query( NifIndex::parseQuery( query->text() ) );
+	qint64 t = timer.nsecsElapsed();
+
+	results->addItems( files );
+	label->setText( tr( "%1 of %2 files match, %3 ms" ).arg( files.size() ).arg( index->fileCount() ).arg( double( t ) / 1.0e6, 0, 'f', 2 ) );
+}
+
+void NifIndexWidget::openFile( QListWidgetItem * item )
+{
+	// files in archives cannot be opened by name
+	if ( !item || !index || source->currentData().toInt() >= 0 )
+		return;
+
+	NifSkope::createWindow( index->filePath( item->text() ) );
+}
+
+void NifIndexWidget::closeEvent( QCloseEvent * e )
+{
+	// update() runs on this window's event loop, cancel it and close on the next request
+	if ( updating ) {
+		cancelled = true;
+		e->ignore();
+	}
+}
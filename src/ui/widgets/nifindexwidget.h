@@ -0,0 +1,94 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef NIFINDEXWIDGET_H
+#define NIFINDEXWIDGET_H
+
+#include <QWidget> // Inherited
+
+#include <memory>
+
+
+class NifIndex;
+
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+class QProgressBar;
+class QPushButton;
+class QSpinBox;
+class FileSelector;
+
+//! @file nifindexwidget.h NifIndexWidget
+
+//! Window for creating and searching the NifIndex of a folder or of the archives of a game
+class NifIndexWidget final : public QWidget
+{
+	Q_OBJECT
+
+public:
+	NifIndexWidget();
+	~NifIndexWidget();
+
+	static NifIndexWidget * create();
+
+protected slots:
+	//! Loads the cached index of the selected source
+	void sourceChanged();
+	//! Updates the index, or cancels a running update
+	void update();
+	void search();
+	void openFile( QListWidgetItem * item );
+
+protected:
+	void closeEvent( QCloseEvent * e ) override final;
+
+	QString sourceName() const;
+
+	QComboBox * source;
+	FileSelector * directory;
+	QLineEdit * fields;
+	QSpinBox * threads;
+	QLineEdit * query;
+	QListWidget * results;
+	QProgressBar * progress;
+	QLabel * label;
+	QPushButton * btUpdate;
+
+	std::unique_ptr<NifIndex> index;
+	bool updating = false;
+	bool cancelled = false;
+};
+
+#endif
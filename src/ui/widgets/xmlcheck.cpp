@@ -1,5 +1,6 @@
 #include "xmlcheck.h"
 
+#include "gamemanager.h"
 #include "message.h"
 #include "model/kfmmodel.h"
 #include "model/nifmodel.h"
@@ -9,6 +10,7 @@
 #include "spells/sanitize.h"
 
 #include <QAction>
+#include <QBuffer>
 #include <QCheckBox>
 #include <QCloseEvent>
 #include <QDir>
@@ -27,7 +29,8 @@
 #include <QComboBox>
 #include <QQueue>
 
-#define NUM_THREADS 4
+#include <algorithm>
+#include <set>
 
 
 TestShredder * TestShredder::create()
@@ -45,6 +48,16 @@ TestShredder::TestShredder()
 	QSettings settings;
 	settings.beginGroup( "XML Checker" );
 
+	source = new QComboBox( this );
+	source->addItem( tr( "Folder" ), -1 );
+	for ( int g = Game::OTHER + 1; g < Game::NUM_GAMES; g++ ) {
+		if ( Game::GameManager::status( Game::GameMode( g ) ) )
+			source->addItem( tr( "%1 archives" ).arg( Game::StringForMode( Game::GameMode( g ) ) ), g );
+	}
+	source->setCurrentIndex( std::max( source->findText( settings.value( "Source" ).toString() ), 0 ) );
+	source->setToolTip( tr( "Check loose files in a folder, or the files in the resource archives of a game" ) );
+	connect( source, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &TestShredder::sourceChanged );
+
 	directory = new FileSelector( FileSelector::Folder, "Dir", QBoxLayout::RightToLeft );
 	directory->setText( settings.value( "Directory" ).toString() );
 
@@ -92,8 +105,8 @@ TestShredder::TestShredder()
 	repErr->setChecked( settings.value( "List Matches Only", true ).toBool() );
 
 	count = new QSpinBox();
-	count->setRange( 1, 16 );
-	count->setValue( settings.value( "Threads", NUM_THREADS ).toInt() );
+	count->setRange( 1, 1024 );
+	count->setValue( settings.value( "Threads", std::max( QThread::idealThreadCount(), 1 ) ).toInt() );
 	connect( count, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &TestShredder::renumberThreads );
 
 	//Version Check
@@ -124,6 +137,7 @@ TestShredder::TestShredder()
 
 	QHBoxLayout * hbox = new QHBoxLayout();
 	lay->addLayout( hbox );
+	hbox->addWidget( source );
 	hbox->addWidget( directory );
 	hbox->addWidget( recursive );
 	hbox->addWidget( chkNif );
@@ -163,6 +177,7 @@ TestShredder::TestShredder()
 	hbox->addWidget( btClose );
 
 	renumberThreads( count->value() );
+	sourceChanged();
 
 	settings.endGroup();
 }
@@ -172,6 +187,7 @@ TestShredder::~TestShredder()
 	QSettings settings;
 	settings.beginGroup( "XML Checker" );
 
+	settings.setValue( "Source", source->currentText() );
 	settings.setValue( "Directory", directory->text() );
 	settings.setValue( "Recursive", recursive->isChecked() );
 	settings.setValue( "Check NIF", chkNif->isChecked() );
@@ -212,6 +228,7 @@ void TestShredder::renumberThreads( int num )
 		thread->reportAll = !repErr->isChecked();
 		thread->headerOnly = hdrOnly->isChecked();
 		thread->checkFile = chkCheckErrors->isChecked();
+		thread->archiveGame = source->currentData().toInt();
 
 		thread->valueName = valueName->text();
 		thread->valueMatch = valueMatch->text();
@@ -228,6 +245,13 @@ void TestShredder::renumberThreads( int num )
 	}
 }
 
+void TestShredder::sourceChanged()
+{
+	bool folder = ( source->currentData().toInt() < 0 );
+	directory->setEnabled( folder );
+	recursive->setEnabled( folder );
+}
+
 void TestShredder::run()
 {
 	errorCount = 0;
@@ -253,7 +277,11 @@ void TestShredder::run()
 	if ( chkKfm->isChecked() )
 		extensions << "*.kfm";
 
-	queue.init( directory->text(), extensions, recursive->isChecked() );
+	int archiveGame = source->currentData().toInt();
+	if ( archiveGame >= 0 )
+		queue.init( Game::GameMode( archiveGame ), extensions );
+	else
+		queue.init( directory->text(), extensions, recursive->isChecked() );
 
 	time = QDateTime::currentDateTime();
 
@@ -266,6 +294,7 @@ void TestShredder::run()
 		thread->reportAll  = !repErr->isChecked();
 		thread->headerOnly = hdrOnly->isChecked();
 		thread->checkFile = chkCheckErrors->isChecked();
+		thread->archiveGame = archiveGame;
 		thread->valueName = valueName->text();
 		thread->valueMatch = valueMatch->text();
 		thread->op = OpType(valueOps->currentIndex());
@@ -290,7 +319,13 @@ void TestShredder::threadFinished()
 
 		btRun->setChecked( false );
 
-		label->setText( tr( "%1 files in %2 seconds" ).arg( progress->maximum() ).arg( time.secsTo( QDateTime::currentDateTime() ) ) );
+		qint64 bytes = 0;
+		for ( TestThread * thread : threads )
+			bytes += thread->bytesRead;
+		double seconds = std::max( double( time.msecsTo( QDateTime::currentDateTime() ) ) / 1000.0, 0.001 );
+		label->setText( tr( "%1 files, %2 MB in %3 seconds (%4 files/s)" ).arg( progress->maximum() )
+						.arg( double( bytes ) / 1048576.0, 0, 'f', 1 ).arg( seconds, 0, 'f', 1 )
+						.arg( double( progress->maximum() ) / seconds, 0, 'f', 0 ) );
 		label->setVisible( true );
 
 		for ( TestThread* thread : threads ) {
@@ -388,6 +423,37 @@ void FileQueue::init( const QString & dname, const QStringList & extensions, boo
 	mutex.unlock();
 }
 
+static bool archiveFileFilter( void * p, const std::string_view & fileName )
+{
+	const QStringList * suffixes = reinterpret_cast<const QStringList *>( p );
+	QLatin1String name( fileName.data(), qsizetype( fileName.length() ) );
+	for ( const QString & s : *suffixes ) {
+		if ( name.endsWith( s, Qt::CaseInsensitive ) )
+			return true;
+	}
+	return false;
+}
+
+void FileQueue::init( Game::GameMode game, const QStringList & extensions )
+{
+	// "*.nif" -> ".nif"
+	QStringList suffixes;
+	for ( const QString & e : extensions )
+		suffixes.append( e.mid( 1 ) );
+
+	std::set<std::string_view> fileSet;
+	Game::GameManager::list_files( fileSet, game, &archiveFileFilter, &suffixes );
+
+	// archive paths are stored as Latin-1 so that they convert back to the same bytes
+	QQueue<QString> paths;
+	for ( const std::string_view & f : fileSet )
+		paths.enqueue( QString::fromLatin1( f.data(), qsizetype( f.length() ) ) );
+
+	mutex.lock();
+	this->queue = paths;
+	mutex.unlock();
+}
+
 QString FileQueue::dequeue()
 {
 	QMutexLocker lock( &mutex );
@@ -433,11 +499,29 @@ void TestThread::run()
 	NifModel nif;
 	KfmModel kfm;
 
+	bytesRead = 0;
+
 	QString filepath = queue->dequeue();
 
 	while ( !filepath.isEmpty() ) {
 		emit sigStart( filepath );
 
+		// read the file once, the header check and the full parse both use the same data
+		QByteArray data;
+		bool dataRead = false;
+		if ( archiveGame >= 0 ) {
+			QByteArray fullPath( filepath.toLatin1() );
+			dataRead = Game::GameManager::get_file( data, Game::GameMode( archiveGame ),
+													std::string_view( fullPath.constData(), size_t( fullPath.size() ) ) );
+		} else {
+			QFile f( filepath );
+			if ( f.open( QIODevice::ReadOnly ) ) {
+				data = f.readAll();
+				dataRead = true;
+			}
+		}
+		bytesRead += data.size();
+
 		BaseModel * model = &nif;
 		QReadWriteLock * lock = &nif.XMLlock;
 
@@ -453,8 +537,13 @@ void TestThread::run()
 			QReadLocker lck( lock );
 
 			QString result;
-			if ( model == &nif && nif.earlyRejection( filepath, blockMatch, verMatch ) ) {
-				bool loaded = (headerOnly) ? nif.loadHeaderOnly(filepath) : model->loadFromFile(filepath);
+			QBuffer buf( &data );
+			bool headerLoaded = dataRead && model == &nif && buf.open( QIODevice::ReadOnly ) && nif.loadHeaderOnly( buf );
+			buf.close();
+
+			// reject by version and block types before the full parse, with "Header Only" the header is all that is needed
+			if ( headerLoaded && nif.headerMatches( blockMatch, verMatch ) ) {
+				bool loaded = headerOnly || model->loadFromData( data, ( archiveGame < 0 ) ? filepath : QString() );
 
 				result = QString( "<a href=\"nif:%1\">%1</a> (%2, %3, %4)" )
 					.arg( filepath, model->getVersion() ).arg( nif.getUserVersion() ).arg( nif.getBSVersion() );
@@ -572,7 +661,7 @@ void TestThread::run()
 					if ( rep )
 						emit sigReady( result );
 				}
-			} else if ( !blockMatch.isEmpty() && !verMatch ) {
+			} else if ( !headerLoaded && !blockMatch.isEmpty() && !verMatch ) {
 				// Do not silently fail on unrecognized NIFs
 				result += QString("Did not recognize file as a NIF: %1").arg(filepath);
 				emit sigReady(result);
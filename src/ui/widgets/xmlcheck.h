@@ -25,6 +25,11 @@ class QTextBrowser;
 class TestMessage;
 class FileSelector;
 
+namespace Game
+{
+enum GameMode : int;
+}
+
 
 enum OpType
 {
@@ -70,6 +75,8 @@ public:
 	int count();
 
 	void init( const QString & directory, const QStringList & extensions, bool recursive );
+	//! Queues the files in the resource archives of \a game that match \a extensions
+	void init( Game::GameMode game, const QStringList & extensions );
 	void clear();
 
 protected:
@@ -95,6 +102,11 @@ public:
 	bool reportAll = true;
 	bool headerOnly = false;
 	bool checkFile = true;
+	//! The game to read the queued files from with GameManager::get_file, or -1 for loose files
+	int archiveGame = -1;
+
+	//! The number of bytes read by the last run
+	qint64 bytesRead = 0;
 
 signals:
 	void sigStart( const QString & file );
@@ -133,10 +145,12 @@ protected slots:
 	void onIncrementError();
 
 	void renumberThreads( int );
+	void sourceChanged();
 
 protected:
 	void closeEvent( QCloseEvent * ) override final;
 
+	QComboBox * source;
 	FileSelector * directory;
 	QLineEdit * blockMatch;
 	QLineEdit * valueName;
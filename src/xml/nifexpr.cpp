@@ -32,6 +32,9 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "nifexpr.h"
 
+#include "data/nifitem.h"
+#include "xml/xmlconfig.h"
+
 
 //! @file nifexpr.cpp Expression parsing for conditions defined in nif.xml.
 
@@ -166,7 +169,8 @@ void NifExpr::partition( const QString & cond, int offset /*= 0*/ )
 	QRegularExpressionMatch reUnaryMatch = reUnary.match( cond, offset );
 	pos = reUnaryMatch.capturedStart();
 	if ( pos != -1 ) {
-		NifExpr e( reUnaryMatch.captured( 1 ).trimmed() );
+		NifExpr e;
+		e.partition( reUnaryMatch.captured( 1 ).trimmed() );
 		opcode = NifExpr::e_not;
 		rhs = QVariant::fromValue( e );
 		return;
@@ -235,8 +239,10 @@ void NifExpr::partition( const QString & cond, int offset /*= 0*/ )
 	rstartpos = oendpos + 1;
 	rendpos = cond.size() - 1;
 
-	NifExpr lhsexp( cond.mid( lstartpos, lendpos - lstartpos + 1 ).trimmed() );
-	NifExpr rhsexp( cond.mid( rstartpos, rendpos - rstartpos + 1 ).trimmed() );
+	// Only the complete expression is compiled, not the operands
+	NifExpr lhsexp, rhsexp;
+	lhsexp.partition( cond.mid( lstartpos, lendpos - lstartpos + 1 ).trimmed() );
+	rhsexp.partition( cond.mid( rstartpos, rendpos - rstartpos + 1 ).trimmed() );
 
 	if ( lhsexp.opcode == NifExpr::e_nop ) {
 		lhs = lhsexp.lhs;
@@ -253,6 +259,184 @@ void NifExpr::partition( const QString & cond, int offset /*= 0*/ )
 	}
 }
 
+NifExpr::Symbol::Symbol( const QString & n )
+	: name( n ), isPath( n.contains( QChar('\\') ) ), fieldId( isPath ? -1 : NifFieldId( n ).value() )
+{
+}
+
+void NifExpr::compile()
+{
+	auto p = std::make_shared<Program>();
+	if ( compileNode( *p, 0 ) && !p->code.empty() )
+		program = std::move( p );
+	else
+		program.reset();
+}
+
+bool NifExpr::compileNode( Program & p, int depth ) const
+{
+	switch ( opcode ) {
+	case NifExpr::e_nop:
+		return compileOperand( p, lhs, depth );
+	case NifExpr::e_not:
+		if ( !compileOperand( p, rhs, depth ) )
+			return false;
+		break;
+	default:
+		if ( !compileOperand( p, lhs, depth ) || !compileOperand( p, rhs, depth + 1 ) )
+			return false;
+		break;
+	}
+
+	p.code.push_back( { 0, 0, Instruction::Apply, quint8( opcode ) } );
+	return true;
+}
+
+bool NifExpr::compileOperand( Program & p, const QVariant & v, int depth )
+{
+	if ( depth >= MaxStackDepth )
+		return false;
+
+	if ( v.typeId() >= QMetaType::User ) {
+		if ( v.canConvert<NifExpr>() )
+			return v.value<NifExpr>().compileNode( p, depth );
+		return false;
+	}
+
+	switch ( v.typeId() ) {
+	case QMetaType::Int:
+		p.code.push_back( { quint64( qint64( v.toInt() ) ), 0, Instruction::PushConst, 0 } );
+		return true;
+	case QMetaType::UInt:
+		p.code.push_back( { quint64( v.toUInt() ), 0, Instruction::PushConst, 0 } );
+		return true;
+	case QMetaType::QString:
+		{
+			QString name = v.toString();
+			if ( name == XMLARG ) {
+				p.code.push_back( { 0, 0, Instruction::PushArg, 0 } );
+				return true;
+			}
+
+			// String values are compared as strings by evaluateValue
+			if ( name.startsWith( QChar('$') ) )
+				return false;
+
+			bool numeric;
+			int val = name.toInt( &numeric, 10 );
+			if ( numeric ) {
+				p.code.push_back( { quint64( qint64( val ) ), 0, Instruction::PushConst, 0 } );
+			} else {
+				p.code.push_back( { 0, quint32( p.symbols.size() ), Instruction::PushSymbol, 0 } );
+				p.symbols.emplace_back( name );
+			}
+			return true;
+		}
+	default:
+		return false;
+	}
+}
+
+//! Operand kinds in serialized expressions
+enum ExprOperandTag : quint8
+{
+	OperandNone, OperandInt, OperandUInt, OperandString, OperandExpr
+};
+
+void NifExpr::writeOperand( QDataStream & ds, const QVariant & v )
+{
+	if ( v.typeId() >= QMetaType::User && v.canConvert<NifExpr>() ) {
+		ds << quint8( OperandExpr );
+		v.value<NifExpr>().write( ds );
+		return;
+	}
+
+	switch ( v.typeId() ) {
+	case QMetaType::Int:
+		ds << quint8( OperandInt ) << qint32( v.toInt() );
+		break;
+	case QMetaType::UInt:
+		ds << quint8( OperandUInt ) << quint32( v.toUInt() );
+		break;
+	case QMetaType::QString:
+		ds << quint8( OperandString ) << v.toString();
+		break;
+	default:
+		// partition() only creates the types above, anything else is written as invalid
+		if ( v.isValid() )
+			ds.setStatus( QDataStream::WriteFailed );
+		ds << quint8( OperandNone );
+		break;
+	}
+}
+
+QVariant NifExpr::readOperand( QDataStream & ds, int depth )
+{
+	quint8 tag = OperandNone;
+	ds >> tag;
+
+	switch ( tag ) {
+	case OperandNone:
+		return QVariant();
+	case OperandInt:
+		{
+			qint32 v = 0;
+			ds >> v;
+			return QVariant::fromValue( int( v ) );
+		}
+	case OperandUInt:
+		{
+			quint32 v = 0;
+			ds >> v;
+			return QVariant::fromValue( uint( v ) );
+		}
+	case OperandString:
+		{
+			QString s;
+			ds >> s;
+			return QVariant::fromValue( s );
+		}
+	case OperandExpr:
+		if ( depth < 256 )
+			return QVariant::fromValue( readNode( ds, depth + 1 ) );
+		[[fallthrough]];
+	default:
+		ds.setStatus( QDataStream::ReadCorruptData );
+		return QVariant();
+	}
+}
+
+void NifExpr::write( QDataStream & ds ) const
+{
+	ds << quint8( opcode );
+	writeOperand( ds, lhs );
+	writeOperand( ds, rhs );
+}
+
+NifExpr NifExpr::readNode( QDataStream & ds, int depth )
+{
+	NifExpr e;
+	quint8 op = e_nop;
+	ds >> op;
+	if ( op > e_rsh ) {
+		ds.setStatus( QDataStream::ReadCorruptData );
+		return e;
+	}
+
+	e.opcode = Operator( op );
+	e.lhs = readOperand( ds, depth );
+	e.rhs = readOperand( ds, depth );
+	return e;
+}
+
+NifExpr NifExpr::read( QDataStream & ds )
+{
+	NifExpr e = readNode( ds, 0 );
+	if ( ds.status() == QDataStream::Ok )
+		e.compile();
+	return e;
+}
+
 QString NifExpr::toString() const
 {
 	QString l = lhs.toString();
@@ -34,10 +34,14 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define NIFEXPR_H
 #pragma once
 
+#include <QDataStream>
 #include <QRegularExpression>
 #include <QString>
 #include <QVariant>
 
+#include <memory>
+#include <vector>
+
 
 //! @file nifexpr.h NifExpr
 
@@ -53,6 +57,18 @@ class NifExpr final
 	Operator opcode;
 
 public:
+	//! A name referenced by a compiled expression (field, header path or block type)
+	struct Symbol
+	{
+		Symbol( const QString & n );
+
+		QString name;
+		//! The name is a path to a field of another item, it is always looked up
+		bool isPath;
+		//! Interned NifFieldId of the name, resolved when the expression is compiled; -1 for paths
+		int fieldId;
+	};
+
 	explicit NifExpr()
 	{
 		opcode = NifExpr::e_nop;
@@ -62,21 +78,37 @@ public:
 	{
 		opcode = NifExpr::e_nop;
 		partition( cond.mid( startpos, endpos - startpos + 1 ) );
+		compile();
 	}
 
 	NifExpr( const QString & cond )
 	{
 		opcode = NifExpr::e_nop;
 		partition( cond );
+		compile();
 	}
 
 	QString toString() const;
 
+	//! Writes the parsed expression tree, for the schema cache
+	void write( QDataStream & ds ) const;
+	//! Reads and compiles an expression written by write(), sets the status of \a ds on invalid data
+	static NifExpr read( QDataStream & ds );
+
 	bool noop() const
 	{
 		return opcode == NifExpr::e_nop;
 	}
 
+	//! Was the expression compiled to bytecode? Expressions which compare strings ($Name) are not.
+	bool isCompiled() const
+	{
+		return bool( program );
+	}
+
+	//! Evaluate compiled expressions with the bytecode interpreter (default) or by walking the expression tree
+	static void setBytecodeEnabled( bool enable ) { bytecodeEnabled = enable; }
+
 public:
 	template <class F>
 	QVariant evaluateValue( const F & convert ) const
@@ -89,9 +121,9 @@ public:
 		case NifExpr::e_not:
 			return QVariant::fromValue( !r.toBool() );
 		case NifExpr::e_not_eq:
-			return QVariant::fromValue( l != r );
+			return QVariant::fromValue( !variantsEqual( l, r ) );
 		case NifExpr::e_eq:
-			return QVariant::fromValue( l == r );
+			return QVariant::fromValue( variantsEqual( l, r ) );
 		case NifExpr::e_gte:
 			return QVariant::fromValue( l.toUInt() >= r.toUInt() );
 		case NifExpr::e_lte:
@@ -130,26 +162,161 @@ public:
 	template <class F>
 	bool evaluateBool( const F & convert ) const
 	{
+		if ( program && bytecodeEnabled )
+			return run( convert ) != 0;
 		return evaluateValue( convert ).toBool();
 	}
 
 	template <class F>
 	int evaluateUInt( const F & convert ) const
 	{
+		if ( program && bytecodeEnabled )
+			return int( quint32( run( convert ) ) );
 		return evaluateValue( convert ).toUInt();
 	}
 
 	template <class F>
 	int evaluateUInt64( const F & convert ) const
 	{
+		if ( program && bytecodeEnabled )
+			return int( run( convert ) );
 		return evaluateValue( convert ).toULongLong();
 	}
 
+	/*! Run the compiled expression
+	 *
+	 * All the values are unsigned 64-bit integers, booleans are 0 or 1. The operators truncate
+	 * their operands like evaluateValue does. The evaluator \a eval resolves the operands:
+	 * quint64 symbol( const NifExpr::Symbol & ) for names and quint64 arg() for #ARG#.
+	 */
+	template <class F>
+	quint64 run( const F & eval ) const
+	{
+		quint64 stack[MaxStackDepth];
+		int sp = 0;
+
+		for ( const Instruction & ins : program->code ) {
+			switch ( ins.kind ) {
+			case Instruction::PushConst:
+				stack[sp++] = ins.value;
+				break;
+			case Instruction::PushSymbol:
+				stack[sp++] = eval.symbol( program->symbols[ins.index] );
+				break;
+			case Instruction::PushArg:
+				stack[sp++] = eval.arg();
+				break;
+			case Instruction::Apply:
+				if ( ins.op == NifExpr::e_not ) {
+					stack[sp - 1] = ( stack[sp - 1] == 0 );
+				} else {
+					sp--;
+					stack[sp - 1] = apply( Operator( ins.op ), stack[sp - 1], stack[sp] );
+				}
+				break;
+			}
+		}
+
+		return ( sp > 0 ) ? stack[0] : 0;
+	}
+
 private:
+	//! Deepest operand stack a compiled expression may need
+	static constexpr int MaxStackDepth = 32;
+
+	struct Instruction
+	{
+		enum Kind : quint8 { PushConst, PushSymbol, PushArg, Apply };
+
+		quint64 value;
+		quint32 index;
+		Kind kind;
+		quint8 op;
+	};
+
+	struct Program
+	{
+		std::vector<Instruction> code;
+		std::vector<Symbol> symbols;
+	};
+
+	//! The compiled expression, shared by the copies of the expression
+	std::shared_ptr<const Program> program;
+
+	static inline bool bytecodeEnabled = true;
+
 	static Operator operatorFromString( const QString & str );
+	//! Integers compare as 32-bit unsigned values like the other operators, so -1 matches 0xFFFFFFFF
+	static bool variantsEqual( const QVariant & l, const QVariant & r )
+	{
+		static const auto isInteger = []( const QVariant & v ) {
+			switch ( v.typeId() ) {
+			case QMetaType::Bool:
+			case QMetaType::Int:
+			case QMetaType::UInt:
+			case QMetaType::LongLong:
+			case QMetaType::ULongLong:
+				return true;
+			default:
+				return false;
+			}
+		};
+		if ( isInteger( l ) && isInteger( r ) )
+			return l.toUInt() == r.toUInt();
+		return l == r;
+	}
 	void partition( const QString & cond, int offset = 0 );
 	void NormalizeVariants( QVariant & l, QVariant & r ) const;
 
+	void compile();
+	bool compileNode( Program & p, int depth ) const;
+
+	static void writeOperand( QDataStream & ds, const QVariant & v );
+	static QVariant readOperand( QDataStream & ds, int depth );
+	//! Reads an expression tree without compiling it, operands are only compiled as part of the complete expression
+	static NifExpr readNode( QDataStream & ds, int depth );
+	static bool compileOperand( Program & p, const QVariant & v, int depth );
+
+	static quint64 apply( Operator op, quint64 l, quint64 r )
+	{
+		switch ( op ) {
+		case NifExpr::e_not_eq:
+			return quint32( l ) != quint32( r );
+		case NifExpr::e_eq:
+			return quint32( l ) == quint32( r );
+		case NifExpr::e_gte:
+			return quint32( l ) >= quint32( r );
+		case NifExpr::e_lte:
+			return quint32( l ) <= quint32( r );
+		case NifExpr::e_gt:
+			return quint32( l ) > quint32( r );
+		case NifExpr::e_lt:
+			return quint32( l ) < quint32( r );
+		case NifExpr::e_bit_and:
+			return quint32( l ) & quint32( r );
+		case NifExpr::e_bit_or:
+			return quint32( l ) | quint32( r );
+		case NifExpr::e_add:
+			return quint32( quint32( l ) + quint32( r ) );
+		case NifExpr::e_sub:
+			return quint32( quint32( l ) - quint32( r ) );
+		case NifExpr::e_div:
+			return quint32( r ) ? quint32( l ) / quint32( r ) : 0;
+		case NifExpr::e_mul:
+			return quint32( quint32( l ) * quint32( r ) );
+		case NifExpr::e_bool_and:
+			return l && r;
+		case NifExpr::e_bool_or:
+			return l || r;
+		case NifExpr::e_lsh:
+			return quint32( r ) < 64 ? l << quint32( r ) : 0;
+		case NifExpr::e_rsh:
+			return quint32( r ) < 64 ? l >> quint32( r ) : 0;
+		default:
+			return l;
+		}
+	}
+
 	template <class F>
 	QVariant convertValue( const QVariant & v, const F & convert ) const
 	{
@@ -36,10 +36,19 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "model/nifmodel.h"
 
 #include <QtXml> // QXmlDefaultHandler Inherited
+#include <QBuffer>
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QMessageBox>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QXmlDefaultHandler>
 
+#include <cstring>
+
 
 //! \file nifxml.cpp NifXmlHandler, NifModel XML
 
@@ -52,6 +61,8 @@ QHash<QString, NifBlockPtr> NifModel::compounds;
 QHash<QString, NifBlockPtr> NifModel::fixedCompounds;
 QHash<QString, NifBlockPtr> NifModel::blocks;
 QMap<quint32, NifBlockPtr> NifModel::blockHashes;
+double                     NifModel::xmlLoadTime = 0.0;
+bool                       NifModel::xmlLoadedFromCache = false;
 
 
 // Current token attribute list
@@ -722,7 +733,7 @@ public:
 };
 
 // documented in nifmodel.h
-bool NifModel::loadXML()
+bool NifModel::loadXML( bool useSchemaCache )
 {
 	QDir        dir( QCoreApplication::applicationDirPath() );
 	QString     fname;
@@ -741,23 +752,247 @@ bool NifModel::loadXML()
 			break;
 		}
 	}
-	QString result = NifModel::parseXmlDescription( fname );
+	QString result = NifModel::parseXmlDescription( fname, useSchemaCache );
 
 	if ( !result.isEmpty() ) {
 		Message::append( tr( "<b>Error loading XML</b><br/>You will need to reinstall the XML and restart the application." ), result, QMessageBox::Critical );
 		return false;
 	}
 
+	// All field names of the schema are interned now
+	NifFieldId::freeze();
+
+	return true;
+}
+
+/*
+ *  Schema cache
+ */
+
+//! Schema cache file header, followed by the QDataStream of the schema
+struct SchemaCacheHeader
+{
+	char magic[8];
+	//! SHA-1 of the cache format, the version, the value type and flag layout, and the contents of nif.xml
+	char key[20];
+	quint32 dataSize;
+};
+
+static const char schemaCacheMagic[8] = { 'N', 'S', 'S', 'C', 'H', 'M', '\0', '\1' };
+
+//! Increment when the layout of the cached schema changes
+static const int schemaCacheFormat = 1;
+
+//! The numbers of the NifValue types and NifData flags stored in the cache, in declaration order; new values must be added here
+static constexpr quint32 schemaCacheLayout[] = {
+	NifValue::tBool, NifValue::tByte, NifValue::tWord, NifValue::tFlags, NifValue::tStringOffset,
+	NifValue::tStringIndex, NifValue::tBlockTypeIndex, NifValue::tInt, NifValue::tShort, NifValue::tULittle32,
+	NifValue::tInt64, NifValue::tUInt64, NifValue::tUInt, NifValue::tLink, NifValue::tUpLink, NifValue::tFloat,
+	NifValue::tSizedString, NifValue::tSizedString16, NifValue::tText, NifValue::tShortString,
+	NifValue::tHeaderString, NifValue::tLineString, NifValue::tChar8String, NifValue::tColor3, NifValue::tColor4,
+	NifValue::tByteColor4, NifValue::tByteColor4BGRA, NifValue::tVector3, NifValue::tHalfVector3,
+	NifValue::tShortVector3, NifValue::tUshortVector3, NifValue::tByteVector3, NifValue::tQuat,
+	NifValue::tQuatXYZW, NifValue::tMatrix, NifValue::tMatrix4, NifValue::tVector2, NifValue::tVector4,
+	NifValue::tByteVector4, NifValue::tUDecVector4, NifValue::tTriangle, NifValue::tFileVersion,
+	NifValue::tByteArray, NifValue::tStringPalette, NifValue::tString, NifValue::tFilePath, NifValue::tByteMatrix,
+	NifValue::tBlob, NifValue::tHfloat, NifValue::tHalfVector2, NifValue::tBSVertexDesc, NifValue::tNormbyte,
+	NifValue::tNone,
+	NifSharedData::None, NifSharedData::Abstract, NifSharedData::Binary, NifSharedData::Templated,
+	NifSharedData::Compound, NifSharedData::Array, NifSharedData::MultiArray, NifSharedData::Conditionless,
+	NifSharedData::Mixin, NifSharedData::TypeCondition
+};
+
+//! FNV-1a hash of schemaCacheLayout, changes if a type or flag is added, removed or renumbered
+static constexpr quint32 schemaCacheLayoutHash()
+{
+	quint32 h = 0x811C9DC5U;
+	for ( quint32 v : schemaCacheLayout ) {
+		for ( int i = 0; i < 32; i += 8 )
+			h = ( h ^ ( ( v >> i ) & 0xFFU ) ) * 0x01000193U;
+	}
+	return h;
+}
+
+//! The key of the cached schema of \a xmlData
+/*!
+ * The cache stores NifValue type numbers and NifData flags, so a hash of their layout is included
+ * in addition to the version. Other changes to what is cached require incrementing schemaCacheFormat.
+ */
+static QByteArray schemaCacheKey( const QByteArray & xmlData )
+{
+	constexpr quint32 layoutHash = schemaCacheLayoutHash();
+
+	QCryptographicHash hash( QCryptographicHash::Sha1 );
+	hash.addData( QByteArray::number( schemaCacheFormat ) );
+	hash.addData( QByteArray( NIFSKOPE_VERSION ) );
+	hash.addData( QByteArray::number( layoutHash ) );
+	hash.addData( xmlData );
+	return hash.result();
+}
+
+static QString schemaCachePath()
+{
+	QString cacheDir = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+	if ( cacheDir.isEmpty() )
+		return QString();
+	return cacheDir + "/nif.xml.cache";
+}
+
+static void writeBlockList( QDataStream & ds, const QHash<QString, NifBlockPtr> & list, bool & ok )
+{
+	ds << quint32( list.size() );
+	for ( const NifBlockPtr & b : list ) {
+		ds << b->id << b->ancestor << b->text << b->abstract << quint32( b->types.size() );
+		for ( const NifData & d : b->types )
+			ok = d.write( ds ) && ok;
+	}
+}
+
+static void readBlockList( QDataStream & ds, QHash<QString, NifBlockPtr> & list )
+{
+	quint32 n = 0;
+	ds >> n;
+	for ( quint32 i = 0; i < n && ds.status() == QDataStream::Ok; i++ ) {
+		NifBlockPtr b = NifBlockPtr( new NifBlock );
+		quint32 typeCount = 0;
+		ds >> b->id >> b->ancestor >> b->text >> b->abstract >> typeCount;
+		for ( quint32 j = 0; j < typeCount && ds.status() == QDataStream::Ok; j++ ) {
+			NifData d;
+			d.read( ds );
+			b->types.append( d );
+		}
+		list.insert( b->id, b );
+	}
+}
+
+bool NifModel::readSchemaCache( const QByteArray & key )
+{
+	QString path = schemaCachePath();
+	if ( path.isEmpty() )
+		return false;
+
+	QFile f( path );
+	if ( !f.open( QIODevice::ReadOnly ) || f.size() < qint64( sizeof( SchemaCacheHeader ) ) )
+		return false;
+
+	// The schema is read straight from the mapped file, without copying it
+	QByteArray buffer;
+	qint64 size = f.size();
+	const uchar * data = f.map( 0, size );
+	if ( !data ) {
+		buffer = f.readAll();
+		data = reinterpret_cast<const uchar *>( buffer.constData() );
+		size = buffer.size();
+	}
+
+	SchemaCacheHeader h;
+	if ( size < qint64( sizeof( h ) ) )
+		return false;
+	std::memcpy( &h, data, sizeof( h ) );
+	if ( std::memcmp( h.magic, schemaCacheMagic, sizeof( h.magic ) ) || key.size() != qsizetype( sizeof( h.key ) )
+		 || std::memcmp( h.key, key.constData(), sizeof( h.key ) ) || qint64( sizeof( h ) ) + h.dataSize != size )
+		return false;
+
+	QByteArray schema = QByteArray::fromRawData( reinterpret_cast<const char *>( data + sizeof( h ) ), qsizetype( h.dataSize ) );
+	QDataStream ds( schema );
+	ds.setVersion( QDataStream::Qt_6_0 );
+
+	if ( !NifValue::readTypeTables( ds ) )
+		return false;
+
+	quint32 versionCount = 0;
+	ds >> versionCount;
+	for ( quint32 i = 0; i < versionCount && ds.status() == QDataStream::Ok; i++ ) {
+		quint32 v = 0;
+		ds >> v;
+		supportedVersions.append( v );
+	}
+
+	readBlockList( ds, compounds );
+	readBlockList( ds, blocks );
+
+	QStringList fixed;
+	ds >> fixed;
+	for ( const QString & id : fixed ) {
+		NifBlockPtr b = compounds.value( id );
+		if ( !b )
+			b = blocks.value( id );
+		if ( !b ) {
+			ds.setStatus( QDataStream::ReadCorruptData );
+			break;
+		}
+		fixedCompounds.insert( id, b );
+	}
+
+	if ( ds.status() != QDataStream::Ok || !ds.atEnd() ) {
+		compounds.clear();
+		fixedCompounds.clear();
+		blocks.clear();
+		supportedVersions.clear();
+		NifValue::initialize();
+		return false;
+	}
+
+	for ( const NifBlockPtr & b : blocks )
+		blockHashes.insert( DJB1Hash( b->id.toStdString().c_str() ), b );
+
 	return true;
 }
 
+void NifModel::writeSchemaCache( const QByteArray & key )
+{
+	QString path = schemaCachePath();
+	if ( path.isEmpty() || !QDir().mkpath( QFileInfo( path ).absolutePath() ) )
+		return;
+
+	QByteArray schema;
+	bool ok = true;
+	{
+		QDataStream ds( &schema, QIODevice::WriteOnly );
+		ds.setVersion( QDataStream::Qt_6_0 );
+
+		NifValue::writeTypeTables( ds );
+
+		ds << quint32( supportedVersions.size() );
+		for ( quint32 v : supportedVersions )
+			ds << v;
+
+		writeBlockList( ds, compounds, ok );
+		writeBlockList( ds, blocks, ok );
+		ds << QStringList( fixedCompounds.keys() );
+
+		ok = ok && ( ds.status() == QDataStream::Ok );
+	}
+	// A schema with default values that cannot be stored is parsed from the XML every time
+	if ( !ok )
+		return;
+
+	SchemaCacheHeader h;
+	std::memcpy( h.magic, schemaCacheMagic, sizeof( h.magic ) );
+	std::memcpy( h.key, key.constData(), sizeof( h.key ) );
+	h.dataSize = quint32( schema.size() );
+
+	QSaveFile f( path );
+	if ( f.open( QIODevice::WriteOnly ) ) {
+		f.write( reinterpret_cast<const char *>( &h ), qint64( sizeof( h ) ) );
+		f.write( schema );
+		f.commit();
+	}
+}
+
 // documented in nifmodel.h
-QString NifModel::parseXmlDescription( const QString & filename )
+QString NifModel::parseXmlDescription( const QString & filename, bool useCache )
 {
 	QWriteLocker lck( &XMLlock );
 
+	QElapsedTimer timer;
+	timer.start();
+	xmlLoadedFromCache = false;
+
 	compounds.clear();
+	fixedCompounds.clear();
 	blocks.clear();
+	blockHashes.clear();
 
 	supportedVersions.clear();
 
@@ -768,22 +1003,109 @@ QString NifModel::parseXmlDescription( const QString & filename )
 	if ( !f.exists() )
 		return tr( "nif.xml could not be found. Please install it and restart the application." );
 
-	if ( !f.open( QIODevice::ReadOnly | QIODevice::Text ) )
+	if ( !f.open( QIODevice::ReadOnly ) )
 		return tr( "Couldn't open NIF XML description file: %1" ).arg( filename );
 
+	QByteArray xmlData = f.readAll();
+	f.close();
+
+	QByteArray key = schemaCacheKey( xmlData );
+	if ( useCache && readSchemaCache( key ) ) {
+		buildFieldTables();
+		xmlLoadedFromCache = true;
+		xmlLoadTime = double( timer.nsecsElapsed() ) / 1.0e6;
+		return QString();
+	}
+
+	QBuffer xmlBuffer( &xmlData );
+	xmlBuffer.open( QIODevice::ReadOnly | QIODevice::Text );
+
 	NifXmlHandler handler;
 	QXmlSimpleReader reader;
 	reader.setContentHandler( &handler );
 	reader.setErrorHandler( &handler );
-	QXmlInputSource source( &f );
+	QXmlInputSource source( &xmlBuffer );
 	reader.parse( source );
 
 	if ( !handler.errorString().isEmpty() ) {
 		compounds.clear();
+		fixedCompounds.clear();
 		blocks.clear();
+		blockHashes.clear();
 		supportedVersions.clear();
+	} else {
+		if ( useCache )
+			writeSchemaCache( key );
+		buildFieldTables();
 	}
 
+	xmlLoadTime = double( timer.nsecsElapsed() ) / 1.0e6;
 	return handler.errorString();
 }
 
+//! Append the names of the items that NifModel::insertType creates for \a data
+static void appendFieldNames( const NifData & data, const QHash<QString, NifBlockPtr> & compounds, QVector<NifFieldId> & fields, int depth = 0 )
+{
+	if ( !data.isArray() ) {
+		if ( data.isCompound() ) {
+			if ( !compounds.contains( data.type() ) )
+				return;
+		} else if ( data.isMixin() ) {
+			// Mixins insert their fields into the parent
+			NifBlockPtr mixin = compounds.value( data.type() );
+			if ( mixin && depth < 16 ) {
+				for ( const NifData & d : mixin->types )
+					appendFieldNames( d, compounds, fields, depth + 1 );
+			}
+			return;
+		}
+	}
+
+	fields.append( data.nameId() );
+}
+
+//! Append the names of the fields of \a block, starting with its ancestors like NifModel::insertNiBlock
+static void appendBlockFieldNames( const NifBlock * block, const QHash<QString, NifBlockPtr> & blocks,
+								   const QHash<QString, NifBlockPtr> & compounds, QVector<NifFieldId> & fields, int depth = 0 )
+{
+	if ( !block->ancestor.isEmpty() && depth < 64 ) {
+		NifBlockPtr ancestor = blocks.value( block->ancestor );
+		if ( ancestor )
+			appendBlockFieldNames( ancestor.get(), blocks, compounds, fields, depth + 1 );
+	}
+
+	for ( const NifData & d : block->types )
+		appendFieldNames( d, compounds, fields );
+}
+
+void NifModel::buildFieldTables()
+{
+	for ( NifBlockPtr & c : compounds ) {
+		QVector<NifFieldId> fields;
+		for ( const NifData & d : c->types )
+			appendFieldNames( d, compounds, fields );
+		c->fields = std::make_shared<NifFieldTable>( fields );
+	}
+
+	for ( NifBlockPtr & b : blocks ) {
+		QVector<NifFieldId> fields;
+		appendBlockFieldNames( b.get(), blocks, compounds, fields );
+		b->fields = std::make_shared<NifFieldTable>( fields );
+	}
+
+	// Items of compound types take their table from their data
+	auto assignTables = []( QList<NifData> & types ) {
+		for ( NifData & d : types ) {
+			if ( d.isCompound() ) {
+				NifBlockPtr c = compounds.value( d.type() );
+				if ( c )
+					d.setFieldTable( c->fields );
+			}
+		}
+	};
+	for ( NifBlockPtr & c : compounds )
+		assignTables( c->types );
+	for ( NifBlockPtr & b : blocks )
+		assignTables( b->types );
+}
+